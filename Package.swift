@@ -58,6 +58,8 @@ let package = Package(
     products: [
         .executable(name: "whisper", targets: ["whisper"]),
         .executable(name: "mdscodes", targets: ["mdscodes"]),
+        .executable(name: "nativebench", targets: ["nativebench"]),
+        .executable(name: "scanbench", targets: ["scanbench"]),
         .library(name: "Seer", type: .dynamic, targets: ["Seer"]),
         .library(name: "Minion", type: .dynamic, targets: ["Minion"]),
         .library(name: "NativeTasks", type: .static, targets: ["NativeTasks"]),
@@ -73,12 +75,27 @@ let package = Package(
         ),
         .target(
             name: "mdscodes",
-            dependencies: ["Seer", "Minion", "NativeTasks"], // pdndebug - remove NativeTasks?
+            dependencies: ["Seer", "Minion", "NativeTasks"],
             path: "Sources/mdscodes/mdscodes",
             cxxSettings: commonCxxSettings,
             swiftSettings: commonSwiftSettings,
         	linkerSettings: commonLinkerSettings
         ),
+        .target(
+            name: "nativebench",
+            dependencies: ["NativeTasks"],
+            path: "Sources/nativebench/nativebench",
+            cxxSettings: commonCxxSettings,
+            linkerSettings: commonLinkerSettings
+        ),
+        .target(
+            name: "scanbench",
+            dependencies: ["Seer", "Minion", "NativeTasks"],
+            path: "Sources/scanbench/scanbench",
+            cxxSettings: commonCxxSettings,
+            swiftSettings: commonSwiftSettings,
+        	linkerSettings: commonLinkerSettings
+        ),
         .target(
             name: "Seer",
             dependencies: ["Minion", "NativeTasks", "C_libpng"],
@@ -0,0 +1,90 @@
+//
+//  CaptureBackend.h
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#pragma once
+
+#include "CircularImageBuffer.h"
+#include "FrameDispatcher.h"
+#include "include/NativeTaskTypes.h"
+
+/// Interface to a source of captured video frames
+///
+/// The `nativeVideoCapture*()` functions operate on the selected backend (see `nativeVideoCaptureSelectBackend()`.) Every
+/// backend delivers frames in the same three ways:
+///
+///		1. To a receiver, on a frame dispatcher thread
+///		2. Into a circular image buffer, for polling
+///		3. Lent directly to the consumer (`acquireImage()`/`releaseImage()`)
+class CaptureBackend
+{
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Construction
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// We'll need a virtual destructor so we can override
+	public: virtual ~CaptureBackend() { }
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Properties
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Returns the name of this backend (as used by `nativeVideoCaptureSelectBackend()`)
+	public: virtual const char *name() const = 0;
+
+	/// Our circular image buffer (only when capturing without a receiver and without lending)
+	public: virtual CircularImageBuffer<LumaSample> *circularImageBuffer() = 0;
+
+	/// Our frame dispatcher (only when capturing to a receiver)
+	public: virtual FrameDispatcher *frameDispatcher() = 0;
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Capture control
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Starts a video capture at the given frame size and rate.
+	///
+	/// If `receiver` is set, then this callback receives every frame as it becomes available. In these cases, the circular
+	/// buffer is not used and polling functions will either do nothing or return empty results.
+	///
+	/// If `lendBuffers` is set (and `receiver` is not), frames are not copied into the circular buffer. Instead, they are lent to
+	/// the consumer through `acquireImage()`/`releaseImage()`.
+	///
+	/// Throws VideoException on error
+	public: virtual void startCapture(unsigned int frameWidth, unsigned int frameHeight, unsigned int frameRate, NativeCaptureFrameReceiver receiver, bool lendBuffers) = 0;
+
+	/// Stop a capture
+	///
+	/// When capturing to a receiver, this waits for any frame being delivered and no further frames will be delivered.
+	///
+	/// Throws VideoException on error
+	public: virtual void stopCapture() = 0;
+
+	/// Sets how frames are queued for delivery to a receiver
+	///
+	/// This must be called before capture is first started. Returns false if it is too late.
+	public: virtual bool setDispatchPolicy(NativeFrameDispatchPolicy policy, unsigned int capacity) = 0;
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Buffer lending
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Acquires the most recent frame that has not yet been acquired, filling in `image`
+	///
+	/// Returns false if no new frame is available (or capture isn't lending buffers)
+	public: virtual bool acquireImage(NativeCaptureImage &image) = 0;
+
+	/// Adds a reference to an acquired image, which then requires an additional `releaseImage()`
+	public: virtual void retainImage(const NativeCaptureImage &image) = 0;
+
+	/// Releases a reference to an acquired image, returning its buffer to the backend when the last reference is released
+	public: virtual void releaseImage(NativeCaptureImage &image) = 0;
+};
@@ -10,18 +10,42 @@
 // Use of this source code is governed by a BSD-style license that can be found
 // in the LICENSE file in the root of the source tree.
 
-#if defined(USE_MMAL)
-
 #pragma once
 
 #include <vector>
+#include <atomic>
+#include <string.h>
 #include <assert.h>
 #include "Mutex.h"
 #include "include/NativeTaskTypes.h"
 
+/// Synchronization modes for a CircularImageBuffer
+enum CircularImageBufferMode
+{
+	/// Every operation is guarded by a mutex, and consumers must wrap `get()`/`peek()` with `lock()`/`unlock()`.
+	///
+	/// When the buffer is full, `add()` overwrites the oldest unread image.
+	CircularImageBufferModeLocked,
+
+	/// Lock-free single-producer/single-consumer ring. The producer (`add()`) never blocks.
+	///
+	/// Exactly one thread may call `add()` and exactly one (other) thread may call `lock()`/`get()`/`peek()`/`unlock()`. The
+	/// image returned by `get()` belongs to the consumer until `unlock()` (or the next `get()`), so the producer can never write
+	/// over an image that is being read. Because of this, when the buffer is full `add()` drops the incoming image rather than
+	/// overwriting the oldest one. Dropped images are counted in `statFramesSkipped()`.
+	CircularImageBufferModeLockFree
+};
+
 template<class SampleType>
 class CircularImageBuffer
 {
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Constants
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Padding used to keep the producer's and consumer's indices on separate cache lines
+	private: static const size_t kCacheLineSize = 64;
+
 	// -----------------------------------------------------------------------------------------------------------------------------
 	// Local types
 	// -----------------------------------------------------------------------------------------------------------------------------
@@ -39,20 +63,30 @@ class CircularImageBuffer
 	/// Returns the total number of frames we've added to the buffer
 	///
 	/// To reset stats, see `resetStats()`
-	public: unsigned int statFramesAdded() const { return mStatFramesAdded; }
+	public: unsigned int statFramesAdded() const { return mStatFramesAdded.load(std::memory_order_relaxed); }
 
 	/// Returns the total number of frames we've read from the buffer
 	///
 	/// To reset stats, see `resetStats()`
-	public: unsigned int statFramesRead() const { return mStatFramesRead; }
+	public: unsigned int statFramesRead() const { return mStatFramesRead.load(std::memory_order_relaxed); }
 
 	/// Returns the total number of frames we've lost (we fell behind)
 	///
 	/// To reset stats, see `resetStats()`
-	public: unsigned int statFramesSkipped() const { return mStatFramesSkipped; }
+	public: unsigned int statFramesSkipped() const { return mStatFramesSkipped.load(std::memory_order_relaxed); }
+
+	/// Returns the synchronization mode of the buffer
+	public: CircularImageBufferMode mode() const { return mMode; }
 
 	/// Returns the total number of images in the buffer
-	public: int count() const { return mCount; }
+	///
+	/// In lock-free mode, this must only be called from the consumer thread (it does not include an image held by the consumer.)
+	public: int count() const
+	{
+		if (mMode == CircularImageBufferModeLocked) return mCount;
+		int count = ringCount(mHead.load(std::memory_order_acquire), mTail.load(std::memory_order_relaxed));
+		return mConsumerHoldsImage ? count - 1 : count;
+	}
 
 	/// Returns the capacity of the buffer
 	///
@@ -66,27 +100,53 @@ class CircularImageBuffer
 	public: unsigned int height() const { return mHeight; }
 
 	/// Returns true if the buffer is empty, otherwise false
-	public: bool isEmpty() const { return mCount == 0; }
+	///
+	/// In lock-free mode, this must only be called from the consumer thread (see `count()`.)
+	public: bool isEmpty() const
+	{
+		if (mMode == CircularImageBufferModeLocked) return mCount == 0;
+		return count() == 0;
+	}
 
 	/// Returns true if the buffer is full (i.e., the next add will overwrite the oldest entry not yet read
-	public: bool isFull() const { return mCount == capacity(); }
+	///
+	/// In lock-free mode, the next add will be dropped instead (an image held by the consumer counts toward this.)
+	public: bool isFull() const
+	{
+		if (mMode == CircularImageBufferModeLocked) return mCount == capacity();
+		return ringCount(mHead.load(std::memory_order_acquire), mTail.load(std::memory_order_acquire)) == capacity();
+	}
 
 	/// Lock the internal mutex to enable thread safe access
 	///
-	/// This is generally required for access to the get/peek methods
-	public: void lock() const { mMutex.lock(); }
+	/// This is generally required for access to the get/peek methods. In lock-free mode, this does nothing.
+	public: void lock() const
+	{
+		if (mMode == CircularImageBufferModeLocked) mMutex.lock();
+	}
 
-	/// Lock the internal mutex to enable thread safe access
+	/// Unlock the internal mutex from a previous call to `lock()`
 	///
-	/// This is generally required for access to the get/peek methods
-	public: void unlock() const { mMutex.unlock(); }
+	/// In lock-free mode, this returns the image returned by the last `get()` to the producer.
+	public: void unlock()
+	{
+		if (mMode == CircularImageBufferModeLocked)
+		{
+			mMutex.unlock();
+		}
+		else
+		{
+			releaseHeldImage();
+		}
+	}
 
 	// -----------------------------------------------------------------------------------------------------------------------------
 	// Construction
 	// -----------------------------------------------------------------------------------------------------------------------------
 
 	/// Initialization and deinitialization
-	public: CircularImageBuffer(unsigned int width, unsigned int height, CircularBufferSizeType capacity = 3)
+	public: CircularImageBuffer(unsigned int width, unsigned int height, CircularBufferSizeType capacity = 3, CircularImageBufferMode mode = CircularImageBufferModeLocked)
+	: mMode(mode), mMutex("CircularImageBuffer")
 	{
 		// Setup our dimensions
 		mWidth = width;
@@ -129,15 +189,23 @@ class CircularImageBuffer
 	///
 	/// This method requires that an empty circular buffer has been fully reset and not simply left in the
 	/// previous state (i.e., if mCount == 0, then mNextAddIndex must be 0 and mNextGetIndex must be -1).
+	///
+	/// In lock-free mode, a full buffer causes the image to be dropped instead (see `CircularImageBufferModeLockFree`.)
 	public: void add(SampleType *image)
 	{
+		if (mMode == CircularImageBufferModeLockFree)
+		{
+			addLockFree(image);
+			return;
+		}
+
 		mMutex.lock();
 
 		// We need a capacity
 		assert(capacity() > 0);
 
 		// Do nothing if we have no capacity
-		if (capacity() == 0) { return; }
+		if (capacity() == 0) { mMutex.unlock(); return; }
 
 		// Ensure our counts and indices agree to our empty/not-empty state
 		if (isEmpty())
@@ -206,6 +274,8 @@ class CircularImageBuffer
 	/// Returns the image pointer, or nullptr if the buffer is empty (see isEmpty()).
 	public: SampleType *get()
 	{
+		if (mMode == CircularImageBufferModeLockFree) return getLockFree();
+
 		if (isEmpty()) return nullptr;
 
 		// Grab the image - this is what we'll return
@@ -218,10 +288,10 @@ class CircularImageBuffer
 		mCount -= 1;
 		assert(count() >= 0);
 
-		// If we're empty, reset the buffer
+		// If we're empty, reset the buffer (we're already holding the lock)
 		if (isEmpty())
 		{
-			reset();
+			resetIndices();
 		}
 		// Not empty, move to the next get position
 		else
@@ -242,10 +312,87 @@ class CircularImageBuffer
 	/// If you intend to hold the data for long, copy it to a buffer in order to release the lock.
 	public: SampleType *peek() const
 	{
+		if (mMode == CircularImageBufferModeLockFree)
+		{
+			// The producer never writes to the oldest unread slot, so this is safe without holding it
+			unsigned int tail = mTail.load(std::memory_order_relaxed);
+			if (mConsumerHoldsImage) tail = ringNext(tail);
+			if (ringCount(mHead.load(std::memory_order_acquire), tail) == 0) return nullptr;
+			return mCircularBuffer[tail % capacity()];
+		}
+
 		if (isEmpty()) return nullptr;
 		return mCircularBuffer[mNextGetIndex];
 	}
 
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Lock-free buffer management
+	//
+	// The ring indices run from 0 to (2 * capacity - 1), so that full (head - tail == capacity) and empty (head == tail) states
+	// can be told apart without a shared count. Only the producer writes `mHead` and only the consumer writes `mTail`.
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Returns the ring index following `index`
+	private: unsigned int ringNext(unsigned int index) const
+	{
+		return (index + 1) % (2 * static_cast<unsigned int>(capacity()));
+	}
+
+	/// Returns the number of images between the `tail` and `head` ring indices
+	private: int ringCount(unsigned int head, unsigned int tail) const
+	{
+		unsigned int span = 2 * static_cast<unsigned int>(capacity());
+		return static_cast<int>((head + span - tail) % span);
+	}
+
+	/// Producer side of `add()` for lock-free mode
+	private: void addLockFree(SampleType *image)
+	{
+		assert(capacity() > 0);
+		if (capacity() == 0) { return; }
+
+		mStatFramesAdded.fetch_add(1, std::memory_order_relaxed);
+
+		unsigned int head = mHead.load(std::memory_order_relaxed);
+		unsigned int tail = mTail.load(std::memory_order_acquire);
+		if (ringCount(head, tail) == capacity())
+		{
+			// The consumer has fallen behind (or is holding the oldest image); drop this one
+			mStatFramesSkipped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		memcpy(mCircularBuffer[head % capacity()], image, width() * height() * sizeof(SampleType));
+
+		// Publish the image to the consumer
+		mHead.store(ringNext(head), std::memory_order_release);
+	}
+
+	/// Consumer side of `get()` for lock-free mode
+	///
+	/// The returned image is held by the consumer until `unlock()` or the next `get()`
+	private: SampleType *getLockFree()
+	{
+		releaseHeldImage();
+
+		unsigned int tail = mTail.load(std::memory_order_relaxed);
+		unsigned int head = mHead.load(std::memory_order_acquire);
+		if (ringCount(head, tail) == 0) return nullptr;
+
+		mStatFramesRead.fetch_add(1, std::memory_order_relaxed);
+		mConsumerHoldsImage = true;
+		return mCircularBuffer[tail % capacity()];
+	}
+
+	/// Returns the image held by the consumer (if any) to the producer
+	private: void releaseHeldImage()
+	{
+		if (!mConsumerHoldsImage) return;
+
+		mConsumerHoldsImage = false;
+		mTail.store(ringNext(mTail.load(std::memory_order_relaxed)), std::memory_order_release);
+	}
+
 	// -----------------------------------------------------------------------------------------------------------------------------
 	// Utilitarian
 	// -----------------------------------------------------------------------------------------------------------------------------
@@ -256,23 +403,37 @@ class CircularImageBuffer
 	/// that represent an empty buffer.
 	///
 	/// NOTE: This method does not reset statistics. For that, see `resetStats()`.
+	///
+	/// In lock-free mode, this must not be called while the producer is active.
 	public: void reset()
 	{
+		if (mMode == CircularImageBufferModeLockFree)
+		{
+			mConsumerHoldsImage = false;
+			mHead.store(0, std::memory_order_relaxed);
+			mTail.store(0, std::memory_order_release);
+			return;
+		}
+
 		mMutex.lock();
+		resetIndices();
+		mMutex.unlock();
+	}
+
+	/// Resets the locked-mode indices to the empty state (the caller must hold the lock)
+	private: void resetIndices()
+	{
 		mCount = 0;
 		mNextAddIndex = 0;
 		mNextGetIndex = -1;
-		mMutex.unlock();
 	}
 
 	/// Reset our tracked statistics
 	public: void resetStats()
 	{
-		mMutex.lock();
-		mStatFramesAdded = 0;
-		mStatFramesRead = 0;
-		mStatFramesSkipped = 0;
-		mMutex.unlock();
+		mStatFramesAdded.store(0, std::memory_order_relaxed);
+		mStatFramesRead.store(0, std::memory_order_relaxed);
+		mStatFramesSkipped.store(0, std::memory_order_relaxed);
 	}
 
 	// -----------------------------------------------------------------------------------------------------------------------------
@@ -286,18 +447,21 @@ class CircularImageBuffer
 	private: unsigned int mHeight;
 
 	/// Tracks the total number of frames we've added to the buffer
-	private: unsigned int mStatFramesAdded;
+	private: std::atomic<unsigned int> mStatFramesAdded;
 
 	/// Tracks the total number of frames we've read from the buffer
-	private: unsigned int mStatFramesRead;
+	private: std::atomic<unsigned int> mStatFramesRead;
 
 	/// Tracks the total number of frames we've lost (we fell behind)
-	private: unsigned int mStatFramesSkipped;
+	private: std::atomic<unsigned int> mStatFramesSkipped;
+
+	/// Our synchronization mode
+	private: CircularImageBufferMode mMode;
 
 	/// Storage for our buffer of images
 	private: CircularBufferType mCircularBuffer;
 
-	/// Returns the total number of images in the buffer
+	/// Returns the total number of images in the buffer (locked mode only)
 	private: int mCount;
 
 	/// The next image to be added to the buffer will go into this index
@@ -308,13 +472,18 @@ class CircularImageBuffer
 	/// Note that this value can be -1 if there are no images in the buffer
 	private: int mNextGetIndex;
 
-	/// Our mutex for thread safety
-	///
-	/// LIMITATION: There is only one of these for all CircularImageBuffer objects
-	private: static Mutex mMutex;
-};
+	/// Our mutex for thread safety (locked mode only)
+	private: mutable Mutex mMutex;
 
-/// Our single mutex for the circular image buffer
-template<class SampleType> Mutex CircularImageBuffer<SampleType>::mMutex = Mutex("CircularImageBuffer");
+	/// Lock-free mode: the producer's ring index (next slot to write)
+	private: char mPadBeforeHead[kCacheLineSize];
+	private: std::atomic<unsigned int> mHead;
 
-#endif // defined(USE_MMAL)
+	/// Lock-free mode: the consumer's ring index (oldest unread slot)
+	private: char mPadBeforeTail[kCacheLineSize - sizeof(std::atomic<unsigned int>)];
+	private: std::atomic<unsigned int> mTail;
+
+	/// Lock-free mode: true while the consumer holds the image at the tail (consumer thread only)
+	private: bool mConsumerHoldsImage;
+	private: char mPadAfterTail[kCacheLineSize];
+};
@@ -0,0 +1,61 @@
+//
+//  CpuFeatures.cpp
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#include "CpuFeatures.h"
+
+#if defined(__linux__) && defined(__arm__)
+	#include <sys/auxv.h>
+	#include <asm/hwcap.h>
+#endif // defined(__linux__) && defined(__arm__)
+
+/// Returns true if the host CPU supports the SSE2 instruction set
+///
+/// This is always false for non-x86 builds
+bool cpuHasSse2()
+{
+#if defined(__x86_64__)
+	// SSE2 is part of the x86-64 baseline
+	return true;
+#elif defined(__i386__)
+	return __builtin_cpu_supports("sse2");
+#else
+	return false;
+#endif
+}
+
+/// Returns true if the host CPU (and OS) supports the AVX2 instruction set
+///
+/// This is always false for non-x86 builds
+bool cpuHasAvx2()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_cpu_supports("avx2");
+#else
+	return false;
+#endif
+}
+
+/// Returns true if the host CPU supports the ARM NEON (Advanced SIMD) instruction set
+///
+/// This is always false for non-ARM builds, as well as for ARM builds that were not compiled with NEON support
+bool cpuHasNeon()
+{
+#if defined(__aarch64__)
+	// Advanced SIMD is mandatory on ARMv8
+	return true;
+#elif defined(__arm__) && defined(__ARM_NEON) && defined(__linux__)
+	// 32-bit ARM (the Pi Zero's ARMv6 has no NEON unit, the Pi 2/3 in 32-bit mode do)
+	return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,28 @@
+//
+//  CpuFeatures.h
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#pragma once
+
+/// Returns true if the host CPU supports the SSE2 instruction set
+///
+/// This is always false for non-x86 builds
+bool cpuHasSse2();
+
+/// Returns true if the host CPU (and OS) supports the AVX2 instruction set
+///
+/// This is always false for non-x86 builds
+bool cpuHasAvx2();
+
+/// Returns true if the host CPU supports the ARM NEON (Advanced SIMD) instruction set
+///
+/// This is always false for non-ARM builds, as well as for ARM builds that were not compiled with NEON support
+bool cpuHasNeon();
@@ -0,0 +1,260 @@
+//
+//  EdgeDetection.cpp
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+
+#include "EdgeDetection.h"
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Local types
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Per-thread scratch space for the rolling min/max, so that edge detection doesn't allocate on every line
+struct EdgeDetectionScratch
+{
+	std::vector<NativeMinMax> suffixMinMax;
+
+	/// Returns the scratch space for the calling thread
+	static EdgeDetectionScratch &local()
+	{
+		static thread_local EdgeDetectionScratch scratch;
+		return scratch;
+	}
+};
+
+/// The slopes between two rolling sums of `window` samples, `offset` samples apart, stepped along the samples one at a time
+///
+/// This also tracks the min/max of every sample it has read, which (once it has stepped to the end) is that of the whole line.
+struct EdgeSlopes
+{
+	const int32_t *samples;
+	int32_t window;
+	int32_t offset;
+	int32_t index;
+	int32_t trailingSum;
+	int32_t leadingSum;
+	NativeMinMax minMax;
+
+	/// Sums the windows at the start of the samples
+	EdgeSlopes(const int32_t *samples, int32_t window, int32_t offset)
+		: samples(samples), window(window), offset(offset), index(0), trailingSum(0), leadingSum(0)
+	{
+		minMax.min = minMax.max = samples[0];
+		for (int32_t i = 0; i < offset + window; ++i)
+		{
+			if (i < window) trailingSum += samples[i];
+			if (i >= offset) leadingSum += samples[i];
+			track(samples[i]);
+		}
+	}
+
+	/// Returns the slope at `index`
+	int32_t slope() const
+	{
+		return leadingSum - trailingSum;
+	}
+
+	/// Rolls both sums forward one sample
+	void step()
+	{
+		int32_t entering = samples[index + offset + window];
+		trailingSum += samples[index + window] - samples[index];
+		leadingSum += entering - samples[index + offset];
+		track(entering);
+		index += 1;
+	}
+
+	/// Includes `sample` in the min/max
+	void track(int32_t sample)
+	{
+		if (sample < minMax.min) minMax.min = sample;
+		if (minMax.max < sample) minMax.max = sample;
+	}
+};
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Local helpers
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Calculates the threshold for a range of samples, scaled by `scale` (see Seer's `EdgeDetection.calcThreshold()`)
+///
+/// The range is converted to FixedPoint, scaled by `sensitivity` and floored, exactly as the FixedPoint math does it.
+static inline int32_t calcThreshold(int32_t blackPoint, int32_t whitePoint, int32_t minThreshold, int32_t sensitivity, int32_t scale)
+{
+	int32_t sampleRange = static_cast<int32_t>(static_cast<uint32_t>(whitePoint - blackPoint) << 16);
+	int32_t threshold = static_cast<int32_t>((static_cast<int64_t>(sensitivity) * sampleRange) >> 16) >> 16;
+	return (threshold < minThreshold ? minThreshold : threshold) * scale;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Edge detection
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Detects the edges along `sampleCount` samples in a single pass, storing them into `dst` (see EdgeDetection.h)
+///
+/// The peaks are found exactly as Seer's `EdgeDetection.findPeaks()` finds them, from slopes calculated as the rolling sums
+/// step along the samples.
+///
+/// With a rolling min/max, each peak is thresholded as soon as it's found, using the van Herk/Gil-Werman decomposition of its
+/// min/max window. Peaks are found in order, so the windows only ever move forward and each sample is visited at most once
+/// more. Without a rolling min/max, the peaks are kept until the line's min/max is known and then thresholded in place.
+int32_t detectEdges(const int32_t *samples, uint32_t sampleCount, int32_t windowSize, int32_t minMaxWindowSize, int32_t overlap, int32_t sensitivity, int32_t minThreshold, NativeEdgePeak *dst)
+{
+	// We need at least one rolling sum, and enough of them for at least one slope
+	int32_t count = static_cast<int32_t>(sampleCount);
+	int32_t slopeOffset = windowSize - overlap;
+	if (windowSize < 0 || windowSize > count || slopeOffset < 0) return -1;
+
+	int32_t slopeCount = count - windowSize - slopeOffset;
+	if (slopeCount <= 0) return -1;
+
+	int32_t peakOffset = windowSize - 1 - overlap / 2;
+	bool rolling = minMaxWindowSize > 0;
+
+	// The rolling min/max windows: as in `rollMinMax()`, the last full window (ending at the last rolling sum) stands in for
+	// any that would run past it
+	uint32_t minMaxWindow = rolling ? std::min(static_cast<uint32_t>(minMaxWindowSize), sampleCount) : 1;
+	uint32_t sumCount = static_cast<uint32_t>(count - windowSize + 1);
+	uint32_t lastMinMaxWindow = sumCount > minMaxWindow ? sumCount - minMaxWindow : 0;
+	int32_t minMaxOffset = peakOffset - minMaxWindowSize / 2;
+
+	// The min/max of a window is that of its start to the end of its block (the suffix) and from the start of the next block to
+	// its end (the prefix), where blocks are the size of the window (see `rollMinMax()`.) Windows only move forward, so we only
+	// need the suffixes of one block at a time and a running prefix.
+	EdgeDetectionScratch &scratch = EdgeDetectionScratch::local();
+	scratch.suffixMinMax.resize(minMaxWindow);
+	NativeMinMax *suffix = scratch.suffixMinMax.data();
+	uint32_t suffixBlock = UINT32_MAX;
+	NativeMinMax prefix = { 0, 0 };
+	uint32_t prefixEnd = 0;
+
+	int32_t scaledMinThreshold = minThreshold * windowSize;
+	int32_t edgeCount = 0;
+
+	// Thresholds a peak as it's found (or keeps it for later, if we're not rolling the min/max)
+	auto addPeak = [&](int32_t slope, int32_t offset)
+	{
+		if (!rolling)
+		{
+			dst[edgeCount].slope = slope;
+			dst[edgeCount].sampleOffset = offset;
+			edgeCount += 1;
+			return;
+		}
+
+		// An early-out for most unusable peaks
+		int32_t absSlope = abs(slope);
+		if (absSlope < scaledMinThreshold) return;
+
+		int32_t index = offset + minMaxOffset;
+		uint32_t start = index < 0 ? 0 : std::min(static_cast<uint32_t>(index), lastMinMaxWindow);
+		uint32_t end = start + minMaxWindow - 1;
+
+		// Suffixes for the block holding the window's start
+		uint32_t blockStart = start - start % minMaxWindow;
+		if (blockStart != suffixBlock)
+		{
+			uint32_t i = minMaxWindow - 1;
+			NativeMinMax minMax = { samples[blockStart + i], samples[blockStart + i] };
+			suffix[i] = minMax;
+			while (i-- > 0)
+			{
+				int32_t sample = samples[blockStart + i];
+				minMax.min = std::min(minMax.min, sample);
+				minMax.max = std::max(minMax.max, sample);
+				suffix[i] = minMax;
+			}
+			suffixBlock = blockStart;
+		}
+
+		// Run the prefix up to the window's end, restarting it at the start of the end's block
+		uint32_t endBlockStart = end - end % minMaxWindow;
+		if (prefixEnd <= endBlockStart)
+		{
+			prefix.min = prefix.max = samples[endBlockStart];
+			prefixEnd = endBlockStart + 1;
+		}
+		for (; prefixEnd <= end; ++prefixEnd)
+		{
+			prefix.min = std::min(prefix.min, samples[prefixEnd]);
+			prefix.max = std::max(prefix.max, samples[prefixEnd]);
+		}
+
+		const NativeMinMax &startMinMax = suffix[start - blockStart];
+		int32_t threshold = calcThreshold(std::min(startMinMax.min, prefix.min), std::max(startMinMax.max, prefix.max), minThreshold, sensitivity, windowSize);
+		if (absSlope >= threshold)
+		{
+			dst[edgeCount].slope = slope;
+			dst[edgeCount].sampleOffset = offset + peakOffset;
+			dst[edgeCount].threshold = threshold;
+			edgeCount += 1;
+		}
+	};
+
+	// Find the peaks (see Seer's `EdgeDetection.findPeaks()` for the details of which index is kept for each)
+	EdgeSlopes slopes(samples, windowSize, slopeOffset);
+	while (slopes.index < slopeCount)
+	{
+		int32_t maxSlope = slopes.slope();
+		int32_t maxSlopeIndex = slopes.index;
+		slopes.step();
+
+		if (maxSlope >= 0)
+		{
+			// Leaving a mark (keeping the first of duplicates, at the last sample of the mark)
+			while (slopes.index < slopeCount)
+			{
+				int32_t slope = slopes.slope();
+				if (slope <= 0) break;
+
+				if (slope > maxSlope) { maxSlope = slope; maxSlopeIndex = slopes.index; }
+				slopes.step();
+			}
+		}
+		else
+		{
+			// Entering a mark (keeping the last of duplicates, at the first sample of the mark)
+			while (slopes.index < slopeCount)
+			{
+				int32_t slope = slopes.slope();
+				if (slope >= 0) break;
+
+				slopes.step();
+				if (slope <= maxSlope) { maxSlope = slope; maxSlopeIndex = slopes.index; }
+			}
+		}
+
+		addPeak(maxSlope, maxSlopeIndex);
+	}
+
+	if (rolling) return edgeCount;
+
+	// Threshold the peaks against the whole line, in place
+	int32_t threshold = calcThreshold(slopes.minMax.min, slopes.minMax.max, minThreshold, sensitivity, windowSize);
+	int32_t peakCount = edgeCount;
+	edgeCount = 0;
+	for (int32_t i = 0; i < peakCount; ++i)
+	{
+		if (abs(dst[i].slope) >= threshold)
+		{
+			dst[edgeCount].slope = dst[i].slope;
+			dst[edgeCount].sampleOffset = dst[i].sampleOffset + peakOffset;
+			dst[edgeCount].threshold = threshold;
+			edgeCount += 1;
+		}
+	}
+
+	return edgeCount;
+}
@@ -0,0 +1,30 @@
+//
+//  EdgeDetection.h
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#pragma once
+
+#include <stdint.h>
+#include "include/NativeTaskTypes.h"
+
+/// Detects the edges along `sampleCount` samples in a single pass, storing them into `dst`
+///
+/// This produces exactly the edges of Seer's multi-pass `EdgeDetection.detectEdges()`: rolling sums over `windowSize` samples,
+/// the peaks of the slopes between sums `windowSize - overlap` apart, then thresholding of each peak against the range of the
+/// samples (the rolling min/max over `minMaxWindowSize` samples around the peak, or the whole line if `minMaxWindowSize` is 0.)
+/// Both window sizes must already be scaled to the image. `sensitivity` is a FixedPoint value (16 fractional bits) and
+/// `minThreshold` is the unscaled minimum threshold.
+///
+/// The sums and slopes are never stored (nor more than a window of the rolling min/max) and peaks are thresholded as they're found.
+/// `dst` must hold at least `sampleCount` peaks, as it also holds the unthresholded peaks when thresholding against the whole line.
+///
+/// Returns the number of edges stored, or -1 if there are too few samples to find any peaks
+int32_t detectEdges(const int32_t *samples, uint32_t sampleCount, int32_t windowSize, int32_t minMaxWindowSize, int32_t overlap, int32_t sensitivity, int32_t minThreshold, NativeEdgePeak *dst);
@@ -0,0 +1,435 @@
+//
+//  ErrorCorrection.cpp
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+#include "ErrorCorrection.h"
+#include "CpuFeatures.h"
+#include "Logger.h"
+
+using namespace std;
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Local types
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// The header at the start of every error correction table, whether stored in a file or in private memory
+///
+/// The table's entries immediately follow the header. The header has no padding, so that it can be compared as a whole.
+struct ErrorCorrectionHeader
+{
+	/// Always `kErrorCorrectionMagic`
+	char magic[4];
+
+	/// The version of the table's format and contents (see `kErrorCorrectionVersion`)
+	uint32_t version;
+
+	/// A hash of the codes the table was built from (see `hashCodes()`)
+	uint64_t formatHash;
+
+	/// The number of bits in each code
+	uint32_t bitCount;
+
+	/// The number of codes
+	uint32_t codeCount;
+
+	/// The size of the table in bytes, including this header
+	uint64_t mapSize;
+};
+
+static_assert(sizeof(ErrorCorrectionHeader) == 32, "ErrorCorrectionHeader must not contain padding");
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Local constants
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Identifies an error correction table
+static const char kErrorCorrectionMagic[4] = { 'N', 'M', 'E', 'C' };
+
+/// Increment this when the format or contents of the tables change, so that stored tables are rebuilt
+static const uint32_t kErrorCorrectionVersion = 1;
+
+/// The fewest values worth handing to a thread of their own
+static const uint64_t kErrorCorrectionMinValuesPerThread = 1 << 14;
+
+/// The number of codes in each block of pairs compared by `calcMinimumDistance()` (8 bytes each, so a block stays in L1)
+static const uint32_t kMinimumDistanceBlockSize = 256;
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Local helpers
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Returns a 64-bit FNV-1a hash of the codes and their bit count
+static uint64_t hashCodes(const int64_t *codes, uint32_t codeCount, uint32_t bitCount)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	auto add = [&hash](uint64_t value)
+	{
+		for (int i = 0; i < 8; ++i)
+		{
+			hash ^= (value >> (i * 8)) & 0xff;
+			hash *= 0x100000001b3ull;
+		}
+	};
+
+	add(bitCount);
+	add(codeCount);
+	for (uint32_t i = 0; i < codeCount; ++i)
+	{
+		add(static_cast<uint64_t>(codes[i]));
+	}
+
+	return hash;
+}
+
+/// Creates `directory` along with any missing parents
+///
+/// Returns true if the directory exists on return
+static bool createDirectory(const string &directory)
+{
+	for (size_t end = directory.find('/', 1); ; end = directory.find('/', end + 1))
+	{
+		string path = directory.substr(0, end);
+		if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) return false;
+		if (end == string::npos) break;
+	}
+
+	struct stat info;
+	return stat(directory.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+/// Returns true if the POPCNT instruction can be used (see `buildRangePopcnt()`)
+static bool hasPopcnt()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	// Every CPU with AVX2 also has POPCNT
+	return cpuHasAvx2();
+#else
+	return false;
+#endif
+}
+
+/// Returns the table within a mapping, which follows its header
+static const int16_t *tableFromMapping(const void *base)
+{
+	return reinterpret_cast<const int16_t *>(reinterpret_cast<const uint8_t *>(base) + sizeof(ErrorCorrectionHeader));
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Table building
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Stores the table entries for the values in [`first`, `last`) into `dst`
+///
+/// Ties are tracked as they're found, rather than marked in the table and cleaned up later; the result is the same.
+__attribute__((always_inline)) static inline void buildRange(const int64_t *codes, uint32_t codeCount, uint32_t bitCount, uint64_t first, uint64_t last, int16_t *dst)
+{
+	for (uint64_t value = first; value < last; ++value)
+	{
+		int32_t bestDistance = static_cast<int32_t>(bitCount);
+		int32_t bestIndex = -1;
+		bool collision = false;
+
+		for (uint32_t i = 0; i < codeCount; ++i)
+		{
+			int32_t distance = __builtin_popcountll(value ^ static_cast<uint64_t>(codes[i]));
+			if (distance < bestDistance)
+			{
+				bestDistance = distance;
+				bestIndex = static_cast<int32_t>(i);
+				collision = false;
+			}
+			else if (distance == bestDistance)
+			{
+				collision = true;
+			}
+		}
+
+		dst[value] = static_cast<int16_t>(collision ? -1 : bestIndex);
+	}
+}
+
+/// Builds a range of the table with the popcount builtin for the target architecture
+static void buildRangeGeneric(const int64_t *codes, uint32_t codeCount, uint32_t bitCount, uint64_t first, uint64_t last, int16_t *dst)
+{
+	buildRange(codes, codeCount, bitCount, first, last, dst);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/// Builds a range of the table with the POPCNT instruction (the generic builtin is a bit-twiddling sequence on baseline x86)
+__attribute__((target("popcnt"))) static void buildRangePopcnt(const int64_t *codes, uint32_t codeCount, uint32_t bitCount, uint64_t first, uint64_t last, int16_t *dst)
+{
+	buildRange(codes, codeCount, bitCount, first, last, dst);
+}
+#endif
+
+/// Builds the error correction table (see ErrorCorrection.h)
+void buildErrorCorrectionTable(const int64_t *codes, uint32_t codeCount, uint32_t bitCount, int16_t *dst, unsigned int threadCount)
+{
+	void (*build)(const int64_t *, uint32_t, uint32_t, uint64_t, uint64_t, int16_t *) = buildRangeGeneric;
+#if defined(__x86_64__) || defined(__i386__)
+	if (hasPopcnt()) build = buildRangePopcnt;
+#endif
+
+	uint64_t valueCount = uint64_t(1) << bitCount;
+	if (threadCount == 0) threadCount = max(thread::hardware_concurrency(), 1u);
+	threadCount = static_cast<unsigned int>(min(static_cast<uint64_t>(threadCount), max(valueCount / kErrorCorrectionMinValuesPerThread, uint64_t(1))));
+
+	// Split the values into contiguous ranges, one per thread, with the calling thread taking the last
+	vector<thread> threads;
+	uint64_t valuesPerThread = valueCount / threadCount;
+	for (unsigned int i = 0; i + 1 < threadCount; ++i)
+	{
+		threads.push_back(thread(build, codes, codeCount, bitCount, i * valuesPerThread, (i + 1) * valuesPerThread, dst));
+	}
+
+	build(codes, codeCount, bitCount, (threadCount - 1) * valuesPerThread, valueCount, dst);
+
+	for (thread &worker : threads)
+	{
+		worker.join();
+	}
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Code analysis
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Returns the minimum distance between the codes, or 0 if it falls below `floor` (see ErrorCorrection.h)
+///
+/// Pairs are compared a block of rows against a block of columns at a time (upper triangle only), so that the columns stay in
+/// cache for every row of the block.
+__attribute__((always_inline)) static inline int32_t minimumDistance(const int64_t *codes, uint32_t codeCount, uint32_t codeBits, int32_t floor)
+{
+	int32_t mds = static_cast<int32_t>(codeBits);
+	for (uint32_t rowBlock = 0; rowBlock < codeCount; rowBlock += kMinimumDistanceBlockSize)
+	{
+		uint32_t rowEnd = min(rowBlock + kMinimumDistanceBlockSize, codeCount);
+		for (uint32_t colBlock = rowBlock; colBlock < codeCount; colBlock += kMinimumDistanceBlockSize)
+		{
+			uint32_t colEnd = min(colBlock + kMinimumDistanceBlockSize, codeCount);
+			for (uint32_t row = rowBlock; row < rowEnd; ++row)
+			{
+				uint64_t code = static_cast<uint64_t>(codes[row]);
+				for (uint32_t col = colBlock == rowBlock ? row + 1 : colBlock; col < colEnd; ++col)
+				{
+					mds = min(mds, __builtin_popcountll(code ^ static_cast<uint64_t>(codes[col])));
+				}
+			}
+
+			if (mds < floor) return 0;
+		}
+	}
+
+	return mds;
+}
+
+/// Returns the minimum distance with the popcount builtin for the target architecture
+static int32_t minimumDistanceGeneric(const int64_t *codes, uint32_t codeCount, uint32_t codeBits, int32_t floor)
+{
+	return minimumDistance(codes, codeCount, codeBits, floor);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/// Returns the minimum distance with the POPCNT instruction
+__attribute__((target("popcnt"))) static int32_t minimumDistancePopcnt(const int64_t *codes, uint32_t codeCount, uint32_t codeBits, int32_t floor)
+{
+	return minimumDistance(codes, codeCount, codeBits, floor);
+}
+#endif
+
+/// Returns the minimum distance between the codes, or 0 if it falls below `floor` (see ErrorCorrection.h)
+int32_t calcMinimumDistance(const int64_t *codes, uint32_t codeCount, uint32_t codeBits, int32_t floor)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	if (hasPopcnt()) return minimumDistancePopcnt(codes, codeCount, codeBits, floor);
+#endif
+	return minimumDistanceGeneric(codes, codeCount, codeBits, floor);
+}
+
+/// Stores the histogram of bits set in the masked codes (see ErrorCorrection.h)
+__attribute__((always_inline)) static inline void binaryHistogram(const int64_t *codes, uint32_t codeCount, int64_t mask, uint32_t bitCount, int32_t *dst)
+{
+	uint64_t bits = bitCount >= 64 ? ~uint64_t(0) : (uint64_t(1) << bitCount) - 1;
+	uint64_t masked = static_cast<uint64_t>(mask);
+
+	memset(dst, 0, (bitCount + 1) * sizeof(int32_t));
+	for (uint32_t i = 0; i < codeCount; ++i)
+	{
+		dst[__builtin_popcountll((static_cast<uint64_t>(codes[i]) ^ masked) & bits)] += 1;
+	}
+}
+
+/// Stores the histogram with the popcount builtin for the target architecture
+static void binaryHistogramGeneric(const int64_t *codes, uint32_t codeCount, int64_t mask, uint32_t bitCount, int32_t *dst)
+{
+	binaryHistogram(codes, codeCount, mask, bitCount, dst);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/// Stores the histogram with the POPCNT instruction
+__attribute__((target("popcnt"))) static void binaryHistogramPopcnt(const int64_t *codes, uint32_t codeCount, int64_t mask, uint32_t bitCount, int32_t *dst)
+{
+	binaryHistogram(codes, codeCount, mask, bitCount, dst);
+}
+#endif
+
+/// Stores the histogram of bits set in the masked codes (see ErrorCorrection.h)
+void calcBinaryHistogram(const int64_t *codes, uint32_t codeCount, int64_t mask, uint32_t bitCount, int32_t *dst)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	if (hasPopcnt()) return binaryHistogramPopcnt(codes, codeCount, mask, bitCount, dst);
+#endif
+	binaryHistogramGeneric(codes, codeCount, mask, bitCount, dst);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Table storage
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Maps the table stored at `path`, if it matches `header`
+///
+/// Returns null if the file is missing or doesn't match
+static const int16_t *mapStoredTable(const string &path, const ErrorCorrectionHeader &header)
+{
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) return nullptr;
+
+	void *base = MAP_FAILED;
+	struct stat info;
+	if (fstat(fd, &info) == 0 && static_cast<uint64_t>(info.st_size) == header.mapSize)
+	{
+		base = mmap(nullptr, header.mapSize, PROT_READ, MAP_SHARED, fd, 0);
+	}
+	close(fd);
+
+	if (base == MAP_FAILED) return nullptr;
+
+	if (memcmp(base, &header, sizeof(header)) != 0)
+	{
+		munmap(base, header.mapSize);
+		return nullptr;
+	}
+
+	return tableFromMapping(base);
+}
+
+/// Builds the table into a new file at `path`, mapping it
+///
+/// The table is built into a temporary file that is renamed into place once complete, so other processes only ever see a
+/// complete table. Returns null if the file couldn't be written.
+static const int16_t *buildStoredTable(const string &path, const ErrorCorrectionHeader &header, const int64_t *codes)
+{
+	string tempPath = path + "." + to_string(getpid()) + ".tmp";
+	int fd = open(tempPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) return nullptr;
+
+	void *base = MAP_FAILED;
+	if (ftruncate(fd, static_cast<off_t>(header.mapSize)) == 0)
+	{
+		base = mmap(nullptr, header.mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	close(fd);
+
+	if (base == MAP_FAILED)
+	{
+		unlink(tempPath.c_str());
+		return nullptr;
+	}
+
+	buildErrorCorrectionTable(codes, header.codeCount, header.bitCount, const_cast<int16_t *>(tableFromMapping(base)), 0);
+	memcpy(base, &header, sizeof(header));
+	mprotect(base, header.mapSize, PROT_READ);
+
+	if (rename(tempPath.c_str(), path.c_str()) != 0)
+	{
+		munmap(base, header.mapSize);
+		unlink(tempPath.c_str());
+		return nullptr;
+	}
+
+	return tableFromMapping(base);
+}
+
+/// Builds the table into private memory
+///
+/// Returns null if the memory couldn't be allocated
+static const int16_t *buildPrivateTable(const ErrorCorrectionHeader &header, const int64_t *codes)
+{
+	void *base = mmap(nullptr, header.mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (base == MAP_FAILED) return nullptr;
+
+	buildErrorCorrectionTable(codes, header.codeCount, header.bitCount, const_cast<int16_t *>(tableFromMapping(base)), 0);
+	memcpy(base, &header, sizeof(header));
+	mprotect(base, header.mapSize, PROT_READ);
+	return tableFromMapping(base);
+}
+
+/// Returns the error correction table, mapped read-only into memory (see ErrorCorrection.h)
+const int16_t *openErrorCorrectionTable(const char *directory, const int64_t *codes, uint32_t codeCount, uint32_t bitCount)
+{
+	if (nullptr == codes || codeCount == 0 || codeCount > kErrorCorrectionMaxCodeCount) return nullptr;
+	if (bitCount == 0 || bitCount > kErrorCorrectionMaxBitCount) return nullptr;
+
+	ErrorCorrectionHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, kErrorCorrectionMagic, sizeof(header.magic));
+	header.version = kErrorCorrectionVersion;
+	header.formatHash = hashCodes(codes, codeCount, bitCount);
+	header.bitCount = bitCount;
+	header.codeCount = codeCount;
+	header.mapSize = sizeof(header) + (uint64_t(1) << bitCount) * sizeof(int16_t);
+
+	if (nullptr == directory || 0 == directory[0])
+	{
+		return buildPrivateTable(header, codes);
+	}
+
+	char filename[64];
+	snprintf(filename, sizeof(filename), "/ec-%u-%016llx.table", bitCount, static_cast<unsigned long long>(header.formatHash));
+	string path = string(directory) + filename;
+
+	const int16_t *table = mapStoredTable(path, header);
+	if (table) return table;
+
+	if (createDirectory(directory))
+	{
+		table = buildStoredTable(path, header, codes);
+		if (table)
+		{
+			Logger::info(SSTR << "Built error correction table: " << path);
+			return table;
+		}
+	}
+
+	Logger::warn(SSTR << "Unable to store error correction table (building it in memory): " << path);
+	return buildPrivateTable(header, codes);
+}
+
+/// Releases a table returned by `openErrorCorrectionTable()`
+void closeErrorCorrectionTable(const int16_t *table)
+{
+	if (nullptr == table) return;
+
+	const ErrorCorrectionHeader *header = reinterpret_cast<const ErrorCorrectionHeader *>(reinterpret_cast<const uint8_t *>(table) - sizeof(ErrorCorrectionHeader));
+	munmap(const_cast<ErrorCorrectionHeader *>(header), header->mapSize);
+}
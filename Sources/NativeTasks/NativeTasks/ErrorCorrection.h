@@ -0,0 +1,56 @@
+//
+//  ErrorCorrection.h
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#pragma once
+
+#include <stdint.h>
+
+/// The largest code (in bits) supported by the error correction tables
+const uint32_t kErrorCorrectionMaxBitCount = 30;
+
+/// The largest number of codes supported by the error correction tables (indices are stored as `int16_t`)
+const uint32_t kErrorCorrectionMaxCodeCount = 32767;
+
+/// Builds the error correction table for `codeCount` codes of `bitCount` bits each, storing one entry for each of the
+/// `1 << bitCount` possible values into `dst`
+///
+/// Each entry is the index of the code nearest (by Hamming Distance) to the value, or -1 if two or more codes are equally near.
+/// Values that are `bitCount` bits away from their nearest code are also -1. This matches the maps of Seer's original
+/// `HammingDistance.calcErrorCorrectedMaps()`.
+///
+/// The values are split across `threadCount` threads (0 for one per CPU.)
+void buildErrorCorrectionTable(const int64_t *codes, uint32_t codeCount, uint32_t bitCount, int16_t *dst, unsigned int threadCount);
+
+/// Returns the error correction table for `codeCount` codes of `bitCount` bits each, mapped read-only into memory
+///
+/// Tables are stored in `directory`, keyed by a hash of the codes, so that they are only built once and their pages are shared
+/// by every process that maps them. A table that is missing, stale or from another version is (re)built and stored. If
+/// `directory` is null or empty, or the table can't be stored, it is built into private memory instead.
+///
+/// Returns null if the codes are unsupported (see `kErrorCorrectionMaxBitCount` and `kErrorCorrectionMaxCodeCount`.) The table
+/// must be released with `closeErrorCorrectionTable()`.
+const int16_t *openErrorCorrectionTable(const char *directory, const int64_t *codes, uint32_t codeCount, uint32_t bitCount);
+
+/// Releases a table returned by `openErrorCorrectionTable()` (does nothing if `table` is null)
+void closeErrorCorrectionTable(const int16_t *table);
+
+/// Returns the minimum Hamming Distance between any two of `codeCount` codes of `codeBits` bits each (at most `codeBits`), or 0
+/// if it falls below `floor`
+///
+/// This matches Seer's original `HammingDistance.calcMinimumDistance()`. The pairs are compared in blocks that stay in cache, and
+/// the comparison ends as soon as the distance falls below `floor`.
+int32_t calcMinimumDistance(const int64_t *codes, uint32_t codeCount, uint32_t codeBits, int32_t floor);
+
+/// Stores the number of codes with each number of bits set, after XORing each of `codeCount` codes with `mask`, into `dst`
+///
+/// `dst` must hold `bitCount + 1` counts. Only the lower `bitCount` bits of each masked code are counted.
+void calcBinaryHistogram(const int64_t *codes, uint32_t codeCount, int64_t mask, uint32_t bitCount, int32_t *dst);
@@ -10,14 +10,24 @@
 // Use of this source code is governed by a BSD-style license that can be found
 // in the LICENSE file in the root of the source tree.
 
+#include <string.h>
 #include <algorithm>
+#include <atomic>
 #include "FastImage.h"
+#include "FastImageCommon.h"
+#include "CpuFeatures.h"
 #include "Logger.h"
 
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Scalar reference kernels
+//
+// These are the reference implementations. All other kernels must produce bit-exact results with these.
+// ---------------------------------------------------------------------------------------------------------------------------------
+
 /// Copies image `src` (2vuy) to `dst` image (8-bit monochrome)
 ///
 /// Note that both `src` is a 16-bit format and must contain at least `width` * `height` * `2` elements, while `dst` must contain at least `width` * `height` elements
-void copy2vuyToLuma(const NativeLumaBuffer src, NativeLumaBuffer dst, uint32_t width, uint32_t height)
+static void copy2vuyToLumaScalar(const NativeLumaBuffer src, NativeLumaBuffer dst, uint32_t width, uint32_t height)
 {
 	uint32_t count = width * height;
 	for (uint32_t i = 0; i < count; ++i)
@@ -29,7 +39,7 @@ void copy2vuyToLuma(const NativeLumaBuffer src, NativeLumaBuffer dst, uint32_t w
 /// Copies image `src` (8-bit monochrome) to `dst` image (32-bit ARGB) with 8-bit -> 32-bit monochrome conversion
 ///
 /// Note that both `src` and `dst` must contain at least `width` * `height` elements each
-void copyLumaToColor(const NativeLumaBuffer src, NativeColorBuffer dst, uint32_t width, uint32_t height)
+static void copyLumaToColorScalar(const NativeLumaBuffer src, NativeColorBuffer dst, uint32_t width, uint32_t height)
 {
 	uint32_t count = width * height;
 	for (uint32_t i = 0; i < count; ++i)
@@ -42,7 +52,7 @@ void copyLumaToColor(const NativeLumaBuffer src, NativeColorBuffer dst, uint32_t
 /// Copies image `src` (32-bit ARGB) to `dst` image (8-bit monochrome) with 32-bit -> 8-bit monochrome conversion
 ///
 /// Note that both `src` and `dst` must contain at least `width` * `height` elements each
-void copyColorToLuma(const NativeColorBuffer src, NativeLumaBuffer dst, uint32_t width, uint32_t height)
+static void copyColorToLumaScalar(const NativeColorBuffer src, NativeLumaBuffer dst, uint32_t width, uint32_t height)
 {
 	uint32_t count = width * height;
 	for (uint32_t i = 0; i < count; ++i)
@@ -53,7 +63,7 @@ void copyColorToLuma(const NativeColorBuffer src, NativeLumaBuffer dst, uint32_t
 }
 
 /// Resamples 8-bit monochrome image `src` to `dst` with nearest-neighbor sampling
-void resampleNearestNeighborLuma(const NativeLumaBuffer src, uint32_t srcWidth, uint32_t srcHeight, NativeLumaBuffer dst, uint32_t dstWidth, uint32_t dstHeight)
+static void resampleNearestNeighborLumaScalar(const NativeLumaBuffer src, uint32_t srcWidth, uint32_t srcHeight, NativeLumaBuffer dst, uint32_t dstWidth, uint32_t dstHeight)
 {
 	// FixedPoint scale
 	const int kFixedShift = 16;
@@ -77,7 +87,7 @@ void resampleNearestNeighborLuma(const NativeLumaBuffer src, uint32_t srcWidth,
 }
 
 /// Resamples 32-bit Color image `src` to `dst` with nearest-neighbor sampling
-void resampleNearestNeighborColor(const NativeColorBuffer src, uint32_t srcWidth, uint32_t srcHeight, NativeColorBuffer dst, uint32_t dstWidth, uint32_t dstHeight)
+static void resampleNearestNeighborColorScalar(const NativeColorBuffer src, uint32_t srcWidth, uint32_t srcHeight, NativeColorBuffer dst, uint32_t dstWidth, uint32_t dstHeight)
 {
 	// FixedPoint scale
 	const int kFixedShift = 16;
@@ -101,7 +111,7 @@ void resampleNearestNeighborColor(const NativeColorBuffer src, uint32_t srcWidth
 }
 
 /// Resamples 8-bit monochrome image `src` to `dst` with fast estimation linear interpolation sampling
-void resampleLerpFastLuma(const NativeLumaBuffer src, uint32_t srcWidth, uint32_t srcHeight, NativeLumaBuffer dst, uint32_t dstWidth, uint32_t dstHeight)
+static void resampleLerpFastLumaScalar(const NativeLumaBuffer src, uint32_t srcWidth, uint32_t srcHeight, NativeLumaBuffer dst, uint32_t dstWidth, uint32_t dstHeight)
 {
 	// FixedPoint scale
 	const int kFixedShift = 16;
@@ -146,7 +156,7 @@ void resampleLerpFastLuma(const NativeLumaBuffer src, uint32_t srcWidth, uint32_
 /// Rotates an image by 180-degrees
 ///
 /// This is an optimized method to flip the image horizontally and vertically in-place in a single pass
-void rotate180(const NativeLumaBuffer buffer, uint32_t width, uint32_t height)
+static void rotate180Scalar(const NativeLumaBuffer buffer, uint32_t width, uint32_t height)
 {
 	uint32_t halfHeight = height / 2;
 	uint32_t halfWidth = width / 2;
@@ -182,3 +192,313 @@ void rotate180(const NativeLumaBuffer buffer, uint32_t width, uint32_t height)
 	// 	}
 	// }
 }
+
+static uint32_t sampleLineScalar(const NativeLumaBuffer src, uint32_t width, uint32_t height, int32_t x0, int32_t y0, int32_t x1, int32_t y1, bool invert, int32_t *dst)
+{
+	if (!fastImageLineInside(width, height, x0, y0, x1, y1, 0)) return 0;
+
+	FastImageLineWalk walk(x0, y0, x1, y1);
+	uint32_t total = static_cast<uint32_t>(walk.count);
+	for (; walk.count > 0; walk.step())
+	{
+		LumaSample luma = src[walk.offset(width)];
+		*(dst++) = invert ? 255 - luma : luma;
+	}
+
+	return total;
+}
+
+static uint32_t sampleLineWideScalar(const NativeLumaBuffer src, uint32_t width, uint32_t height, int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t *dst)
+{
+	const int32_t kWideAmount = 2;
+	if (!fastImageLineInside(width, height, x0, y0, x1, y1, kWideAmount)) return 0;
+
+	FastImageLineWalk walk(x0, y0, x1, y1);
+	uint32_t total = static_cast<uint32_t>(walk.count);
+
+	// The first sample is not weighted
+	*(dst++) = src[walk.offset(width)];
+	walk.step();
+
+	// Neighbors are across the minor axis
+	int32_t wideOffset = walk.horizontal ? static_cast<int32_t>(width) * kWideAmount : kWideAmount;
+	for (; walk.count > 0; walk.step())
+	{
+		const LumaSample *pix = src + walk.offset(width);
+		*(dst++) = (pix[-wideOffset] + pix[0] * 2 + pix[wideOffset]) / 4;
+	}
+
+	return total;
+}
+
+static uint32_t sampleBitColumnsScalar(const NativeLumaBuffer src, uint32_t width, uint32_t height, const NativePoint *leftCenters, uint32_t leftCount, const NativePoint *rightCenters, uint32_t rightCount, const float *bitCenters, uint32_t bitCount, bool invert, int32_t *dst, uint32_t dstStride)
+{
+	return fastImageSampleBitColumns(src, width, height, leftCenters, leftCount, rightCenters, rightCount, bitCenters, bitCount, invert, dst, dstStride, fastImageGatherTapsScalar);
+}
+
+static void transposeBitColumnsScalar(const uint8_t *packed, uint32_t columnCount, uint32_t *dst)
+{
+	fastImageTransposeBitColumns(packed, columnCount, dst, fastImageTransposeBitGroupScalar);
+}
+
+/// Returns the scalar (reference) kernel table
+const FastImageKernels *fastImageKernelsScalar()
+{
+	static const FastImageKernels kernels =
+	{
+		FastImageIsaScalar,
+		"scalar",
+		copy2vuyToLumaScalar,
+		copyLumaToColorScalar,
+		copyColorToLumaScalar,
+		resampleNearestNeighborLumaScalar,
+		resampleNearestNeighborColorScalar,
+		resampleLerpFastLumaScalar,
+		rotate180Scalar,
+		sampleLineScalar,
+		sampleLineWideScalar,
+		sampleBitColumnsScalar,
+		transposeBitColumnsScalar
+	};
+
+	return &kernels;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Kernel dispatch
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// The currently active kernels (nullptr until first use)
+static std::atomic<const FastImageKernels *> gActiveKernels(nullptr);
+
+/// Returns the kernel table for the given instruction set, or nullptr if that instruction set was not compiled into this build or
+/// is not supported by the host CPU
+const FastImageKernels *fastImageKernels(FastImageIsa isa)
+{
+	switch (isa)
+	{
+		case FastImageIsaScalar: return fastImageKernelsScalar();
+		case FastImageIsaSse2: return cpuHasSse2() ? fastImageKernelsSse2() : nullptr;
+		case FastImageIsaAvx2: return cpuHasAvx2() ? fastImageKernelsAvx2() : nullptr;
+		case FastImageIsaNeon: return cpuHasNeon() ? fastImageKernelsNeon() : nullptr;
+		default: return nullptr;
+	}
+}
+
+/// Returns the kernel table currently used by the public image functions
+///
+/// On first use, this selects the best instruction set supported by the host CPU
+const FastImageKernels *fastImageActiveKernels()
+{
+	const FastImageKernels *kernels = gActiveKernels.load(std::memory_order_acquire);
+	if (kernels) return kernels;
+
+	// Best first
+	static const FastImageIsa kPreferred[] = { FastImageIsaAvx2, FastImageIsaNeon, FastImageIsaSse2, FastImageIsaScalar };
+	for (FastImageIsa isa : kPreferred)
+	{
+		kernels = fastImageKernels(isa);
+		if (kernels) break;
+	}
+
+	// If two threads race to get here, they'll both pick the same kernels, so there's no harm in a plain store
+	gActiveKernels.store(kernels, std::memory_order_release);
+	Logger::info(SSTR << "FastImage: using " << kernels->name << " kernels");
+	return kernels;
+}
+
+/// Overrides the kernel table used by the public image functions
+///
+/// Returns false (leaving the active kernels unchanged) if the instruction set is not available (see `fastImageKernels()`)
+bool fastImageSelectIsa(FastImageIsa isa)
+{
+	const FastImageKernels *kernels = fastImageKernels(isa);
+	if (!kernels) return false;
+
+	gActiveKernels.store(kernels, std::memory_order_release);
+	return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Image functions (dispatched to the active kernels)
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Copies image `src` (2vuy) to `dst` image (8-bit monochrome)
+///
+/// Note that both `src` is a 16-bit format and must contain at least `width` * `height` * `2` elements, while `dst` must contain at least `width` * `height` elements
+void copy2vuyToLuma(const NativeLumaBuffer src, NativeLumaBuffer dst, uint32_t width, uint32_t height)
+{
+	fastImageActiveKernels()->copy2vuyToLuma(src, dst, width, height);
+}
+
+/// Copies image `src` (8-bit monochrome) to `dst` image (32-bit ARGB) with 8-bit -> 32-bit monochrome conversion
+///
+/// Note that both `src` and `dst` must contain at least `width` * `height` elements each
+void copyLumaToColor(const NativeLumaBuffer src, NativeColorBuffer dst, uint32_t width, uint32_t height)
+{
+	fastImageActiveKernels()->copyLumaToColor(src, dst, width, height);
+}
+
+/// Copies image `src` (32-bit ARGB) to `dst` image (8-bit monochrome) with 32-bit -> 8-bit monochrome conversion
+///
+/// Note that both `src` and `dst` must contain at least `width` * `height` elements each
+void copyColorToLuma(const NativeColorBuffer src, NativeLumaBuffer dst, uint32_t width, uint32_t height)
+{
+	fastImageActiveKernels()->copyColorToLuma(src, dst, width, height);
+}
+
+/// Resamples 8-bit monochrome image `src` to `dst` with nearest-neighbor sampling
+void resampleNearestNeighborLuma(const NativeLumaBuffer src, uint32_t srcWidth, uint32_t srcHeight, NativeLumaBuffer dst, uint32_t dstWidth, uint32_t dstHeight)
+{
+	fastImageActiveKernels()->resampleNearestNeighborLuma(src, srcWidth, srcHeight, dst, dstWidth, dstHeight);
+}
+
+/// Resamples 32-bit Color image `src` to `dst` with nearest-neighbor sampling
+void resampleNearestNeighborColor(const NativeColorBuffer src, uint32_t srcWidth, uint32_t srcHeight, NativeColorBuffer dst, uint32_t dstWidth, uint32_t dstHeight)
+{
+	fastImageActiveKernels()->resampleNearestNeighborColor(src, srcWidth, srcHeight, dst, dstWidth, dstHeight);
+}
+
+/// Resamples 8-bit monochrome image `src` to `dst` with fast estimation linear interpolation sampling
+void resampleLerpFastLuma(const NativeLumaBuffer src, uint32_t srcWidth, uint32_t srcHeight, NativeLumaBuffer dst, uint32_t dstWidth, uint32_t dstHeight)
+{
+	fastImageActiveKernels()->resampleLerpFastLuma(src, srcWidth, srcHeight, dst, dstWidth, dstHeight);
+}
+
+/// Rotates an image by 180-degrees
+///
+/// This is an optimized method to flip the image horizontally and vertically in-place in a single pass
+void rotate180(const NativeLumaBuffer buffer, uint32_t width, uint32_t height)
+{
+	fastImageActiveKernels()->rotate180(buffer, width, height);
+}
+
+/// Samples 8-bit monochrome image `src` along the line from (`x0`, `y0`) to (`x1`, `y1`), inclusive (see FastImage.h)
+uint32_t sampleLine(const NativeLumaBuffer src, uint32_t width, uint32_t height, int32_t x0, int32_t y0, int32_t x1, int32_t y1, bool invert, int32_t *dst)
+{
+	return fastImageActiveKernels()->sampleLine(src, width, height, x0, y0, x1, y1, invert, dst);
+}
+
+/// Samples 8-bit monochrome image `src` along a line, weighting each sample with its neighbors (see FastImage.h)
+uint32_t sampleLineWide(const NativeLumaBuffer src, uint32_t width, uint32_t height, int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t *dst)
+{
+	return fastImageActiveKernels()->sampleLineWide(src, width, height, x0, y0, x1, y1, dst);
+}
+
+/// Samples the bit columns of a deck between left and right landmark centers (see FastImage.h)
+uint32_t sampleBitColumns(const NativeLumaBuffer src, uint32_t width, uint32_t height, const NativePoint *leftCenters, uint32_t leftCount, const NativePoint *rightCenters, uint32_t rightCount, const float *bitCenters, uint32_t bitCount, bool invert, int32_t *dst, uint32_t dstStride)
+{
+	return fastImageActiveKernels()->sampleBitColumns(src, width, height, leftCenters, leftCount, rightCenters, rightCount, bitCenters, bitCount, invert, dst, dstStride);
+}
+
+/// Transposes packed bit columns into one word per column (see FastImage.h)
+void transposeBitColumns(const uint8_t *packed, uint32_t columnCount, uint32_t *dst)
+{
+	fastImageActiveKernels()->transposeBitColumns(packed, columnCount, dst);
+}
+
+/// Copies the `width` x `height` region at (`x`, `y`) of 8-bit monochrome image `src` to `dst`, binning by `binning`
+///
+/// Each sample of `dst` is the average of a `binning` x `binning` block of the region, so `dst` must contain at least
+/// (`width` / `binning`) * (`height` / `binning`) elements. The region must lie within `src`.
+void cropLuma(const NativeLumaBuffer src, uint32_t srcWidth, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t binning, NativeLumaBuffer dst)
+{
+	const LumaSample *srcRow = src + y * srcWidth + x;
+
+	// A plain crop is a copy per row
+	if (binning <= 1)
+	{
+		for (uint32_t row = 0; row < height; ++row, srcRow += srcWidth, dst += width)
+		{
+			memcpy(dst, srcRow, width);
+		}
+		return;
+	}
+
+	uint32_t dstWidth = width / binning;
+	uint32_t dstHeight = height / binning;
+	uint32_t area = binning * binning;
+	for (uint32_t row = 0; row < dstHeight; ++row, srcRow += srcWidth * binning)
+	{
+		for (uint32_t col = 0; col < dstWidth; ++col)
+		{
+			const LumaSample *block = srcRow + col * binning;
+			uint32_t sum = 0;
+			for (uint32_t by = 0; by < binning; ++by, block += srcWidth)
+			{
+				for (uint32_t bx = 0; bx < binning; ++bx)
+				{
+					sum += block[bx];
+				}
+			}
+
+			*(dst++) = static_cast<LumaSample>(sum / area);
+		}
+	}
+}
+
+/// Calculates the rolling min/max of `sampleCount` samples over a window of `windowSize` samples, storing `count` results into
+/// `dst` (see FastImage.h)
+///
+/// This is the van Herk/Gil-Werman algorithm: the samples are split into blocks of `windowSize` samples, so every window spans the
+/// tail of one block and the head of the next. Each result combines the min/max from the window's start to the end of its block
+/// (the suffix) with the min/max from the start of the next block to the window's end (the prefix.) That's a constant three
+/// comparisons per sample for each of min and max, regardless of the window size or the order of the samples.
+uint32_t rollMinMax(const int32_t *samples, uint32_t sampleCount, uint32_t count, uint32_t windowSize, NativeMinMax *dst)
+{
+	if (sampleCount == 0) return 0;
+
+	uint32_t window = std::max(std::min(windowSize, sampleCount), 1u);
+	uint32_t last = std::min(count, sampleCount) > window ? std::min(count, sampleCount) - window : 0;
+
+	// Store the suffix min/max for each window's start in `dst`, back to front through each block up to the last window
+	for (uint32_t blockEnd = (last / window + 1) * window; blockEnd > 0; blockEnd -= window)
+	{
+		uint32_t i = blockEnd - 1;
+		NativeMinMax suffix = { samples[i], samples[i] };
+		dst[i] = suffix;
+		while (i-- > blockEnd - window)
+		{
+			int32_t sample = samples[i];
+			if (sample < suffix.min) suffix.min = sample;
+			if (suffix.max < sample) suffix.max = sample;
+			dst[i] = suffix;
+		}
+	}
+
+	// Combine each with the prefix min/max at the window's end, which restarts at the start of each block
+	NativeMinMax prefix = { samples[0], samples[0] };
+	for (uint32_t i = 1; i + 1 < window; ++i)
+	{
+		if (samples[i] < prefix.min) prefix.min = samples[i];
+		if (prefix.max < samples[i]) prefix.max = samples[i];
+	}
+
+	uint32_t blockOffset = window - 1;
+	for (uint32_t i = 0; i <= last; ++i)
+	{
+		int32_t sample = samples[i + window - 1];
+		if (blockOffset == 0)
+		{
+			prefix.min = sample;
+			prefix.max = sample;
+		}
+		else
+		{
+			if (sample < prefix.min) prefix.min = sample;
+			if (prefix.max < sample) prefix.max = sample;
+		}
+		if (++blockOffset == window) blockOffset = 0;
+
+		if (prefix.min < dst[i].min) dst[i].min = prefix.min;
+		if (dst[i].max < prefix.max) dst[i].max = prefix.max;
+	}
+
+	// The last full window fills out the results
+	for (uint32_t i = last + 1; i < last + window; ++i)
+	{
+		dst[i] = dst[last];
+	}
+
+	return last + window;
+}
@@ -14,6 +14,70 @@
 
 #include "include/NativeTaskTypes.h"
 
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Kernel dispatch
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// The instruction sets for which we have image kernels
+///
+/// The scalar kernels are always available and serve as the reference implementation that all other kernels must match
+/// bit-for-bit.
+enum FastImageIsa
+{
+	FastImageIsaScalar = 0,
+	FastImageIsaSse2,
+	FastImageIsaAvx2,
+	FastImageIsaNeon,
+
+	FastImageIsaCount
+};
+
+/// A table of image kernels for a single instruction set
+///
+/// Each entry has the same signature and contract as the public function of the same name, below
+struct FastImageKernels
+{
+	FastImageIsa isa;
+	const char *name;
+	void (*copy2vuyToLuma)(const NativeLumaBuffer src, NativeLumaBuffer dst, uint32_t width, uint32_t height);
+	void (*copyLumaToColor)(const NativeLumaBuffer src, NativeColorBuffer dst, uint32_t width, uint32_t height);
+	void (*copyColorToLuma)(const NativeColorBuffer src, NativeLumaBuffer dst, uint32_t width, uint32_t height);
+	void (*resampleNearestNeighborLuma)(const NativeLumaBuffer src, uint32_t srcWidth, uint32_t srcHeight, NativeLumaBuffer dst, uint32_t dstWidth, uint32_t dstHeight);
+	void (*resampleNearestNeighborColor)(const NativeColorBuffer src, uint32_t srcWidth, uint32_t srcHeight, NativeColorBuffer dst, uint32_t dstWidth, uint32_t dstHeight);
+	void (*resampleLerpFastLuma)(const NativeLumaBuffer src, uint32_t srcWidth, uint32_t srcHeight, NativeLumaBuffer dst, uint32_t dstWidth, uint32_t dstHeight);
+	void (*rotate180)(const NativeLumaBuffer buffer, uint32_t width, uint32_t height);
+	uint32_t (*sampleLine)(const NativeLumaBuffer src, uint32_t width, uint32_t height, int32_t x0, int32_t y0, int32_t x1, int32_t y1, bool invert, int32_t *dst);
+	uint32_t (*sampleLineWide)(const NativeLumaBuffer src, uint32_t width, uint32_t height, int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t *dst);
+	uint32_t (*sampleBitColumns)(const NativeLumaBuffer src, uint32_t width, uint32_t height, const NativePoint *leftCenters, uint32_t leftCount, const NativePoint *rightCenters, uint32_t rightCount, const float *bitCenters, uint32_t bitCount, bool invert, int32_t *dst, uint32_t dstStride);
+	void (*transposeBitColumns)(const uint8_t *packed, uint32_t columnCount, uint32_t *dst);
+};
+
+/// Returns the kernel table for the given instruction set, or nullptr if that instruction set was not compiled into this build or
+/// is not supported by the host CPU
+const FastImageKernels *fastImageKernels(FastImageIsa isa);
+
+/// Returns the kernel table currently used by the public image functions
+///
+/// On first use, this selects the best instruction set supported by the host CPU
+const FastImageKernels *fastImageActiveKernels();
+
+/// Overrides the kernel table used by the public image functions
+///
+/// Returns false (leaving the active kernels unchanged) if the instruction set is not available (see `fastImageKernels()`)
+bool fastImageSelectIsa(FastImageIsa isa);
+
+/// Per-ISA kernel tables, defined in their respective translation units
+///
+/// These return nullptr when the instruction set was not compiled into this build. They do not check the host CPU.
+const FastImageKernels *fastImageKernelsScalar();
+const FastImageKernels *fastImageKernelsSse2();
+const FastImageKernels *fastImageKernelsAvx2();
+const FastImageKernels *fastImageKernelsNeon();
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Image functions (dispatched to the active kernels)
+// ---------------------------------------------------------------------------------------------------------------------------------
+
 /// Copies image `src` (2vuy) to `dst` image (8-bit monochrome)
 ///
 /// Note that both `src` is a 16-bit format and must contain at least `width` * `height` * `2` elements, while `dst` must contain at least `width` * `height` elements
@@ -42,3 +106,58 @@ void resampleLerpFastLuma(const NativeLumaBuffer src, uint32_t srcWidth, uint32_
 ///
 /// This is an optimized method to flip the image horizontally and vertically in-place in a single pass
 void rotate180(const NativeLumaBuffer buffer, uint32_t width, uint32_t height);
+
+/// Samples 8-bit monochrome image `src` along the line from (`x0`, `y0`) to (`x1`, `y1`), inclusive, storing one sample per pixel
+/// along the line's major axis into `dst` (optionally inverted, as `255 - luma`)
+///
+/// The line is walked exactly as Seer's `SampleLine.sample()` walks it, so `dst` must hold at least
+/// `max(abs(x1 - x0), abs(y1 - y0)) + 1` samples. The line is not clipped: if either end point lies outside the image, nothing is
+/// sampled.
+///
+/// Returns the number of samples stored (zero if the line lies outside the image)
+uint32_t sampleLine(const NativeLumaBuffer src, uint32_t width, uint32_t height, int32_t x0, int32_t y0, int32_t x1, int32_t y1, bool invert, int32_t *dst);
+
+/// Samples 8-bit monochrome image `src` along a line as `sampleLine()` does, but weighting each sample with its neighbors two pixels
+/// to either side of the line's minor axis: `(a + 2b + c) / 4`
+///
+/// This matches Seer's `SampleLine.sampleWide()`, including its first sample, which is not weighted. Both end points must lie at
+/// least two pixels inside the image.
+///
+/// Returns the number of samples stored (zero if the line lies outside the image)
+uint32_t sampleLineWide(const NativeLumaBuffer src, uint32_t width, uint32_t height, int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t *dst);
+
+/// Samples the bit columns of a deck from 8-bit monochrome image `src`, storing one row of samples per bit into `dst`, each row
+/// `dstStride` samples apart (optionally inverted, as `255 - luma`)
+///
+/// Each scanline runs from a left landmark center to a right landmark center, stepping through `leftCenters` and `rightCenters`
+/// so that the longer of the two is visited one center per scanline. Bit `i` is sampled along each scanline at `bitCenters[i]`
+/// (normalized from the left center to the right) and weighted with its neighbors one pixel to either side along the scanline:
+/// `(a + 6b + c) / 8`. This matches Seer's `MarkLines.generateContouredMarkLines()`, so each row of `dst` must hold at least
+/// `max(leftCount, rightCount)` samples.
+///
+/// Returns the number of scanlines sampled (zero if there are no centers or bits, or if any sample lies outside the image)
+uint32_t sampleBitColumns(const NativeLumaBuffer src, uint32_t width, uint32_t height, const NativePoint *leftCenters, uint32_t leftCount, const NativePoint *rightCenters, uint32_t rightCount, const float *bitCenters, uint32_t bitCount, bool invert, int32_t *dst, uint32_t dstStride);
+
+/// Transposes `columnCount` packed bit columns into one word per column, storing them into `dst`
+///
+/// The columns are packed in groups of eight, with 32 bytes per group: bit `j` of byte `i` of group `g` is row `i` of column
+/// `g * 8 + j`. Each word of `dst` holds its column's rows, with row `i` in bit `i`. `packed` must hold every byte of the final
+/// (possibly partial) group.
+void transposeBitColumns(const uint8_t *packed, uint32_t columnCount, uint32_t *dst);
+
+/// Calculates the rolling min/max of `sampleCount` samples over a window of `windowSize` samples, storing `count` results into
+/// `dst`
+///
+/// Result `i` is the min/max of samples [`i`, `i` + `windowSize`). Once the window reaches the end of the first `count` samples,
+/// that final window is repeated to fill out the results, so there are always `max(count, windowSize)` of them and `dst` must
+/// hold at least `sampleCount`. The window is clamped to [1, `sampleCount`] and `count` to `sampleCount`. This matches Seer's
+/// `rollMinMax(samples:count:windowSize:)` exactly.
+///
+/// Returns the number of results stored (zero if there are no samples)
+uint32_t rollMinMax(const int32_t *samples, uint32_t sampleCount, uint32_t count, uint32_t windowSize, NativeMinMax *dst);
+
+/// Copies the `width` x `height` region at (`x`, `y`) of 8-bit monochrome image `src` to `dst`, binning by `binning`
+///
+/// Each sample of `dst` is the average of a `binning` x `binning` block of the region, so `dst` must contain at least
+/// (`width` / `binning`) * (`height` / `binning`) elements. The region must lie within `src`.
+void cropLuma(const NativeLumaBuffer src, uint32_t srcWidth, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t binning, NativeLumaBuffer dst);
@@ -0,0 +1,579 @@
+//
+//  FastImageCommon.h
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+//
+// Internal helpers shared by the ISA-specific image kernels (FastImageSse.cpp, FastImageNeon.cpp.)
+//
+// The resamplers are only partially vectorizable (their source addressing is data-dependent), so the parts that aren't ISA-specific
+// live here: per-column lookup tables, reuse of identical destination rows, and the prefix sums used by the box filter. Every
+// helper here must produce results that are bit-exact with the scalar reference kernels in FastImage.cpp.
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "include/NativeTaskTypes.h"
+
+/// FixedPoint scale used by the resamplers (must match the scalar reference kernels)
+static const int kFastImageFixedShift = 16;
+
+/// Per-thread scratch space so that the resamplers don't allocate on every frame
+struct FastImageScratch
+{
+	std::vector<int32_t> columnTable;
+	std::vector<uint16_t> columnSums;
+	std::vector<uint32_t> prefixSums;
+	std::vector<int32_t> tapOffsets;
+	std::vector<float> scanlines;
+
+	/// Returns the scratch space for the calling thread
+	static FastImageScratch &local()
+	{
+		static thread_local FastImageScratch scratch;
+		return scratch;
+	}
+};
+
+/// Adds a row of `count` 8-bit samples into `count` 16-bit accumulators
+typedef void (*FastImageAccumulateRow)(const LumaSample *row, uint16_t *acc, uint32_t count);
+
+/// The largest number of rows that can be accumulated into 16-bit column sums without overflow (255 * 257 == 65535)
+static const int kFastImageMaxAccumulatedRows = 257;
+
+/// Nearest-neighbor resampling using a precomputed column table
+///
+/// Destination rows that sample the same source row (any vertical upscale) are copied from the previous destination row rather
+/// than resampled.
+template<class SampleType>
+inline void fastImageResampleNearestNeighbor(const SampleType *src, uint32_t srcWidth, uint32_t srcHeight, SampleType *dst, uint32_t dstWidth, uint32_t dstHeight, void (*gatherRow)(const SampleType *srcRow, const int32_t *columnTable, SampleType *dstRow, uint32_t count))
+{
+	int fxDxSrc = (srcWidth << kFastImageFixedShift) / dstWidth;
+	int fxDySrc = (srcHeight << kFastImageFixedShift) / dstHeight;
+
+	std::vector<int32_t> &columnTable = FastImageScratch::local().columnTable;
+	columnTable.resize(dstWidth);
+	for (int xDst = 0, xSrc = 0; xDst < static_cast<int>(dstWidth); xDst += 1, xSrc += fxDxSrc)
+	{
+		columnTable[xDst] = xSrc >> kFastImageFixedShift;
+	}
+
+	int lastSrcRow = -1;
+	for (int yDst = 0, ySrc = 0; yDst < static_cast<int>(dstHeight); yDst += 1, ySrc += fxDySrc)
+	{
+		SampleType *dstRow = dst + yDst * dstWidth;
+		int srcRow = ySrc >> kFastImageFixedShift;
+		if (srcRow == lastSrcRow)
+		{
+			memcpy(dstRow, dstRow - dstWidth, dstWidth * sizeof(SampleType));
+		}
+		else
+		{
+			gatherRow(src + srcRow * srcWidth, columnTable.data(), dstRow, dstWidth);
+			lastSrcRow = srcRow;
+		}
+	}
+}
+
+/// Box-filter ("lerp fast") resampling using vectorized vertical column sums and scalar horizontal prefix sums
+///
+/// The vertical pass (the bulk of the memory traffic) is performed by `accumulateRow`. If a destination row covers more than
+/// `kFastImageMaxAccumulatedRows` source rows, that row falls back to 32-bit scalar accumulation.
+inline void fastImageResampleLerpFast(const LumaSample *src, uint32_t srcWidth, uint32_t srcHeight, LumaSample *dst, uint32_t dstWidth, uint32_t dstHeight, FastImageAccumulateRow accumulateRow)
+{
+	int dxSrc = (srcWidth << kFastImageFixedShift) / dstWidth;
+	int dySrc = (srcHeight << kFastImageFixedShift) / dstHeight;
+
+	FastImageScratch &scratch = FastImageScratch::local();
+	scratch.columnSums.resize(srcWidth);
+	scratch.prefixSums.resize(srcWidth + 1);
+	scratch.columnTable.resize(dstWidth);
+	uint16_t *columnSums = scratch.columnSums.data();
+	uint32_t *prefixSums = scratch.prefixSums.data();
+	int32_t *columnTable = scratch.columnTable.data();
+
+	// The first source column covered by each destination column
+	for (int xDst = 0, xSrc = 0; xDst < static_cast<int>(dstWidth); xDst += 1, xSrc += dxSrc)
+	{
+		columnTable[xDst] = xSrc >> kFastImageFixedShift;
+	}
+
+	for (int yDst = 0, ySrc = 0; yDst < static_cast<int>(dstHeight); yDst += 1, ySrc += dySrc)
+	{
+		int y0Src = ySrc >> kFastImageFixedShift;
+		int y1Src = (ySrc + dySrc) >> kFastImageFixedShift;
+		int rows = y1Src - y0Src;
+
+		// Vertical pass into prefix sums
+		prefixSums[0] = 0;
+		if (rows <= kFastImageMaxAccumulatedRows)
+		{
+			memset(columnSums, 0, srcWidth * sizeof(uint16_t));
+			for (int y = y0Src; y < y1Src; ++y)
+			{
+				accumulateRow(src + y * srcWidth, columnSums, srcWidth);
+			}
+			for (uint32_t x = 0; x < srcWidth; ++x)
+			{
+				prefixSums[x + 1] = prefixSums[x] + columnSums[x];
+			}
+		}
+		else
+		{
+			for (uint32_t x = 0; x < srcWidth; ++x)
+			{
+				uint32_t sum = 0;
+				for (int y = y0Src; y < y1Src; ++y)
+				{
+					sum += src[y * srcWidth + x];
+				}
+				prefixSums[x + 1] = prefixSums[x] + sum;
+			}
+		}
+
+		// Horizontal pass
+		LumaSample *dstRow = dst + yDst * dstWidth;
+		for (int xDst = 0, xSrc = 0; xDst < static_cast<int>(dstWidth); xDst += 1, xSrc += dxSrc)
+		{
+			int x0Src = columnTable[xDst];
+			int x1Src = (xSrc + dxSrc) >> kFastImageFixedShift;
+			int pix = static_cast<int>(prefixSums[x1Src] - prefixSums[x0Src]);
+			int tot = rows * (x1Src - x0Src);
+			dstRow[xDst] = (LumaSample)(pix / tot);
+		}
+	}
+}
+
+/// Rotates an image by 180 degrees in place, using `swapBlocks` to swap four mirrored blocks of `kBlock` samples at a time
+///
+/// The scalar tail (and the treatment of odd center rows/columns) mirrors the scalar reference kernel exactly.
+template<uint32_t kBlock>
+inline void fastImageRotate180(LumaSample *buffer, uint32_t width, uint32_t height, void (*swapBlocks)(LumaSample *topLeft, LumaSample *topRight, LumaSample *botLeft, LumaSample *botRight))
+{
+	uint32_t halfHeight = height / 2;
+	uint32_t halfWidth = width / 2;
+	for (uint32_t y = 0; y < halfHeight; y++)
+	{
+		LumaSample *topLine = buffer + width * y;
+		LumaSample *botLine = buffer + width * (height - y - 1);
+		uint32_t x = 0;
+		for (; x + kBlock <= halfWidth; x += kBlock)
+		{
+			swapBlocks(topLine + x, topLine + width - x - kBlock, botLine + x, botLine + width - x - kBlock);
+		}
+		for (; x < halfWidth; ++x)
+		{
+			LumaSample ltmp = topLine[x];
+			LumaSample rtmp = topLine[width - x - 1];
+			topLine[x] = botLine[width - x - 1];
+			topLine[width - x - 1] = botLine[x];
+			botLine[x] = rtmp;
+			botLine[width - x - 1] = ltmp;
+		}
+	}
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Line sampling
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// The fixed-point walk along a line, exactly as performed by Seer's `SampleLine.sample()`
+///
+/// The walk takes one step per pixel along the line's major axis (x if the line is primarily horizontal, otherwise y) while the
+/// minor axis is stepped in fixed point, sampling at pixel centers. The minor axis starts with an error term applied so that the
+/// walk lands exactly on the end point.
+struct FastImageLineWalk
+{
+	/// Is the line primarily horizontal?
+	bool horizontal;
+
+	/// The number of samples remaining
+	int32_t count;
+
+	/// The current position along the major axis (in pixels) and the step (+/- 1)
+	int32_t major;
+	int32_t majorStep;
+
+	/// The current position along the minor axis (in fixed point) and the step
+	int32_t minor;
+	int32_t minorStep;
+
+	FastImageLineWalk(int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+	{
+		int32_t dx = x1 - x0;
+		int32_t dy = y1 - y0;
+		horizontal = abs(dx) >= abs(dy);
+
+		int32_t majorDelta = horizontal ? dx : dy;
+		int32_t minorDelta = horizontal ? dy : dx;
+		int32_t minor0 = horizontal ? y0 : x0;
+		int32_t minor1 = horizontal ? y1 : x1;
+		int32_t steps = abs(majorDelta);
+
+		const int32_t kOne = 1 << kFastImageFixedShift;
+		count = steps + 1;
+		major = horizontal ? x0 : y0;
+		majorStep = majorDelta >= 0 ? 1 : -1;
+		minorStep = steps == 0 ? 0 : minorDelta * kOne / steps;
+
+		// Calculate our error epsilon and add it to the starting point
+		minor = minor0 * kOne + kOne / 2;
+		minor += (minor1 * kOne + kOne / 2) - (minor + minorStep * steps);
+	}
+
+	/// Returns the offset of the current sample within an image of the given width
+	int32_t offset(uint32_t width) const
+	{
+		int32_t minorPixel = minor >> kFastImageFixedShift;
+		return horizontal ? minorPixel * static_cast<int32_t>(width) + major : major * static_cast<int32_t>(width) + minorPixel;
+	}
+
+	/// Steps to the next sample
+	void step(int32_t steps = 1)
+	{
+		major += majorStep * steps;
+		minor += minorStep * steps;
+		count -= steps;
+	}
+};
+
+/// Returns true if both end points of a line lie at least `margin` pixels inside an image of the given size
+inline bool fastImageLineInside(uint32_t width, uint32_t height, int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t margin)
+{
+	int32_t maxX = static_cast<int32_t>(width) - 1 - margin;
+	int32_t maxY = static_cast<int32_t>(height) - 1 - margin;
+	return x0 >= margin && x1 >= margin && y0 >= margin && y1 >= margin && x0 <= maxX && x1 <= maxX && y0 <= maxY && y1 <= maxY;
+}
+
+/// Samples a run of `count` pixels within a single row, stepping `step` (+/- 1) pixels from `src`, optionally inverted
+typedef void (*FastImageSampleRow)(const LumaSample *src, int32_t count, int32_t step, bool invert, int32_t *dst);
+
+/// Samples a run of `count` pixels within a single row as `FastImageSampleRow` does, weighted with the pixels `stride` samples
+/// before and after each one: `(a + 2b + c) / 4`
+typedef void (*FastImageSampleRowWide)(const LumaSample *src, int32_t stride, int32_t count, int32_t step, int32_t *dst);
+
+/// Samples `count` pixels of a line walk, one per step
+///
+/// Sample `i` is read from `src[i * majorStride + ((minor + i * minorStep) >> kFastImageFixedShift) * minorStride]`. If
+/// `wideOffset` is non-zero, each sample is weighted with the pixels `wideOffset` samples before and after it (see
+/// `FastImageSampleRowWide`.) Vectorized implementations may read four bytes at a time from any offset up to `readLimit - 4`.
+typedef void (*FastImageSampleWalk)(const LumaSample *src, int32_t majorStride, int32_t minorStride, int32_t minor, int32_t minorStep, int32_t count, int32_t wideOffset, bool invert, int32_t readLimit, int32_t *dst);
+
+/// Row runs shorter than this (on average) are sampled with the walk sampler, rather than split into runs
+static const int32_t kFastImageMinRowRun = 8;
+
+/// Scalar row sampler (also used for the tails of the vectorized samplers)
+inline void fastImageSampleRowScalar(const LumaSample *src, int32_t count, int32_t step, bool invert, int32_t *dst)
+{
+	int32_t flip = invert ? 0xff : 0;
+	for (int32_t i = 0; i < count; ++i, src += step)
+	{
+		dst[i] = *src ^ flip;
+	}
+}
+
+/// Scalar wide row sampler (also used for the tails of the vectorized samplers)
+inline void fastImageSampleRowWideScalar(const LumaSample *src, int32_t stride, int32_t count, int32_t step, int32_t *dst)
+{
+	for (int32_t i = 0; i < count; ++i, src += step)
+	{
+		dst[i] = (src[-stride] + src[0] * 2 + src[stride]) / 4;
+	}
+}
+
+/// Scalar walk sampler (also used for the tails of the vectorized samplers)
+inline void fastImageSampleWalkScalar(const LumaSample *src, int32_t majorStride, int32_t minorStride, int32_t minor, int32_t minorStep, int32_t count, int32_t wideOffset, bool invert, int32_t readLimit, int32_t *dst)
+{
+	(void) readLimit;
+	int32_t flip = invert ? 0xff : 0;
+	for (int32_t i = 0; i < count; ++i, src += majorStride, minor += minorStep)
+	{
+		const LumaSample *pix = src + (minor >> kFastImageFixedShift) * minorStride;
+		if (wideOffset == 0)
+		{
+			dst[i] = *pix ^ flip;
+		}
+		else
+		{
+			dst[i] = (pix[-wideOffset] + pix[0] * 2 + pix[wideOffset]) / 4;
+		}
+	}
+}
+
+/// Returns the number of samples from the current position of a primarily horizontal walk that lie in the same row
+inline int32_t fastImageRowRun(const FastImageLineWalk &walk)
+{
+	const int32_t kOne = 1 << kFastImageFixedShift;
+	int32_t row = walk.minor >> kFastImageFixedShift;
+	int32_t run = walk.count;
+	if (walk.minorStep > 0)
+	{
+		run = std::min(run, ((row + 1) * kOne - 1 - walk.minor) / walk.minorStep + 1);
+	}
+	else if (walk.minorStep < 0)
+	{
+		run = std::min(run, (walk.minor - row * kOne) / -walk.minorStep + 1);
+	}
+	return run;
+}
+
+/// Samples a line (see `sampleLine()`)
+///
+/// Shallow, primarily horizontal lines are split into runs of contiguous pixels within the same row (see `sampleRow`.) All other
+/// lines are sampled a pixel at a time (see `sampleWalk`.) If `wide` is set, samples are weighted with their neighbors (see
+/// `sampleLineWide()`) and `invert` is ignored.
+inline uint32_t fastImageSampleLine(const LumaSample *src, uint32_t width, uint32_t height, int32_t x0, int32_t y0, int32_t x1, int32_t y1, bool wide, bool invert, int32_t *dst, FastImageSampleRow sampleRow, FastImageSampleRowWide sampleRowWide, FastImageSampleWalk sampleWalk)
+{
+	// Wide samples reach this far from the line, along the minor axis
+	const int32_t kWideAmount = 2;
+
+	if (!fastImageLineInside(width, height, x0, y0, x1, y1, wide ? kWideAmount : 0)) return 0;
+
+	FastImageLineWalk walk(x0, y0, x1, y1);
+	uint32_t total = static_cast<uint32_t>(walk.count);
+	int32_t stride = static_cast<int32_t>(width);
+
+	// The first wide sample is not weighted (matching `SampleLine.sampleWide()`)
+	if (wide)
+	{
+		*(dst++) = src[walk.offset(width)];
+		walk.step();
+	}
+
+	if (walk.horizontal && abs(walk.minorStep) * kFastImageMinRowRun <= (1 << kFastImageFixedShift))
+	{
+		while (walk.count > 0)
+		{
+			int32_t run = fastImageRowRun(walk);
+			if (wide)
+			{
+				sampleRowWide(src + walk.offset(width), stride * kWideAmount, run, walk.majorStep, dst);
+			}
+			else
+			{
+				sampleRow(src + walk.offset(width), run, walk.majorStep, invert, dst);
+			}
+
+			dst += run;
+			walk.step(run);
+		}
+	}
+	else if (walk.count > 0)
+	{
+		int32_t majorStride = walk.horizontal ? 1 : stride;
+		int32_t minorStride = walk.horizontal ? stride : 1;
+		int32_t majorOffset = walk.major * majorStride;
+		int32_t readLimit = static_cast<int32_t>(width * height) - majorOffset;
+		sampleWalk(src + majorOffset, walk.majorStep * majorStride, minorStride, walk.minor, walk.minorStep, walk.count, wide ? kWideAmount * minorStride : 0, invert, readLimit, dst);
+	}
+
+	return total;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Bit column sampling
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Gathers `count` samples, each weighted from three taps: `(a + 6b + c) / 8`, where the taps are read from `src` at the offsets
+/// in `aOffsets`, `bOffsets` and `cOffsets` (each optionally inverted first, as `255 - luma`)
+///
+/// Vectorized implementations may read four bytes at a time from any offset up to `readLimit - 4`.
+typedef void (*FastImageGatherTaps)(const LumaSample *src, const int32_t *aOffsets, const int32_t *bOffsets, const int32_t *cOffsets, int32_t count, bool invert, int32_t readLimit, int32_t *dst);
+
+/// Scalar tap gatherer (also used for the tails of the vectorized gatherers)
+inline void fastImageGatherTapsScalar(const LumaSample *src, const int32_t *aOffsets, const int32_t *bOffsets, const int32_t *cOffsets, int32_t count, bool invert, int32_t readLimit, int32_t *dst)
+{
+	(void) readLimit;
+	int32_t flip = invert ? 0xff : 0;
+	for (int32_t i = 0; i < count; ++i)
+	{
+		int32_t a = src[aOffsets[i]] ^ flip;
+		int32_t b = src[bOffsets[i]] ^ flip;
+		int32_t c = src[cOffsets[i]] ^ flip;
+		dst[i] = (a + b * 6 + c) / 8;
+	}
+}
+
+/// Returns true if the pixel containing `(x, y)` (truncated toward zero, as Seer's `Vector.chopToPoint()` does) lies within an
+/// image of the given size
+inline bool fastImageTapInside(float x, float y, float width, float height)
+{
+	return x > -1.0f && y > -1.0f && x < width && y < height;
+}
+
+/// Samples the bit columns of a deck (see `sampleBitColumns()`), using `gatherTaps` to sample each column
+///
+/// The scanlines step through the left and right landmark centers in fixed point, exactly as Seer's FixedPoint math does. The bit
+/// locations along each scanline (and the normal across it) are calculated with the same Float math as the Swift, as statements
+/// of their own so that they can't be contracted.
+///
+/// Every step of a tap's position is a single rounded operation with the bit center as its only variable, so each coordinate is
+/// monotonic in the bit center. The taps of the bits with the smallest and largest centers therefore bound those of every bit on
+/// their scanline, and they are the only ones that need to be checked against the image. The scanlines are set up (and checked)
+/// first, so that each column's tap offsets can be calculated in one contiguous pass before the column is gathered in one call.
+inline uint32_t fastImageSampleBitColumns(const LumaSample *src, uint32_t width, uint32_t height, const NativePoint *leftCenters, uint32_t leftCount, const NativePoint *rightCenters, uint32_t rightCount, const float *bitCenters, uint32_t bitCount, bool invert, int32_t *dst, uint32_t dstStride, FastImageGatherTaps gatherTaps)
+{
+	if (leftCount == 0 || rightCount == 0 || bitCount == 0) return 0;
+
+	const int32_t kOne = 1 << kFastImageFixedShift;
+	int32_t scanlineCount = static_cast<int32_t>(std::max(leftCount, rightCount));
+	int32_t leftStep = static_cast<int32_t>(leftCount) * kOne / scanlineCount;
+	int32_t rightStep = static_cast<int32_t>(rightCount) * kOne / scanlineCount;
+
+	float fw = static_cast<float>(width);
+	float fh = static_cast<float>(height);
+	const float extremeCenters[2] = { *std::min_element(bitCenters, bitCenters + bitCount), *std::max_element(bitCenters, bitCenters + bitCount) };
+
+	// Each scanline's left center, its span to the right center and the unit normal along it, in separate runs
+	FastImageScratch &scratch = FastImageScratch::local();
+	scratch.scanlines.resize(static_cast<size_t>(scanlineCount) * 6);
+	float *lxs = scratch.scanlines.data();
+	float *lys = lxs + scanlineCount;
+	float *dxs = lys + scanlineCount;
+	float *dys = dxs + scanlineCount;
+	float *nxs = dys + scanlineCount;
+	float *nys = nxs + scanlineCount;
+
+	for (int32_t scanline = 0, left = 0, right = 0; scanline < scanlineCount; ++scanline, left += leftStep, right += rightStep)
+	{
+		const NativePoint &lCenter = leftCenters[left >> kFastImageFixedShift];
+		const NativePoint &rCenter = rightCenters[right >> kFastImageFixedShift];
+		float lx = static_cast<float>(lCenter.x);
+		float ly = static_cast<float>(lCenter.y);
+		float dx = static_cast<float>(rCenter.x) - lx;
+		float dy = static_cast<float>(rCenter.y) - ly;
+
+		// See Seer's `Vector.normal()`
+		float dx2 = dx * dx;
+		float dy2 = dy * dy;
+		float lengthSquared = dx2 + dy2;
+		float length = static_cast<float>(sqrt(static_cast<double>(lengthSquared)));
+		float scale = length == 0 ? 0 : 1.0f / length;
+		float nx = dx * scale;
+		float ny = dy * scale;
+
+		for (float center : extremeCenters)
+		{
+			float ox = dx * center;
+			float oy = dy * center;
+			float bx = lx + ox;
+			float by = ly + oy;
+			if (!fastImageTapInside(bx - nx, by - ny, fw, fh) || !fastImageTapInside(bx, by, fw, fh) || !fastImageTapInside(bx + nx, by + ny, fw, fh)) return 0;
+		}
+
+		lxs[scanline] = lx;
+		lys[scanline] = ly;
+		dxs[scanline] = dx;
+		dys[scanline] = dy;
+		nxs[scanline] = nx;
+		nys[scanline] = ny;
+	}
+
+	// The offsets of one column's taps: all of its `a` taps, then `b`, then `c`
+	scratch.tapOffsets.resize(static_cast<size_t>(scanlineCount) * 3);
+	int32_t *aOffsets = scratch.tapOffsets.data();
+	int32_t *bOffsets = aOffsets + scanlineCount;
+	int32_t *cOffsets = bOffsets + scanlineCount;
+
+	int32_t stride = static_cast<int32_t>(width);
+	int32_t readLimit = static_cast<int32_t>(width * height);
+	for (uint32_t bit = 0; bit < bitCount; ++bit)
+	{
+		float center = bitCenters[bit];
+		for (int32_t scanline = 0; scanline < scanlineCount; ++scanline)
+		{
+			float ox = dxs[scanline] * center;
+			float oy = dys[scanline] * center;
+			float bx = lxs[scanline] + ox;
+			float by = lys[scanline] + oy;
+			float ax = bx - nxs[scanline];
+			float ay = by - nys[scanline];
+			float cx = bx + nxs[scanline];
+			float cy = by + nys[scanline];
+			aOffsets[scanline] = static_cast<int32_t>(ay) * stride + static_cast<int32_t>(ax);
+			bOffsets[scanline] = static_cast<int32_t>(by) * stride + static_cast<int32_t>(bx);
+			cOffsets[scanline] = static_cast<int32_t>(cy) * stride + static_cast<int32_t>(cx);
+		}
+
+		gatherTaps(src, aOffsets, bOffsets, cOffsets, scanlineCount, invert, readLimit, dst + static_cast<size_t>(bit) * dstStride);
+	}
+
+	return static_cast<uint32_t>(scanlineCount);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Bit column transposition
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// The number of rows in each group of packed bit columns (see `transposeBitColumns()`)
+static const uint32_t kFastImageBitColumnRows = 32;
+
+/// Transposes an 8x8 bit matrix, stored as one byte per row (row `i` in byte `i`, column `j` in bit `j`), so that each byte
+/// holds a column
+inline uint64_t fastImageTranspose8x8(uint64_t x)
+{
+	uint64_t t;
+	t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaull;
+	x ^= t ^ (t << 7);
+	t = (x ^ (x >> 14)) & 0x0000cccc0000ccccull;
+	x ^= t ^ (t << 14);
+	t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ull;
+	x ^= t ^ (t << 28);
+	return x;
+}
+
+/// Transposes the columns of one group of packed bits into eight words (see `transposeBitColumns()`)
+///
+/// Each quarter of the rows is transposed as an 8x8 bit matrix, giving a byte of each column's word.
+inline void fastImageTransposeBitGroupScalar(const uint8_t *group, uint32_t *words)
+{
+	uint64_t columns[kFastImageBitColumnRows / 8];
+	for (uint32_t quarter = 0; quarter < kFastImageBitColumnRows / 8; ++quarter)
+	{
+		uint64_t rows;
+		memcpy(&rows, group + quarter * 8, sizeof(rows));
+		columns[quarter] = fastImageTranspose8x8(rows);
+	}
+
+	for (uint32_t column = 0; column < 8; ++column)
+	{
+		uint32_t shift = column * 8;
+		words[column] = static_cast<uint32_t>((columns[0] >> shift) & 0xff) |
+		                static_cast<uint32_t>((columns[1] >> shift) & 0xff) << 8 |
+		                static_cast<uint32_t>((columns[2] >> shift) & 0xff) << 16 |
+		                static_cast<uint32_t>((columns[3] >> shift) & 0xff) << 24;
+	}
+}
+
+/// A transposer for one group of packed bits (see `fastImageTransposeBitGroupScalar()`)
+typedef void (*FastImageTransposeBitGroup)(const uint8_t *group, uint32_t *words);
+
+/// Transposes `columnCount` packed bit columns into `dst` (see `transposeBitColumns()`), using `transposeGroup` for each group
+///
+/// The final group's columns are transposed into a temporary, so that nothing is written past the end of `dst`.
+inline void fastImageTransposeBitColumns(const uint8_t *packed, uint32_t columnCount, uint32_t *dst, FastImageTransposeBitGroup transposeGroup)
+{
+	uint32_t fullGroups = columnCount / 8;
+	for (uint32_t group = 0; group < fullGroups; ++group)
+	{
+		transposeGroup(packed + group * kFastImageBitColumnRows, dst + group * 8);
+	}
+
+	uint32_t remaining = columnCount % 8;
+	if (remaining != 0)
+	{
+		uint32_t words[8];
+		transposeGroup(packed + fullGroups * kFastImageBitColumnRows, words);
+		memcpy(dst + fullGroups * 8, words, remaining * sizeof(uint32_t));
+	}
+}
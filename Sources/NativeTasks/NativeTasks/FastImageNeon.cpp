@@ -0,0 +1,265 @@
+//
+//  FastImageNeon.cpp
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+//
+// NEON image kernels for the Pi (and Apple Silicon.)
+//
+// These are only compiled when the compiler targets NEON (always the case for AArch64; 32-bit ARM builds need -mfpu=neon.) Note
+// that the Pi Zero's ARMv6 core has no NEON unit, so it will always use the scalar kernels.
+
+#include <algorithm>
+#include "FastImage.h"
+#include "FastImageCommon.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#include <arm_neon.h>
+
+/// Gathers a row of luma samples through a column table (NEON has no gather, so this is unrolled scalar code)
+static void gatherRowLuma(const LumaSample *srcRow, const int32_t *columnTable, LumaSample *dstRow, uint32_t count)
+{
+	uint32_t x = 0;
+	for (; x + 4 <= count; x += 4)
+	{
+		dstRow[x + 0] = srcRow[columnTable[x + 0]];
+		dstRow[x + 1] = srcRow[columnTable[x + 1]];
+		dstRow[x + 2] = srcRow[columnTable[x + 2]];
+		dstRow[x + 3] = srcRow[columnTable[x + 3]];
+	}
+	for (; x < count; ++x)
+	{
+		dstRow[x] = srcRow[columnTable[x]];
+	}
+}
+
+/// Gathers a row of color samples through a column table (NEON has no gather, so this is unrolled scalar code)
+static void gatherRowColor(const ColorSample *srcRow, const int32_t *columnTable, ColorSample *dstRow, uint32_t count)
+{
+	uint32_t x = 0;
+	for (; x + 4 <= count; x += 4)
+	{
+		dstRow[x + 0] = srcRow[columnTable[x + 0]];
+		dstRow[x + 1] = srcRow[columnTable[x + 1]];
+		dstRow[x + 2] = srcRow[columnTable[x + 2]];
+		dstRow[x + 3] = srcRow[columnTable[x + 3]];
+	}
+	for (; x < count; ++x)
+	{
+		dstRow[x] = srcRow[columnTable[x]];
+	}
+}
+
+static void copy2vuyToLumaNeon(const NativeLumaBuffer src, NativeLumaBuffer dst, uint32_t width, uint32_t height)
+{
+	uint32_t count = width * height;
+	uint32_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		// De-interleave the chroma/luma pairs and keep the luma
+		uint8x16x2_t pairs = vld2q_u8(src + i * 2);
+		vst1q_u8(dst + i, pairs.val[1]);
+	}
+	for (; i < count; ++i)
+	{
+		dst[i] = src[i * 2 + 1];
+	}
+}
+
+static void copyLumaToColorNeon(const NativeLumaBuffer src, NativeColorBuffer dst, uint32_t width, uint32_t height)
+{
+	uint32_t count = width * height;
+	uint32_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		uint8x16_t pix = vld1q_u8(src + i);
+		uint8x16x4_t color;
+		color.val[0] = pix;
+		color.val[1] = pix;
+		color.val[2] = pix;
+		color.val[3] = vdupq_n_u8(0);
+		vst4q_u8(reinterpret_cast<uint8_t *>(dst + i), color);
+	}
+	for (; i < count; ++i)
+	{
+		uint32_t pix = uint32_t(src[i]);
+		dst[i] = pix | (pix << 8) | (pix << 16);
+	}
+}
+
+static void copyColorToLumaNeon(const NativeColorBuffer src, NativeLumaBuffer dst, uint32_t width, uint32_t height)
+{
+	uint32_t count = width * height;
+	uint32_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		uint8x16x4_t color = vld4q_u8(reinterpret_cast<const uint8_t *>(src + i));
+		vst1q_u8(dst + i, vmaxq_u8(color.val[2], vmaxq_u8(color.val[1], color.val[0])));
+	}
+	for (; i < count; ++i)
+	{
+		uint32_t pix = src[i];
+		dst[i] = uint8_t(std::max((pix>>16)&0xff, std::max((pix>>8)&0xff, pix&0xff)));
+	}
+}
+
+static void resampleNearestNeighborLumaNeon(const NativeLumaBuffer src, uint32_t srcWidth, uint32_t srcHeight, NativeLumaBuffer dst, uint32_t dstWidth, uint32_t dstHeight)
+{
+	fastImageResampleNearestNeighbor<LumaSample>(src, srcWidth, srcHeight, dst, dstWidth, dstHeight, gatherRowLuma);
+}
+
+static void resampleNearestNeighborColorNeon(const NativeColorBuffer src, uint32_t srcWidth, uint32_t srcHeight, NativeColorBuffer dst, uint32_t dstWidth, uint32_t dstHeight)
+{
+	fastImageResampleNearestNeighbor<ColorSample>(src, srcWidth, srcHeight, dst, dstWidth, dstHeight, gatherRowColor);
+}
+
+static void accumulateRowNeon(const LumaSample *row, uint16_t *acc, uint32_t count)
+{
+	uint32_t x = 0;
+	for (; x + 16 <= count; x += 16)
+	{
+		uint8x16_t pix = vld1q_u8(row + x);
+		vst1q_u16(acc + x, vaddw_u8(vld1q_u16(acc + x), vget_low_u8(pix)));
+		vst1q_u16(acc + x + 8, vaddw_u8(vld1q_u16(acc + x + 8), vget_high_u8(pix)));
+	}
+	for (; x < count; ++x)
+	{
+		acc[x] += row[x];
+	}
+}
+
+static void resampleLerpFastLumaNeon(const NativeLumaBuffer src, uint32_t srcWidth, uint32_t srcHeight, NativeLumaBuffer dst, uint32_t dstWidth, uint32_t dstHeight)
+{
+	fastImageResampleLerpFast(src, srcWidth, srcHeight, dst, dstWidth, dstHeight, accumulateRowNeon);
+}
+
+/// Reverses the order of the 16 bytes in a register
+static inline uint8x16_t reverseBytesNeon(uint8x16_t v)
+{
+	v = vrev64q_u8(v);
+	return vcombine_u8(vget_high_u8(v), vget_low_u8(v));
+}
+
+static void swapBlocksNeon(LumaSample *topLeft, LumaSample *topRight, LumaSample *botLeft, LumaSample *botRight)
+{
+	uint8x16_t tl = vld1q_u8(topLeft);
+	uint8x16_t tr = vld1q_u8(topRight);
+	uint8x16_t bl = vld1q_u8(botLeft);
+	uint8x16_t br = vld1q_u8(botRight);
+	vst1q_u8(topLeft, reverseBytesNeon(br));
+	vst1q_u8(topRight, reverseBytesNeon(bl));
+	vst1q_u8(botLeft, reverseBytesNeon(tr));
+	vst1q_u8(botRight, reverseBytesNeon(tl));
+}
+
+static void rotate180Neon(const NativeLumaBuffer buffer, uint32_t width, uint32_t height)
+{
+	fastImageRotate180<16>(buffer, width, height, swapBlocksNeon);
+}
+
+/// Loads the 16 pixels of a row run starting at `src` and stepping `step` (+/- 1), in the order they are sampled
+static inline uint8x16_t loadRunNeon(const LumaSample *src, int32_t step)
+{
+	if (step > 0) return vld1q_u8(src);
+	return reverseBytesNeon(vld1q_u8(src - 15));
+}
+
+/// Stores 16 pixels as samples (widened to 32 bits)
+static inline void storeSamplesNeon(uint8x16_t pix, int32_t *dst)
+{
+	uint16x8_t lo = vmovl_u8(vget_low_u8(pix));
+	uint16x8_t hi = vmovl_u8(vget_high_u8(pix));
+	vst1q_s32(dst + 0, vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(lo))));
+	vst1q_s32(dst + 4, vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(lo))));
+	vst1q_s32(dst + 8, vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(hi))));
+	vst1q_s32(dst + 12, vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(hi))));
+}
+
+static void sampleRowNeon(const LumaSample *src, int32_t count, int32_t step, bool invert, int32_t *dst)
+{
+	// 255 - luma is a flip of every bit
+	const uint8x16_t flip = vdupq_n_u8(invert ? 0xff : 0);
+	int32_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		storeSamplesNeon(veorq_u8(loadRunNeon(src + i * step, step), flip), dst + i);
+	}
+	fastImageSampleRowScalar(src + i * step, count - i, step, invert, dst + i);
+}
+
+static void sampleRowWideNeon(const LumaSample *src, int32_t stride, int32_t count, int32_t step, int32_t *dst)
+{
+	int32_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		const LumaSample *run = src + i * step;
+		uint8x16_t a = loadRunNeon(run - stride, step);
+		uint8x16_t b = loadRunNeon(run, step);
+		uint8x16_t c = loadRunNeon(run + stride, step);
+
+		// (a + 2b + c) / 4 fits in 16 bits, and the result fits back into 8 bits
+		uint16x8_t lo = vaddq_u16(vaddl_u8(vget_low_u8(a), vget_low_u8(c)), vshll_n_u8(vget_low_u8(b), 1));
+		uint16x8_t hi = vaddq_u16(vaddl_u8(vget_high_u8(a), vget_high_u8(c)), vshll_n_u8(vget_high_u8(b), 1));
+		storeSamplesNeon(vcombine_u8(vshrn_n_u16(lo, 2), vshrn_n_u16(hi, 2)), dst + i);
+	}
+	fastImageSampleRowWideScalar(src + i * step, stride, count - i, step, dst + i);
+}
+
+/// NEON has no gather, so lines that aren't split into row runs are sampled with the scalar walk sampler
+static uint32_t sampleLineNeon(const NativeLumaBuffer src, uint32_t width, uint32_t height, int32_t x0, int32_t y0, int32_t x1, int32_t y1, bool invert, int32_t *dst)
+{
+	return fastImageSampleLine(src, width, height, x0, y0, x1, y1, false, invert, dst, sampleRowNeon, sampleRowWideNeon, fastImageSampleWalkScalar);
+}
+
+static uint32_t sampleLineWideNeon(const NativeLumaBuffer src, uint32_t width, uint32_t height, int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t *dst)
+{
+	return fastImageSampleLine(src, width, height, x0, y0, x1, y1, true, false, dst, sampleRowNeon, sampleRowWideNeon, fastImageSampleWalkScalar);
+}
+
+/// NEON has no gather, so the taps are gathered one at a time
+static uint32_t sampleBitColumnsNeon(const NativeLumaBuffer src, uint32_t width, uint32_t height, const NativePoint *leftCenters, uint32_t leftCount, const NativePoint *rightCenters, uint32_t rightCount, const float *bitCenters, uint32_t bitCount, bool invert, int32_t *dst, uint32_t dstStride)
+{
+	return fastImageSampleBitColumns(src, width, height, leftCenters, leftCount, rightCenters, rightCount, bitCenters, bitCount, invert, dst, dstStride, fastImageGatherTapsScalar);
+}
+
+/// NEON has no movemask, so the groups are transposed with the scalar 8x8 bit transposes
+static void transposeBitColumnsNeon(const uint8_t *packed, uint32_t columnCount, uint32_t *dst)
+{
+	fastImageTransposeBitColumns(packed, columnCount, dst, fastImageTransposeBitGroupScalar);
+}
+
+/// Returns the NEON kernel table
+const FastImageKernels *fastImageKernelsNeon()
+{
+	static const FastImageKernels kernels =
+	{
+		FastImageIsaNeon,
+		"neon",
+		copy2vuyToLumaNeon,
+		copyLumaToColorNeon,
+		copyColorToLumaNeon,
+		resampleNearestNeighborLumaNeon,
+		resampleNearestNeighborColorNeon,
+		resampleLerpFastLumaNeon,
+		rotate180Neon,
+		sampleLineNeon,
+		sampleLineWideNeon,
+		sampleBitColumnsNeon,
+		transposeBitColumnsNeon
+	};
+
+	return &kernels;
+}
+
+#else
+
+const FastImageKernels *fastImageKernelsNeon() { return nullptr; }
+
+#endif // defined(__ARM_NEON) || defined(__ARM_NEON__)
@@ -0,0 +1,590 @@
+//
+//  FastImageSse.cpp
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+//
+// SSE2 and AVX2 image kernels for x86 development and replay machines.
+//
+// SSE2 is the x86-64 baseline, but AVX2 is not, so the AVX2 kernels are compiled with a per-function target attribute rather than
+// a global compiler flag. They must only be called after `cpuHasAvx2()` returns true (see `fastImageKernels()`.)
+
+#include <algorithm>
+#include "FastImage.h"
+#include "FastImageCommon.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Shared scalar helpers
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Gathers a row of luma samples through a column table
+static void gatherRowLuma(const LumaSample *srcRow, const int32_t *columnTable, LumaSample *dstRow, uint32_t count)
+{
+	uint32_t x = 0;
+	for (; x + 4 <= count; x += 4)
+	{
+		dstRow[x + 0] = srcRow[columnTable[x + 0]];
+		dstRow[x + 1] = srcRow[columnTable[x + 1]];
+		dstRow[x + 2] = srcRow[columnTable[x + 2]];
+		dstRow[x + 3] = srcRow[columnTable[x + 3]];
+	}
+	for (; x < count; ++x)
+	{
+		dstRow[x] = srcRow[columnTable[x]];
+	}
+}
+
+/// Gathers a row of color samples through a column table
+static void gatherRowColor(const ColorSample *srcRow, const int32_t *columnTable, ColorSample *dstRow, uint32_t count)
+{
+	uint32_t x = 0;
+	for (; x + 4 <= count; x += 4)
+	{
+		dstRow[x + 0] = srcRow[columnTable[x + 0]];
+		dstRow[x + 1] = srcRow[columnTable[x + 1]];
+		dstRow[x + 2] = srcRow[columnTable[x + 2]];
+		dstRow[x + 3] = srcRow[columnTable[x + 3]];
+	}
+	for (; x < count; ++x)
+	{
+		dstRow[x] = srcRow[columnTable[x]];
+	}
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// SSE2
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+static void copy2vuyToLumaSse2(const NativeLumaBuffer src, NativeLumaBuffer dst, uint32_t width, uint32_t height)
+{
+	uint32_t count = width * height;
+	uint32_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		// Luma is the odd byte of each 16-bit pair
+		__m128i a = _mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 2)), 8);
+		__m128i b = _mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 2 + 16)), 8);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(a, b));
+	}
+	for (; i < count; ++i)
+	{
+		dst[i] = src[i * 2 + 1];
+	}
+}
+
+static void copyLumaToColorSse2(const NativeLumaBuffer src, NativeColorBuffer dst, uint32_t width, uint32_t height)
+{
+	uint32_t count = width * height;
+	const __m128i zero = _mm_setzero_si128();
+	uint32_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__m128i pix = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+
+		// [p p] pairs and [p 0] pairs, interleaved into [p p p 0] quads
+		__m128i pairsLo = _mm_unpacklo_epi8(pix, pix);
+		__m128i pairsHi = _mm_unpackhi_epi8(pix, pix);
+		__m128i zeroLo = _mm_unpacklo_epi8(pix, zero);
+		__m128i zeroHi = _mm_unpackhi_epi8(pix, zero);
+
+		__m128i *out = reinterpret_cast<__m128i *>(dst + i);
+		_mm_storeu_si128(out + 0, _mm_unpacklo_epi16(pairsLo, zeroLo));
+		_mm_storeu_si128(out + 1, _mm_unpackhi_epi16(pairsLo, zeroLo));
+		_mm_storeu_si128(out + 2, _mm_unpacklo_epi16(pairsHi, zeroHi));
+		_mm_storeu_si128(out + 3, _mm_unpackhi_epi16(pairsHi, zeroHi));
+	}
+	for (; i < count; ++i)
+	{
+		uint32_t pix = uint32_t(src[i]);
+		dst[i] = pix | (pix << 8) | (pix << 16);
+	}
+}
+
+/// Returns the max of the three low channels of each 32-bit pixel, in the low byte of each 32-bit lane (upper bytes are zero)
+static inline __m128i maxChannelsSse2(__m128i pix, __m128i lowByteMask)
+{
+	__m128i m = _mm_max_epu8(pix, _mm_srli_epi32(pix, 8));
+	m = _mm_max_epu8(m, _mm_srli_epi32(pix, 16));
+	return _mm_and_si128(m, lowByteMask);
+}
+
+static void copyColorToLumaSse2(const NativeColorBuffer src, NativeLumaBuffer dst, uint32_t width, uint32_t height)
+{
+	uint32_t count = width * height;
+	const __m128i lowByteMask = _mm_set1_epi32(0xff);
+	uint32_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		const __m128i *in = reinterpret_cast<const __m128i *>(src + i);
+		__m128i m0 = maxChannelsSse2(_mm_loadu_si128(in + 0), lowByteMask);
+		__m128i m1 = maxChannelsSse2(_mm_loadu_si128(in + 1), lowByteMask);
+		__m128i m2 = maxChannelsSse2(_mm_loadu_si128(in + 2), lowByteMask);
+		__m128i m3 = maxChannelsSse2(_mm_loadu_si128(in + 3), lowByteMask);
+
+		// Values are all <= 255, so the saturating packs are lossless
+		__m128i p01 = _mm_packs_epi32(m0, m1);
+		__m128i p23 = _mm_packs_epi32(m2, m3);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(p01, p23));
+	}
+	for (; i < count; ++i)
+	{
+		uint32_t pix = src[i];
+		dst[i] = uint8_t(std::max((pix>>16)&0xff, std::max((pix>>8)&0xff, pix&0xff)));
+	}
+}
+
+static void resampleNearestNeighborLumaSse2(const NativeLumaBuffer src, uint32_t srcWidth, uint32_t srcHeight, NativeLumaBuffer dst, uint32_t dstWidth, uint32_t dstHeight)
+{
+	fastImageResampleNearestNeighbor<LumaSample>(src, srcWidth, srcHeight, dst, dstWidth, dstHeight, gatherRowLuma);
+}
+
+static void resampleNearestNeighborColorSse2(const NativeColorBuffer src, uint32_t srcWidth, uint32_t srcHeight, NativeColorBuffer dst, uint32_t dstWidth, uint32_t dstHeight)
+{
+	fastImageResampleNearestNeighbor<ColorSample>(src, srcWidth, srcHeight, dst, dstWidth, dstHeight, gatherRowColor);
+}
+
+static void accumulateRowSse2(const LumaSample *row, uint16_t *acc, uint32_t count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	uint32_t x = 0;
+	for (; x + 16 <= count; x += 16)
+	{
+		__m128i pix = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x));
+		__m128i *sums = reinterpret_cast<__m128i *>(acc + x);
+		_mm_storeu_si128(sums + 0, _mm_add_epi16(_mm_loadu_si128(sums + 0), _mm_unpacklo_epi8(pix, zero)));
+		_mm_storeu_si128(sums + 1, _mm_add_epi16(_mm_loadu_si128(sums + 1), _mm_unpackhi_epi8(pix, zero)));
+	}
+	for (; x < count; ++x)
+	{
+		acc[x] += row[x];
+	}
+}
+
+static void resampleLerpFastLumaSse2(const NativeLumaBuffer src, uint32_t srcWidth, uint32_t srcHeight, NativeLumaBuffer dst, uint32_t dstWidth, uint32_t dstHeight)
+{
+	fastImageResampleLerpFast(src, srcWidth, srcHeight, dst, dstWidth, dstHeight, accumulateRowSse2);
+}
+
+/// Reverses the order of the 16 bytes in a register (SSE2 has no byte shuffle)
+static inline __m128i reverseBytesSse2(__m128i v)
+{
+	v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+	v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+	v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+	return _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+}
+
+static void swapBlocksSse2(LumaSample *topLeft, LumaSample *topRight, LumaSample *botLeft, LumaSample *botRight)
+{
+	__m128i tl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(topLeft));
+	__m128i tr = _mm_loadu_si128(reinterpret_cast<const __m128i *>(topRight));
+	__m128i bl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(botLeft));
+	__m128i br = _mm_loadu_si128(reinterpret_cast<const __m128i *>(botRight));
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(topLeft), reverseBytesSse2(br));
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(topRight), reverseBytesSse2(bl));
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(botLeft), reverseBytesSse2(tr));
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(botRight), reverseBytesSse2(tl));
+}
+
+static void rotate180Sse2(const NativeLumaBuffer buffer, uint32_t width, uint32_t height)
+{
+	fastImageRotate180<16>(buffer, width, height, swapBlocksSse2);
+}
+
+/// Loads the 16 pixels of a row run starting at `src` and stepping `step` (+/- 1), in the order they are sampled
+static inline __m128i loadRunSse2(const LumaSample *src, int32_t step)
+{
+	if (step > 0) return _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+	return reverseBytesSse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src - 15)));
+}
+
+/// Stores 16 pixels as samples (widened to 32 bits)
+static inline void storeSamplesSse2(__m128i pix, int32_t *dst)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i lo = _mm_unpacklo_epi8(pix, zero);
+	__m128i hi = _mm_unpackhi_epi8(pix, zero);
+
+	__m128i *out = reinterpret_cast<__m128i *>(dst);
+	_mm_storeu_si128(out + 0, _mm_unpacklo_epi16(lo, zero));
+	_mm_storeu_si128(out + 1, _mm_unpackhi_epi16(lo, zero));
+	_mm_storeu_si128(out + 2, _mm_unpacklo_epi16(hi, zero));
+	_mm_storeu_si128(out + 3, _mm_unpackhi_epi16(hi, zero));
+}
+
+static void sampleRowSse2(const LumaSample *src, int32_t count, int32_t step, bool invert, int32_t *dst)
+{
+	// 255 - luma is a flip of every bit
+	const __m128i flip = _mm_set1_epi8(invert ? -1 : 0);
+	int32_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		storeSamplesSse2(_mm_xor_si128(loadRunSse2(src + i * step, step), flip), dst + i);
+	}
+	fastImageSampleRowScalar(src + i * step, count - i, step, invert, dst + i);
+}
+
+static void sampleRowWideSse2(const LumaSample *src, int32_t stride, int32_t count, int32_t step, int32_t *dst)
+{
+	const __m128i zero = _mm_setzero_si128();
+	int32_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		const LumaSample *run = src + i * step;
+		__m128i a = loadRunSse2(run - stride, step);
+		__m128i b = loadRunSse2(run, step);
+		__m128i c = loadRunSse2(run + stride, step);
+
+		// (a + 2b + c) / 4 fits in 16 bits, and the result fits back into 8 bits
+		__m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(c, zero)), _mm_slli_epi16(_mm_unpacklo_epi8(b, zero), 1));
+		__m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(c, zero)), _mm_slli_epi16(_mm_unpackhi_epi8(b, zero), 1));
+		storeSamplesSse2(_mm_packus_epi16(_mm_srli_epi16(lo, 2), _mm_srli_epi16(hi, 2)), dst + i);
+	}
+	fastImageSampleRowWideScalar(src + i * step, stride, count - i, step, dst + i);
+}
+
+/// SSE2 has no gather, so lines that aren't split into row runs are sampled with the scalar walk sampler
+static uint32_t sampleLineSse2(const NativeLumaBuffer src, uint32_t width, uint32_t height, int32_t x0, int32_t y0, int32_t x1, int32_t y1, bool invert, int32_t *dst)
+{
+	return fastImageSampleLine(src, width, height, x0, y0, x1, y1, false, invert, dst, sampleRowSse2, sampleRowWideSse2, fastImageSampleWalkScalar);
+}
+
+static uint32_t sampleLineWideSse2(const NativeLumaBuffer src, uint32_t width, uint32_t height, int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t *dst)
+{
+	return fastImageSampleLine(src, width, height, x0, y0, x1, y1, true, false, dst, sampleRowSse2, sampleRowWideSse2, fastImageSampleWalkScalar);
+}
+
+/// SSE2 has no gather, so the taps are gathered one at a time
+static uint32_t sampleBitColumnsSse2(const NativeLumaBuffer src, uint32_t width, uint32_t height, const NativePoint *leftCenters, uint32_t leftCount, const NativePoint *rightCenters, uint32_t rightCount, const float *bitCenters, uint32_t bitCount, bool invert, int32_t *dst, uint32_t dstStride)
+{
+	return fastImageSampleBitColumns(src, width, height, leftCenters, leftCount, rightCenters, rightCount, bitCenters, bitCount, invert, dst, dstStride, fastImageGatherTapsScalar);
+}
+
+/// Transposes one group of packed bits with movemasks, sixteen rows at a time
+///
+/// A movemask collects the top bit of every byte (column 7); adding the bytes to themselves shifts the next column up into it.
+static void transposeBitGroupSse2(const uint8_t *group, uint32_t *words)
+{
+	__m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+	__m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group + 16));
+	for (int column = 7; column >= 0; --column)
+	{
+		words[column] = static_cast<uint32_t>(_mm_movemask_epi8(lo)) | static_cast<uint32_t>(_mm_movemask_epi8(hi)) << 16;
+		lo = _mm_add_epi8(lo, lo);
+		hi = _mm_add_epi8(hi, hi);
+	}
+}
+
+static void transposeBitColumnsSse2(const uint8_t *packed, uint32_t columnCount, uint32_t *dst)
+{
+	fastImageTransposeBitColumns(packed, columnCount, dst, transposeBitGroupSse2);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// AVX2
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+AVX2_TARGET static void copy2vuyToLumaAvx2(const NativeLumaBuffer src, NativeLumaBuffer dst, uint32_t width, uint32_t height)
+{
+	uint32_t count = width * height;
+	uint32_t i = 0;
+	for (; i + 32 <= count; i += 32)
+	{
+		__m256i a = _mm256_srli_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 2)), 8);
+		__m256i b = _mm256_srli_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 2 + 32)), 8);
+
+		// The pack works per 128-bit lane, so restore the qword order afterwards
+		__m256i packed = _mm256_packus_epi16(a, b);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+	}
+	copy2vuyToLumaSse2(src + i * 2, dst + i, count - i, 1);
+}
+
+AVX2_TARGET static void copyLumaToColorAvx2(const NativeLumaBuffer src, NativeColorBuffer dst, uint32_t width, uint32_t height)
+{
+	uint32_t count = width * height;
+	uint32_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i pix = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i)));
+		pix = _mm256_or_si256(pix, _mm256_or_si256(_mm256_slli_epi32(pix, 8), _mm256_slli_epi32(pix, 16)));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), pix);
+	}
+	copyLumaToColorSse2(src + i, dst + i, count - i, 1);
+}
+
+AVX2_TARGET static inline __m256i maxChannelsAvx2(__m256i pix, __m256i lowByteMask)
+{
+	__m256i m = _mm256_max_epu8(pix, _mm256_srli_epi32(pix, 8));
+	m = _mm256_max_epu8(m, _mm256_srli_epi32(pix, 16));
+	return _mm256_and_si256(m, lowByteMask);
+}
+
+AVX2_TARGET static void copyColorToLumaAvx2(const NativeColorBuffer src, NativeLumaBuffer dst, uint32_t width, uint32_t height)
+{
+	uint32_t count = width * height;
+	const __m256i lowByteMask = _mm256_set1_epi32(0xff);
+	const __m256i laneOrder = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	uint32_t i = 0;
+	for (; i + 32 <= count; i += 32)
+	{
+		const __m256i *in = reinterpret_cast<const __m256i *>(src + i);
+		__m256i m0 = maxChannelsAvx2(_mm256_loadu_si256(in + 0), lowByteMask);
+		__m256i m1 = maxChannelsAvx2(_mm256_loadu_si256(in + 1), lowByteMask);
+		__m256i m2 = maxChannelsAvx2(_mm256_loadu_si256(in + 2), lowByteMask);
+		__m256i m3 = maxChannelsAvx2(_mm256_loadu_si256(in + 3), lowByteMask);
+
+		// The packs work per 128-bit lane, so restore the dword order afterwards
+		__m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(m0, m1), _mm256_packs_epi32(m2, m3));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_permutevar8x32_epi32(packed, laneOrder));
+	}
+	copyColorToLumaSse2(src + i, dst + i, count - i, 1);
+}
+
+AVX2_TARGET static void gatherRowColorAvx2(const ColorSample *srcRow, const int32_t *columnTable, ColorSample *dstRow, uint32_t count)
+{
+	uint32_t x = 0;
+	for (; x + 8 <= count; x += 8)
+	{
+		__m256i columns = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(columnTable + x));
+		__m256i pix = _mm256_i32gather_epi32(reinterpret_cast<const int *>(srcRow), columns, 4);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dstRow + x), pix);
+	}
+	for (; x < count; ++x)
+	{
+		dstRow[x] = srcRow[columnTable[x]];
+	}
+}
+
+static void resampleNearestNeighborColorAvx2(const NativeColorBuffer src, uint32_t srcWidth, uint32_t srcHeight, NativeColorBuffer dst, uint32_t dstWidth, uint32_t dstHeight)
+{
+	fastImageResampleNearestNeighbor<ColorSample>(src, srcWidth, srcHeight, dst, dstWidth, dstHeight, gatherRowColorAvx2);
+}
+
+AVX2_TARGET static void accumulateRowAvx2(const LumaSample *row, uint16_t *acc, uint32_t count)
+{
+	uint32_t x = 0;
+	for (; x + 16 <= count; x += 16)
+	{
+		__m256i pix = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x)));
+		__m256i *sums = reinterpret_cast<__m256i *>(acc + x);
+		_mm256_storeu_si256(sums, _mm256_add_epi16(_mm256_loadu_si256(sums), pix));
+	}
+	for (; x < count; ++x)
+	{
+		acc[x] += row[x];
+	}
+}
+
+static void resampleLerpFastLumaAvx2(const NativeLumaBuffer src, uint32_t srcWidth, uint32_t srcHeight, NativeLumaBuffer dst, uint32_t dstWidth, uint32_t dstHeight)
+{
+	fastImageResampleLerpFast(src, srcWidth, srcHeight, dst, dstWidth, dstHeight, accumulateRowAvx2);
+}
+
+/// Reverses the order of the 32 bytes in a register
+AVX2_TARGET static inline __m256i reverseBytesAvx2(__m256i v)
+{
+	const __m256i reverseLanes = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+	                                              15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+	v = _mm256_shuffle_epi8(v, reverseLanes);
+	return _mm256_permute4x64_epi64(v, _MM_SHUFFLE(1, 0, 3, 2));
+}
+
+AVX2_TARGET static void swapBlocksAvx2(LumaSample *topLeft, LumaSample *topRight, LumaSample *botLeft, LumaSample *botRight)
+{
+	__m256i tl = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(topLeft));
+	__m256i tr = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(topRight));
+	__m256i bl = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(botLeft));
+	__m256i br = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(botRight));
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(topLeft), reverseBytesAvx2(br));
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(topRight), reverseBytesAvx2(bl));
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(botLeft), reverseBytesAvx2(tr));
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(botRight), reverseBytesAvx2(tl));
+}
+
+static void rotate180Avx2(const NativeLumaBuffer buffer, uint32_t width, uint32_t height)
+{
+	fastImageRotate180<32>(buffer, width, height, swapBlocksAvx2);
+}
+
+/// Gathers the pixel at each of the eight byte `offsets` from `src` into the low byte of each 32-bit lane
+AVX2_TARGET static inline __m256i gatherLumaAvx2(const LumaSample *src, __m256i offsets)
+{
+	__m256i pix = _mm256_i32gather_epi32(reinterpret_cast<const int *>(src), offsets, 1);
+	return _mm256_and_si256(pix, _mm256_set1_epi32(0xff));
+}
+
+/// Samples a line walk eight pixels at a time with gathers
+///
+/// Each gather reads four bytes per pixel, so vectors that would read past `readLimit` are left to the scalar sampler.
+AVX2_TARGET static void sampleWalkAvx2(const LumaSample *src, int32_t majorStride, int32_t minorStride, int32_t minor, int32_t minorStep, int32_t count, int32_t wideOffset, bool invert, int32_t readLimit, int32_t *dst)
+{
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256i majorsStep = _mm256_set1_epi32(majorStride * 8);
+	const __m256i minorsStep = _mm256_set1_epi32(minorStep * 8);
+	const __m256i minorStrides = _mm256_set1_epi32(minorStride);
+	const __m256i flip = _mm256_set1_epi32(invert ? 0xff : 0);
+	const __m256i limit = _mm256_set1_epi32(readLimit - 4 - wideOffset);
+
+	__m256i majors = _mm256_mullo_epi32(lanes, _mm256_set1_epi32(majorStride));
+	__m256i minors = _mm256_add_epi32(_mm256_set1_epi32(minor), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(minorStep)));
+
+	int32_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i offsets = _mm256_add_epi32(majors, _mm256_mullo_epi32(_mm256_srai_epi32(minors, kFastImageFixedShift), minorStrides));
+		if (_mm256_movemask_epi8(_mm256_cmpgt_epi32(offsets, limit)) != 0) break;
+
+		__m256i pix;
+		if (wideOffset == 0)
+		{
+			pix = _mm256_xor_si256(gatherLumaAvx2(src, offsets), flip);
+		}
+		else
+		{
+			__m256i a = gatherLumaAvx2(src - wideOffset, offsets);
+			__m256i b = gatherLumaAvx2(src, offsets);
+			__m256i c = gatherLumaAvx2(src + wideOffset, offsets);
+			pix = _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(a, c), _mm256_slli_epi32(b, 1)), 2);
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), pix);
+
+		majors = _mm256_add_epi32(majors, majorsStep);
+		minors = _mm256_add_epi32(minors, minorsStep);
+	}
+
+	fastImageSampleWalkScalar(src + i * majorStride, majorStride, minorStride, minor + i * minorStep, minorStep, count - i, wideOffset, invert, readLimit - i * majorStride, dst + i);
+}
+
+/// Row runs are contiguous, so they share the SSE2 samplers; gathers are used for everything else
+static uint32_t sampleLineAvx2(const NativeLumaBuffer src, uint32_t width, uint32_t height, int32_t x0, int32_t y0, int32_t x1, int32_t y1, bool invert, int32_t *dst)
+{
+	return fastImageSampleLine(src, width, height, x0, y0, x1, y1, false, invert, dst, sampleRowSse2, sampleRowWideSse2, sampleWalkAvx2);
+}
+
+static uint32_t sampleLineWideAvx2(const NativeLumaBuffer src, uint32_t width, uint32_t height, int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t *dst)
+{
+	return fastImageSampleLine(src, width, height, x0, y0, x1, y1, true, false, dst, sampleRowSse2, sampleRowWideSse2, sampleWalkAvx2);
+}
+
+/// Gathers the three taps of eight samples at a time
+///
+/// Each gather reads four bytes per pixel, so vectors with any tap that would read past `readLimit` are left to the scalar
+/// gatherer.
+AVX2_TARGET static void gatherTapsAvx2(const LumaSample *src, const int32_t *aOffsets, const int32_t *bOffsets, const int32_t *cOffsets, int32_t count, bool invert, int32_t readLimit, int32_t *dst)
+{
+	const __m256i flip = _mm256_set1_epi32(invert ? 0xff : 0);
+	const __m256i limit = _mm256_set1_epi32(readLimit - 4);
+
+	int32_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i aOffs = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(aOffsets + i));
+		__m256i bOffs = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bOffsets + i));
+		__m256i cOffs = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cOffsets + i));
+		__m256i over = _mm256_or_si256(_mm256_cmpgt_epi32(aOffs, limit), _mm256_or_si256(_mm256_cmpgt_epi32(bOffs, limit), _mm256_cmpgt_epi32(cOffs, limit)));
+		if (_mm256_movemask_epi8(over) != 0) break;
+
+		__m256i a = _mm256_xor_si256(gatherLumaAvx2(src, aOffs), flip);
+		__m256i b = _mm256_xor_si256(gatherLumaAvx2(src, bOffs), flip);
+		__m256i c = _mm256_xor_si256(gatherLumaAvx2(src, cOffs), flip);
+
+		// a + 6b + c, as a + c + 4b + 2b
+		__m256i sum = _mm256_add_epi32(_mm256_add_epi32(a, c), _mm256_add_epi32(_mm256_slli_epi32(b, 2), _mm256_slli_epi32(b, 1)));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_srli_epi32(sum, 3));
+	}
+
+	fastImageGatherTapsScalar(src, aOffsets + i, bOffsets + i, cOffsets + i, count - i, invert, readLimit, dst + i);
+}
+
+static uint32_t sampleBitColumnsAvx2(const NativeLumaBuffer src, uint32_t width, uint32_t height, const NativePoint *leftCenters, uint32_t leftCount, const NativePoint *rightCenters, uint32_t rightCount, const float *bitCenters, uint32_t bitCount, bool invert, int32_t *dst, uint32_t dstStride)
+{
+	return fastImageSampleBitColumns(src, width, height, leftCenters, leftCount, rightCenters, rightCount, bitCenters, bitCount, invert, dst, dstStride, gatherTapsAvx2);
+}
+
+/// Transposes one group of packed bits with movemasks, all 32 rows at a time (see `transposeBitGroupSse2()`)
+AVX2_TARGET static void transposeBitGroupAvx2(const uint8_t *group, uint32_t *words)
+{
+	__m256i rows = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(group));
+	for (int column = 7; column >= 0; --column)
+	{
+		words[column] = static_cast<uint32_t>(_mm256_movemask_epi8(rows));
+		rows = _mm256_add_epi8(rows, rows);
+	}
+}
+
+static void transposeBitColumnsAvx2(const uint8_t *packed, uint32_t columnCount, uint32_t *dst)
+{
+	fastImageTransposeBitColumns(packed, columnCount, dst, transposeBitGroupAvx2);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Kernel tables
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Returns the SSE2 kernel table
+const FastImageKernels *fastImageKernelsSse2()
+{
+	static const FastImageKernels kernels =
+	{
+		FastImageIsaSse2,
+		"sse2",
+		copy2vuyToLumaSse2,
+		copyLumaToColorSse2,
+		copyColorToLumaSse2,
+		resampleNearestNeighborLumaSse2,
+		resampleNearestNeighborColorSse2,
+		resampleLerpFastLumaSse2,
+		rotate180Sse2,
+		sampleLineSse2,
+		sampleLineWideSse2,
+		sampleBitColumnsSse2,
+		transposeBitColumnsSse2
+	};
+
+	return &kernels;
+}
+
+/// Returns the AVX2 kernel table
+///
+/// There is no AVX2 gather for bytes, so luma nearest-neighbor resampling shares the SSE2 kernel
+const FastImageKernels *fastImageKernelsAvx2()
+{
+	static const FastImageKernels kernels =
+	{
+		FastImageIsaAvx2,
+		"avx2",
+		copy2vuyToLumaAvx2,
+		copyLumaToColorAvx2,
+		copyColorToLumaAvx2,
+		resampleNearestNeighborLumaSse2,
+		resampleNearestNeighborColorAvx2,
+		resampleLerpFastLumaAvx2,
+		rotate180Avx2,
+		sampleLineAvx2,
+		sampleLineWideAvx2,
+		sampleBitColumnsAvx2,
+		transposeBitColumnsAvx2
+	};
+
+	return &kernels;
+}
+
+#else
+
+const FastImageKernels *fastImageKernelsSse2() { return nullptr; }
+const FastImageKernels *fastImageKernelsAvx2() { return nullptr; }
+
+#endif // defined(__x86_64__) || defined(__i386__)
@@ -0,0 +1,149 @@
+//
+//  FrameArena.cpp
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#include <assert.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#include "FrameArena.h"
+#include "Logger.h"
+
+using namespace std;
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Local constants
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// The smallest block the arena will use
+static const size_t kMinimumCapacity = 4096;
+
+/// The number of overflowing allocations per frame that can be tracked without growing the tracking list
+static const size_t kOverflowReservation = 256;
+
+/// `std::max()` takes its arguments by reference, so the class constant needs a definition (or unoptimized builds fail to link)
+const size_t FrameArena::kMinimumAlignment;
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Local helpers
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Returns `value` rounded up to a multiple of `alignment` (a power of two)
+static inline size_t roundUp(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/// Returns `size` bytes from the heap aligned to `alignment` (a power of two), or nullptr on failure
+static void *heapAllocate(size_t size, size_t alignment)
+{
+	void *pMemory = nullptr;
+	if (posix_memalign(&pMemory, max(alignment, FrameArena::kMinimumAlignment), max(size, (size_t) 1)) != 0) return nullptr;
+	return pMemory;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Construction
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Initialization and deinitialization
+///
+/// The arena starts with a block of `capacity` bytes, which grows as needed (see `reset()`.)
+FrameArena::FrameArena(size_t capacity)
+	: mCapacity(roundUp(max(capacity, kMinimumCapacity), kMinimumAlignment)), mOffset(0), mAllocations(0)
+{
+	mpBlock = static_cast<uint8_t *>(heapAllocate(mCapacity, kMinimumAlignment));
+	if (!mpBlock)
+	{
+		Logger::error(SSTR << "FrameArena: Unable to allocate " << mCapacity << " bytes; all allocations will use the heap");
+		mCapacity = 0;
+	}
+
+	mOverflow.reserve(kOverflowReservation);
+}
+
+/// Releases the block and any heap allocations from the current frame
+FrameArena::~FrameArena()
+{
+	for (void *pMemory : mOverflow) free(pMemory);
+	free(mpBlock);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Allocation
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Returns `size` bytes aligned to `alignment` (a power of two), valid until the next `reset()`
+///
+/// This is safe to call from any number of threads at once. Returns nullptr only if the heap is exhausted.
+void *FrameArena::allocate(size_t size, size_t alignment)
+{
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+	mAllocations.fetch_add(1, memory_order_relaxed);
+
+	// The block (and every reservation) is aligned to kMinimumAlignment, so larger alignments reserve enough to align within
+	size_t padding = alignment > kMinimumAlignment ? alignment - kMinimumAlignment : 0;
+	size_t reserved = roundUp(max(size, (size_t) 1) + padding, kMinimumAlignment);
+	size_t offset = mOffset.fetch_add(reserved, memory_order_relaxed);
+	if (offset + reserved <= mCapacity)
+	{
+		return reinterpret_cast<void *>(roundUp(reinterpret_cast<uintptr_t>(mpBlock + offset), alignment));
+	}
+
+	// The block is full, so this one comes from the heap
+	void *pMemory = heapAllocate(size, alignment);
+	if (pMemory)
+	{
+		lock_guard<mutex> lock(mOverflowMutex);
+		mOverflow.push_back(pMemory);
+	}
+	return pMemory;
+}
+
+/// Releases everything allocated since the previous reset, returning the statistics for that frame
+///
+/// If the frame overflowed the block, the block is replaced with one large enough to hold the whole frame. This must not be
+/// called while any thread is allocating, nor while any allocation is still in use.
+NativeFrameArenaStats FrameArena::reset()
+{
+	size_t used = mOffset.load(memory_order_relaxed);
+
+	NativeFrameArenaStats stats;
+	stats.allocations = mAllocations.load(memory_order_relaxed);
+	stats.heapAllocations = static_cast<uint32_t>(mOverflow.size());
+	stats.bytesUsed = used;
+
+	for (void *pMemory : mOverflow) free(pMemory);
+	mOverflow.clear();
+
+	// Grow to fit this frame, so the next one like it is served entirely from the block
+	if (used > mCapacity)
+	{
+		size_t capacity = max(mCapacity, kMinimumCapacity);
+		while (capacity < used) capacity *= 2;
+
+		uint8_t *pBlock = static_cast<uint8_t *>(heapAllocate(capacity, kMinimumAlignment));
+		if (pBlock)
+		{
+			free(mpBlock);
+			mpBlock = pBlock;
+			mCapacity = capacity;
+			stats.heapAllocations += 1;
+		}
+	}
+
+	stats.capacity = mCapacity;
+
+	mOffset.store(0, memory_order_relaxed);
+	mAllocations.store(0, memory_order_relaxed);
+	return stats;
+}
@@ -0,0 +1,81 @@
+//
+//  FrameArena.h
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "include/NativeTaskTypes.h"
+
+/// A bump allocator for temporaries that live no longer than a single frame
+///
+/// Allocations are carved from a single block by bumping an atomic offset, so any number of threads may allocate at once
+/// without locking. Nothing is freed individually; the whole arena is released at once by `reset()` at the end of the frame.
+///
+/// If a frame needs more than the block holds, the excess is served from the heap (and counted.) At the end of that frame the
+/// block grows to fit it, so a steady stream of similar frames settles into serving everything from the block.
+class FrameArena
+{
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Local constants
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Every allocation is aligned (and sized) to at least this many bytes
+	public: static const size_t kMinimumAlignment = 16;
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Construction
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Initialization and deinitialization
+	///
+	/// The arena starts with a block of `capacity` bytes, which grows as needed (see `reset()`.)
+	public: FrameArena(size_t capacity);
+
+	/// Releases the block and any heap allocations from the current frame
+	public: ~FrameArena();
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Allocation
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Returns `size` bytes aligned to `alignment` (a power of two), valid until the next `reset()`
+	///
+	/// This is safe to call from any number of threads at once. Returns nullptr only if the heap is exhausted.
+	public: void *allocate(size_t size, size_t alignment);
+
+	/// Releases everything allocated since the previous reset, returning the statistics for that frame
+	///
+	/// If the frame overflowed the block, the block is replaced with one large enough to hold the whole frame. This must not be
+	/// called while any thread is allocating, nor while any allocation is still in use.
+	public: NativeFrameArenaStats reset();
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Data members
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// The block that allocations are carved from, and its size in bytes
+	private: uint8_t *mpBlock;
+	private: size_t mCapacity;
+
+	/// The number of bytes reserved from the block this frame (this may run past `mCapacity` once the block has overflowed)
+	private: std::atomic<size_t> mOffset;
+
+	/// The number of allocations this frame
+	private: std::atomic<uint32_t> mAllocations;
+
+	/// Allocations that overflowed the block this frame, served from the heap
+	private: std::mutex mOverflowMutex;
+	private: std::vector<void *> mOverflow;
+};
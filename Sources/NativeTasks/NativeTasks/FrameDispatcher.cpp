@@ -0,0 +1,283 @@
+//
+//  FrameDispatcher.cpp
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#include <string.h>
+#include <algorithm>
+
+#include "FrameDispatcher.h"
+#include "FastImage.h"
+#include "Logger.h"
+
+using namespace std;
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Local helpers
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Returns `roi` clamped to a frame of `frameWidth` x `frameHeight`, trimmed to whole bins
+static NativeCaptureRoi clampRoi(NativeCaptureRoi roi, uint32_t frameWidth, uint32_t frameHeight)
+{
+	if (roi.width == 0 || roi.height == 0)
+	{
+		roi.x = 0;
+		roi.y = 0;
+		roi.width = frameWidth;
+		roi.height = frameHeight;
+	}
+
+	roi.width = min(roi.width, frameWidth);
+	roi.height = min(roi.height, frameHeight);
+	roi.x = min(roi.x, frameWidth - roi.width);
+	roi.y = min(roi.y, frameHeight - roi.height);
+
+	if (roi.binning != 2 && roi.binning != 4) roi.binning = 1;
+	if (roi.width < roi.binning || roi.height < roi.binning) roi.binning = 1;
+	roi.width -= roi.width % roi.binning;
+	roi.height -= roi.height % roi.binning;
+	return roi;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Construction
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Initialization and deinitialization
+///
+/// `capacity` is the maximum number of frames waiting for delivery with the FIFO policy (the latest-frame policy only ever
+/// keeps one.) The dispatcher is created stopped; see `start()`.
+FrameDispatcher::FrameDispatcher(NativeCaptureFrameReceiver receiver, FrameDispatchRelease release, void *releaseContext, NativeFrameDispatchPolicy policy, unsigned int capacity)
+	: mReceiver(receiver), mRelease(release), mpReleaseContext(releaseContext), mPolicy(policy), mCapacity(max(capacity, 1u)),
+	  mRunning(false), mTotalLatencyMicroseconds(0)
+{
+	memset(&mRoi, 0, sizeof(mRoi));
+	memset(&mDeliveredRoi, 0, sizeof(mDeliveredRoi));
+	resetStats();
+}
+
+/// Stops the dispatcher (see `stop()`)
+FrameDispatcher::~FrameDispatcher()
+{
+	stop();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Control
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Starts the worker thread (does nothing if already running)
+void FrameDispatcher::start()
+{
+	lock_guard<mutex> lock(mMutex);
+	if (mRunning) return;
+
+	mRunning = true;
+	mThread = thread(&FrameDispatcher::run, this);
+}
+
+/// Stops the worker thread
+///
+/// Frames waiting for delivery are dropped. If a frame is being delivered, this waits for the receiver to return. No frames are
+/// delivered after this returns.
+void FrameDispatcher::stop()
+{
+	deque<Frame> dropped;
+	{
+		lock_guard<mutex> lock(mMutex);
+		if (!mRunning) return;
+
+		mRunning = false;
+		dropped.swap(mQueue);
+		mStats.depth = 0;
+	}
+
+	mCondition.notify_all();
+	if (mThread.joinable())
+	{
+		mThread.join();
+	}
+
+	dropFrames(dropped);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Frame submission
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Queues a frame for delivery; this never waits on the receiver
+///
+/// Returns false if the frame was dropped, in which case it has already been released.
+bool FrameDispatcher::submit(LumaSample *luma, uint32_t width, uint32_t height, void *handle)
+{
+	Frame frame;
+	frame.luma = luma;
+	frame.width = width;
+	frame.height = height;
+	frame.handle = handle;
+	frame.submitted = chrono::steady_clock::now();
+
+	deque<Frame> dropped;
+	bool queued = false;
+	{
+		lock_guard<mutex> lock(mMutex);
+		mStats.framesSubmitted += 1;
+
+		if (!mRunning)
+		{
+			dropped.push_back(frame);
+		}
+		else if (mPolicy == NativeFrameDispatchPolicyLatest)
+		{
+			// The newest frame wins: anything still waiting is stale
+			dropped.swap(mQueue);
+			mQueue.push_back(frame);
+			queued = true;
+		}
+		else if (mQueue.size() < mCapacity)
+		{
+			mQueue.push_back(frame);
+			queued = true;
+		}
+		else
+		{
+			// FIFO and full: keep the order intact and drop the new frame
+			dropped.push_back(frame);
+		}
+
+		mStats.depth = static_cast<uint32_t>(mQueue.size());
+		mStats.maxDepth = max(mStats.maxDepth, mStats.depth);
+	}
+
+	if (queued)
+	{
+		mCondition.notify_one();
+	}
+
+	dropFrames(dropped);
+	return queued;
+}
+
+/// Releases frames that were dropped, counting them
+///
+/// Must be called without holding the lock
+void FrameDispatcher::dropFrames(const deque<Frame> &frames)
+{
+	if (frames.empty()) return;
+
+	for (const Frame &frame : frames)
+	{
+		mRelease(mpReleaseContext, frame.handle);
+	}
+
+	lock_guard<mutex> lock(mMutex);
+	mStats.framesDropped += static_cast<uint32_t>(frames.size());
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Region of interest
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Sets the region of each frame to deliver, taking effect with the next frame delivered
+///
+/// A zero width or height denotes the full frame. The region is clamped to each frame as it is delivered.
+void FrameDispatcher::setRoi(const NativeCaptureRoi &roi)
+{
+	lock_guard<mutex> lock(mMutex);
+	mRoi = roi;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Statistics
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Returns the current statistics
+NativeFrameDispatchStats FrameDispatcher::stats() const
+{
+	lock_guard<mutex> lock(mMutex);
+	return mStats;
+}
+
+/// Reset our tracked statistics
+void FrameDispatcher::resetStats()
+{
+	lock_guard<mutex> lock(mMutex);
+	uint32_t depth = static_cast<uint32_t>(mQueue.size());
+	memset(&mStats, 0, sizeof(mStats));
+	mStats.depth = depth;
+	mStats.maxDepth = depth;
+	mTotalLatencyMicroseconds = 0;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Implementation
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Worker thread: delivers frames until stopped
+void FrameDispatcher::run()
+{
+	for (;;)
+	{
+		Frame frame;
+		NativeCaptureRoi roi;
+		{
+			unique_lock<mutex> lock(mMutex);
+			mCondition.wait(lock, [this]() { return !mRunning || !mQueue.empty(); });
+			if (!mRunning) return;
+
+			frame = mQueue.front();
+			mQueue.pop_front();
+
+			// Track the delivery latency
+			int64_t latency = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - frame.submitted).count();
+			mStats.lastLatencyMicroseconds = static_cast<uint32_t>(latency);
+			mStats.maxLatencyMicroseconds = max(mStats.maxLatencyMicroseconds, mStats.lastLatencyMicroseconds);
+			mStats.depth = static_cast<uint32_t>(mQueue.size());
+			mStats.framesDelivered += 1;
+			mTotalLatencyMicroseconds += static_cast<uint64_t>(latency);
+			mStats.meanLatencyMicroseconds = static_cast<uint32_t>(mTotalLatencyMicroseconds / mStats.framesDelivered);
+			roi = mRoi;
+		}
+
+		// Crop to the region of interest, returning the frame's buffer right away
+		mDeliveredRoi = clampRoi(roi, frame.width, frame.height);
+		if (mDeliveredRoi.binning != 1 || mDeliveredRoi.width != frame.width || mDeliveredRoi.height != frame.height)
+		{
+			uint32_t width = mDeliveredRoi.width / mDeliveredRoi.binning;
+			uint32_t height = mDeliveredRoi.height / mDeliveredRoi.binning;
+			mRoiBuffer.resize(width * height);
+			cropLuma(frame.luma, frame.width, mDeliveredRoi.x, mDeliveredRoi.y, mDeliveredRoi.width, mDeliveredRoi.height, mDeliveredRoi.binning, mRoiBuffer.data());
+			mRelease(mpReleaseContext, frame.handle);
+
+			frame.luma = mRoiBuffer.data();
+			frame.width = width;
+			frame.height = height;
+			frame.handle = nullptr;
+		}
+
+		try
+		{
+			(*mReceiver)(frame.luma, frame.width, frame.height);
+		}
+		catch(std::exception &ex)
+		{
+			Logger::error(SSTR << "Caught unexpected exception during frame delivery: " << ex.what());
+		}
+		catch(...)
+		{
+			Logger::error(SSTR << "Caught unknown exception during frame delivery");
+		}
+
+		if (frame.handle)
+		{
+			mRelease(mpReleaseContext, frame.handle);
+		}
+	}
+}
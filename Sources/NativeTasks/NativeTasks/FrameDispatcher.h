@@ -0,0 +1,169 @@
+//
+//  FrameDispatcher.h
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include "include/NativeTaskTypes.h"
+
+/// Returns a frame to its owner once it has been delivered (or dropped)
+///
+/// `handle` is the handle passed to `FrameDispatcher::submit()`
+typedef void (*FrameDispatchRelease)(void *context, void *handle);
+
+/// Delivers captured frames to a receiver on a dedicated worker thread
+///
+/// The capture callback submits frames without waiting on the receiver, so the camera's buffers keep flowing while a frame is
+/// being processed. Frames are not copied: each frame is owned by the dispatcher from `submit()` until it is handed back
+/// through the release function, after delivery or when it is dropped.
+///
+/// Frames that can't be queued (according to the policy) are dropped and counted, rather than silently lost.
+///
+/// If a region of interest is set, each frame is cropped (and binned) on the worker thread and its buffer is released before
+/// delivery; the receiver is handed the cropped copy.
+class FrameDispatcher
+{
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Local types
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// A frame waiting for delivery
+	private: struct Frame
+	{
+		LumaSample *luma;
+		uint32_t width;
+		uint32_t height;
+		void *handle;
+		std::chrono::steady_clock::time_point submitted;
+	};
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Construction
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Initialization and deinitialization
+	///
+	/// `capacity` is the maximum number of frames waiting for delivery with the FIFO policy (the latest-frame policy only ever
+	/// keeps one.) The dispatcher is created stopped; see `start()`.
+	public: FrameDispatcher(NativeCaptureFrameReceiver receiver, FrameDispatchRelease release, void *releaseContext, NativeFrameDispatchPolicy policy, unsigned int capacity);
+
+	/// Stops the dispatcher (see `stop()`)
+	public: ~FrameDispatcher();
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Control
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Starts the worker thread (does nothing if already running)
+	public: void start();
+
+	/// Stops the worker thread
+	///
+	/// Frames waiting for delivery are dropped. If a frame is being delivered, this waits for the receiver to return. No frames are
+	/// delivered after this returns.
+	public: void stop();
+
+	/// Returns the maximum number of frames the dispatcher can hold at once (queued frames plus the one being delivered)
+	///
+	/// This is the number of buffers the owner must be able to spare.
+	public: unsigned int maxFramesHeld() const { return queueCapacity() + 1; }
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Frame submission
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Queues a frame for delivery; this never waits on the receiver
+	///
+	/// Returns false if the frame was dropped, in which case it has already been released.
+	public: bool submit(LumaSample *luma, uint32_t width, uint32_t height, void *handle);
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Region of interest
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Sets the region of each frame to deliver, taking effect with the next frame delivered
+	///
+	/// A zero width or height denotes the full frame. The region is clamped to each frame as it is delivered.
+	public: void setRoi(const NativeCaptureRoi &roi);
+
+	/// Returns the region of the frame currently being delivered
+	///
+	/// This is only valid on the worker thread (i.e., from within the receiver.)
+	public: const NativeCaptureRoi &deliveredRoi() const { return mDeliveredRoi; }
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Statistics
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Returns the current statistics
+	public: NativeFrameDispatchStats stats() const;
+
+	/// Reset our tracked statistics
+	public: void resetStats();
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Implementation
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Returns the maximum number of frames waiting for delivery
+	private: unsigned int queueCapacity() const { return mPolicy == NativeFrameDispatchPolicyLatest ? 1 : mCapacity; }
+
+	/// Worker thread: delivers frames until stopped
+	private: void run();
+
+	/// Releases frames that were dropped, counting them
+	///
+	/// Must be called without holding the lock
+	private: void dropFrames(const std::deque<Frame> &frames);
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Data members
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Frame receiver and the owner's release function
+	private: NativeCaptureFrameReceiver mReceiver;
+	private: FrameDispatchRelease mRelease;
+	private: void *mpReleaseContext;
+
+	/// Queueing policy and capacity
+	private: NativeFrameDispatchPolicy mPolicy;
+	private: unsigned int mCapacity;
+
+	/// Frames waiting for delivery
+	private: std::deque<Frame> mQueue;
+
+	/// The requested region of interest, and the region of the frame being delivered (worker thread only)
+	private: NativeCaptureRoi mRoi;
+	private: NativeCaptureRoi mDeliveredRoi;
+
+	/// Holds the cropped frame being delivered (worker thread only)
+	private: std::vector<LumaSample> mRoiBuffer;
+
+	/// Is the worker accepting and delivering frames?
+	private: bool mRunning;
+
+	/// Guards the queue, running state and statistics
+	private: mutable std::mutex mMutex;
+	private: std::condition_variable mCondition;
+
+	/// The worker thread
+	private: std::thread mThread;
+
+	/// Statistics
+	private: NativeFrameDispatchStats mStats;
+	private: uint64_t mTotalLatencyMicroseconds;
+};
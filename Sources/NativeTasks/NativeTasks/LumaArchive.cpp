@@ -0,0 +1,488 @@
+//
+//  LumaArchive.cpp
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+#include "LumaArchive.h"
+#include "LumaCodec.h"
+#include "Logger.h"
+
+using namespace std;
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Local helpers
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Returns `value` rounded up to a multiple of `kLumaArchiveAlignment`
+static inline uint64_t alignRecord(uint64_t value)
+{
+	return (value + kLumaArchiveAlignment - 1) & ~uint64_t(kLumaArchiveAlignment - 1);
+}
+
+/// Writes all `size` bytes of `data` to `fd` at `offset`
+///
+/// Returns false on error
+static bool writeFully(int fd, const void *data, size_t size, uint64_t offset)
+{
+	const uint8_t *pData = static_cast<const uint8_t *>(data);
+	while (size > 0)
+	{
+		ssize_t written = pwrite(fd, pData, size, static_cast<off_t>(offset));
+		if (written < 0 && errno == EINTR) continue;
+		if (written <= 0) return false;
+
+		pData += written;
+		size -= static_cast<size_t>(written);
+		offset += static_cast<uint64_t>(written);
+	}
+
+	return true;
+}
+
+/// Reserves the space from `offset` to `offset + size` in the file, so that writing it doesn't have to extend the file
+///
+/// Returns false on error (most likely, the disk is full)
+static bool preallocate(int fd, uint64_t offset, uint64_t size)
+{
+#if defined(__linux__)
+	int result = posix_fallocate(fd, static_cast<off_t>(offset), static_cast<off_t>(size));
+	if (result == 0) return true;
+
+	// Not every filesystem can preallocate, so fall back to extending the file
+	if (result != EOPNOTSUPP && result != EINVAL) return false;
+#endif
+
+	return ftruncate(fd, static_cast<off_t>(offset + size)) == 0;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+//  __        __    _ _
+//  \ \      / / __(_) |_ ___ _ __
+//   \ \ /\ / / '__| | __/ _ \ '__|
+//    \ V  V /| |  | | ||  __/ |
+//     \_/\_/ |_|  |_|\__\___|_|
+//
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Initialization and deinitialization
+///
+/// The writer is created closed; see `open()`.
+LumaArchiveWriter::LumaArchiveWriter()
+	: mFd(-1), mPreallocation(kDefaultPreallocation), mAllocatedSize(0), mCompress(false), mNextOffset(0), mPendingBytes(0),
+	  mFailed(false), mClosing(false)
+{
+}
+
+/// Closes the archive (see `close()`)
+LumaArchiveWriter::~LumaArchiveWriter()
+{
+	close();
+}
+
+/// Creates the archive at `path` (replacing any existing file), preallocating `preallocation` bytes at a time (0 for
+/// `kDefaultPreallocation`), and compressing frames if `compress` is set
+///
+/// Returns false on error
+bool LumaArchiveWriter::open(const string &path, uint64_t preallocation, bool compress)
+{
+	close();
+
+	mFd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (mFd < 0)
+	{
+		Logger::error(SSTR << "Unable to create luma archive: " << path);
+		return false;
+	}
+
+	mPath = path;
+	mPreallocation = preallocation > 0 ? alignRecord(preallocation) : kDefaultPreallocation;
+	mAllocatedSize = 0;
+	mCompress = compress;
+	mOffsets.clear();
+	mPendingBytes = 0;
+	mFailed = false;
+	mClosing = false;
+
+	// The header goes out first (without an index), so that the archive can be recovered if it is never closed
+	LumaArchiveHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, kLumaArchiveMagic, sizeof(header.magic));
+	header.version = kLumaArchiveVersion;
+	mNextOffset = alignRecord(sizeof(header));
+
+	if (!write(&header, sizeof(header), 0))
+	{
+		Logger::error(SSTR << "Unable to write luma archive: " << path);
+		::close(mFd);
+		mFd = -1;
+		return false;
+	}
+
+	mThread = thread(&LumaArchiveWriter::run, this);
+	return true;
+}
+
+/// Appends a frame of `width` x `height` packed samples, along with `headerSize` bytes of header data
+///
+/// Returns false if the archive isn't open, the frame is too large, or an earlier write has failed.
+bool LumaArchiveWriter::append(const LumaSample *luma, uint32_t width, uint32_t height, const void *header, uint32_t headerSize)
+{
+	if (mFd < 0 || width > UINT16_MAX || height > UINT16_MAX) return false;
+	if (headerSize > 0 && !header) return false;
+
+	LumaArchiveRecord record;
+	memset(&record, 0, sizeof(record));
+	memcpy(record.magic, kLumaArchiveRecordMagic, sizeof(record.magic));
+	record.width = static_cast<uint16_t>(width);
+	record.height = static_cast<uint16_t>(height);
+	record.encoding = kLumaArchiveEncodingRaw;
+	record.headerSize = headerSize;
+	record.payloadSize = width * height;
+
+	size_t size = static_cast<size_t>(alignRecord(sizeof(record) + record.headerSize + record.payloadSize));
+
+	PendingRecord pending;
+	{
+		unique_lock<mutex> lock(mMutex);
+		if (mFailed) return false;
+
+		// Don't let the writes fall too far behind (a single record larger than the limit is still allowed through)
+		mCondition.wait(lock, [&]() { return mFailed || mPending.empty() || mPendingBytes + size <= kMaxPendingBytes; });
+		if (mFailed) return false;
+
+		if (!mSpareBuffers.empty())
+		{
+			pending.data.swap(mSpareBuffers.back());
+			mSpareBuffers.pop_back();
+		}
+	}
+
+	// Build the record outside of the lock (the buffer's capacity is reused, so this is just the copy)
+	pending.data.resize(size);
+	uint8_t *pData = pending.data.data();
+	memcpy(pData, &record, sizeof(record));
+	if (record.headerSize > 0) memcpy(pData + sizeof(record), header, record.headerSize);
+	memcpy(pData + sizeof(record) + record.headerSize, luma, record.payloadSize);
+	memset(pData + sizeof(record) + record.headerSize + record.payloadSize, 0, size - sizeof(record) - record.headerSize - record.payloadSize);
+
+	{
+		lock_guard<mutex> lock(mMutex);
+		mPendingBytes += size;
+		mPending.push_back(move(pending));
+	}
+	mCondition.notify_all();
+
+	return true;
+}
+
+/// Waits for every frame to be written, then writes the index and closes the archive (does nothing if not open)
+///
+/// Returns false if any part of the archive failed to write.
+bool LumaArchiveWriter::close()
+{
+	if (mFd < 0) return true;
+
+	{
+		lock_guard<mutex> lock(mMutex);
+		mClosing = true;
+	}
+	mCondition.notify_all();
+	if (mThread.joinable())
+	{
+		mThread.join();
+	}
+
+	bool succeeded = !mFailed;
+	if (succeeded)
+	{
+		// The index follows the last record, and the header is updated to point to it
+		LumaArchiveIndex index;
+		memcpy(index.magic, kLumaArchiveIndexMagic, sizeof(index.magic));
+		index.frameCount = static_cast<uint32_t>(mOffsets.size());
+
+		LumaArchiveHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, kLumaArchiveMagic, sizeof(header.magic));
+		header.version = kLumaArchiveVersion;
+		header.indexOffset = mNextOffset;
+		header.frameCount = index.frameCount;
+
+		uint64_t end = mNextOffset + sizeof(index) + mOffsets.size() * sizeof(uint64_t);
+		succeeded = write(&index, sizeof(index), mNextOffset) &&
+		            (mOffsets.empty() || write(mOffsets.data(), mOffsets.size() * sizeof(uint64_t), mNextOffset + sizeof(index))) &&
+		            writeFully(mFd, &header, sizeof(header), 0) &&
+		            ftruncate(mFd, static_cast<off_t>(end)) == 0;
+	}
+	else
+	{
+		// Whatever was written before the failure can still be recovered (see `LumaArchiveReader::open()`), so keep it
+		Logger::warn(SSTR << "Luma archive left without an index after a failed write: " << mPath);
+	}
+
+	if (::close(mFd) != 0) succeeded = false;
+	if (!succeeded)
+	{
+		Logger::error(SSTR << "Failed to write luma archive: " << mPath);
+	}
+
+	mFd = -1;
+	mPending.clear();
+	mSpareBuffers.clear();
+	mOffsets.clear();
+	mEncodeBuffer.clear();
+	return succeeded;
+}
+
+/// Background thread: writes records until closed
+void LumaArchiveWriter::run()
+{
+	unique_lock<mutex> lock(mMutex);
+	for(;;)
+	{
+		mCondition.wait(lock, [&]() { return mClosing || !mPending.empty(); });
+		if (mPending.empty()) break;
+
+		PendingRecord pending = move(mPending.front());
+		mPending.pop_front();
+		size_t pendingBytes = pending.data.size();
+
+		lock.unlock();
+		bool written = false;
+		if (!mFailed)
+		{
+			if (mCompress) compress(pending.data);
+
+			written = write(pending.data.data(), pending.data.size(), mNextOffset);
+			mOffsets.push_back(mNextOffset);
+			mNextOffset += pending.data.size();
+		}
+		lock.lock();
+
+		if (!written) mFailed = true;
+		mPendingBytes -= pendingBytes;
+		mSpareBuffers.push_back(move(pending.data));
+		mCondition.notify_all();
+	}
+}
+
+/// Compresses the samples of the raw record in `data` in place, unless that wouldn't make it any smaller
+void LumaArchiveWriter::compress(vector<uint8_t> &data)
+{
+	LumaArchiveRecord *pRecord = reinterpret_cast<LumaArchiveRecord *>(data.data());
+	uint8_t *pPayload = data.data() + sizeof(LumaArchiveRecord) + pRecord->headerSize;
+
+	mEncodeBuffer.resize(lumaCodecMaxEncodedSize(pRecord->width, pRecord->height));
+	size_t encodedSize = lumaCodecEncode(pPayload, pRecord->width, pRecord->height, mEncodeBuffer.data());
+	if (encodedSize >= pRecord->payloadSize) return;
+
+	pRecord->encoding = kLumaArchiveEncodingLumaCodec;
+	pRecord->payloadSize = static_cast<uint32_t>(encodedSize);
+	memcpy(pPayload, mEncodeBuffer.data(), encodedSize);
+
+	size_t end = sizeof(LumaArchiveRecord) + pRecord->headerSize + encodedSize;
+	size_t size = static_cast<size_t>(alignRecord(end));
+	memset(data.data() + end, 0, size - end);
+	data.resize(size);
+}
+
+/// Writes `size` bytes at `offset`, preallocating space as needed
+///
+/// Returns false on error
+bool LumaArchiveWriter::write(const void *data, size_t size, uint64_t offset)
+{
+	uint64_t end = offset + size;
+	if (end > mAllocatedSize)
+	{
+		uint64_t allocation = max(mPreallocation, alignRecord(end - mAllocatedSize));
+		if (!preallocate(mFd, mAllocatedSize, allocation)) return false;
+		mAllocatedSize += allocation;
+	}
+
+	return writeFully(mFd, data, size, offset);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+//   ____                _
+//  |  _ \ ___  __ _  __| | ___ _ __
+//  | |_) / _ \/ _` |/ _` |/ _ \ '__|
+//  |  _ <  __/ (_| | (_| |  __/ |
+//  |_| \_\___|\__,_|\__,_|\___|_|
+//
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Initialization and deinitialization
+///
+/// The reader is created closed; see `open()`.
+LumaArchiveReader::LumaArchiveReader()
+	: mpBase(nullptr), mSize(0), mpOffsets(nullptr), mFrameCount(0)
+{
+}
+
+/// Closes the archive (see `close()`)
+LumaArchiveReader::~LumaArchiveReader()
+{
+	close();
+}
+
+/// Maps the archive at `path`
+///
+/// If the archive has no index (it was never closed), its records are walked to recover every complete frame.
+///
+/// Returns false if the file can't be mapped or isn't a luma archive
+bool LumaArchiveReader::open(const string &path)
+{
+	close();
+
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+	{
+		Logger::error(SSTR << "Unable to open luma archive: " << path);
+		return false;
+	}
+
+	void *base = MAP_FAILED;
+	struct stat info;
+	if (fstat(fd, &info) == 0 && static_cast<uint64_t>(info.st_size) >= sizeof(LumaArchiveHeader))
+	{
+		mSize = static_cast<uint64_t>(info.st_size);
+		base = mmap(nullptr, static_cast<size_t>(mSize), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	}
+	::close(fd);
+
+	if (base == MAP_FAILED)
+	{
+		Logger::error(SSTR << "Unable to map luma archive: " << path);
+		mSize = 0;
+		return false;
+	}
+
+	mpBase = static_cast<uint8_t *>(base);
+
+	const LumaArchiveHeader *pHeader = reinterpret_cast<const LumaArchiveHeader *>(mpBase);
+	if (memcmp(pHeader->magic, kLumaArchiveMagic, sizeof(pHeader->magic)) != 0 || pHeader->version != kLumaArchiveVersion)
+	{
+		Logger::error(SSTR << "Not a luma archive (or an unsupported version): " << path);
+		close();
+		return false;
+	}
+
+	// Use the index if it's intact
+	uint64_t indexOffset = pHeader->indexOffset;
+	if (indexOffset != 0 && indexOffset % kLumaArchiveAlignment == 0 && indexOffset <= mSize - sizeof(LumaArchiveIndex))
+	{
+		const LumaArchiveIndex *pIndex = reinterpret_cast<const LumaArchiveIndex *>(mpBase + indexOffset);
+		uint64_t indexEnd = indexOffset + sizeof(LumaArchiveIndex) + uint64_t(pIndex->frameCount) * sizeof(uint64_t);
+		if (memcmp(pIndex->magic, kLumaArchiveIndexMagic, sizeof(pIndex->magic)) == 0 && pIndex->frameCount == pHeader->frameCount && indexEnd <= mSize)
+		{
+			mpOffsets = reinterpret_cast<const uint64_t *>(mpBase + indexOffset + sizeof(LumaArchiveIndex));
+			mFrameCount = pIndex->frameCount;
+			return true;
+		}
+	}
+
+	recoverOffsets();
+	Logger::warn(SSTR << "Luma archive has no index (recovered " << mFrameCount << " frame(s)): " << path);
+	return true;
+}
+
+/// Unmaps the archive; frames read from it are no longer valid
+void LumaArchiveReader::close()
+{
+	if (mpBase)
+	{
+		munmap(mpBase, static_cast<size_t>(mSize));
+	}
+
+	mpBase = nullptr;
+	mSize = 0;
+	mpOffsets = nullptr;
+	mFrameCount = 0;
+	mRecoveredOffsets.clear();
+	mDecodeBuffer.clear();
+}
+
+/// Fills `frame` with frame `index` of the archive, valid until the archive is closed (or, for a compressed frame, until the
+/// next frame is read)
+///
+/// Returns false if `index` is out of range or the frame's record is invalid
+bool LumaArchiveReader::frame(uint32_t index, NativeLumaArchiveFrame &frame) const
+{
+	if (index >= mFrameCount) return false;
+
+	const LumaArchiveRecord *pRecord = recordAt(mpOffsets[index]);
+	if (!pRecord) return false;
+
+	const uint8_t *pHeader = reinterpret_cast<const uint8_t *>(pRecord + 1);
+	const uint8_t *pPayload = pHeader + pRecord->headerSize;
+	if (pRecord->encoding == kLumaArchiveEncodingRaw)
+	{
+		frame.luma = const_cast<LumaSample *>(pPayload);
+	}
+	else if (pRecord->encoding == kLumaArchiveEncodingLumaCodec)
+	{
+		mDecodeBuffer.resize(size_t(pRecord->width) * pRecord->height);
+		if (!lumaCodecDecode(pPayload, pRecord->payloadSize, pRecord->width, pRecord->height, mDecodeBuffer.data()))
+		{
+			Logger::error(SSTR << "Luma archive frame " << index << " failed to decode");
+			return false;
+		}
+
+		frame.luma = mDecodeBuffer.data();
+	}
+	else
+	{
+		return false;
+	}
+
+	frame.width = pRecord->width;
+	frame.height = pRecord->height;
+	frame.header = pHeader;
+	frame.headerSize = pRecord->headerSize;
+	return true;
+}
+
+/// Returns the record at `offset`, or null if it doesn't fit within the archive or is invalid
+const LumaArchiveRecord *LumaArchiveReader::recordAt(uint64_t offset) const
+{
+	if (offset < sizeof(LumaArchiveHeader) || offset % kLumaArchiveAlignment != 0 || offset > mSize - sizeof(LumaArchiveRecord)) return nullptr;
+
+	const LumaArchiveRecord *pRecord = reinterpret_cast<const LumaArchiveRecord *>(mpBase + offset);
+	if (memcmp(pRecord->magic, kLumaArchiveRecordMagic, sizeof(pRecord->magic)) != 0) return nullptr;
+	if (pRecord->encoding == kLumaArchiveEncodingRaw && pRecord->payloadSize != uint32_t(pRecord->width) * pRecord->height) return nullptr;
+	if (pRecord->encoding == kLumaArchiveEncodingLumaCodec && pRecord->payloadSize > lumaCodecMaxEncodedSize(pRecord->width, pRecord->height)) return nullptr;
+	if (offset + sizeof(LumaArchiveRecord) + pRecord->headerSize + pRecord->payloadSize > mSize) return nullptr;
+
+	return pRecord;
+}
+
+/// Finds every complete record by walking them from the start of the archive (see `open()`)
+void LumaArchiveReader::recoverOffsets()
+{
+	mRecoveredOffsets.clear();
+
+	// The walk ends at the first incomplete record; anything after it (the preallocated space) is unwritten
+	uint64_t offset = alignRecord(sizeof(LumaArchiveHeader));
+	while (const LumaArchiveRecord *pRecord = recordAt(offset))
+	{
+		mRecoveredOffsets.push_back(offset);
+		offset += alignRecord(sizeof(LumaArchiveRecord) + pRecord->headerSize + pRecord->payloadSize);
+	}
+
+	mpOffsets = mRecoveredOffsets.data();
+	mFrameCount = static_cast<uint32_t>(mRecoveredOffsets.size());
+}
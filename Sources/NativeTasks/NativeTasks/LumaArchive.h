@@ -0,0 +1,312 @@
+//
+//  LumaArchive.h
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "include/NativeTaskTypes.h"
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// File format
+// ---------------------------------------------------------------------------------------------------------------------------------
+//
+// A luma archive holds any number of frames in a single file:
+//
+//		LumaArchiveHeader
+//		LumaArchiveRecord, header data, samples, padding (to kLumaArchiveAlignment)   <- one per frame
+//		...
+//		LumaArchiveIndex, uint64_t offset of each record
+//
+// The header data of each frame is the same as the user data of a `.luma` file (the temporal state of the frame.) Values are
+// stored in native byte order, as they are in `.luma` files. The samples are stored raw or compressed (see `LumaCodec.h`), as
+// given by each record's encoding.
+//
+// The index is written when the archive is closed, at which point the header is updated to point to it. An archive that was
+// never closed (e.g., the process died while writing) has no index; its records are found by walking them from the start.
+
+/// The header at the start of every luma archive
+struct LumaArchiveHeader
+{
+	/// Always `kLumaArchiveMagic`
+	char magic[4];
+
+	/// The version of the archive format (see `kLumaArchiveVersion`)
+	uint32_t version;
+
+	/// The offset of the index, or 0 if the archive was never closed
+	uint64_t indexOffset;
+
+	/// The number of frames in the index
+	uint32_t frameCount;
+
+	/// Reserved (zero)
+	uint32_t reserved[3];
+};
+
+/// The header of each frame's record
+struct LumaArchiveRecord
+{
+	/// Always `kLumaArchiveRecordMagic`
+	char magic[4];
+
+	/// Frame dimensions
+	uint16_t width;
+	uint16_t height;
+
+	/// How the samples are stored (see `kLumaArchiveEncodingRaw` and `kLumaArchiveEncodingLumaCodec`)
+	uint32_t encoding;
+
+	/// Sizes of the header data and the samples that follow this record, in bytes
+	uint32_t headerSize;
+	uint32_t payloadSize;
+
+	/// Reserved (zero)
+	uint32_t reserved;
+};
+
+/// The header of the index (the offset of each record follows)
+struct LumaArchiveIndex
+{
+	/// Always `kLumaArchiveIndexMagic`
+	char magic[4];
+
+	/// The number of offsets that follow
+	uint32_t frameCount;
+};
+
+static_assert(sizeof(LumaArchiveHeader) == 32, "LumaArchiveHeader must not contain padding");
+static_assert(sizeof(LumaArchiveRecord) == 24, "LumaArchiveRecord must not contain padding");
+static_assert(sizeof(LumaArchiveIndex) == 8, "LumaArchiveIndex must not contain padding");
+
+/// Identifies a luma archive, each of its records and its index
+const char kLumaArchiveMagic[4] = { 'N', 'M', 'L', 'A' };
+const char kLumaArchiveRecordMagic[4] = { 'N', 'M', 'L', 'F' };
+const char kLumaArchiveIndexMagic[4] = { 'N', 'M', 'L', 'I' };
+
+/// Increment this when the format changes
+const uint32_t kLumaArchiveVersion = 1;
+
+/// Records (and the index) start on multiples of this many bytes
+const uint32_t kLumaArchiveAlignment = 16;
+
+/// Samples are stored as packed rows of `width` samples
+const uint32_t kLumaArchiveEncodingRaw = 0;
+
+/// Samples are stored losslessly compressed by `lumaCodecEncode()`
+const uint32_t kLumaArchiveEncodingLumaCodec = 1;
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Writer
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Appends frames to a new luma archive
+///
+/// Appending only copies the frame into a buffer (reused from frame to frame); the writing happens on a background thread, which
+/// also preallocates the file's space in large chunks so that the filesystem isn't extended a frame at a time. If the writes fall
+/// too far behind, appending waits for them to catch up.
+///
+/// When compressing, frames are compressed on the background thread as well, just before they are written (a frame that doesn't
+/// get any smaller is stored raw.) Since a record's size isn't known until then, that is also where records are given their
+/// place in the file.
+///
+/// Frames must be appended from one thread at a time.
+class LumaArchiveWriter
+{
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Local constants
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// The default amount of space to preallocate at a time
+	public: static const uint64_t kDefaultPreallocation = 16 * 1024 * 1024;
+
+	/// Appending waits while more than this many bytes are waiting to be written
+	private: static const size_t kMaxPendingBytes = 32 * 1024 * 1024;
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Local types
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// A record waiting to be written (with raw samples, until it is compressed)
+	private: struct PendingRecord
+	{
+		std::vector<uint8_t> data;
+	};
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Construction
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Initialization and deinitialization
+	///
+	/// The writer is created closed; see `open()`.
+	public: LumaArchiveWriter();
+
+	/// Closes the archive (see `close()`)
+	public: ~LumaArchiveWriter();
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Writing
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Creates the archive at `path` (replacing any existing file), preallocating `preallocation` bytes at a time (0 for
+	/// `kDefaultPreallocation`), and compressing frames if `compress` is set
+	///
+	/// Returns false on error
+	public: bool open(const std::string &path, uint64_t preallocation, bool compress);
+
+	/// Appends a frame of `width` x `height` packed samples, along with `headerSize` bytes of header data
+	///
+	/// Returns false if the archive isn't open, the frame is too large, or an earlier write has failed.
+	public: bool append(const LumaSample *luma, uint32_t width, uint32_t height, const void *header, uint32_t headerSize);
+
+	/// Waits for every frame to be written, then writes the index and closes the archive (does nothing if not open)
+	///
+	/// Returns false if any part of the archive failed to write.
+	public: bool close();
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Implementation
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Background thread: writes records until closed
+	private: void run();
+
+	/// Compresses the samples of the raw record in `data` in place, unless that wouldn't make it any smaller
+	private: void compress(std::vector<uint8_t> &data);
+
+	/// Writes `size` bytes at `offset`, preallocating space as needed
+	///
+	/// Returns false on error
+	private: bool write(const void *data, size_t size, uint64_t offset);
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Data members
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// The archive's path and file descriptor (-1 when closed)
+	private: std::string mPath;
+	private: int mFd;
+
+	/// The amount of space to preallocate at a time, and the end of the space preallocated so far
+	private: uint64_t mPreallocation;
+	private: uint64_t mAllocatedSize;
+
+	/// Set if frames are compressed
+	private: bool mCompress;
+
+	/// The offset of the next record (owned by the background thread while open)
+	private: uint64_t mNextOffset;
+
+	/// The offset of every record written (owned by the background thread while open)
+	private: std::vector<uint64_t> mOffsets;
+
+	/// Compressed samples, reused from frame to frame (owned by the background thread)
+	private: std::vector<uint8_t> mEncodeBuffer;
+
+	/// Records waiting to be written, the bytes they hold, and spent buffers kept for reuse
+	private: std::deque<PendingRecord> mPending;
+	private: size_t mPendingBytes;
+	private: std::vector<std::vector<uint8_t>> mSpareBuffers;
+
+	/// Set when a write fails; nothing more is written
+	private: bool mFailed;
+
+	/// Set to ask the background thread to finish (once everything pending is written)
+	private: bool mClosing;
+
+	/// Guards the pending records, spare buffers and flags
+	private: std::mutex mMutex;
+	private: std::condition_variable mCondition;
+	private: std::thread mThread;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Reader
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Reads frames from a luma archive, mapped into memory
+///
+/// Any frame can be read directly through the index without reading the frames before it. The mapping is private, so the
+/// samples of a frame may be modified in place without changing the file.
+///
+/// Raw frames are read in place, without copying. Compressed frames are decoded into a buffer owned by the reader, which is
+/// reused by the next frame read; frames must therefore be read from one thread at a time.
+class LumaArchiveReader
+{
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Construction
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Initialization and deinitialization
+	///
+	/// The reader is created closed; see `open()`.
+	public: LumaArchiveReader();
+
+	/// Closes the archive (see `close()`)
+	public: ~LumaArchiveReader();
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Reading
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Maps the archive at `path`
+	///
+	/// If the archive has no index (it was never closed), its records are walked to recover every complete frame.
+	///
+	/// Returns false if the file can't be mapped or isn't a luma archive
+	public: bool open(const std::string &path);
+
+	/// Unmaps the archive; frames read from it are no longer valid
+	public: void close();
+
+	/// Returns the number of frames in the archive
+	public: uint32_t frameCount() const { return mFrameCount; }
+
+	/// Fills `frame` with frame `index` of the archive, valid until the archive is closed (or, for a compressed frame, until the
+	/// next frame is read)
+	///
+	/// Returns false if `index` is out of range or the frame's record is invalid
+	public: bool frame(uint32_t index, NativeLumaArchiveFrame &frame) const;
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Implementation
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Returns the record at `offset`, or null if it doesn't fit within the archive or is invalid
+	private: const LumaArchiveRecord *recordAt(uint64_t offset) const;
+
+	/// Finds every complete record by walking them from the start of the archive (see `open()`)
+	private: void recoverOffsets();
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Data members
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// The mapped archive and its size in bytes
+	private: uint8_t *mpBase;
+	private: uint64_t mSize;
+
+	/// The offset of each record: within the mapped index, or `mRecoveredOffsets` for an archive without one
+	private: const uint64_t *mpOffsets;
+	private: uint32_t mFrameCount;
+	private: std::vector<uint64_t> mRecoveredOffsets;
+
+	/// The samples of the last compressed frame read
+	private: mutable std::vector<LumaSample> mDecodeBuffer;
+};
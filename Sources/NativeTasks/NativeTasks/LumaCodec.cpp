@@ -0,0 +1,331 @@
+//
+//  LumaCodec.cpp
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#include <vector>
+
+#include "LumaCodec.h"
+
+using namespace std;
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Local constants
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// The number of contexts (see `context()`)
+static const uint32_t kContextCount = 8;
+
+/// A code with this many leading zeros is an escape: the mapped error follows as 8 raw bits
+static const uint32_t kEscapeZeros = 16;
+
+/// The largest Rice parameter (beyond this, an 8-bit error costs more than an escape)
+static const uint32_t kMaxRiceParameter = 7;
+
+/// Each context's running totals are halved once they cover this many samples, so that they follow local changes
+static const uint32_t kContextResetCount = 64;
+
+/// The starting total of the errors in each context (as JPEG-LS does for 8-bit samples)
+static const uint32_t kContextInitialTotal = 4;
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Local types
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// The recent errors coded in a context: their total and their count
+struct RiceContext
+{
+	uint32_t total;
+	uint32_t count;
+
+	RiceContext() : total(kContextInitialTotal), count(1) {}
+
+	/// Returns the Rice parameter for the next error: the smallest `k` for which `count << k` covers the total (roughly, the
+	/// number of bits in the mean error)
+	inline uint32_t parameter() const
+	{
+		uint32_t k = 0;
+		while ((count << k) < total && k < kMaxRiceParameter) ++k;
+		return k;
+	}
+
+	/// Adds `error` to the context's totals
+	inline void update(uint32_t error)
+	{
+		total += error;
+		if (++count == kContextResetCount)
+		{
+			total >>= 1;
+			count >>= 1;
+		}
+	}
+};
+
+/// Writes codes, most significant bit first, as big-endian 32-bit words
+class BitWriter
+{
+	public: BitWriter(uint8_t *pDst) : mpDst(pDst), mBits(0), mBitCount(0) {}
+
+	/// Writes the low `count` bits (at most 32) of `value`
+	public: inline void write(uint32_t value, uint32_t count)
+	{
+		mBits = (mBits << count) | value;
+		mBitCount += count;
+		if (mBitCount >= 32)
+		{
+			mBitCount -= 32;
+			storeWord(static_cast<uint32_t>(mBits >> mBitCount));
+		}
+	}
+
+	/// Writes any remaining bits (padded with zeros to a whole word), returning the number of bytes written
+	public: size_t finish(const uint8_t *pStart)
+	{
+		if (mBitCount > 0)
+		{
+			storeWord(static_cast<uint32_t>(mBits << (32 - mBitCount)));
+			mBitCount = 0;
+		}
+
+		return static_cast<size_t>(mpDst - pStart);
+	}
+
+	private: inline void storeWord(uint32_t word)
+	{
+		mpDst[0] = static_cast<uint8_t>(word >> 24);
+		mpDst[1] = static_cast<uint8_t>(word >> 16);
+		mpDst[2] = static_cast<uint8_t>(word >> 8);
+		mpDst[3] = static_cast<uint8_t>(word);
+		mpDst += 4;
+	}
+
+	private: uint8_t *mpDst;
+	private: uint64_t mBits;
+	private: uint32_t mBitCount;
+};
+
+/// Reads codes written by `BitWriter`
+///
+/// Reading past the end of the data reads zeros; `overrun()` reports whether that happened.
+class BitReader
+{
+	public: BitReader(const uint8_t *pSrc, size_t size)
+	: mpSrc(pSrc), mpEnd(pSrc + (size & ~size_t(3))), mBits(0), mBitCount(0), mOverrunBits(0)
+	{}
+
+	/// Ensures at least 32 bits are available to `peek()`
+	public: inline void refill()
+	{
+		if (mBitCount > 32) return;
+
+		uint64_t word = 0;
+		if (mpSrc < mpEnd)
+		{
+			word = (uint32_t(mpSrc[0]) << 24) | (uint32_t(mpSrc[1]) << 16) | (uint32_t(mpSrc[2]) << 8) | uint32_t(mpSrc[3]);
+			mpSrc += 4;
+		}
+		else
+		{
+			mOverrunBits += 32;
+		}
+
+		mBits |= word << (32 - mBitCount);
+		mBitCount += 32;
+	}
+
+	/// Returns the next 64 bits (of which at least 32 are valid), most significant first
+	public: inline uint64_t peek() const { return mBits; }
+
+	/// Consumes `count` bits
+	public: inline void skip(uint32_t count)
+	{
+		mBits <<= count;
+		mBitCount -= count;
+	}
+
+	/// Returns true if more bits were consumed than the data holds
+	public: bool overrun() const { return mOverrunBits > mBitCount; }
+
+	private: const uint8_t *mpSrc;
+	private: const uint8_t *mpEnd;
+	private: uint64_t mBits;
+	private: uint32_t mBitCount;
+	private: uint32_t mOverrunBits;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Local helpers
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Returns the prediction of a sample from its neighbors to the left (`a`), above (`b`) and above-left (`c`)
+///
+/// This is the median edge detector: across a horizontal or vertical edge it picks the neighbor on the sample's side of the
+/// edge, and elsewhere it assumes a smooth gradient.
+static inline int predict(int a, int b, int c)
+{
+	int lo = a < b ? a : b;
+	int hi = a < b ? b : a;
+	if (c >= hi) return lo;
+	if (c <= lo) return hi;
+	return a + b - c;
+}
+
+/// Returns the context of a sample from its neighbors (see `predict()`): the bit length of their local gradient, so that areas
+/// of similar activity share their statistics
+static inline uint32_t context(int a, int b, int c)
+{
+	int dac = a - c;
+	int dbc = b - c;
+	uint32_t activity = static_cast<uint32_t>((dac < 0 ? -dac : dac) + (dbc < 0 ? -dbc : dbc));
+	if (activity == 0) return 0;
+
+	uint32_t bits = 32 - static_cast<uint32_t>(__builtin_clz(activity));
+	return bits < kContextCount ? bits : kContextCount - 1;
+}
+
+/// Maps a prediction error (modulo 256) to an unsigned value, with small errors of either sign mapping to small values
+static inline uint32_t mapError(int sample, int prediction)
+{
+	int error = static_cast<int8_t>(sample - prediction);
+	return static_cast<uint32_t>(error < 0 ? -2 * error - 1 : 2 * error);
+}
+
+/// Reverses `mapError()`, returning the sample
+static inline LumaSample unmapError(uint32_t mapped, int prediction)
+{
+	int error = static_cast<int>(mapped >> 1) ^ -static_cast<int>(mapped & 1);
+	return static_cast<LumaSample>(prediction + error);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+//  _                          ____          _
+// | |   _   _ _ __ ___   __ _/ ___|___   __| | ___  ___
+// | |  | | | | '_ ` _ \ / _` | |   / _ \ / _` |/ _ \/ __|
+// | |__| |_| | | | | | | (_| | |__| (_) | (_| |  __/ (__
+// |_____\__,_|_| |_| |_|\__,_|\____\___/ \__,_|\___|\___|
+//
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// The largest number of bytes that `lumaCodecEncode()` can produce for a frame of `width` x `height` samples
+size_t lumaCodecMaxEncodedSize(uint32_t width, uint32_t height)
+{
+	// Every sample can be an escape (kEscapeZeros + 8 bits), plus the padding of the last word
+	return (size_t(width) * height * (kEscapeZeros + 8) + 31) / 32 * 4;
+}
+
+/// Losslessly encodes a frame of `width` x `height` packed samples from `src` into `dst`, which must hold at least
+/// `lumaCodecMaxEncodedSize()` bytes
+///
+/// Returns the number of bytes written (a multiple of four.) For noise-like frames this can be larger than the frame itself.
+size_t lumaCodecEncode(const LumaSample *src, uint32_t width, uint32_t height, uint8_t *dst)
+{
+	if (width == 0 || height == 0) return 0;
+
+	BitWriter writer(dst);
+	RiceContext contexts[kContextCount];
+
+	// The first row is predicted from a row of zeros above it, which reduces the prediction to the sample on its left
+	vector<LumaSample> zeros(width, 0);
+	const LumaSample *pAbove = zeros.data();
+
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		const LumaSample *pRow = src + size_t(y) * width;
+
+		// The first sample of a row has no neighbors to its left, so it borrows the one above
+		int a = pAbove[0];
+		int c = pAbove[0];
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			int b = pAbove[x];
+			uint32_t mapped = mapError(pRow[x], predict(a, b, c));
+
+			RiceContext &ctx = contexts[context(a, b, c)];
+			uint32_t k = ctx.parameter();
+			uint32_t quotient = mapped >> k;
+			if (quotient < kEscapeZeros)
+			{
+				// `quotient` zero bits, a one, then the low `k` bits of the error
+				writer.write((1u << k) | (mapped & ((1u << k) - 1)), quotient + 1 + k);
+			}
+			else
+			{
+				writer.write(mapped, kEscapeZeros + 8);
+			}
+			ctx.update(mapped);
+
+			a = pRow[x];
+			c = b;
+		}
+
+		pAbove = pRow;
+	}
+
+	return writer.finish(dst);
+}
+
+/// Decodes a frame of `width` x `height` samples from `size` bytes of data produced by `lumaCodecEncode()`, into `dst`
+///
+/// Returns false if the data is truncated or damaged (`dst` is left partly written.)
+bool lumaCodecDecode(const uint8_t *src, size_t size, uint32_t width, uint32_t height, LumaSample *dst)
+{
+	if (width == 0 || height == 0) return size == 0;
+	if (size % 4 != 0) return false;
+
+	BitReader reader(src, size);
+	RiceContext contexts[kContextCount];
+
+	vector<LumaSample> zeros(width, 0);
+	const LumaSample *pAbove = zeros.data();
+
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		LumaSample *pRow = dst + size_t(y) * width;
+
+		int a = pAbove[0];
+		int c = pAbove[0];
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			int b = pAbove[x];
+
+			RiceContext &ctx = contexts[context(a, b, c)];
+			uint32_t k = ctx.parameter();
+
+			reader.refill();
+			uint64_t bits = reader.peek();
+			uint32_t quotient = bits == 0 ? 64 : static_cast<uint32_t>(__builtin_clzll(bits));
+
+			uint32_t mapped;
+			if (quotient < kEscapeZeros)
+			{
+				uint32_t length = quotient + 1 + k;
+				mapped = (quotient << k) | static_cast<uint32_t>((bits >> (64 - length)) & ((1u << k) - 1));
+				reader.skip(length);
+			}
+			else
+			{
+				mapped = static_cast<uint32_t>(bits >> (64 - kEscapeZeros - 8)) & 0xff;
+				reader.skip(kEscapeZeros + 8);
+			}
+
+			// A damaged code can map beyond a byte
+			if (mapped > 0xff) return false;
+			ctx.update(mapped);
+
+			pRow[x] = unmapError(mapped, predict(a, b, c));
+			a = pRow[x];
+			c = b;
+		}
+
+		pAbove = pRow;
+	}
+
+	return !reader.overrun();
+}
@@ -0,0 +1,43 @@
+//
+//  LumaCodec.h
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "include/NativeTaskTypes.h"
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Lossless luma compression
+// ---------------------------------------------------------------------------------------------------------------------------------
+//
+// Each sample is predicted from its neighbors to the left, above and above-left (the median edge detector of LOCO-I/JPEG-LS),
+// and the prediction error is Rice coded. The Rice parameter adapts to the recent errors seen in each of a handful of contexts,
+// chosen by how busy the neighborhood is, so that flat areas cost little more than a bit per sample while noisy or detailed
+// areas still code tightly. There is no dictionary and no tables to build, so a frame is coded in a single pass over its rows
+// (with the row above as the only state.)
+//
+// Encoded data is a sequence of big-endian 32-bit words of codes; it carries no dimensions of its own.
+
+/// The largest number of bytes that `lumaCodecEncode()` can produce for a frame of `width` x `height` samples
+size_t lumaCodecMaxEncodedSize(uint32_t width, uint32_t height);
+
+/// Losslessly encodes a frame of `width` x `height` packed samples from `src` into `dst`, which must hold at least
+/// `lumaCodecMaxEncodedSize()` bytes
+///
+/// Returns the number of bytes written (a multiple of four.) For noise-like frames this can be larger than the frame itself.
+size_t lumaCodecEncode(const LumaSample *src, uint32_t width, uint32_t height, uint8_t *dst);
+
+/// Decodes a frame of `width` x `height` samples from `size` bytes of data produced by `lumaCodecEncode()`, into `dst`
+///
+/// Returns false if the data is truncated or damaged (`dst` is left partly written.)
+bool lumaCodecDecode(const uint8_t *src, size_t size, uint32_t width, uint32_t height, LumaSample *dst);
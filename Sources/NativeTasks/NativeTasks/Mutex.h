@@ -10,14 +10,18 @@
 // Use of this source code is governed by a BSD-style license that can be found
 // in the LICENSE file in the root of the source tree.
 
-#if defined(USE_MMAL)
-
 #pragma once
 
+#include <assert.h>
+
+#if defined(USE_MMAL)
 extern "C"
 {
 	#include <interface/vcos/vcos_mutex.h>
 }
+#else
+#include <mutex>
+#endif // defined(USE_MMAL)
 
 /// Class that represents a mutex
 ///
@@ -41,7 +45,11 @@ class Mutex
 	private: bool mValid;
 
 	/// This is our mutex
+#if defined(USE_MMAL)
 	private: VCOS_MUTEX_T mMutex;
+#else
+	private: std::mutex mMutex;
+#endif // defined(USE_MMAL)
 
 	// -----------------------------------------------------------------------------------------------------------------------------
 	// Construction
@@ -50,8 +58,13 @@ class Mutex
 	/// Initialize the mutex with a given name
 	public: Mutex(const char *mutexName)
 	{
+#if defined(USE_MMAL)
 		VCOS_STATUS_T vst = vcos_mutex_create(&mMutex, mutexName);
 		mValid = vst == VCOS_SUCCESS;
+#else
+		(void) mutexName;
+		mValid = true;
+#endif // defined(USE_MMAL)
 
 		// Sanity check
 		assert(isValid());
@@ -60,10 +73,12 @@ class Mutex
 	/// Destruct the mutex, releasing it
 	public: ~Mutex()
 	{
+#if defined(USE_MMAL)
 		if (isValid())
 		{
 			vcos_mutex_delete(&mMutex);
 		}
+#endif // defined(USE_MMAL)
 	}
 
 	// -----------------------------------------------------------------------------------------------------------------------------
@@ -78,7 +93,11 @@ class Mutex
 		assert(isValid());
 		if (isValid())
 		{
+#if defined(USE_MMAL)
 			vcos_mutex_lock(&mMutex);
+#else
+			mMutex.lock();
+#endif // defined(USE_MMAL)
 		}
 	}
 
@@ -90,9 +109,11 @@ class Mutex
 		assert(isValid());
 		if (isValid())
 		{
+#if defined(USE_MMAL)
 			vcos_mutex_unlock(&mMutex);
+#else
+			mMutex.unlock();
+#endif // defined(USE_MMAL)
 		}
 	}
 };
-
-#endif // defined(USE_MMAL)
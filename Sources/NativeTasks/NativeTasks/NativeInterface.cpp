@@ -11,20 +11,30 @@
 // in the LICENSE file in the root of the source tree.
 
 #include <stdio.h>
+#include <string.h>
 #include <string>
 #include <stdint.h>
 #include <execinfo.h>
 
 #include "FastImage.h"
+#include "EdgeDetection.h"
+#include "ErrorCorrection.h"
+#include "FrameArena.h"
+#include "LumaArchive.h"
+#include "LumaCodec.h"
 #include "SecDescriptor.h"
 #include "Logger.h"
 
 #if defined(USE_MMAL)
 	#include <sys/vfs.h>
-	#include "include/NativeInterface.h"
 	#include "VideoCapture.h"
-	#include "VideoException.h"
 #endif // defined(USE_MMAL)
+#if defined(__linux__)
+	#include "include/NativeInterface.h"
+	#include "VideoException.h"
+	#include "ReplayCapture.h"
+	#include "V4l2Capture.h"
+#endif // defined(__linux__)
 #if defined(__MACH__)
 	#include <sys/param.h>
 	#include <sys/mount.h>
@@ -32,6 +42,36 @@
 
 using namespace std;
 
+#if defined(__linux__)
+
+/// The V4L2 device used when none is specified
+static const char *kDefaultV4l2Device = "/dev/video0";
+
+/// The selected capture backend (see `nativeVideoCaptureSelectBackend()`)
+static CaptureBackend *gpCaptureBackend = nullptr;
+
+/// Is the selected capture backend capturing?
+static bool gCaptureActive = false;
+
+/// Returns the selected capture backend
+///
+/// Until one is selected, this is the MMAL camera (or, without MMAL, the default V4L2 device)
+static CaptureBackend &captureBackend()
+{
+	if (!gpCaptureBackend)
+	{
+#if defined(USE_MMAL)
+		gpCaptureBackend = &gVideoCaptureManager;
+#else
+		gpCaptureBackend = new V4l2Capture(kDefaultV4l2Device);
+#endif // defined(USE_MMAL)
+	}
+
+	return *gpCaptureBackend;
+}
+
+#endif // defined(__linux__)
+
 extern "C"
 {
 	// -----------------------------------------------------------------------------------------------------------------------------
@@ -154,6 +194,290 @@ extern "C"
 		rotate180(buffer, width, height);
 	}
 
+	/// Samples 8-bit monochrome image `src` along the line from (`x0`, `y0`) to (`x1`, `y1`), inclusive, storing one sample per
+	/// pixel along the line's major axis into `dst` (optionally inverted, as `255 - luma`)
+	///
+	/// Returns the number of samples stored, or zero if either end point lies outside the image
+	uint32_t nativeSampleLine(const NativeLumaBuffer src, uint32_t width, uint32_t height, int32_t x0, int32_t y0, int32_t x1, int32_t y1, bool invert, int32_t *dst)
+	{
+		return sampleLine(src, width, height, x0, y0, x1, y1, invert, dst);
+	}
+
+	/// Samples 8-bit monochrome image `src` along a line as `nativeSampleLine()` does, weighting each sample with its neighbors
+	/// two pixels to either side: `(a + 2b + c) / 4`
+	///
+	/// Returns the number of samples stored, or zero if either end point lies within two pixels of the image's edge
+	uint32_t nativeSampleLineWide(const NativeLumaBuffer src, uint32_t width, uint32_t height, int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t *dst)
+	{
+		return sampleLineWide(src, width, height, x0, y0, x1, y1, dst);
+	}
+
+	/// Samples the bit columns of a deck from 8-bit monochrome image `src`, between the left and right landmark centers, storing
+	/// one row of samples per bit into `dst` (each row `dstStride` samples apart)
+	///
+	/// Returns the number of scanlines sampled, or zero if there are no centers or bits, or if any sample lies outside the image
+	uint32_t nativeSampleBitColumns(const NativeLumaBuffer src, uint32_t width, uint32_t height, const NativePoint *leftCenters, uint32_t leftCount, const NativePoint *rightCenters, uint32_t rightCount, const float *bitCenters, uint32_t bitCount, bool invert, int32_t *dst, uint32_t dstStride)
+	{
+		return sampleBitColumns(src, width, height, leftCenters, leftCount, rightCenters, rightCount, bitCenters, bitCount, invert, dst, dstStride);
+	}
+
+	/// Transposes `columnCount` packed bit columns into one word per column, storing them into `dst`
+	///
+	/// The columns are packed in groups of eight, 32 bytes per group: bit `j` of byte `i` of group `g` is row `i` of column
+	/// `g * 8 + j`. Word `c` of `dst` holds the rows of column `c`, with row `i` in bit `i`.
+	void nativeTransposeBitColumns(const uint8_t *packed, uint32_t columnCount, uint32_t *dst)
+	{
+		transposeBitColumns(packed, columnCount, dst);
+	}
+
+	/// Calculates the rolling min/max of `sampleCount` samples over a window of `windowSize` samples, storing `count` results
+	/// into `dst`
+	///
+	/// Returns the number of results stored (`max(count, windowSize)`), or zero if there are no samples
+	uint32_t nativeRollMinMax(const int32_t *samples, uint32_t sampleCount, uint32_t count, uint32_t windowSize, NativeMinMax *dst)
+	{
+		return rollMinMax(samples, sampleCount, count, windowSize, dst);
+	}
+
+	/// Detects the edges along `sampleCount` samples in a single pass, storing them into `dst`
+	///
+	/// Returns the number of edges stored, or -1 if there are too few samples to find any peaks
+	int32_t nativeDetectEdges(const int32_t *samples, uint32_t sampleCount, int32_t windowSize, int32_t minMaxWindowSize, int32_t overlap, int32_t sensitivity, int32_t minThreshold, NativeEdgePeak *dst)
+	{
+		return detectEdges(samples, sampleCount, windowSize, minMaxWindowSize, overlap, sensitivity, minThreshold, dst);
+	}
+
+	/// Returns the name of the instruction set used by the image conversion functions ("scalar", "sse2", "avx2" or "neon")
+	///
+	/// The best instruction set supported by the host CPU is selected automatically on first use
+	const char *nativeImageKernelsName()
+	{
+		return fastImageActiveKernels()->name;
+	}
+
+	/// Selects the instruction set used by the image conversion functions, by name (see `nativeImageKernelsName()`)
+	///
+	/// This is intended for testing and benchmarking. The "scalar" kernels are the reference implementation and are always
+	/// available.
+	///
+	/// Returns error string or nullptr
+	const char *nativeImageKernelsSelect(const char *name)
+	{
+		if (nullptr == name) { return "nativeImageKernelsSelect: No instruction set name specified"; }
+
+		for (int isa = 0; isa < FastImageIsaCount; ++isa)
+		{
+			const FastImageKernels *kernels = fastImageKernels(static_cast<FastImageIsa>(isa));
+			if (kernels && string(kernels->name) == name)
+			{
+				fastImageSelectIsa(kernels->isa);
+				return nullptr;
+			}
+		}
+
+		return "nativeImageKernelsSelect: Instruction set is unknown or unsupported by this CPU";
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	//  _____                       ____                          _   _
+	// | ____|_ __ _ __ ___  _ __  / ___|___  _ __ _ __ ___  ___| |_(_) ___  _ __
+	// |  _| | '__| '__/ _ \| '__| | |   / _ \| '__| '__/ _ \/ __| __| |/ _ \| '_ \
+	// | |___| |  | | | (_) | |    | |__| (_) | |  | | |  __/ (__| |_| | (_) | | | |
+	// |_____|_|  |_|  \___/|_|     \____\___/|_|  |_|  \___|\___|\__|_|\___/|_| |_|
+	//
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Returns the error correction table for `codeCount` codes of `bitCount` bits each, mapped read-only into memory
+	///
+	/// The table has one entry for each of the `1 << bitCount` possible values: the index of the code nearest to it (by Hamming
+	/// Distance), or -1 if two or more codes are equally near. Tables are built in parallel and stored in `directory`, keyed by a
+	/// hash of the codes, so that they are only built once and their pages are shared by every process that maps them. If
+	/// `directory` is null or empty (or not writable), the table is built into private memory instead.
+	///
+	/// Returns null if the codes are unsupported (more than 30 bits or 32767 codes.) Release the table with
+	/// `nativeErrorCorrectionTableClose()`.
+	const int16_t *nativeErrorCorrectionTableOpen(const char *directory, const int64_t *codes, uint32_t codeCount, uint32_t bitCount)
+	{
+		return openErrorCorrectionTable(directory, codes, codeCount, bitCount);
+	}
+
+	/// Releases a table returned by `nativeErrorCorrectionTableOpen()` (does nothing if `table` is null)
+	void nativeErrorCorrectionTableClose(const int16_t *table)
+	{
+		closeErrorCorrectionTable(table);
+	}
+
+	/// Returns the minimum Hamming Distance between any two of `codeCount` codes of `codeBits` bits each (at most `codeBits`), or
+	/// 0 if it falls below `floor`
+	///
+	/// This is Seer's `HammingDistance.calcMinimumDistance()`, comparing the pairs in cache-sized blocks with hardware popcount
+	/// (where available) and ending early once the distance falls below `floor`.
+	int32_t nativeMinimumDistance(const int64_t *codes, uint32_t codeCount, uint32_t codeBits, int32_t floor)
+	{
+		return calcMinimumDistance(codes, codeCount, codeBits, floor);
+	}
+
+	/// Stores the number of codes with each number of bits set (of the lower `bitCount` bits), after XORing each of `codeCount`
+	/// codes with `mask`, into `dst`, which must hold `bitCount + 1` counts
+	void nativeBinaryHistogram(const int64_t *codes, uint32_t codeCount, int64_t mask, uint32_t bitCount, int32_t *dst)
+	{
+		calcBinaryHistogram(codes, codeCount, mask, bitCount, dst);
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	//  _____                               _
+	// |  ___| __ __ _ _ __ ___   ___      / \   _ __ ___ _ __   __ _
+	// | |_ | '__/ _` | '_ ` _ \ / _ \    / _ \ | '__/ _ \ '_ \ / _` |
+	// |  _|| | | (_| | | | | | |  __/   / ___ \| | |  __/ | | | (_| |
+	// |_|  |_|  \__,_|_| |_| |_|\___|  /_/   \_\_|  \___|_| |_|\__,_|
+	//
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Creates an arena for temporaries that live no longer than a single frame, starting with a block of `capacity` bytes
+	///
+	/// Allocations are carved from the block without locking, from any number of threads at once, and are all released together
+	/// by `nativeFrameArenaReset()`. A frame that overflows the block is served from the heap, after which the block grows to fit.
+	///
+	/// Release the arena with `nativeFrameArenaDestroy()`.
+	void *nativeFrameArenaCreate(uint64_t capacity)
+	{
+		return new FrameArena(static_cast<size_t>(capacity));
+	}
+
+	/// Releases an arena created by `nativeFrameArenaCreate()`, along with everything allocated from it
+	void nativeFrameArenaDestroy(void *arena)
+	{
+		delete static_cast<FrameArena *>(arena);
+	}
+
+	/// Returns `size` bytes from `arena`, aligned to `alignment` (a power of two), valid until the next `nativeFrameArenaReset()`
+	///
+	/// Returns nullptr only if the heap is exhausted.
+	void *nativeFrameArenaAllocate(void *arena, uint64_t size, uint32_t alignment)
+	{
+		return static_cast<FrameArena *>(arena)->allocate(static_cast<size_t>(size), alignment);
+	}
+
+	/// Releases everything allocated from `arena` since the previous reset, returning the statistics for that frame
+	///
+	/// This must not be called while allocations are being made from `arena`, nor while any allocation is still in use.
+	NativeFrameArenaStats nativeFrameArenaReset(void *arena)
+	{
+		return static_cast<FrameArena *>(arena)->reset();
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	//  _                                _             _     _
+	// | |   _   _ _ __ ___   __ _      / \   _ __ ___| |__ (_)_   _____
+	// | |  | | | | '_ ` _ \ / _` |    / _ \ | '__/ __| '_ \| \ \ / / _ \
+	// | |__| |_| | | | | | | (_| |   / ___ \| | | (__| | | | |\ V /  __/
+	// |_____\__,_|_| |_| |_|\__,_|  /_/   \_\_|  \___|_| |_|_| \_/ \___|
+	//
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Creates a luma archive at `path` for writing (replacing any existing file), returning the writer or nullptr on error
+	///
+	/// An archive holds any number of frames, each with its header data (as the user data of a `.luma` file), followed by an
+	/// index. Frames are written on a background thread into space preallocated `preallocation` bytes at a time (0 for the
+	/// default.) If `compress` is set, frames are losslessly compressed (see `nativeLumaEncode()`) on that thread as well.
+	///
+	/// The archive must be finished with `nativeLumaArchiveWriterClose()`.
+	void *nativeLumaArchiveWriterCreate(const char *path, uint64_t preallocation, bool compress)
+	{
+		LumaArchiveWriter *pWriter = new LumaArchiveWriter();
+		if (!pWriter->open(path, preallocation, compress))
+		{
+			delete pWriter;
+			return nullptr;
+		}
+
+		return pWriter;
+	}
+
+	/// Appends a frame of `width` x `height` packed samples to `writer`, along with `headerSize` bytes of header data
+	///
+	/// This only copies the frame; it is written in the background. Frames must be appended from one thread at a time.
+	///
+	/// Returns false on error (including an earlier write that failed)
+	bool nativeLumaArchiveWriterAppend(void *writer, const LumaSample *luma, uint32_t width, uint32_t height, const void *header, uint32_t headerSize)
+	{
+		return static_cast<LumaArchiveWriter *>(writer)->append(luma, width, height, header, headerSize);
+	}
+
+	/// Waits for every frame to be written, then writes the index and releases `writer`
+	///
+	/// Returns false if any part of the archive failed to write (frames written before the failure can still be read.)
+	bool nativeLumaArchiveWriterClose(void *writer)
+	{
+		LumaArchiveWriter *pWriter = static_cast<LumaArchiveWriter *>(writer);
+		bool succeeded = pWriter->close();
+		delete pWriter;
+		return succeeded;
+	}
+
+	/// Opens the luma archive at `path` for reading, returning the reader or nullptr on error
+	///
+	/// The archive is mapped into memory, and any frame can be read directly through its index. An archive that was never closed
+	/// is recovered up to its last complete frame.
+	///
+	/// Release the reader with `nativeLumaArchiveReaderClose()`.
+	void *nativeLumaArchiveReaderOpen(const char *path)
+	{
+		LumaArchiveReader *pReader = new LumaArchiveReader();
+		if (!pReader->open(path))
+		{
+			delete pReader;
+			return nullptr;
+		}
+
+		return pReader;
+	}
+
+	/// Returns the number of frames in the archive read by `reader`
+	uint32_t nativeLumaArchiveReaderFrameCount(void *reader)
+	{
+		return static_cast<LumaArchiveReader *>(reader)->frameCount();
+	}
+
+	/// Fills `frame` with frame `index` of the archive read by `reader`, without copying it
+	///
+	/// The frame is valid until the reader is closed; a compressed frame is decoded into the reader, so it is only valid until
+	/// the next frame is read. Returns false if `index` is out of range or the frame is damaged.
+	bool nativeLumaArchiveReaderFrame(void *reader, uint32_t index, NativeLumaArchiveFrame *frame)
+	{
+		return static_cast<LumaArchiveReader *>(reader)->frame(index, *frame);
+	}
+
+	/// Releases `reader`, unmapping its archive (does nothing if `reader` is null)
+	void nativeLumaArchiveReaderClose(void *reader)
+	{
+		delete static_cast<LumaArchiveReader *>(reader);
+	}
+
+	/// Returns the largest number of bytes that `nativeLumaEncode()` can produce for a frame of `width` x `height` samples
+	uint64_t nativeLumaEncodeMaxSize(uint32_t width, uint32_t height)
+	{
+		return lumaCodecMaxEncodedSize(width, height);
+	}
+
+	/// Losslessly compresses a frame of `width` x `height` packed samples into `dst`, which must hold at least
+	/// `nativeLumaEncodeMaxSize()` bytes, returning the number of bytes written
+	///
+	/// This is the compression used by luma archives: each sample is predicted from its neighbors and the prediction error is
+	/// coded with adaptive Rice codes. The dimensions are not stored.
+	uint64_t nativeLumaEncode(const LumaSample *luma, uint32_t width, uint32_t height, uint8_t *dst)
+	{
+		return lumaCodecEncode(luma, width, height, dst);
+	}
+
+	/// Decompresses `size` bytes from `nativeLumaEncode()` into a frame of `width` x `height` packed samples
+	///
+	/// Returns false if the data is truncated or damaged
+	bool nativeLumaDecode(const uint8_t *src, uint64_t size, uint32_t width, uint32_t height, LumaSample *luma)
+	{
+		return lumaCodecDecode(src, static_cast<size_t>(size), width, height, luma);
+	}
+
 	// -----------------------------------------------------------------------------------------------------------------------------
 	//  _                  ____            _     _             _   _
 	// | |    ___   __ _  |  _ \ ___  __ _(_)___| |_ _ __ __ _| |_(_) ___  _ __
@@ -197,7 +521,74 @@ extern "C"
 	//                                         |_|                       
 	// -----------------------------------------------------------------------------------------------------------------------------
 
+#if defined(__linux__)
+
+	/// Selects the source of captured video frames. This must be called while capture is stopped.
+	///
+	/// `name` is one of:
+	///
+	///		"mmal"   - The Raspberry Pi camera (only available in MMAL builds, where it is the default)
+	///		"v4l2"   - A Video4Linux2 device; `source` is the device path (default: /dev/video0)
+	///		"replay" - Replays `.luma`, `.lumas` (luma archive) or raw luma files from `source` (a file or directory) at the
+	///		           capture frame rate. If `source` is empty, synthetic frames are generated.
+	///
+	/// Returns error string or nullptr
+	const char *nativeVideoCaptureSelectBackend(const char *name, const char *source)
+	{
+		if (gCaptureActive)
+		{
+			return "nativeVideoCaptureSelectBackend: Capture is active";
+		}
+
+		string backendName = name ? name : "";
+		string backendSource = source ? source : "";
+		CaptureBackend *backend = nullptr;
+
+		try
+		{
+			if (backendName == "mmal")
+			{
+#if defined(USE_MMAL)
+				backend = &gVideoCaptureManager;
+#else
+				return "nativeVideoCaptureSelectBackend: MMAL is not available in this build";
+#endif // defined(USE_MMAL)
+			}
+			else if (backendName == "v4l2")
+			{
+				backend = new V4l2Capture(backendSource.empty() ? kDefaultV4l2Device : backendSource);
+			}
+			else if (backendName == "replay")
+			{
+				backend = new ReplayCapture(backendSource);
+			}
+			else
+			{
+				return "nativeVideoCaptureSelectBackend: Unknown backend (expected mmal, v4l2 or replay)";
+			}
+		}
+		catch(...)
+		{
+			return "nativeVideoCaptureSelectBackend: Caught unknown exception";
+		}
+
+		// Release the previous backend (unless it's the MMAL camera, which is a global)
 #if defined(USE_MMAL)
+		if (gpCaptureBackend != &gVideoCaptureManager)
+#endif // defined(USE_MMAL)
+		{
+			delete gpCaptureBackend;
+		}
+
+		gpCaptureBackend = backend;
+		return nullptr;
+	}
+
+	/// Returns the name of the selected capture backend (see `nativeVideoCaptureSelectBackend()`)
+	const char *nativeVideoCaptureBackendName()
+	{
+		return captureBackend().name();
+	}
 
 	/// Causes video capturing from the camera to begin at the requested frame dimensions and rate
 	///
@@ -211,7 +602,8 @@ extern "C"
 	{
 		try
 		{
-			gVideoCaptureManager.startCapture(frameWidth, frameHeight, frameRate, receiver);
+			captureBackend().startCapture(frameWidth, frameHeight, frameRate, receiver, false);
+			gCaptureActive = true;
 		}
 		catch(VideoException &ex)
 		{
@@ -225,6 +617,31 @@ extern "C"
 		return nullptr;
 	}
 
+	/// Causes video capturing from the camera to begin at the requested frame dimensions and rate, lending the camera's buffers
+	/// directly to the caller rather than copying them into the circular buffer
+	///
+	/// Captured frames are accessed with `nativeVideoCaptureImageAcquire()` and `nativeVideoCaptureImageRelease()`.
+	///
+	/// Returns error string or nullptr
+	const char *nativeVideoCaptureStartLending(uint32_t frameWidth, uint32_t frameHeight, uint32_t frameRate)
+	{
+		try
+		{
+			captureBackend().startCapture(frameWidth, frameHeight, frameRate, nullptr, true);
+			gCaptureActive = true;
+		}
+		catch(VideoException &ex)
+		{
+			return ex.what();
+		}
+		catch(...)
+		{
+			return "nativeStartCaptureLending: Caught unknown exception";
+		}
+
+		return nullptr;
+	}
+
 	/// Causes video capture from the camera to stop
 	///
 	/// Returns error string or nullptr
@@ -232,7 +649,8 @@ extern "C"
 	{
 		try
 		{
-			gVideoCaptureManager.stopCapture();
+			gCaptureActive = false;
+			captureBackend().stopCapture();
 		}
 		catch(VideoException &ex)
 		{
@@ -246,17 +664,109 @@ extern "C"
 		return nullptr;
 	}
 
+	/// Sets how captured frames are queued for delivery to the `receiver` passed to `nativeVideoCaptureStart()`
+	///
+	/// Frames are delivered to the receiver on a dedicated thread, so the camera never waits for a frame to be processed. With
+	/// `NativeFrameDispatchPolicyLatest` (the default), a new frame replaces one still waiting for delivery. With
+	/// `NativeFrameDispatchPolicyFifo`, up to `capacity` frames wait in order and new frames are dropped when the queue is full.
+	///
+	/// This must be called before capture is first started.
+	///
+	/// Returns error string or nullptr
+	const char *nativeVideoCaptureDispatchConfigure(NativeFrameDispatchPolicy policy, uint32_t capacity)
+	{
+		if (!captureBackend().setDispatchPolicy(policy, capacity))
+		{
+			return "nativeVideoCaptureDispatchConfigure: Capture has already been started";
+		}
+
+		return nullptr;
+	}
+
+	/// Returns statistics for the delivery of frames to the `receiver` passed to `nativeVideoCaptureStart()`
+	///
+	/// If `reset` is set, the statistics are reset after they are returned. The statistics are all zero if no receiver is active.
+	NativeFrameDispatchStats nativeVideoCaptureDispatchStats(bool reset)
+	{
+		NativeFrameDispatchStats stats;
+		memset(&stats, 0, sizeof(stats));
+
+		FrameDispatcher *dispatcher = captureBackend().frameDispatcher();
+		if (dispatcher)
+		{
+			stats = dispatcher->stats();
+			if (reset) dispatcher->resetStats();
+		}
+
+		return stats;
+	}
+
+	/// Sets the region of interest of frames delivered to the `receiver` passed to `nativeVideoCaptureStart()`
+	///
+	/// Frames are cropped to the `width` x `height` region at (`x`, `y`) before delivery, and optionally binned (each delivered
+	/// sample being the average of a `binning` x `binning` block.) The receiver is then given a frame of (`width` / `binning`) x
+	/// (`height` / `binning`) samples; `nativeVideoCaptureFrameRoi()` reports where it lies within the full frame. A zero `width`
+	/// or `height` restores the full frame. The region is clamped to the frame and takes effect with the next frame delivered.
+	///
+	/// `binning` must be 1, 2 or 4. This is only available while capturing to a receiver.
+	///
+	/// Returns error string or nullptr
+	const char *nativeVideoCaptureSetRoi(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t binning)
+	{
+		if (binning != 1 && binning != 2 && binning != 4)
+		{
+			return "nativeVideoCaptureSetRoi: Binning must be 1, 2 or 4";
+		}
+
+		FrameDispatcher *dispatcher = captureBackend().frameDispatcher();
+		if (!dispatcher)
+		{
+			return "nativeVideoCaptureSetRoi: Not capturing to a receiver";
+		}
+
+		NativeCaptureRoi roi;
+		roi.x = x;
+		roi.y = y;
+		roi.width = width;
+		roi.height = height;
+		roi.binning = binning;
+		dispatcher->setRoi(roi);
+		return nullptr;
+	}
+
+	/// Returns the region of the full frame covered by the frame being delivered (see `nativeVideoCaptureSetRoi()`)
+	///
+	/// This must only be called from within the `receiver` passed to `nativeVideoCaptureStart()`. The region is all zero if no
+	/// receiver is active.
+	NativeCaptureRoi nativeVideoCaptureFrameRoi()
+	{
+		NativeCaptureRoi roi;
+		memset(&roi, 0, sizeof(roi));
+
+		FrameDispatcher *dispatcher = captureBackend().frameDispatcher();
+		if (dispatcher)
+		{
+			roi = dispatcher->deliveredRoi();
+		}
+
+		return roi;
+	}
+
 	/// Locks the circular image buffer so it can be read safely in a threaded environment.
 	///
 	/// If you plan to keep this image for long, be sure to make a copy so you don't hold the lock too long.
 	///
+	/// The capture buffer is a lock-free ring, so this never blocks the camera. Instead, the image returned by
+	/// `nativeVideoCaptureImageGet()` is held (and will not be overwritten) until `nativeVideoCaptureImageUnlock()`. New frames that
+	/// arrive while the ring is full are dropped and counted as skipped.
+	///
 	/// This method will do nothing if `receiver` is set when calling `nativeVideoCaptureStart()`
 	///
 	/// Be sure to call `nativeVideoCaptureImageUnlock()` when you're finished with it.
 	void nativeVideoCaptureImageLock()
 	{
-		if (!gVideoCaptureManager.circularImageBuffer()) { return; }
-		return gVideoCaptureManager.circularImageBuffer()->lock();
+		if (!captureBackend().circularImageBuffer()) { return; }
+		return captureBackend().circularImageBuffer()->lock();
 	}
 
 	/// Unlocks the circular image buffer from a previous call to `nativeVideoCaptureImageLock()`.
@@ -266,8 +776,8 @@ extern "C"
 	/// See `nativeVideoCaptureImageLock()`
 	void nativeVideoCaptureImageUnlock()
 	{
-		if (!gVideoCaptureManager.circularImageBuffer()) { return; }
-		return gVideoCaptureManager.circularImageBuffer()->unlock();
+		if (!captureBackend().circularImageBuffer()) { return; }
+		return captureBackend().circularImageBuffer()->unlock();
 	}
 
 	/// Returns the next image (and increments the next pointer) from the circular buffer (or nullptr if none)
@@ -278,8 +788,8 @@ extern "C"
 	/// `nativeVideoCaptureImageLock()` for details.)
 	NativeLumaBuffer nativeVideoCaptureImageGet()
 	{
-		if (!gVideoCaptureManager.circularImageBuffer()) { return nullptr; }
-		return gVideoCaptureManager.circularImageBuffer()->get();
+		if (!captureBackend().circularImageBuffer()) { return nullptr; }
+		return captureBackend().circularImageBuffer()->get();
 	}
 
 	/// Returns the next image (without incrementing the next pointer) from the circular buffer (or nullptr if none)
@@ -290,8 +800,8 @@ extern "C"
 	/// `nativeVideoCaptureImageLock()` for details.)
 	NativeLumaBuffer nativeVideoCaptureImagePeek()
 	{
-		if (!gVideoCaptureManager.circularImageBuffer()) { return nullptr; }
-		return gVideoCaptureManager.circularImageBuffer()->peek();
+		if (!captureBackend().circularImageBuffer()) { return nullptr; }
+		return captureBackend().circularImageBuffer()->peek();
 	}
 
 	/// Returns the current number of images in the circular image buffer
@@ -301,8 +811,8 @@ extern "C"
 	/// To see the capacity of the circular image buffer, see `nativeVideoCaptureImageCapacity()`
 	int32_t nativeVideoCaptureImageCount()
 	{
-		if (!gVideoCaptureManager.circularImageBuffer()) { return 0; }
-		return gVideoCaptureManager.circularImageBuffer()->count();
+		if (!captureBackend().circularImageBuffer()) { return 0; }
+		return captureBackend().circularImageBuffer()->count();
 	}
 
 	/// Returns the total capacity of the circular image buffer
@@ -312,9 +822,43 @@ extern "C"
 	/// For the number of images in the circular image buffer, see `nativeVideoCaptureImageCount()`
 	int32_t nativeVideoCaptureImageCapacity()
 	{
-		if (!gVideoCaptureManager.circularImageBuffer()) { return 0; }
-		return gVideoCaptureManager.circularImageBuffer()->capacity();
+		if (!captureBackend().circularImageBuffer()) { return 0; }
+		return captureBackend().circularImageBuffer()->capacity();
 	}
 
-#endif // defined(USE_MMAL)
+	/// Acquires the most recent captured frame that has not yet been acquired, lending the camera's buffer to the caller without a
+	/// copy. The image remains valid until it is released with `nativeVideoCaptureImageRelease()`.
+	///
+	/// The camera only has a few spare buffers, so release images promptly (copy the image if you need to keep it.) While a
+	/// frame goes unacquired, newer frames replace it.
+	///
+	/// This method will always return nullptr unless capture was started with `nativeVideoCaptureStartLending()`
+	///
+	/// Returns the image's luma samples (also stored in `image`) or nullptr if no new frame is available
+	NativeLumaBuffer nativeVideoCaptureImageAcquire(NativeCaptureImage *image)
+	{
+		if (!image || !captureBackend().acquireImage(*image)) { return nullptr; }
+		return image->luma;
+	}
+
+	/// Adds a reference to an image from `nativeVideoCaptureImageAcquire()`, so it can be shared
+	///
+	/// Each call requires a matching call to `nativeVideoCaptureImageRelease()`.
+	void nativeVideoCaptureImageRetain(const NativeCaptureImage *image)
+	{
+		if (!image) { return; }
+		captureBackend().retainImage(*image);
+	}
+
+	/// Releases an image from `nativeVideoCaptureImageAcquire()` (or a reference from `nativeVideoCaptureImageRetain()`.) When
+	/// the last reference is released, the buffer is returned to the camera.
+	///
+	/// The image's `luma` and `handle` are cleared.
+	void nativeVideoCaptureImageRelease(NativeCaptureImage *image)
+	{
+		if (!image) { return; }
+		captureBackend().releaseImage(*image);
+	}
+
+#endif // defined(__linux__)
 } // extern "C"
@@ -0,0 +1,363 @@
+//
+//  ReplayCapture.cpp
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+#include "ReplayCapture.h"
+#include "LumaArchive.h"
+#include "FastImage.h"
+#include "VideoException.h"
+#include "Logger.h"
+
+using namespace std;
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Local helpers
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Returns true if `path` ends with `suffix`
+static bool hasSuffix(const string &path, const char *suffix)
+{
+	size_t length = strlen(suffix);
+	return path.size() >= length && path.compare(path.size() - length, length, suffix) == 0;
+}
+
+/// Reads the header of the LUMA file open as `fp`, leaving the file positioned at its samples
+///
+/// Returns false if the header can't be read or is invalid
+static bool readLumaHeader(FILE *fp, int16_t &width, int16_t &height, int32_t &userDataSize)
+{
+	if (fseek(fp, 0, SEEK_SET) != 0) return false;
+	if (fread(&width, sizeof(width), 1, fp) != 1) return false;
+	if (fread(&height, sizeof(height), 1, fp) != 1) return false;
+	if (fread(&userDataSize, sizeof(userDataSize), 1, fp) != 1) return false;
+	if (width <= 0 || height <= 0 || userDataSize < 0) return false;
+	return fseek(fp, userDataSize, SEEK_CUR) == 0;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Construction
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Construct a backend that replays frames from `source` (a file or directory path)
+ReplayCapture::ReplayCapture(const string &source)
+	: SoftwareCapture(source), mSynthetic(false), mNextFile(0), mNextFrame(0), mOpenFile(-1), mpFile(nullptr)
+{
+}
+
+/// Destruction
+ReplayCapture::~ReplayCapture()
+{
+	uninit();
+	closeFile();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Source interface
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Finds the files to replay, and counts their frames
+///
+/// Throws VideoException on error
+void ReplayCapture::openSource()
+{
+	closeSource();
+
+	if (source().empty())
+	{
+		mSynthetic = true;
+		return;
+	}
+
+	struct stat info;
+	if (stat(source().c_str(), &info) != 0)
+	{
+		throw VideoException(SSTR << "Replay source not found: " << source());
+	}
+
+	if (S_ISDIR(info.st_mode))
+	{
+		DIR *dir = opendir(source().c_str());
+		if (!dir)
+		{
+			throw VideoException(SSTR << "Unable to read replay directory: " << source());
+		}
+
+		vector<string> names;
+		while (struct dirent *entry = readdir(dir))
+		{
+			if (entry->d_name[0] != '.') names.push_back(entry->d_name);
+		}
+		closedir(dir);
+
+		sort(names.begin(), names.end());
+		for (const string &name : names)
+		{
+			string path = source() + "/" + name;
+			if (stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode))
+			{
+				addFile(path);
+			}
+		}
+	}
+	else
+	{
+		addFile(source());
+	}
+
+	if (mFiles.empty())
+	{
+		throw VideoException(SSTR << "No frames found in replay source: " << source());
+	}
+
+	uint64_t frameCount = 0;
+	for (const ReplayFile &file : mFiles) frameCount += file.frameCount;
+	Logger::info(SSTR << "Replaying " << frameCount << " frame(s) from " << mFiles.size() << " file(s) in " << source());
+}
+
+/// Closes the file being replayed and forgets the files
+void ReplayCapture::closeSource()
+{
+	closeFile();
+	mFiles.clear();
+	mFiles.shrink_to_fit();
+	mScratch.clear();
+	mScratch.shrink_to_fit();
+	mSynthetic = false;
+	mNextFile = 0;
+	mNextFrame = 0;
+}
+
+/// Reads the next frame into `luma`
+///
+/// A frame that can't be read (for example, its file was removed during replay) is skipped.
+bool ReplayCapture::readFrame(LumaSample *luma)
+{
+	if (mSynthetic)
+	{
+		generateFrame(mNextFrame, luma);
+		mNextFrame = (mNextFrame + 1) % kSyntheticFrameCount;
+		return true;
+	}
+
+	if (mFiles.empty()) return false;
+
+	bool read = readFileFrame(mNextFile, mNextFrame, luma);
+
+	mNextFrame += 1;
+	if (mNextFrame >= mFiles[mNextFile].frameCount)
+	{
+		mNextFrame = 0;
+		mNextFile = (mNextFile + 1) % mFiles.size();
+	}
+
+	return read;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Implementation
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Checks a single file and adds it to the files to replay (unless it holds no frames)
+///
+/// Throws VideoException on error
+void ReplayCapture::addFile(const string &path)
+{
+	ReplayFile file;
+	file.path = path;
+
+	if (hasSuffix(path, ".lumas"))
+	{
+		LumaArchiveReader archive;
+		if (!archive.open(path))
+		{
+			throw VideoException(SSTR << "Invalid luma archive: " << path);
+		}
+
+		file.type = ReplayFileArchive;
+		file.frameCount = archive.frameCount();
+	}
+	else
+	{
+		struct stat info;
+		if (stat(path.c_str(), &info) != 0)
+		{
+			throw VideoException(SSTR << "Unable to open replay file: " << path);
+		}
+
+		size_t size = static_cast<size_t>(info.st_size);
+		if (hasSuffix(path, ".luma"))
+		{
+			FILE *fp = fopen(path.c_str(), "rb");
+			if (!fp)
+			{
+				throw VideoException(SSTR << "Unable to open replay file: " << path);
+			}
+
+			int16_t width, height;
+			int32_t userDataSize;
+			bool valid = readLumaHeader(fp, width, height, userDataSize);
+			fclose(fp);
+
+			if (!valid)
+			{
+				throw VideoException(SSTR << "Invalid LUMA file (truncated header): " << path);
+			}
+
+			if (size != kLumaHeaderSize + static_cast<size_t>(userDataSize) + static_cast<size_t>(width) * height)
+			{
+				throw VideoException(SSTR << "Invalid LUMA file (dimension mismatch): " << path);
+			}
+
+			file.type = ReplayFileLuma;
+			file.frameCount = 1;
+		}
+		else
+		{
+			size_t frameSize = frameWidth() * frameHeight();
+			if (size == 0 || size % frameSize != 0)
+			{
+				throw VideoException(SSTR << "Raw luma file size is not a multiple of the " << frameWidth() << "x" << frameHeight() << " frame size: " << path);
+			}
+
+			file.type = ReplayFileRaw;
+			file.frameCount = static_cast<uint32_t>(size / frameSize);
+		}
+	}
+
+	if (file.frameCount > 0) mFiles.push_back(file);
+}
+
+/// Reads frame `index` of file `fileIndex` into `luma`, opening the file if it isn't already
+///
+/// Returns false if the frame could not be read
+bool ReplayCapture::readFileFrame(size_t fileIndex, uint32_t index, LumaSample *luma)
+{
+	if (!openFile(fileIndex)) return false;
+
+	const ReplayFile &file = mFiles[fileIndex];
+	switch (file.type)
+	{
+		case ReplayFileArchive:
+		{
+			NativeLumaArchiveFrame frame;
+			if (!mArchive.frame(index, frame)) break;
+			storeFrame(frame.luma, frame.width, frame.height, luma);
+			return true;
+		}
+
+		case ReplayFileLuma:
+		{
+			int16_t width, height;
+			int32_t userDataSize;
+			if (!readLumaHeader(mpFile, width, height, userDataSize)) break;
+
+			size_t sampleCount = static_cast<size_t>(width) * height;
+			bool resample = static_cast<unsigned int>(width) != frameWidth() || static_cast<unsigned int>(height) != frameHeight();
+			if (resample) mScratch.resize(sampleCount);
+
+			LumaSample *samples = resample ? mScratch.data() : luma;
+			if (fread(samples, 1, sampleCount, mpFile) != sampleCount) break;
+
+			if (resample) storeFrame(samples, width, height, luma);
+			return true;
+		}
+
+		case ReplayFileRaw:
+		{
+			size_t frameSize = frameWidth() * frameHeight();
+			if (fseeko(mpFile, static_cast<off_t>(index) * static_cast<off_t>(frameSize), SEEK_SET) != 0) break;
+			if (fread(luma, 1, frameSize, mpFile) != frameSize) break;
+			return true;
+		}
+	}
+
+	Logger::warn(SSTR << "Unable to read replay frame " << index << " from " << file.path);
+	return false;
+}
+
+/// Makes file `fileIndex` the open file (closing any other)
+///
+/// Returns false if the file could not be opened
+bool ReplayCapture::openFile(size_t fileIndex)
+{
+	if (mOpenFile == static_cast<int>(fileIndex)) return true;
+
+	closeFile();
+
+	const ReplayFile &file = mFiles[fileIndex];
+	if (file.type == ReplayFileArchive)
+	{
+		if (!mArchive.open(file.path))
+		{
+			Logger::warn(SSTR << "Unable to open replay file: " << file.path);
+			return false;
+		}
+	}
+	else
+	{
+		mpFile = fopen(file.path.c_str(), "rb");
+		if (!mpFile)
+		{
+			Logger::warn(SSTR << "Unable to open replay file: " << file.path);
+			return false;
+		}
+	}
+
+	mOpenFile = static_cast<int>(fileIndex);
+	return true;
+}
+
+/// Closes the open file, if any
+void ReplayCapture::closeFile()
+{
+	mArchive.close();
+
+	if (mpFile)
+	{
+		fclose(mpFile);
+		mpFile = nullptr;
+	}
+
+	mOpenFile = -1;
+}
+
+/// Copies a frame of `width` x `height` samples into `luma`, resampling it to the capture frame size if needed
+void ReplayCapture::storeFrame(const LumaSample *frame, unsigned int width, unsigned int height, LumaSample *luma)
+{
+	if (width == frameWidth() && height == frameHeight())
+	{
+		memcpy(luma, frame, frameWidth() * frameHeight());
+	}
+	else
+	{
+		resampleNearestNeighborLuma(const_cast<LumaSample *>(frame), width, height, luma, frameWidth(), frameHeight());
+	}
+}
+
+/// Generates frame `index` of a synthetic sequence of frames into `luma`
+///
+/// Each frame is a diagonal gradient that shifts by a few samples per frame, so consecutive frames differ.
+void ReplayCapture::generateFrame(unsigned int index, LumaSample *luma)
+{
+	for (unsigned int y = 0; y < frameHeight(); ++y)
+	{
+		for (unsigned int x = 0; x < frameWidth(); ++x)
+		{
+			luma[y * frameWidth() + x] = static_cast<LumaSample>(x + y + index * 4);
+		}
+	}
+}
@@ -0,0 +1,153 @@
+//
+//  ReplayCapture.h
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+#include <string>
+#include "SoftwareCapture.h"
+#include "LumaArchive.h"
+
+/// Capture backend that replays frames from files at the capture frame rate
+///
+/// The source is a file or a directory of files (replayed in name order, looping forever.) Supported files are:
+///
+///		*.luma  - LUMA images (as written by Seer); images of a different size are resampled to the capture frame size
+///		*.lumas - Luma archives (any number of LUMA images in a single file); resampled as above
+///		others  - Raw 8-bit luma planes of the capture frame size. A file may hold any number of consecutive frames.
+///
+/// If the source is empty, a synthetic moving gradient is generated instead.
+///
+/// The files are checked and their frames counted when capture starts, but frames are only read as they are replayed, so memory
+/// use does not grow with the length of the recording. Luma archives are mapped (see `LumaArchiveReader`); other files are read
+/// a frame at a time. Only the file being replayed is kept open. A frame rate of 0 replays frames as fast as possible (frames
+/// that can't be delivered are dropped, as with a real camera.)
+class ReplayCapture : public SoftwareCapture
+{
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Constants
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Number of frames generated for a synthetic source
+	private: static const unsigned int kSyntheticFrameCount = 64;
+
+	/// Size of the header of a LUMA file: width (int16), height (int16), user data size (int32)
+	private: static const size_t kLumaHeaderSize = 8;
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Local types
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// The kinds of files we replay
+	private: enum ReplayFileType
+	{
+		ReplayFileLuma,
+		ReplayFileArchive,
+		ReplayFileRaw
+	};
+
+	/// A file to replay
+	private: struct ReplayFile
+	{
+		std::string path;
+		ReplayFileType type;
+
+		/// The number of frames in the file
+		uint32_t frameCount;
+	};
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Construction
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Construct a backend that replays frames from `source` (a file or directory path)
+	public: ReplayCapture(const std::string &source);
+
+	/// Destruction
+	public: virtual ~ReplayCapture();
+
+	/// Returns the name of this backend
+	public: virtual const char *name() const override { return "replay"; }
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Source interface
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Finds the files to replay, and counts their frames
+	///
+	/// Throws VideoException on error
+	protected: virtual void openSource() override;
+
+	/// Closes the file being replayed and forgets the files
+	protected: virtual void closeSource() override;
+
+	/// Reads the next frame into `luma`
+	protected: virtual bool readFrame(LumaSample *luma) override;
+
+	/// Replayed frames are paced at the frame rate
+	protected: virtual bool isPaced() const override { return true; }
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Implementation
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Checks a single file and adds it to the files to replay (unless it holds no frames)
+	///
+	/// Throws VideoException on error
+	private: void addFile(const std::string &path);
+
+	/// Reads frame `index` of file `fileIndex` into `luma`, opening the file if it isn't already
+	///
+	/// Returns false if the frame could not be read
+	private: bool readFileFrame(size_t fileIndex, uint32_t index, LumaSample *luma);
+
+	/// Makes file `fileIndex` the open file (closing any other)
+	///
+	/// Returns false if the file could not be opened
+	private: bool openFile(size_t fileIndex);
+
+	/// Closes the open file, if any
+	private: void closeFile();
+
+	/// Copies a frame of `width` x `height` samples into `luma`, resampling it to the capture frame size if needed
+	private: void storeFrame(const LumaSample *frame, unsigned int width, unsigned int height, LumaSample *luma);
+
+	/// Generates frame `index` of a synthetic sequence of frames into `luma`
+	private: void generateFrame(unsigned int index, LumaSample *luma);
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Data members
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// The files to replay, in order (empty for a synthetic source)
+	private: std::vector<ReplayFile> mFiles;
+
+	/// True if we're generating frames rather than replaying files
+	private: bool mSynthetic;
+
+	/// The next frame to replay: its file and its index within that file (or, for a synthetic source, its index)
+	private: size_t mNextFile;
+	private: uint32_t mNextFrame;
+
+	/// The open file, as an index into `mFiles` (or -1 if none)
+	private: int mOpenFile;
+
+	/// The open file, if it is a luma archive
+	private: LumaArchiveReader mArchive;
+
+	/// The open file, if it is a LUMA or raw file
+	private: FILE *mpFile;
+
+	/// Storage for LUMA images that must be resampled
+	private: std::vector<LumaSample> mScratch;
+};
@@ -0,0 +1,323 @@
+//
+//  SoftwareCapture.cpp
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#include <chrono>
+
+#include "SoftwareCapture.h"
+#include "VideoException.h"
+#include "Logger.h"
+
+using namespace std;
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Construction
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Construct a backend that reads from `source`
+SoftwareCapture::SoftwareCapture(const string &source)
+	: mpCircularImageBuffer(nullptr), mpFrameDispatcher(nullptr), mSource(source), mFrameWidth(0), mFrameHeight(0),
+	  mFrameRateHz(0), mInitialized(false), mLumaFrameReceiver(nullptr), mLendBuffers(false),
+	  mDispatchPolicy(kDefaultDispatchPolicy), mDispatchCapacity(kDefaultDispatchCapacity), mpLatestBuffer(nullptr),
+	  mRunning(false), mStatFramesSkipped(0)
+{
+}
+
+/// Destruction
+///
+/// Subclasses must call `uninit()` from their destructor, as the source can't be closed from here.
+SoftwareCapture::~SoftwareCapture()
+{
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Capture control
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Starts a video capture at the given frame size and rate (see `CaptureBackend::startCapture()`)
+///
+/// Throws VideoException on error
+void SoftwareCapture::startCapture(unsigned int frameWidth, unsigned int frameHeight, unsigned int frameRate, NativeCaptureFrameReceiver receiver, bool lendBuffers)
+{
+	if (mRunning) return;
+
+	if (!mInitialized)
+	{
+		if (frameWidth == 0 || frameHeight == 0)
+		{
+			throw VideoException(SSTR << "Invalid capture frame size: " << frameWidth << "x" << frameHeight);
+		}
+
+		mFrameWidth = frameWidth;
+		mFrameHeight = frameHeight;
+		mFrameRateHz = frameRate;
+		mLumaFrameReceiver = receiver;
+		mLendBuffers = lendBuffers && nullptr == receiver;
+		mStatFramesSkipped = 0;
+
+		openSource();
+
+		// Enough buffers for every frame that can be held at once, plus the one being read
+		unsigned int bufferCount = 1;
+		if (nullptr != receiver)
+		{
+			mpFrameDispatcher = new FrameDispatcher(receiver, dispatchRelease, this, mDispatchPolicy, mDispatchCapacity);
+			bufferCount += mpFrameDispatcher->maxFramesHeld();
+		}
+		else if (mLendBuffers)
+		{
+			bufferCount += kLentBufferCount;
+		}
+		else
+		{
+			mpCircularImageBuffer = new CircularImageBuffer<LumaSample>(mFrameWidth, mFrameHeight, kCircularImageBufferCapacity, CircularImageBufferModeLockFree);
+		}
+
+		for (unsigned int i = 0; i < bufferCount; ++i)
+		{
+			FrameBuffer *buffer = new FrameBuffer;
+			buffer->luma.resize(mFrameWidth * mFrameHeight);
+			buffer->refs = 0;
+			mFrameBuffers.push_back(buffer);
+		}
+		mDropBuffer.resize(mFrameWidth * mFrameHeight);
+
+		mInitialized = true;
+	}
+
+	if (mpFrameDispatcher)
+	{
+		mpFrameDispatcher->start();
+	}
+
+	mRunning = true;
+	mThread = thread(&SoftwareCapture::run, this);
+
+	Logger::trace(SSTR << "*** Beginning " << name() << " video capture from " << mSource);
+	Logger::trace(SSTR << "    Frame info: " << mFrameWidth << "x" << mFrameHeight << "@" << mFrameRateHz << "Hz");
+}
+
+/// Stop a capture (see `CaptureBackend::stopCapture()`)
+void SoftwareCapture::stopCapture()
+{
+	mRunning = false;
+	if (mThread.joinable())
+	{
+		mThread.join();
+	}
+
+	if (mpFrameDispatcher)
+	{
+		mpFrameDispatcher->stop();
+	}
+}
+
+/// Sets how frames are queued for delivery to a receiver
+bool SoftwareCapture::setDispatchPolicy(NativeFrameDispatchPolicy policy, unsigned int capacity)
+{
+	if (mInitialized) return false;
+
+	mDispatchPolicy = policy;
+	mDispatchCapacity = capacity;
+	return true;
+}
+
+/// Stops capture, closes the source and frees all buffers
+void SoftwareCapture::uninit()
+{
+	stopCapture();
+
+	if (!mInitialized) return;
+
+	closeSource();
+
+	// Return the latest frame (if it was never acquired)
+	FrameBuffer *latest = mpLatestBuffer.exchange(nullptr);
+	if (latest)
+	{
+		releaseBuffer(latest);
+	}
+
+	delete mpFrameDispatcher;
+	mpFrameDispatcher = nullptr;
+
+	delete mpCircularImageBuffer;
+	mpCircularImageBuffer = nullptr;
+
+	// Free our buffers, unless the consumer is still holding some of them
+	bool held = false;
+	for (FrameBuffer *buffer : mFrameBuffers)
+	{
+		held = held || buffer->refs.load() != 0;
+	}
+
+	if (held)
+	{
+		Logger::error(SSTR << "Video capture (" << name() << ") shut down with image(s) still acquired; leaking the frame buffers");
+	}
+	else
+	{
+		for (FrameBuffer *buffer : mFrameBuffers)
+		{
+			delete buffer;
+		}
+	}
+
+	mFrameBuffers.clear();
+	mLumaFrameReceiver = nullptr;
+	mInitialized = false;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Frame management
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Capture thread: reads and delivers frames until stopped
+void SoftwareCapture::run()
+{
+	chrono::steady_clock::duration period = chrono::steady_clock::duration::zero();
+	if (isPaced() && mFrameRateHz != 0)
+	{
+		period = chrono::duration_cast<chrono::steady_clock::duration>(chrono::seconds(1)) / mFrameRateHz;
+	}
+
+	chrono::steady_clock::time_point nextFrame = chrono::steady_clock::now();
+	while (mRunning)
+	{
+		FrameBuffer *buffer = takeFreeBuffer();
+		if (!buffer)
+		{
+			// The consumer is holding every buffer; read the frame anyway to keep up with the source, then drop it
+			if (readFrame(mDropBuffer.data()))
+			{
+				mStatFramesSkipped.fetch_add(1, memory_order_relaxed);
+			}
+		}
+		else if (readFrame(buffer->luma.data()))
+		{
+			deliver(buffer);
+		}
+		else
+		{
+			releaseBuffer(buffer);
+		}
+
+		// Pace the frames at the frame rate, without trying to catch up if we've fallen behind
+		if (period != chrono::steady_clock::duration::zero())
+		{
+			nextFrame += period;
+			chrono::steady_clock::time_point now = chrono::steady_clock::now();
+			if (nextFrame < now)
+			{
+				nextFrame = now;
+			}
+			else
+			{
+				this_thread::sleep_until(nextFrame);
+			}
+		}
+	}
+}
+
+/// Returns a free frame buffer (holding one reference), or nullptr if all are in use
+///
+/// Only the capture thread takes buffers, so a buffer with no references can't be taken by anyone else.
+SoftwareCapture::FrameBuffer *SoftwareCapture::takeFreeBuffer()
+{
+	for (FrameBuffer *buffer : mFrameBuffers)
+	{
+		if (buffer->refs.load(memory_order_acquire) == 0)
+		{
+			buffer->refs.store(1, memory_order_relaxed);
+			return buffer;
+		}
+	}
+
+	return nullptr;
+}
+
+/// Delivers a frame to the receiver, circular buffer or lending slot (the frame's reference is passed on)
+void SoftwareCapture::deliver(FrameBuffer *buffer)
+{
+	if (mpFrameDispatcher)
+	{
+		// If this is dropped, it is released right away
+		mpFrameDispatcher->submit(buffer->luma.data(), mFrameWidth, mFrameHeight, buffer);
+	}
+	else if (mLendBuffers)
+	{
+		FrameBuffer *previous = mpLatestBuffer.exchange(buffer, memory_order_acq_rel);
+		if (previous)
+		{
+			mStatFramesSkipped.fetch_add(1, memory_order_relaxed);
+			releaseBuffer(previous);
+		}
+	}
+	else
+	{
+		if (mpCircularImageBuffer)
+		{
+			mpCircularImageBuffer->add(buffer->luma.data());
+		}
+
+		releaseBuffer(buffer);
+	}
+}
+
+/// Releases a reference to a frame buffer
+void SoftwareCapture::releaseBuffer(FrameBuffer *buffer)
+{
+	buffer->refs.fetch_sub(1, memory_order_acq_rel);
+}
+
+/// Returns a delivered (or dropped) frame's buffer (see `FrameDispatchRelease`)
+void SoftwareCapture::dispatchRelease(void *context, void *handle)
+{
+	(void) context;
+	releaseBuffer(static_cast<FrameBuffer *>(handle));
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Buffer lending
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Acquires the most recent frame that has not yet been acquired, filling in `image`
+bool SoftwareCapture::acquireImage(NativeCaptureImage &image)
+{
+	if (!mLendBuffers) return false;
+
+	// Take over the latest frame's reference
+	FrameBuffer *buffer = mpLatestBuffer.exchange(nullptr, memory_order_acq_rel);
+	if (!buffer) return false;
+
+	image.luma = buffer->luma.data();
+	image.width = mFrameWidth;
+	image.height = mFrameHeight;
+	image.handle = buffer;
+	return true;
+}
+
+/// Adds a reference to an acquired image, which then requires an additional `releaseImage()`
+void SoftwareCapture::retainImage(const NativeCaptureImage &image)
+{
+	if (!image.handle) return;
+	static_cast<FrameBuffer *>(image.handle)->refs.fetch_add(1, memory_order_relaxed);
+}
+
+/// Releases a reference to an acquired image
+void SoftwareCapture::releaseImage(NativeCaptureImage &image)
+{
+	if (!image.handle) return;
+
+	releaseBuffer(static_cast<FrameBuffer *>(image.handle));
+	image.luma = nullptr;
+	image.handle = nullptr;
+}
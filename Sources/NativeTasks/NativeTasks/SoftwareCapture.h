@@ -0,0 +1,197 @@
+//
+//  SoftwareCapture.h
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <string>
+#include "CaptureBackend.h"
+
+/// Base class for capture backends that produce frames in software (i.e., without the MMAL camera pipeline)
+///
+/// A capture thread reads frames from the source (see `readFrame()`) into a small pool of reference-counted frame buffers, and
+/// delivers them exactly as the MMAL backend does: to a receiver via a frame dispatcher, into the circular image buffer, or lent
+/// to the consumer. If every buffer is still held by the consumer, the frame is read anyway (keeping the source in real time)
+/// and dropped.
+class SoftwareCapture : public CaptureBackend
+{
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Constants
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Additional frame buffers allocated when lending buffers: one for the latest frame and two held by the consumer
+	private: static const unsigned int kLentBufferCount = 3;
+
+	/// Default frame dispatch settings (see `setDispatchPolicy()`)
+	private: static const NativeFrameDispatchPolicy kDefaultDispatchPolicy = NativeFrameDispatchPolicyLatest;
+	private: static const unsigned int kDefaultDispatchCapacity = 2;
+
+	/// Circular Image Buffer capacity
+	private: static const unsigned int kCircularImageBufferCapacity = 3;
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Local types
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// A reference-counted frame buffer (a count of zero means the buffer is free)
+	private: struct FrameBuffer
+	{
+		std::vector<LumaSample> luma;
+		std::atomic<int> refs;
+	};
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Properties
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Our circular image buffer
+	public: virtual CircularImageBuffer<LumaSample> *circularImageBuffer() override { return mpCircularImageBuffer; }
+	private: CircularImageBuffer<LumaSample> *mpCircularImageBuffer;
+
+	/// Our frame dispatcher (only when capturing to a receiver)
+	public: virtual FrameDispatcher *frameDispatcher() override { return mpFrameDispatcher; }
+	private: FrameDispatcher *mpFrameDispatcher;
+
+	/// Returns the source of frames (a device or file path)
+	public: const std::string &source() const { return mSource; }
+
+	/// Capture frame dimensions and rate
+	protected: unsigned int frameWidth() const { return mFrameWidth; }
+	protected: unsigned int frameHeight() const { return mFrameHeight; }
+	protected: unsigned int frameRateHz() const { return mFrameRateHz; }
+
+	/// Returns the number of frames read while every buffer was held by the consumer, or replaced before being acquired
+	public: unsigned int statFramesSkipped() const { return mStatFramesSkipped.load(std::memory_order_relaxed); }
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Construction
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Construct a backend that reads from `source`
+	public: SoftwareCapture(const std::string &source);
+
+	/// Destruction
+	///
+	/// Subclasses must call `uninit()` from their destructor, as the source can't be closed from here.
+	public: virtual ~SoftwareCapture();
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Capture control
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Starts a video capture at the given frame size and rate (see `CaptureBackend::startCapture()`)
+	///
+	/// Throws VideoException on error
+	public: virtual void startCapture(unsigned int frameWidth, unsigned int frameHeight, unsigned int frameRate, NativeCaptureFrameReceiver receiver, bool lendBuffers) override;
+
+	/// Stop a capture (see `CaptureBackend::stopCapture()`)
+	public: virtual void stopCapture() override;
+
+	/// Sets how frames are queued for delivery to a receiver
+	public: virtual bool setDispatchPolicy(NativeFrameDispatchPolicy policy, unsigned int capacity) override;
+
+	/// Stops capture, closes the source and frees all buffers
+	protected: void uninit();
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Source interface
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Opens the source for frames of the given size and rate
+	///
+	/// Throws VideoException on error
+	protected: virtual void openSource() = 0;
+
+	/// Closes the source
+	protected: virtual void closeSource() = 0;
+
+	/// Reads the next frame (`frameWidth()` x `frameHeight()` samples) into `luma`
+	///
+	/// This is called on the capture thread. Returns false if no frame could be read (the capture thread will try again.)
+	protected: virtual bool readFrame(LumaSample *luma) = 0;
+
+	/// Returns true if the capture thread should pace frames at the frame rate (false if `readFrame()` waits for frames itself)
+	protected: virtual bool isPaced() const = 0;
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Frame management
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Capture thread: reads and delivers frames until stopped
+	private: void run();
+
+	/// Returns a free frame buffer (holding one reference), or nullptr if all are in use
+	private: FrameBuffer *takeFreeBuffer();
+
+	/// Delivers a frame to the receiver, circular buffer or lending slot (the frame's reference is passed on)
+	private: void deliver(FrameBuffer *buffer);
+
+	/// Releases a reference to a frame buffer
+	private: static void releaseBuffer(FrameBuffer *buffer);
+
+	/// Returns a delivered (or dropped) frame's buffer (see `FrameDispatchRelease`)
+	private: static void dispatchRelease(void *context, void *handle);
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Buffer lending
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Acquires the most recent frame that has not yet been acquired, filling in `image`
+	public: virtual bool acquireImage(NativeCaptureImage &image) override;
+
+	/// Adds a reference to an acquired image, which then requires an additional `releaseImage()`
+	public: virtual void retainImage(const NativeCaptureImage &image) override;
+
+	/// Releases a reference to an acquired image
+	public: virtual void releaseImage(NativeCaptureImage &image) override;
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Data members
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Frame source (a device or file path)
+	private: std::string mSource;
+
+	/// Video capture frame dimensions and rate (in Hz)
+	private: unsigned int mFrameWidth;
+	private: unsigned int mFrameHeight;
+	private: unsigned int mFrameRateHz;
+
+	/// Have we been initialized?
+	private: bool mInitialized;
+
+	/// Video capture receiver
+	private: NativeCaptureFrameReceiver mLumaFrameReceiver;
+
+	/// Are we lending frame buffers to the consumer?
+	private: bool mLendBuffers;
+
+	/// Frame dispatch settings
+	private: NativeFrameDispatchPolicy mDispatchPolicy;
+	private: unsigned int mDispatchCapacity;
+
+	/// Our pool of frame buffers, and a buffer for frames that are read only to be dropped
+	private: std::vector<FrameBuffer *> mFrameBuffers;
+	private: std::vector<LumaSample> mDropBuffer;
+
+	/// The latest frame, not yet acquired by the consumer (lending only)
+	private: std::atomic<FrameBuffer *> mpLatestBuffer;
+
+	/// The capture thread, and whether it should keep running
+	private: std::thread mThread;
+	private: std::atomic<bool> mRunning;
+
+	/// Number of frames dropped (see `statFramesSkipped()`)
+	private: std::atomic<unsigned int> mStatFramesSkipped;
+};
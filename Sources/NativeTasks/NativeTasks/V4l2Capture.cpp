@@ -0,0 +1,299 @@
+//
+//  V4l2Capture.cpp
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#if defined(__linux__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/videodev2.h>
+
+#include "V4l2Capture.h"
+#include "FastImage.h"
+#include "VideoException.h"
+#include "Logger.h"
+
+using namespace std;
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Local helpers
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Device pixel formats we can extract luma from, in order of preference
+static const uint32_t kSupportedPixelFormats[] =
+{
+	V4L2_PIX_FMT_GREY,
+	V4L2_PIX_FMT_YUV420,
+	V4L2_PIX_FMT_NV12,
+	V4L2_PIX_FMT_YUYV,
+	V4L2_PIX_FMT_UYVY,
+};
+
+/// ioctl(), retrying if interrupted
+static int xioctl(int fd, unsigned long request, void *arg)
+{
+	int result;
+	do
+	{
+		result = ioctl(fd, request, arg);
+	} while (result == -1 && errno == EINTR);
+
+	return result;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Construction
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Construct a backend that captures from the device at `source` (e.g., "/dev/video0")
+V4l2Capture::V4l2Capture(const string &source)
+	: SoftwareCapture(source), mFd(-1), mPixelFormat(0), mDeviceWidth(0), mDeviceHeight(0), mBytesPerLine(0)
+{
+}
+
+/// Destruction
+V4l2Capture::~V4l2Capture()
+{
+	uninit();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Source interface
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Opens the device, negotiates the format and starts streaming
+///
+/// Throws VideoException on error
+void V4l2Capture::openSource()
+{
+	mFd = open(source().c_str(), O_RDWR | O_NONBLOCK);
+	if (mFd < 0)
+	{
+		throw VideoException(SSTR << "Unable to open V4L2 device " << source() << ": " << strerror(errno));
+	}
+
+	try
+	{
+		v4l2_capability capability;
+		memset(&capability, 0, sizeof(capability));
+		if (xioctl(mFd, VIDIOC_QUERYCAP, &capability) == -1 ||
+		    !(capability.capabilities & V4L2_CAP_VIDEO_CAPTURE) || !(capability.capabilities & V4L2_CAP_STREAMING))
+		{
+			throw VideoException(SSTR << "Device " << source() << " is not a V4L2 streaming capture device");
+		}
+
+		// Find a pixel format we can use (the driver may adjust the frame size)
+		v4l2_format format;
+		bool formatFound = false;
+		for (uint32_t pixelFormat : kSupportedPixelFormats)
+		{
+			memset(&format, 0, sizeof(format));
+			format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+			format.fmt.pix.width = frameWidth();
+			format.fmt.pix.height = frameHeight();
+			format.fmt.pix.pixelformat = pixelFormat;
+			format.fmt.pix.field = V4L2_FIELD_NONE;
+			if (xioctl(mFd, VIDIOC_S_FMT, &format) == 0 && format.fmt.pix.pixelformat == pixelFormat)
+			{
+				formatFound = true;
+				break;
+			}
+		}
+
+		if (!formatFound)
+		{
+			throw VideoException(SSTR << "Device " << source() << " supports none of the GREY/YUV420/NV12/YUYV/UYVY pixel formats");
+		}
+
+		mPixelFormat = format.fmt.pix.pixelformat;
+		mDeviceWidth = format.fmt.pix.width;
+		mDeviceHeight = format.fmt.pix.height;
+		mBytesPerLine = format.fmt.pix.bytesperline;
+		if (mBytesPerLine == 0)
+		{
+			bool packed = mPixelFormat == V4L2_PIX_FMT_YUYV || mPixelFormat == V4L2_PIX_FMT_UYVY;
+			mBytesPerLine = packed ? mDeviceWidth * 2 : mDeviceWidth;
+		}
+
+		if (mDeviceWidth != frameWidth() || mDeviceHeight != frameHeight())
+		{
+			Logger::warn(SSTR << "V4L2 device " << source() << " captures at " << mDeviceWidth << "x" << mDeviceHeight << "; resampling to " << frameWidth() << "x" << frameHeight());
+			mDeviceLuma.resize(mDeviceWidth * mDeviceHeight);
+		}
+
+		// Request the frame rate (not all drivers support this)
+		if (frameRateHz() != 0)
+		{
+			v4l2_streamparm parm;
+			memset(&parm, 0, sizeof(parm));
+			parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+			parm.parm.capture.timeperframe.numerator = 1;
+			parm.parm.capture.timeperframe.denominator = frameRateHz();
+			xioctl(mFd, VIDIOC_S_PARM, &parm);
+		}
+
+		// Map the device buffers
+		v4l2_requestbuffers request;
+		memset(&request, 0, sizeof(request));
+		request.count = kDeviceBufferCount;
+		request.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		request.memory = V4L2_MEMORY_MMAP;
+		if (xioctl(mFd, VIDIOC_REQBUFS, &request) == -1 || request.count < 2)
+		{
+			throw VideoException(SSTR << "Unable to allocate memory-mapped buffers on device " << source());
+		}
+
+		for (unsigned int i = 0; i < request.count; ++i)
+		{
+			v4l2_buffer buffer;
+			memset(&buffer, 0, sizeof(buffer));
+			buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+			buffer.memory = V4L2_MEMORY_MMAP;
+			buffer.index = i;
+			if (xioctl(mFd, VIDIOC_QUERYBUF, &buffer) == -1)
+			{
+				throw VideoException(SSTR << "Unable to query buffer " << i << " on device " << source());
+			}
+
+			DeviceBuffer deviceBuffer;
+			deviceBuffer.length = buffer.length;
+			deviceBuffer.start = mmap(nullptr, buffer.length, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, buffer.m.offset);
+			if (deviceBuffer.start == MAP_FAILED)
+			{
+				throw VideoException(SSTR << "Unable to map buffer " << i << " on device " << source());
+			}
+			mDeviceBuffers.push_back(deviceBuffer);
+
+			if (xioctl(mFd, VIDIOC_QBUF, &buffer) == -1)
+			{
+				throw VideoException(SSTR << "Unable to queue buffer " << i << " on device " << source());
+			}
+		}
+
+		v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		if (xioctl(mFd, VIDIOC_STREAMON, &type) == -1)
+		{
+			throw VideoException(SSTR << "Unable to start streaming on device " << source());
+		}
+	}
+	catch(VideoException &ex)
+	{
+		closeSource();
+
+		// rethrow
+		throw;
+	}
+}
+
+/// Stops streaming and closes the device
+void V4l2Capture::closeSource()
+{
+	if (mFd < 0) return;
+
+	v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	xioctl(mFd, VIDIOC_STREAMOFF, &type);
+
+	for (const DeviceBuffer &buffer : mDeviceBuffers)
+	{
+		munmap(buffer.start, buffer.length);
+	}
+	mDeviceBuffers.clear();
+
+	close(mFd);
+	mFd = -1;
+}
+
+/// Waits for the next frame from the device and extracts its luma into `luma`
+bool V4l2Capture::readFrame(LumaSample *luma)
+{
+	pollfd pfd;
+	pfd.fd = mFd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	if (poll(&pfd, 1, kFrameTimeoutMS) <= 0)
+	{
+		return false;
+	}
+
+	v4l2_buffer buffer;
+	memset(&buffer, 0, sizeof(buffer));
+	buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	buffer.memory = V4L2_MEMORY_MMAP;
+	if (xioctl(mFd, VIDIOC_DQBUF, &buffer) == -1)
+	{
+		if (errno != EAGAIN)
+		{
+			Logger::error(SSTR << "Unable to dequeue a frame from V4L2 device " << source() << ": " << strerror(errno));
+		}
+		return false;
+	}
+
+	const uint8_t *frame = static_cast<const uint8_t *>(mDeviceBuffers[buffer.index].start);
+	if (mDeviceLuma.empty())
+	{
+		extractLuma(frame, luma);
+	}
+	else
+	{
+		extractLuma(frame, mDeviceLuma.data());
+		resampleNearestNeighborLuma(mDeviceLuma.data(), mDeviceWidth, mDeviceHeight, luma, frameWidth(), frameHeight());
+	}
+
+	// Give the buffer back to the driver
+	if (xioctl(mFd, VIDIOC_QBUF, &buffer) == -1)
+	{
+		Logger::error(SSTR << "Unable to return a buffer to V4L2 device " << source());
+	}
+
+	return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Implementation
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Extracts the luma plane from a device frame into `dst` (at the device frame size)
+void V4l2Capture::extractLuma(const uint8_t *frame, LumaSample *dst) const
+{
+	for (unsigned int y = 0; y < mDeviceHeight; ++y)
+	{
+		const uint8_t *src = frame + y * mBytesPerLine;
+		LumaSample *dstRow = dst + y * mDeviceWidth;
+		switch (mPixelFormat)
+		{
+			// Planar formats start with the full luma plane
+			case V4L2_PIX_FMT_GREY:
+			case V4L2_PIX_FMT_YUV420:
+			case V4L2_PIX_FMT_NV12:
+				memcpy(dstRow, src, mDeviceWidth);
+				break;
+
+			// UYVY is the same layout as 2vuy
+			case V4L2_PIX_FMT_UYVY:
+				copy2vuyToLuma(const_cast<uint8_t *>(src), dstRow, mDeviceWidth, 1);
+				break;
+
+			case V4L2_PIX_FMT_YUYV:
+				for (unsigned int x = 0; x < mDeviceWidth; ++x)
+				{
+					dstRow[x] = src[x * 2];
+				}
+				break;
+		}
+	}
+}
+
+#endif // defined(__linux__)
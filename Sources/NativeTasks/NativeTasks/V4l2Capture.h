@@ -0,0 +1,106 @@
+//
+//  V4l2Capture.h
+//  NativeTasks
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#if defined(__linux__)
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include "SoftwareCapture.h"
+
+/// Capture backend for Video4Linux2 devices (USB cameras, the Pi camera via bcm2835-v4l2, etc.)
+///
+/// Frames are captured with memory-mapped streaming IO. The luma is extracted from the device's native pixel format (GREY,
+/// YUYV, UYVY, YUV420 or NV12) and resampled if the device doesn't support the requested frame size.
+class V4l2Capture : public SoftwareCapture
+{
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Constants
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Number of memory-mapped buffers requested from the driver
+	private: static const unsigned int kDeviceBufferCount = 4;
+
+	/// How long to wait for a frame before giving the capture thread a chance to stop
+	private: static const int kFrameTimeoutMS = 250;
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Local types
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// A memory-mapped device buffer
+	private: struct DeviceBuffer
+	{
+		void *start;
+		size_t length;
+	};
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Construction
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Construct a backend that captures from the device at `source` (e.g., "/dev/video0")
+	public: V4l2Capture(const std::string &source);
+
+	/// Destruction
+	public: virtual ~V4l2Capture();
+
+	/// Returns the name of this backend
+	public: virtual const char *name() const override { return "v4l2"; }
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Source interface
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Opens the device, negotiates the format and starts streaming
+	///
+	/// Throws VideoException on error
+	protected: virtual void openSource() override;
+
+	/// Stops streaming and closes the device
+	protected: virtual void closeSource() override;
+
+	/// Waits for the next frame from the device and extracts its luma into `luma`
+	protected: virtual bool readFrame(LumaSample *luma) override;
+
+	/// The device delivers frames at its own rate
+	protected: virtual bool isPaced() const override { return false; }
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Implementation
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Extracts the luma plane from a device frame into `dst` (at the device frame size)
+	private: void extractLuma(const uint8_t *frame, LumaSample *dst) const;
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Data members
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Device file descriptor
+	private: int mFd;
+
+	/// Memory-mapped device buffers
+	private: std::vector<DeviceBuffer> mDeviceBuffers;
+
+	/// Negotiated device format
+	private: uint32_t mPixelFormat;
+	private: unsigned int mDeviceWidth;
+	private: unsigned int mDeviceHeight;
+	private: unsigned int mBytesPerLine;
+
+	/// Device-sized luma, used only when the device frame size differs from the capture frame size
+	private: std::vector<LumaSample> mDeviceLuma;
+};
+
+#endif // defined(__linux__)
@@ -39,7 +39,7 @@ using namespace std;
 // ---------------------------------------------------------------------------------------------------------------------------------
 
 /// Our primary video capture manager
-VideoCapture gVideoCaptureManager = VideoCapture();
+VideoCapture gVideoCaptureManager;
 
 // ---------------------------------------------------------------------------------------------------------------------------------
 // Construction
@@ -47,7 +47,9 @@ VideoCapture gVideoCaptureManager = VideoCapture();
 
 /// Construction
 VideoCapture::VideoCapture()
-	: mVideoInitialized(false), mLumaFrameReceiver(nullptr)
+	: mpCircularImageBuffer(nullptr), mpFrameDispatcher(nullptr), mVideoInitialized(false), mLumaFrameReceiver(nullptr),
+	  mLendBuffers(false), mDispatchPolicy(kDefaultDispatchPolicy), mDispatchCapacity(kDefaultDispatchCapacity),
+	  mpLentBufferRefs(nullptr), mpLatestBuffer(nullptr), mLentBufferCount(0), mStatLentFramesSkipped(0)
 {
 	// Do our one-time system initialization
 	oneTimeInit();
@@ -68,10 +70,18 @@ VideoCapture::~VideoCapture()
 /// If `receiver` is set, then this callback receives every frame as it becomes available. In these cases, the circular
 /// buffer is not used and polling functions will either do nothing or return empty results.
 ///
+/// If `lendBuffers` is set (and `receiver` is not), frames are not copied into the circular buffer. Instead, the camera's own
+/// buffers are lent to the consumer through `acquireImage()`/`releaseImage()`.
+///
 /// Throws VcosException on error
-void VideoCapture::startCapture(unsigned int frameWidth, unsigned int frameHeight, unsigned int frameRate, NativeCaptureFrameReceiver receiver)
+void VideoCapture::startCapture(unsigned int frameWidth, unsigned int frameHeight, unsigned int frameRate, NativeCaptureFrameReceiver receiver, bool lendBuffers)
 {
-	initVideo(frameWidth, frameHeight, frameRate, receiver);
+	initVideo(frameWidth, frameHeight, frameRate, receiver, lendBuffers);
+
+	if (mpFrameDispatcher)
+	{
+		mpFrameDispatcher->start();
+	}
 
 	MMAL_STATUS_T status = mmal_port_parameter_set_boolean(&mMmalVideoPort, MMAL_PARAMETER_CAPTURE, 1);
 	if (status != MMAL_SUCCESS)
@@ -85,16 +95,37 @@ void VideoCapture::startCapture(unsigned int frameWidth, unsigned int frameHeigh
 
 /// Stop a capture
 ///
+/// When capturing to a receiver, this waits for any frame being delivered and no further frames will be delivered.
+///
 /// Throws VcosException on error
 void VideoCapture::stopCapture()
 {
 	MMAL_STATUS_T status = mmal_port_parameter_set_boolean(&mMmalVideoPort, MMAL_PARAMETER_CAPTURE, 0);
+
+	if (mpFrameDispatcher)
+	{
+		mpFrameDispatcher->stop();
+	}
+
 	if (status != MMAL_SUCCESS)
 	{
 		throw VcosException(status, "Unable to stop the active capture");
 	}
 }
 
+/// Sets how frames are queued for delivery to a receiver
+///
+/// This must be called before video is first initialized (the camera's buffer pool is sized to match.) Returns false if it is
+/// too late.
+bool VideoCapture::setDispatchPolicy(NativeFrameDispatchPolicy policy, unsigned int capacity)
+{
+	if (mVideoInitialized) return false;
+
+	mDispatchPolicy = policy;
+	mDispatchCapacity = capacity;
+	return true;
+}
+
 // ---------------------------------------------------------------------------------------------------------------------------------
 // Initialization
 // ---------------------------------------------------------------------------------------------------------------------------------
@@ -133,7 +164,7 @@ void VideoCapture::oneTimeInit()
 /// buffer is not used and polling functions will either do nothing or return empty results.
 ///
 /// Throws VcosException on error
-void VideoCapture::initVideo(unsigned int frameWidth, unsigned int frameHeight, unsigned int frameRate, NativeCaptureFrameReceiver receiver)
+void VideoCapture::initVideo(unsigned int frameWidth, unsigned int frameHeight, unsigned int frameRate, NativeCaptureFrameReceiver receiver, bool lendBuffers)
 {
 	// Ensure we've initialized
 	oneTimeInit();
@@ -155,6 +186,17 @@ void VideoCapture::initVideo(unsigned int frameWidth, unsigned int frameHeight,
 	mUseCameraControlCallback = 0;
 	mSensorMode = 0;
 	mLumaFrameReceiver = receiver;
+	mLendBuffers = lendBuffers && nullptr == receiver;
+	mpFrameDispatcher = nullptr;
+	mpLatestBuffer = nullptr;
+	mLentBufferCount = 0;
+	mStatLentFramesSkipped = 0;
+
+	// Receivers get their frames from a dispatcher thread, so the camera callback never waits on them
+	if (nullptr != receiver)
+	{
+		mpFrameDispatcher = new FrameDispatcher(receiver, dispatchRelease, this, mDispatchPolicy, mDispatchCapacity);
+	}
 
 	// Set up the videoParameters to default
 	mVideoParameters.setDefaults();
@@ -170,6 +212,17 @@ void VideoCapture::initVideo(unsigned int frameWidth, unsigned int frameHeight,
 		// Our state data is our user data
 		mmalVideoPort->userdata = (struct MMAL_PORT_USERDATA_T *) this;
 
+		// Give each buffer header a reference count for lending (or dispatching)
+		if (mLendBuffers || mpFrameDispatcher)
+		{
+			mpLentBufferRefs = new std::atomic<int>[mpMmalVideoPortPool->headers_num];
+			for (unsigned int i = 0; i < mpMmalVideoPortPool->headers_num; ++i)
+			{
+				mpLentBufferRefs[i] = 0;
+				mpMmalVideoPortPool->header[i]->user_data = &mpLentBufferRefs[i];
+			}
+		}
+
 		// Enable the camera video port with a callback function
 		MMAL_STATUS_T status = mmal_port_enable(mmalVideoPort, cameraBufferCallback);
 		if (status != MMAL_SUCCESS)
@@ -198,10 +251,10 @@ void VideoCapture::initVideo(unsigned int frameWidth, unsigned int frameHeight,
 		// Let's keep a copy of this...
 		mMmalVideoPort = *mmalVideoPort;
 
-		// If we have don't have receiver, allocate our circular image buffer
-		if (nullptr == mLumaFrameReceiver)
+		// If we have don't have receiver (and aren't lending buffers), allocate our circular image buffer
+		if (nullptr == mLumaFrameReceiver && !mLendBuffers)
 		{
-			mpCircularImageBuffer = new CircularImageBuffer<LumaSample>(mFrameWidth, mFrameHeight, kCircularImageBufferCapacity);
+			mpCircularImageBuffer = new CircularImageBuffer<LumaSample>(mFrameWidth, mFrameHeight, kCircularImageBufferCapacity, kCircularImageBufferMode);
 		}
 	}
 	catch(VcosException &ex)
@@ -242,8 +295,32 @@ void VideoCapture::uninitVideo()
 				}
 			}
 
-			// Destroy the video port pool
-			mmal_port_pool_destroy(videoPort, mpMmalVideoPortPool);
+			// Drop any frames waiting for delivery (they return to the pool)
+			if (mpFrameDispatcher)
+			{
+				mpFrameDispatcher->stop();
+			}
+
+			// Return the latest frame (if it was never acquired) to the pool
+			MMAL_BUFFER_HEADER_T *latest = mpLatestBuffer.exchange(nullptr);
+			if (latest)
+			{
+				releaseBuffer(latest);
+			}
+
+			// Destroy the video port pool, unless the consumer is still holding some of its buffers
+			if (mLentBufferCount.load() > 0)
+			{
+				Logger::error(SSTR << "Video capture shut down with " << mLentBufferCount.load() << " image(s) still acquired; leaking the buffer pool");
+			}
+			else
+			{
+				mmal_port_pool_destroy(videoPort, mpMmalVideoPortPool);
+				delete[] mpLentBufferRefs;
+			}
+
+			mpMmalVideoPortPool = nullptr;
+			mpLentBufferRefs = nullptr;
 		}
 
 		// Destroy the camera component
@@ -257,6 +334,13 @@ void VideoCapture::uninitVideo()
 		mpMmalCamComponent = nullptr;
 	}
 
+	// Cleanup our frame dispatcher
+	if (mpFrameDispatcher)
+	{
+		delete mpFrameDispatcher;
+		mpFrameDispatcher = nullptr;
+	}
+
 	// Cleanup our circular image buffer
 	if (mpCircularImageBuffer)
 	{
@@ -367,6 +451,16 @@ void VideoCapture::createCameraComponent()
 			videoPort->buffer_num = kVideoOutputBufferCount;
 		}
 
+		// Lent buffers are out of the camera's hands, so it needs extras to keep capturing while they're held
+		if (mLendBuffers)
+		{
+			videoPort->buffer_num += kLentBufferCount;
+		}
+		else if (mpFrameDispatcher)
+		{
+			videoPort->buffer_num += mpFrameDispatcher->maxFramesHeld();
+		}
+
 		status = mmal_port_parameter_set_boolean(videoPort, MMAL_PARAMETER_ZERO_COPY, MMAL_TRUE);
 		if (status != MMAL_SUCCESS)
 		{
@@ -411,19 +505,13 @@ void VideoCapture::createCameraComponent()
 // ---------------------------------------------------------------------------------------------------------------------------------
 
 /// Callback for buffer containing captured image data (YUV)
+///
+/// This runs on the camera's thread and must never wait on the consumer: frames are lent, dispatched or copied, and the camera
+/// is given a free buffer right away.
 void VideoCapture::cameraBufferCallback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffer)
 {
-	static bool noReentryFlag = false;
-
-	// Don't re-enter this method
-	if (noReentryFlag) return;
-
-	// Set the flag so they know we're busy
-	noReentryFlag = true;
-
 	try
 	{
-		MMAL_BUFFER_HEADER_T *newBuffer;
 		static int64_t baseTime = -1;
 
 		// All our times based on the receipt of the first callback
@@ -437,48 +525,61 @@ void VideoCapture::cameraBufferCallback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T
 			// Get our state data
 			VideoCapture &state = *((VideoCapture *)port->userdata);
 
-			// Lock the buffer
-			mmal_buffer_header_mem_lock(buffer);
+			// Lend the buffer (zero-copy): it replaces the latest frame and stays locked until its last reference is released
+			if (state.mLendBuffers && buffer->length != 0)
 			{
-				NativeLumaBuffer imageBuffer = reinterpret_cast<NativeLumaBuffer>(buffer->data);
+				mmal_buffer_header_mem_lock(buffer);
+				static_cast<std::atomic<int> *>(buffer->user_data)->store(1, std::memory_order_relaxed);
 
-				// Add it to our circular buffer
-				if (state.mpCircularImageBuffer)
+				MMAL_BUFFER_HEADER_T *previous = state.mpLatestBuffer.exchange(buffer, std::memory_order_acq_rel);
+				if (previous)
 				{
-					state.mpCircularImageBuffer->add(imageBuffer);
+					state.mStatLentFramesSkipped.fetch_add(1, std::memory_order_relaxed);
+					state.releaseBuffer(previous);
 				}
 
+				state.sendFreeBuffersToPort();
+			}
+			// Dispatch the buffer to the receiver (zero-copy): it stays locked until the dispatcher releases it
+			else if (state.mpFrameDispatcher && buffer->length != 0)
+			{
+				mmal_buffer_header_mem_lock(buffer);
+				static_cast<std::atomic<int> *>(buffer->user_data)->store(1, std::memory_order_relaxed);
+
 				// Our image dimensions
 				unsigned int w = port->format->es->video.width;
 				unsigned int h = vcos_min(port->format->es->video.height, state.mFrameHeight);
 
-				// If we have a receiver, notify them
-				if (nullptr != state.mLumaFrameReceiver)
-				{
-					(*state.mLumaFrameReceiver)(imageBuffer, w, h);
-				}
-			}
-			mmal_buffer_header_mem_unlock(buffer);
-
-			// release buffer back to the pool
-			mmal_buffer_header_release(buffer);
+				// If this is dropped, it is released right away
+				state.mpFrameDispatcher->submit(reinterpret_cast<NativeLumaBuffer>(buffer->data), w, h, buffer);
 
-			// and send one back to the port (if still open)
-			if (port->is_enabled)
+				state.sendFreeBuffersToPort();
+			}
+			else if (state.mLendBuffers || state.mpFrameDispatcher)
 			{
-				MMAL_STATUS_T status;
-
-				newBuffer = mmal_queue_get(state.mpMmalVideoPortPool->queue);
-
-				if (newBuffer)
+				mmal_buffer_header_release(buffer);
+				state.sendFreeBuffersToPort();
+			}
+			else
+			{
+				// Lock the buffer
+				mmal_buffer_header_mem_lock(buffer);
 				{
-					status = mmal_port_send_buffer(port, newBuffer);
-				}
+					NativeLumaBuffer imageBuffer = reinterpret_cast<NativeLumaBuffer>(buffer->data);
 
-				if (!newBuffer || status != MMAL_SUCCESS)
-				{
-					Logger::error("Unable to return a buffer to the camera port");
+					// Add it to our circular buffer
+					if (state.mpCircularImageBuffer)
+					{
+						state.mpCircularImageBuffer->add(imageBuffer);
+					}
 				}
+				mmal_buffer_header_mem_unlock(buffer);
+
+				// release buffer back to the pool
+				mmal_buffer_header_release(buffer);
+
+				// and send one back to the port (if still open)
+				state.sendFreeBuffersToPort();
 			}
 		}
 		else
@@ -498,8 +599,103 @@ void VideoCapture::cameraBufferCallback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T
 		Logger::error(SSTR << "Caught unknown exception during video capture callback");
 	}
 
-	// It's OK to enter again
-	noReentryFlag = false;
+}
+
+/// Sends every free buffer in the pool to the camera video port (if still open)
+void VideoCapture::sendFreeBuffersToPort()
+{
+	MMAL_PORT_T *port = mpMmalCamComponent ? mpMmalCamComponent->output[kMmalCameraVideoPort] : nullptr;
+	if (!port || !port->is_enabled) return;
+
+	// When lending, an empty pool just means the consumer is holding every spare buffer
+	bool sent = false;
+	while (MMAL_BUFFER_HEADER_T *newBuffer = mmal_queue_get(mpMmalVideoPortPool->queue))
+	{
+		if (mmal_port_send_buffer(port, newBuffer) != MMAL_SUCCESS)
+		{
+			mmal_buffer_header_release(newBuffer);
+			Logger::error("Unable to return a buffer to the camera port");
+			return;
+		}
+
+		sent = true;
+	}
+
+	if (!sent && !mLendBuffers && !mpFrameDispatcher)
+	{
+		Logger::error("Unable to return a buffer to the camera port");
+	}
+}
+
+/// Returns a delivered (or dropped) frame's buffer to the camera (see `FrameDispatchRelease`)
+void VideoCapture::dispatchRelease(void *context, void *handle)
+{
+	VideoCapture &state = *static_cast<VideoCapture *>(context);
+	state.releaseBuffer(static_cast<MMAL_BUFFER_HEADER_T *>(handle));
+	state.sendFreeBuffersToPort();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Buffer lending
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Acquires the most recent frame that has not yet been acquired, filling in `image`
+///
+/// Returns false if no new frame is available (or capture isn't lending buffers)
+bool VideoCapture::acquireImage(NativeCaptureImage &image)
+{
+	if (!mLendBuffers) return false;
+
+	// Take over the latest frame's reference
+	MMAL_BUFFER_HEADER_T *buffer = mpLatestBuffer.exchange(nullptr, std::memory_order_acq_rel);
+	if (!buffer) return false;
+
+	mLentBufferCount.fetch_add(1, std::memory_order_relaxed);
+
+	image.luma = reinterpret_cast<NativeLumaBuffer>(buffer->data);
+	image.width = mMmalVideoPort.format->es->video.width;
+	image.height = vcos_min(mMmalVideoPort.format->es->video.height, mFrameHeight);
+	image.handle = buffer;
+	return true;
+}
+
+/// Adds a reference to an acquired image, which then requires an additional `releaseImage()`
+void VideoCapture::retainImage(const NativeCaptureImage &image)
+{
+	if (!image.handle) return;
+
+	mLentBufferCount.fetch_add(1, std::memory_order_relaxed);
+	retainBuffer(static_cast<MMAL_BUFFER_HEADER_T *>(image.handle));
+}
+
+/// Releases a reference to an acquired image, returning the buffer to the camera when the last reference is released
+void VideoCapture::releaseImage(NativeCaptureImage &image)
+{
+	if (!image.handle) return;
+
+	releaseBuffer(static_cast<MMAL_BUFFER_HEADER_T *>(image.handle));
+	mLentBufferCount.fetch_sub(1, std::memory_order_relaxed);
+	sendFreeBuffersToPort();
+
+	image.luma = nullptr;
+	image.handle = nullptr;
+}
+
+/// Adds a reference to a lent buffer
+void VideoCapture::retainBuffer(MMAL_BUFFER_HEADER_T *buffer)
+{
+	static_cast<std::atomic<int> *>(buffer->user_data)->fetch_add(1, std::memory_order_relaxed);
+}
+
+/// Releases a reference to a lent buffer (see `retainBuffer()`)
+///
+/// The last reference unlocks the buffer's memory and returns it to the pool
+void VideoCapture::releaseBuffer(MMAL_BUFFER_HEADER_T *buffer)
+{
+	if (static_cast<std::atomic<int> *>(buffer->user_data)->fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+	mmal_buffer_header_mem_unlock(buffer);
+	mmal_buffer_header_release(buffer);
 }
 
 #endif // defined(USE_MMAL)
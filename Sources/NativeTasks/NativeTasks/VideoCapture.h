@@ -15,8 +15,9 @@
 #pragma once
 
 #include <vector>
+#include <atomic>
 #include "VideoParameters.h"
-#include "CircularImageBuffer.h"
+#include "CaptureBackend.h"
 #include "include/NativeInterface.h"
 
 extern "C"
@@ -26,8 +27,8 @@ extern "C"
 
 /// Video capture management class
 ///
-/// Performs initialization and capture of live video data
-class VideoCapture
+/// Performs initialization and capture of live video data from the Raspberry Pi camera (via MMAL)
+class VideoCapture : public CaptureBackend
 {
 	// -----------------------------------------------------------------------------------------------------------------------------
 	// Constants
@@ -41,17 +42,36 @@ class VideoCapture
 	/// Video render needs at least 2 buffers
 	private: static const int kVideoOutputBufferCount = 2;
 
+	/// Additional camera buffers allocated when lending buffers: one for the latest frame and two held by the consumer
+	private: static const int kLentBufferCount = 3;
+
+	/// Default frame dispatch settings (see `setDispatchPolicy()`)
+	private: static const NativeFrameDispatchPolicy kDefaultDispatchPolicy = NativeFrameDispatchPolicyLatest;
+	private: static const unsigned int kDefaultDispatchCapacity = 2;
+
 	/// Circular Image Buffer capacity
 	private: static const unsigned int kCircularImageBufferCapacity = 3;
 
+	/// Circular Image Buffer mode
+	///
+	/// The camera callback is the only producer, so it uses the lock-free ring and never waits on a reader holding the lock
+	private: static const CircularImageBufferMode kCircularImageBufferMode = CircularImageBufferModeLockFree;
+
 	// -----------------------------------------------------------------------------------------------------------------------------
 	// Properties
 	// -----------------------------------------------------------------------------------------------------------------------------
 
 	/// Our circular image buffer
-	public: CircularImageBuffer<LumaSample> *circularImageBuffer() { return mpCircularImageBuffer; }
+	public: virtual CircularImageBuffer<LumaSample> *circularImageBuffer() override { return mpCircularImageBuffer; }
 	private: CircularImageBuffer<LumaSample> *mpCircularImageBuffer;
 
+	/// Our frame dispatcher (only when capturing to a receiver)
+	public: virtual FrameDispatcher *frameDispatcher() override { return mpFrameDispatcher; }
+
+	/// Returns the name of this backend
+	public: virtual const char *name() const override { return "mmal"; }
+	private: FrameDispatcher *mpFrameDispatcher;
+
 	// -----------------------------------------------------------------------------------------------------------------------------
 	// Construction
 	// -----------------------------------------------------------------------------------------------------------------------------
@@ -60,7 +80,7 @@ class VideoCapture
 	public: VideoCapture();
 
 	/// Destruction
-	public: ~VideoCapture();
+	public: virtual ~VideoCapture();
 
 	// -----------------------------------------------------------------------------------------------------------------------------
 	// Capture control
@@ -71,13 +91,24 @@ class VideoCapture
 	/// If `receiver` is set, then this callback receives every frame as it becomes available. In these cases, the circular
 	/// buffer is not used and polling functions will either do nothing or return empty results.
 	///
+	/// If `lendBuffers` is set (and `receiver` is not), frames are not copied into the circular buffer. Instead, the camera's own
+	/// buffers are lent to the consumer through `acquireImage()`/`releaseImage()`.
+	///
 	/// Throws VcosException on error
-	public: void startCapture(unsigned int frameWidth, unsigned int frameHeight, unsigned int frameRate, NativeCaptureFrameReceiver receiver);
+	public: virtual void startCapture(unsigned int frameWidth, unsigned int frameHeight, unsigned int frameRate, NativeCaptureFrameReceiver receiver, bool lendBuffers) override;
 
 	/// Stop a capture
 	///
+	/// When capturing to a receiver, this waits for any frame being delivered and no further frames will be delivered.
+	///
 	/// Throws VcosException on error
-	public: void stopCapture();
+	public: virtual void stopCapture() override;
+
+	/// Sets how frames are queued for delivery to a receiver
+	///
+	/// This must be called before video is first initialized (the camera's buffer pool is sized to match.) Returns false if it is
+	/// too late.
+	public: virtual bool setDispatchPolicy(NativeFrameDispatchPolicy policy, unsigned int capacity) override;
 
 	// -----------------------------------------------------------------------------------------------------------------------------
 	// Initialization
@@ -92,7 +123,7 @@ class VideoCapture
 	/// Returns camera video port
 	///
 	/// Throws VcosException on error
-	private: void initVideo(unsigned int frameWidth, unsigned int frameHeight, unsigned int frameRate, NativeCaptureFrameReceiver receiver);
+	private: void initVideo(unsigned int frameWidth, unsigned int frameHeight, unsigned int frameRate, NativeCaptureFrameReceiver receiver, bool lendBuffers);
 
 	/// Destroy the camera component
 	///
@@ -111,6 +142,42 @@ class VideoCapture
 	/// Callback for buffer containing captured image data (YUV)
 	private: static void cameraBufferCallback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffer);
 
+	/// Sends every free buffer in the pool to the camera video port (if still open)
+	private: void sendFreeBuffersToPort();
+
+	/// Returns a delivered (or dropped) frame's buffer to the camera (see `FrameDispatchRelease`)
+	private: static void dispatchRelease(void *context, void *handle);
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Buffer lending
+	//
+	// Each lent buffer header carries a reference count (in its `user_data`.) The latest frame holds one reference until it is
+	// acquired (or replaced by a newer frame), and each consumer holds one more. When the count reaches zero, the buffer is
+	// unlocked and returned to the pool, and free buffers are sent back to the camera.
+	//
+	// Frames dispatched to a receiver are lent to the frame dispatcher in the same way.
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Acquires the most recent frame that has not yet been acquired, filling in `image`
+	///
+	/// Returns false if no new frame is available (or capture isn't lending buffers)
+	public: virtual bool acquireImage(NativeCaptureImage &image) override;
+
+	/// Adds a reference to an acquired image, which then requires an additional `releaseImage()`
+	public: virtual void retainImage(const NativeCaptureImage &image) override;
+
+	/// Releases a reference to an acquired image, returning the buffer to the camera when the last reference is released
+	public: virtual void releaseImage(NativeCaptureImage &image) override;
+
+	/// Returns the number of frames replaced by a newer frame before they were acquired
+	public: unsigned int statFramesSkipped() const { return mStatLentFramesSkipped.load(std::memory_order_relaxed); }
+
+	/// Adds a reference to a lent buffer
+	private: static void retainBuffer(MMAL_BUFFER_HEADER_T *buffer);
+
+	/// Releases a reference to a lent buffer (see `retainBuffer()`)
+	private: void releaseBuffer(MMAL_BUFFER_HEADER_T *buffer);
+
 	// -----------------------------------------------------------------------------------------------------------------------------
 	// Data members
 	// -----------------------------------------------------------------------------------------------------------------------------
@@ -150,6 +217,25 @@ class VideoCapture
 
 	/// Video capture receiver
 	private: NativeCaptureFrameReceiver mLumaFrameReceiver;
+
+	/// Are we lending camera buffers to the consumer (rather than copying into the circular image buffer)?
+	private: bool mLendBuffers;
+
+	/// Frame dispatch settings
+	private: NativeFrameDispatchPolicy mDispatchPolicy;
+	private: unsigned int mDispatchCapacity;
+
+	/// Reference counts for each buffer header in the video port pool (lending or dispatching only)
+	private: std::atomic<int> *mpLentBufferRefs;
+
+	/// The latest frame, not yet acquired by the consumer (lending only)
+	private: std::atomic<MMAL_BUFFER_HEADER_T *> mpLatestBuffer;
+
+	/// Number of references currently held by consumers (lending only)
+	private: std::atomic<int> mLentBufferCount;
+
+	/// Number of lent frames that were replaced before being acquired
+	private: std::atomic<unsigned int> mStatLentFramesSkipped;
 };
 
 /// Our primary video capture manager
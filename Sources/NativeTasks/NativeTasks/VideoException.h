@@ -10,8 +10,6 @@
 // Use of this source code is governed by a BSD-style license that can be found
 // in the LICENSE file in the root of the source tree.
 
-#if defined(USE_MMAL)
-
 #pragma once
 
 #include <string>
@@ -53,5 +51,3 @@ struct VideoException : public std::exception
 	/// Our stored message
 	protected: std::string mMessage;
 };
-
-#endif // defined(USE_MMAL)
@@ -107,6 +107,200 @@ extern "C"
 	/// This is an optimized method to flip the image horizontally and vertically in-place in a single pass
 	void nativeRotate180(const NativeLumaBuffer src, uint32_t width, uint32_t height);
 
+	/// Samples 8-bit monochrome image `src` along the line from (`x0`, `y0`) to (`x1`, `y1`), inclusive, storing one sample per
+	/// pixel along the line's major axis into `dst` (optionally inverted, as `255 - luma`)
+	///
+	/// This is the sampling loop of Seer's `SampleLine.sample()`; the results are identical. The line is not clipped, so `dst`
+	/// must hold at least `max(abs(x1 - x0), abs(y1 - y0)) + 1` samples.
+	///
+	/// Returns the number of samples stored, or zero if either end point lies outside the image
+	uint32_t nativeSampleLine(const NativeLumaBuffer src, uint32_t width, uint32_t height, int32_t x0, int32_t y0, int32_t x1, int32_t y1, bool invert, int32_t *dst);
+
+	/// Samples 8-bit monochrome image `src` along a line as `nativeSampleLine()` does, weighting each sample with its neighbors
+	/// two pixels to either side: `(a + 2b + c) / 4`
+	///
+	/// This is the sampling loop of Seer's `SampleLine.sampleWide()`; the results are identical.
+	///
+	/// Returns the number of samples stored, or zero if either end point lies within two pixels of the image's edge
+	uint32_t nativeSampleLineWide(const NativeLumaBuffer src, uint32_t width, uint32_t height, int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t *dst);
+
+	/// Samples the bit columns of a deck from 8-bit monochrome image `src`, between the left and right landmark centers, storing
+	/// one row of samples per bit into `dst` (each row `dstStride` samples apart)
+	///
+	/// This is the sampling loop of Seer's `MarkLines.generateContouredMarkLines()`; the results are identical. Each row of `dst`
+	/// must hold at least `max(leftCount, rightCount)` samples.
+	///
+	/// Returns the number of scanlines sampled, or zero if there are no centers or bits, or if any sample lies outside the image
+	uint32_t nativeSampleBitColumns(const NativeLumaBuffer src, uint32_t width, uint32_t height, const NativePoint *leftCenters, uint32_t leftCount, const NativePoint *rightCenters, uint32_t rightCount, const float *bitCenters, uint32_t bitCount, bool invert, int32_t *dst, uint32_t dstStride);
+
+	/// Transposes `columnCount` packed bit columns into one word per column, storing them into `dst`
+	///
+	/// The columns are packed in groups of eight, 32 bytes per group: bit `j` of byte `i` of group `g` is row `i` of column
+	/// `g * 8 + j`. Word `c` of `dst` holds the rows of column `c`, with row `i` in bit `i`. This is the bit combining loop of
+	/// Seer's `MarkLines.generateBitWords()`.
+	void nativeTransposeBitColumns(const uint8_t *packed, uint32_t columnCount, uint32_t *dst);
+
+	/// Calculates the rolling min/max of `sampleCount` samples over a window of `windowSize` samples, storing `count` results
+	/// into `dst`
+	///
+	/// This is the rolling loop of Seer's `rollMinMax(samples:count:windowSize:)`; the results are identical. Result `i` is the
+	/// min/max of the window starting at sample `i`. The final full window is repeated to fill out the results, so `dst` must
+	/// hold at least `sampleCount` results. The window is clamped to `sampleCount`.
+	///
+	/// Returns the number of results stored (`max(count, windowSize)`), or zero if there are no samples
+	uint32_t nativeRollMinMax(const int32_t *samples, uint32_t sampleCount, uint32_t count, uint32_t windowSize, NativeMinMax *dst);
+
+	/// Detects the edges along `sampleCount` samples in a single pass, storing them into `dst`
+	///
+	/// This is Seer's `EdgeDetection.detectEdges()` (rolling sums, peak finding and thresholding) fused into one pass over the
+	/// samples; the edges are identical. The window sizes must already be scaled to the image, `sensitivity` is a FixedPoint value
+	/// and `minThreshold` is the unscaled minimum threshold. `dst` must hold at least `sampleCount` peaks.
+	///
+	/// Returns the number of edges stored, or -1 if there are too few samples to find any peaks
+	int32_t nativeDetectEdges(const int32_t *samples, uint32_t sampleCount, int32_t windowSize, int32_t minMaxWindowSize, int32_t overlap, int32_t sensitivity, int32_t minThreshold, NativeEdgePeak *dst);
+
+	/// Returns the name of the instruction set used by the image conversion functions ("scalar", "sse2", "avx2" or "neon")
+	///
+	/// The best instruction set supported by the host CPU is selected automatically on first use
+	const char *nativeImageKernelsName();
+
+	/// Selects the instruction set used by the image conversion functions, by name (see `nativeImageKernelsName()`)
+	///
+	/// This is intended for testing and benchmarking. The "scalar" kernels are the reference implementation and are always
+	/// available.
+	///
+	/// Returns error string or nullptr
+	const char *nativeImageKernelsSelect(const char *name);
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	//  _____                       ____                          _   _
+	// | ____|_ __ _ __ ___  _ __  / ___|___  _ __ _ __ ___  ___| |_(_) ___  _ __
+	// |  _| | '__| '__/ _ \| '__| | |   / _ \| '__| '__/ _ \/ __| __| |/ _ \| '_ \
+	// | |___| |  | | | (_) | |    | |__| (_) | |  | | |  __/ (__| |_| | (_) | | | |
+	// |_____|_|  |_|  \___/|_|     \____\___/|_|  |_|  \___|\___|\__|_|\___/|_| |_|
+	//
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Returns the error correction table for `codeCount` codes of `bitCount` bits each, mapped read-only into memory
+	///
+	/// The table has one entry for each of the `1 << bitCount` possible values: the index of the code nearest to it (by Hamming
+	/// Distance), or -1 if two or more codes are equally near. Tables are built in parallel and stored in `directory`, keyed by a
+	/// hash of the codes, so that they are only built once and their pages are shared by every process that maps them. If
+	/// `directory` is null or empty (or not writable), the table is built into private memory instead.
+	///
+	/// Returns null if the codes are unsupported (more than 30 bits or 32767 codes.) Release the table with
+	/// `nativeErrorCorrectionTableClose()`.
+	const int16_t *nativeErrorCorrectionTableOpen(const char *directory, const int64_t *codes, uint32_t codeCount, uint32_t bitCount);
+
+	/// Releases a table returned by `nativeErrorCorrectionTableOpen()` (does nothing if `table` is null)
+	void nativeErrorCorrectionTableClose(const int16_t *table);
+
+	/// Returns the minimum Hamming Distance between any two of `codeCount` codes of `codeBits` bits each (at most `codeBits`), or
+	/// 0 if it falls below `floor`
+	///
+	/// This is Seer's `HammingDistance.calcMinimumDistance()`, comparing the pairs in cache-sized blocks with hardware popcount
+	/// (where available) and ending early once the distance falls below `floor`.
+	int32_t nativeMinimumDistance(const int64_t *codes, uint32_t codeCount, uint32_t codeBits, int32_t floor);
+
+	/// Stores the number of codes with each number of bits set (of the lower `bitCount` bits), after XORing each of `codeCount`
+	/// codes with `mask`, into `dst`, which must hold `bitCount + 1` counts
+	void nativeBinaryHistogram(const int64_t *codes, uint32_t codeCount, int64_t mask, uint32_t bitCount, int32_t *dst);
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	//  _____                               _
+	// |  ___| __ __ _ _ __ ___   ___      / \   _ __ ___ _ __   __ _
+	// | |_ | '__/ _` | '_ ` _ \ / _ \    / _ \ | '__/ _ \ '_ \ / _` |
+	// |  _|| | | (_| | | | | | |  __/   / ___ \| | |  __/ | | | (_| |
+	// |_|  |_|  \__,_|_| |_| |_|\___|  /_/   \_\_|  \___|_| |_|\__,_|
+	//
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Creates an arena for temporaries that live no longer than a single frame, starting with a block of `capacity` bytes
+	///
+	/// Allocations are carved from the block without locking, from any number of threads at once, and are all released together
+	/// by `nativeFrameArenaReset()`. A frame that overflows the block is served from the heap, after which the block grows to fit.
+	///
+	/// Release the arena with `nativeFrameArenaDestroy()`.
+	void *nativeFrameArenaCreate(uint64_t capacity);
+
+	/// Releases an arena created by `nativeFrameArenaCreate()`, along with everything allocated from it
+	void nativeFrameArenaDestroy(void *arena);
+
+	/// Returns `size` bytes from `arena`, aligned to `alignment` (a power of two), valid until the next `nativeFrameArenaReset()`
+	///
+	/// Returns nullptr only if the heap is exhausted.
+	void *nativeFrameArenaAllocate(void *arena, uint64_t size, uint32_t alignment);
+
+	/// Releases everything allocated from `arena` since the previous reset, returning the statistics for that frame
+	///
+	/// This must not be called while allocations are being made from `arena`, nor while any allocation is still in use.
+	NativeFrameArenaStats nativeFrameArenaReset(void *arena);
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	//  _                                _             _     _
+	// | |   _   _ _ __ ___   __ _      / \   _ __ ___| |__ (_)_   _____
+	// | |  | | | | '_ ` _ \ / _` |    / _ \ | '__/ __| '_ \| \ \ / / _ \
+	// | |__| |_| | | | | | | (_| |   / ___ \| | | (__| | | | |\ V /  __/
+	// |_____\__,_|_| |_| |_|\__,_|  /_/   \_\_|  \___|_| |_|_| \_/ \___|
+	//
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Creates a luma archive at `path` for writing (replacing any existing file), returning the writer or nullptr on error
+	///
+	/// An archive holds any number of frames, each with its header data (as the user data of a `.luma` file), followed by an
+	/// index. Frames are written on a background thread into space preallocated `preallocation` bytes at a time (0 for the
+	/// default.) If `compress` is set, frames are losslessly compressed (see `nativeLumaEncode()`) on that thread as well.
+	///
+	/// The archive must be finished with `nativeLumaArchiveWriterClose()`.
+	void *nativeLumaArchiveWriterCreate(const char *path, uint64_t preallocation, bool compress);
+
+	/// Appends a frame of `width` x `height` packed samples to `writer`, along with `headerSize` bytes of header data
+	///
+	/// This only copies the frame; it is written in the background. Frames must be appended from one thread at a time.
+	///
+	/// Returns false on error (including an earlier write that failed)
+	bool nativeLumaArchiveWriterAppend(void *writer, const LumaSample *luma, uint32_t width, uint32_t height, const void *header, uint32_t headerSize);
+
+	/// Waits for every frame to be written, then writes the index and releases `writer`
+	///
+	/// Returns false if any part of the archive failed to write (frames written before the failure can still be read.)
+	bool nativeLumaArchiveWriterClose(void *writer);
+
+	/// Opens the luma archive at `path` for reading, returning the reader or nullptr on error
+	///
+	/// The archive is mapped into memory, and any frame can be read directly through its index. An archive that was never closed
+	/// is recovered up to its last complete frame.
+	///
+	/// Release the reader with `nativeLumaArchiveReaderClose()`.
+	void *nativeLumaArchiveReaderOpen(const char *path);
+
+	/// Returns the number of frames in the archive read by `reader`
+	uint32_t nativeLumaArchiveReaderFrameCount(void *reader);
+
+	/// Fills `frame` with frame `index` of the archive read by `reader`, without copying it
+	///
+	/// The frame is valid until the reader is closed; a compressed frame is decoded into the reader, so it is only valid until
+	/// the next frame is read. Returns false if `index` is out of range or the frame is damaged.
+	bool nativeLumaArchiveReaderFrame(void *reader, uint32_t index, NativeLumaArchiveFrame *frame);
+
+	/// Releases `reader`, unmapping its archive (does nothing if `reader` is null)
+	void nativeLumaArchiveReaderClose(void *reader);
+
+	/// Returns the largest number of bytes that `nativeLumaEncode()` can produce for a frame of `width` x `height` samples
+	uint64_t nativeLumaEncodeMaxSize(uint32_t width, uint32_t height);
+
+	/// Losslessly compresses a frame of `width` x `height` packed samples into `dst`, which must hold at least
+	/// `nativeLumaEncodeMaxSize()` bytes, returning the number of bytes written
+	///
+	/// This is the compression used by luma archives: each sample is predicted from its neighbors and the prediction error is
+	/// coded with adaptive Rice codes. The dimensions are not stored.
+	uint64_t nativeLumaEncode(const LumaSample *luma, uint32_t width, uint32_t height, uint8_t *dst);
+
+	/// Decompresses `size` bytes from `nativeLumaEncode()` into a frame of `width` x `height` packed samples
+	///
+	/// Returns false if the data is truncated or damaged
+	bool nativeLumaDecode(const uint8_t *src, uint64_t size, uint32_t width, uint32_t height, LumaSample *luma);
+
 	// -----------------------------------------------------------------------------------------------------------------------------
 	//  _                  ____            _     _             _   _
 	// | |    ___   __ _  |  _ \ ___  __ _(_)___| |_ _ __ __ _| |_(_) ___  _ __
@@ -152,6 +346,21 @@ extern "C"
 	//                                         |_|                       
 	// -----------------------------------------------------------------------------------------------------------------------------
 
+	/// Selects the source of captured video frames. This must be called while capture is stopped.
+	///
+	/// `name` is one of:
+	///
+	///		"mmal"   - The Raspberry Pi camera (only available in MMAL builds, where it is the default)
+	///		"v4l2"   - A Video4Linux2 device; `source` is the device path (default: /dev/video0)
+	///		"replay" - Replays `.luma`, `.lumas` (luma archive) or raw luma files from `source` (a file or directory) at the
+	///		           capture frame rate. If `source` is empty, synthetic frames are generated.
+	///
+	/// Returns error string or nullptr
+	const char *nativeVideoCaptureSelectBackend(const char *name, const char *source);
+
+	/// Returns the name of the selected capture backend (see `nativeVideoCaptureSelectBackend()`)
+	const char *nativeVideoCaptureBackendName();
+
 	/// Causes video capturing from the camera to begin at the requested frame dimensions and rate
 	///
 	/// If `receiver` method is set, captured frames will be sent to that receiver. Otherwise, captured frames will rotate
@@ -162,15 +371,61 @@ extern "C"
 	/// Returns error string or nullptr
 	const char *nativeVideoCaptureStart(uint32_t frameWidth, uint32_t frameHeight, uint32_t frameRate, NativeCaptureFrameReceiver receiver);
 
+	/// Causes video capturing from the camera to begin at the requested frame dimensions and rate, lending the camera's buffers
+	/// directly to the caller rather than copying them into the circular buffer
+	///
+	/// Captured frames are accessed with `nativeVideoCaptureImageAcquire()` and `nativeVideoCaptureImageRelease()`.
+	///
+	/// Returns error string or nullptr
+	const char *nativeVideoCaptureStartLending(uint32_t frameWidth, uint32_t frameHeight, uint32_t frameRate);
+
 	/// Causes video capture from the camera to stop
 	///
 	/// Returns error string or nullptr
 	const char *nativeVideoCaptureStop();
 
+	/// Sets how captured frames are queued for delivery to the `receiver` passed to `nativeVideoCaptureStart()`
+	///
+	/// Frames are delivered to the receiver on a dedicated thread, so the camera never waits for a frame to be processed. With
+	/// `NativeFrameDispatchPolicyLatest` (the default), a new frame replaces one still waiting for delivery. With
+	/// `NativeFrameDispatchPolicyFifo`, up to `capacity` frames wait in order and new frames are dropped when the queue is full.
+	///
+	/// This must be called before capture is first started.
+	///
+	/// Returns error string or nullptr
+	const char *nativeVideoCaptureDispatchConfigure(NativeFrameDispatchPolicy policy, uint32_t capacity);
+
+	/// Returns statistics for the delivery of frames to the `receiver` passed to `nativeVideoCaptureStart()`
+	///
+	/// If `reset` is set, the statistics are reset after they are returned. The statistics are all zero if no receiver is active.
+	NativeFrameDispatchStats nativeVideoCaptureDispatchStats(bool reset);
+
+	/// Sets the region of interest of frames delivered to the `receiver` passed to `nativeVideoCaptureStart()`
+	///
+	/// Frames are cropped to the `width` x `height` region at (`x`, `y`) before delivery, and optionally binned (each delivered
+	/// sample being the average of a `binning` x `binning` block.) The receiver is then given a frame of (`width` / `binning`) x
+	/// (`height` / `binning`) samples; `nativeVideoCaptureFrameRoi()` reports where it lies within the full frame. A zero `width`
+	/// or `height` restores the full frame. The region is clamped to the frame and takes effect with the next frame delivered.
+	///
+	/// `binning` must be 1, 2 or 4. This is only available while capturing to a receiver.
+	///
+	/// Returns error string or nullptr
+	const char *nativeVideoCaptureSetRoi(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t binning);
+
+	/// Returns the region of the full frame covered by the frame being delivered (see `nativeVideoCaptureSetRoi()`)
+	///
+	/// This must only be called from within the `receiver` passed to `nativeVideoCaptureStart()`. The region is all zero if no
+	/// receiver is active.
+	NativeCaptureRoi nativeVideoCaptureFrameRoi();
+
 	/// Locks the circular image buffer so it can be read safely in a threaded environment.
 	///
 	/// If you plan to keep this image for long, be sure to make a copy so you don't hold the lock too long.
 	///
+	/// The capture buffer is a lock-free ring, so this never blocks the camera. Instead, the image returned by
+	/// `nativeVideoCaptureImageGet()` is held (and will not be overwritten) until `nativeVideoCaptureImageUnlock()`. New frames that
+	/// arrive while the ring is full are dropped and counted as skipped.
+	///
 	/// This method will do nothing if `receiver` is set when calling `nativeVideoCaptureStart()`
 	///
 	/// Be sure to call `nativeVideoCaptureImageUnlock()` when you're finished with it.
@@ -213,6 +468,28 @@ extern "C"
 	/// For the number of images in the circular image buffer, see `nativeVideoCaptureImageCount()`
 	int32_t nativeVideoCaptureImageCapacity();
 
+	/// Acquires the most recent captured frame that has not yet been acquired, lending the camera's buffer to the caller without a
+	/// copy. The image remains valid until it is released with `nativeVideoCaptureImageRelease()`.
+	///
+	/// The camera only has a few spare buffers, so release images promptly (copy the image if you need to keep it.) While a
+	/// frame goes unacquired, newer frames replace it.
+	///
+	/// This method will always return nullptr unless capture was started with `nativeVideoCaptureStartLending()`
+	///
+	/// Returns the image's luma samples (also stored in `image`) or nullptr if no new frame is available
+	NativeLumaBuffer nativeVideoCaptureImageAcquire(NativeCaptureImage *image);
+
+	/// Adds a reference to an image from `nativeVideoCaptureImageAcquire()`, so it can be shared
+	///
+	/// Each call requires a matching call to `nativeVideoCaptureImageRelease()`.
+	void nativeVideoCaptureImageRetain(const NativeCaptureImage *image);
+
+	/// Releases an image from `nativeVideoCaptureImageAcquire()` (or a reference from `nativeVideoCaptureImageRetain()`.) When
+	/// the last reference is released, the buffer is returned to the camera.
+	///
+	/// The image's `luma` and `handle` are cleared.
+	void nativeVideoCaptureImageRelease(NativeCaptureImage *image);
+
 #endif // defined(__linux__)
 
 #ifdef __cplusplus
@@ -13,6 +13,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdbool.h>
 
 /// Type used to represent an 8-bit Luma image sample
 typedef uint8_t LumaSample;
@@ -26,6 +27,120 @@ typedef uint32_t ColorSample;
 /// Type used to represent an 8-bit Luma image buffer
 typedef ColorSample * NativeColorBuffer;
 
+/// A minimum and maximum sample value (laid out as Seer's `MinMax<Sample>`; see `nativeRollMinMax()`)
+typedef struct
+{
+	int32_t min;
+	int32_t max;
+} NativeMinMax;
+
+/// A point in an image (laid out as Seer's `IVector`, which stores its components as `Int`; see `nativeSampleBitColumns()`)
+typedef struct
+{
+	int64_t x;
+	int64_t y;
+} NativePoint;
+
+/// An edge found along a line of samples (see `nativeDetectEdges()`)
+typedef struct
+{
+	/// The peak slope of the rolling sums at the edge (negative when entering a mark, positive when leaving one)
+	int32_t slope;
+
+	/// The offset of the edge within the samples
+	int32_t sampleOffset;
+
+	/// The threshold the slope met (or exceeded)
+	int32_t threshold;
+} NativeEdgePeak;
+
+/// A captured image lent directly from the camera's buffer pool (see `nativeVideoCaptureImageAcquire()`)
+typedef struct
+{
+	/// The image's luma samples, valid until the image is released
+	NativeLumaBuffer luma;
+
+	/// Image dimensions (the width is also the row stride)
+	uint32_t width;
+	uint32_t height;
+
+	/// Opaque handle to the lent camera buffer
+	void *handle;
+} NativeCaptureImage;
+
+/// A region of interest within the captured frame (see `nativeVideoCaptureSetRoi()`)
+typedef struct
+{
+	/// Top-left corner and dimensions of the region, in full-frame samples (a zero width or height denotes the full frame)
+	uint32_t x;
+	uint32_t y;
+	uint32_t width;
+	uint32_t height;
+
+	/// Each delivered sample is the average of a `binning` x `binning` block of the region (1, 2 or 4)
+	uint32_t binning;
+} NativeCaptureRoi;
+
+/// How captured frames are queued for delivery to a capture receiver (see `nativeVideoCaptureDispatchConfigure()`)
+typedef enum
+{
+	/// Only the most recent frame is kept; a new frame replaces any frame still waiting for delivery
+	NativeFrameDispatchPolicyLatest = 0,
+
+	/// Frames are delivered in order; a new frame is dropped if the queue is full
+	NativeFrameDispatchPolicyFifo = 1
+} NativeFrameDispatchPolicy;
+
+/// Statistics for the delivery of captured frames to a capture receiver (see `nativeVideoCaptureDispatchStats()`)
+typedef struct
+{
+	/// Frames currently waiting for delivery, and the most that have waited at once
+	uint32_t depth;
+	uint32_t maxDepth;
+
+	/// Frame counts: received from the camera, delivered to the receiver and dropped without delivery
+	uint32_t framesSubmitted;
+	uint32_t framesDelivered;
+	uint32_t framesDropped;
+
+	/// Time from the camera callback to the start of delivery, in microseconds
+	uint32_t lastLatencyMicroseconds;
+	uint32_t meanLatencyMicroseconds;
+	uint32_t maxLatencyMicroseconds;
+} NativeFrameDispatchStats;
+
+/// Statistics for a single frame of allocations from a frame arena (see `nativeFrameArenaReset()`)
+typedef struct
+{
+	/// Allocations made during the frame, and the heap allocations needed to serve them (those that overflowed the arena's block,
+	/// plus one if the block grew at the end of the frame.) Once the block has grown to fit, this is zero.
+	uint32_t allocations;
+	uint32_t heapAllocations;
+
+	/// Bytes allocated during the frame (including alignment), and the size of the arena's block after the frame
+	uint64_t bytesUsed;
+	uint64_t capacity;
+} NativeFrameArenaStats;
+
+/// A frame read from a luma archive (see `nativeLumaArchiveReaderFrame()`)
+typedef struct
+{
+	/// The frame's packed luma samples, valid until the archive is closed (or, for a compressed frame, until the next frame is
+	/// read)
+	///
+	/// These are mapped privately from the archive (or decoded into the reader), so they may be modified without changing the
+	/// file.
+	NativeLumaBuffer luma;
+
+	/// Frame dimensions
+	uint32_t width;
+	uint32_t height;
+
+	/// The frame's header data (as the user data of a `.luma` file), valid until the archive is closed
+	const void *header;
+	uint32_t headerSize;
+} NativeLumaArchiveFrame;
+
 /// This little ditty is to simplify the use of stringstream being passed into the logging methods. This allows us to do something
 /// similar to the following:
 ///
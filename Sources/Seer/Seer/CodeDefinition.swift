@@ -577,7 +577,172 @@ public final class CodeDefinition
 	/// We do this by reducing the set of MarkLocations into single points (their center) and seeing if those points fall within
 	/// the bounds of a MarkDefinition. If we get a full set of MarkDefinitions, then they are built into a DeckLocation and the
 	/// error is calculated. If we get multiple possible DeckLocations, the one with the least error is returned.
-	public func bestMatch(markLocations inMarkLocations: [MarkLocation]) -> DeckMatchResult?
+	///
+	/// Implementation details:
+	///
+	/// Every (start group, end group) pair of MarkLocations is a candidate, so this is called with a lot of them. Candidates are
+	/// evaluated by index into `inMarkLocations`, normalizing each mark as it is needed, exactly as a DeckLocation spanning the
+	/// candidate would normalize it. Only the best candidate is built into a DeckLocation.
+	///
+	/// The start and end groups alone give us a lower bound on a candidate's error: the squared deviations of the interior
+	/// landmarks can only add to it. A candidate whose bound is already beyond the limit (or no better than our best so far) is
+	/// dropped before we look for its interior landmarks. The deviations are summed in the same order either way, so this never
+	/// drops a candidate that would have been chosen.
+	///
+	/// The MarkLocations (and our working indices) are frame temporaries from the FrameArena; the DeckMatchResult is not.
+	public func bestMatch(markLocations inMarkLocations: UnsafeMutableArray<MarkLocation>) -> DeckMatchResult?
+	{
+		// The definition must always start and stop with a landmark MarkDefinition so it can be located
+		assert(!startLandmarks.isEmpty && !endLandmarks.isEmpty)
+
+		// For convenience
+		let startLandmarkCount = startLandmarks.count
+		let interiorLandmarkCount = interiorLandmarks.count
+		let endLandmarkCount = endLandmarks.count
+		let totalLandmarkCount = startLandmarkCount + interiorLandmarkCount + endLandmarkCount
+		let maxError = Config.searchMaxDeckMatchError
+
+		// Ensure we have enough marks
+		if inMarkLocations.count < totalLandmarkCount { return nil }
+
+		// The indices of the interior marks for the current candidate and for the best candidate so far
+		var interiorMarkIndices = FrameArena.instance.allocate(Int.self, capacity: interiorLandmarkCount)
+		interiorMarkIndices.initialize(to: 0, count: interiorLandmarkCount)
+		var bestInteriorMarkIndices = FrameArena.instance.allocate(Int.self, capacity: interiorLandmarkCount)
+		bestInteriorMarkIndices.initialize(to: 0, count: interiorLandmarkCount)
+		var bestStartGroupFirstIndex = -1
+		var bestEndGroupFirstIndex = -1
+		var bestSquaredDeviations: Real = 0
+		var bestError: Real = 0
+
+		// Start Landmark group range
+		for startGroupFirstIndex in 0...inMarkLocations.count - totalLandmarkCount
+		{
+			// The candidate's DeckLocation would be normalized from the start of its first mark
+			let origin = inMarkLocations[startGroupFirstIndex].start.point.toVector()
+
+			// End Landmark group range
+			for endGroupFirstIndex in startGroupFirstIndex + startLandmarkCount + interiorLandmarkCount...inMarkLocations.count - endLandmarkCount
+			{
+				// ...to the end of its last mark
+				let length = origin.distance(to: inMarkLocations[endGroupFirstIndex + endLandmarkCount - 1].end.point.toVector())
+
+				// Our lower bound: the squared deviations of the start and end landmarks (see `calcError()`)
+				var startSquaredDeviations: Real = 0
+				for i in 0..<startLandmarkCount
+				{
+					accumulateSquaredDeviations(&startSquaredDeviations, markLocation: inMarkLocations[startGroupFirstIndex + i], markDefinition: startLandmarks[i], origin: origin, length: length)
+				}
+
+				var boundSquaredDeviations = startSquaredDeviations
+				for i in 0..<endLandmarkCount
+				{
+					accumulateSquaredDeviations(&boundSquaredDeviations, markLocation: inMarkLocations[endGroupFirstIndex + i], markDefinition: endLandmarks[i], origin: origin, length: length)
+				}
+
+				// Can this candidate be our best?
+				if bestStartGroupFirstIndex >= 0 && boundSquaredDeviations >= bestSquaredDeviations { continue }
+				if calcError(squaredDeviations: boundSquaredDeviations) >= maxError { continue }
+
+				// The range of interior marks
+				let firstInteriorMarkIndex = startGroupFirstIndex + startLandmarkCount
+				let lastInteriorMarkIndex = endGroupFirstIndex - 1
+
+				// Find candidates for our interior landmarks, accumulating their squared deviations as we go
+				var candidateSquaredDeviations = startSquaredDeviations
+				var skipFlag = false
+				for landmarkIndex in 0..<interiorLandmarkCount
+				{
+					let interiorLandmarkDefinition = interiorLandmarks[landmarkIndex]
+					let markDefinitionCenter = interiorLandmarkDefinition.normalizedCenter
+					var bestMarkIndex = firstInteriorMarkIndex
+					var bestDistance: Real = 0
+
+					for interiorMarkIndex in firstInteriorMarkIndex...lastInteriorMarkIndex
+					{
+						let markLocation = inMarkLocations[interiorMarkIndex]
+						let markLocationStart = normalizedLocation(of: markLocation.start, origin: origin, length: length)
+						let markLocationEnd = normalizedLocation(of: markLocation.end, origin: origin, length: length)
+						let markLocationCenter = (markLocationStart + markLocationEnd) / 2
+						let distance = abs(markDefinitionCenter - markLocationCenter)
+						if interiorMarkIndex == firstInteriorMarkIndex || distance < bestDistance
+						{
+							bestMarkIndex = interiorMarkIndex
+							bestDistance = distance
+						}
+					}
+
+					// If our best is already taken, then our best isn't our best, so let's skip this grouping altogether
+					//
+					// Note that the start and end marks are outside of the interior range, so we only need to check the interior
+					for i in 0..<landmarkIndex where interiorMarkIndices[i] == bestMarkIndex
+					{
+						skipFlag = true
+						break
+					}
+					if skipFlag { break }
+
+					interiorMarkIndices[landmarkIndex] = bestMarkIndex
+					accumulateSquaredDeviations(&candidateSquaredDeviations, markLocation: inMarkLocations[bestMarkIndex], markDefinition: interiorLandmarkDefinition, origin: origin, length: length)
+				}
+
+				// Did we decide we needed to skip this group?
+				if skipFlag { continue }
+
+				for i in 0..<endLandmarkCount
+				{
+					accumulateSquaredDeviations(&candidateSquaredDeviations, markLocation: inMarkLocations[endGroupFirstIndex + i], markDefinition: endLandmarks[i], origin: origin, length: length)
+				}
+
+				// Limit our error
+				let error = calcError(squaredDeviations: candidateSquaredDeviations)
+				if error >= maxError { continue }
+
+				// If this is a better candidate, store it
+				if bestStartGroupFirstIndex < 0 || error < bestError
+				{
+					bestStartGroupFirstIndex = startGroupFirstIndex
+					bestEndGroupFirstIndex = endGroupFirstIndex
+					bestInteriorMarkIndices._rawPointer.assign(from: interiorMarkIndices._rawPointer, count: interiorLandmarkCount)
+					bestSquaredDeviations = candidateSquaredDeviations
+					bestError = error
+				}
+			}
+		}
+
+		if bestStartGroupFirstIndex < 0 { return nil }
+
+		// Build our best candidate deck, keeping track of the MarkDefinition that each MarkLocation was matched with
+		var candidateMarkLocations = [MarkLocation]()
+		candidateMarkLocations.reserveCapacity(totalLandmarkCount)
+		for i in 0..<startLandmarkCount
+		{
+			var markLocation = inMarkLocations[bestStartGroupFirstIndex + i]
+			markLocation.matchedDefinitionIndex = startLandmarks[i].index
+			candidateMarkLocations.append(markLocation)
+		}
+		for i in 0..<interiorLandmarkCount
+		{
+			var markLocation = inMarkLocations[bestInteriorMarkIndices[i]]
+			markLocation.matchedDefinitionIndex = interiorLandmarks[i].index
+			candidateMarkLocations.append(markLocation)
+		}
+		for i in 0..<endLandmarkCount
+		{
+			var markLocation = inMarkLocations[bestEndGroupFirstIndex + i]
+			markLocation.matchedDefinitionIndex = endLandmarks[i].index
+			candidateMarkLocations.append(markLocation)
+		}
+
+		return DeckMatchResult(deckLocation: DeckLocation(markLocations: candidateMarkLocations), error: bestError)
+	}
+
+	/// Returns the same DeckMatchResult as `bestMatch()`, by way of the original (exhaustive) matcher
+	///
+	/// This builds and normalizes a DeckLocation for every candidate and calculates its error from scratch (see `calcRMSD()`.) It
+	/// is far too slow to scan with, but it is the definition of a correct match: `bestMatch()` is verified against it on mark sets
+	/// recorded from real frames (see `MarkSetPlayback`.)
+	func referenceBestMatch(markLocations inMarkLocations: UnsafeMutableArray<MarkLocation>) -> DeckMatchResult?
 	{
 		// The definition must always start and stop with a landmark MarkDefinition so it can be located
 		assert(!startLandmarks.isEmpty && !endLandmarks.isEmpty)
@@ -605,7 +770,7 @@ public final class CodeDefinition
 			for endGroupFirstIndex in startGroupFirstIndex + startLandmarkCount + interiorLandmarkCount...inMarkLocations.count - endLandmarkCount
 			{
 				// Create a DeckLocation from our markLocations
-				let workingDeck = DeckLocation(markLocations: Array(inMarkLocations[startGroupFirstIndex...endGroupFirstIndex + endLandmarkCount - 1]))
+				let workingDeck = DeckLocation(markLocations: (startGroupFirstIndex...endGroupFirstIndex + endLandmarkCount - 1).map { inMarkLocations[$0] })
 				var markLocations = workingDeck.markLocations
 
 				// The range of interior marks
@@ -751,7 +916,29 @@ public final class CodeDefinition
 		return normalizedCenters
 	}
 
-	/// Calculates the error for a deck using Root Mean Standard Error method
+	/// Returns the normalized location of `edge` within a DeckLocation that starts at `origin` and is `length` long
+	///
+	/// This matches the `normalizedLocation` that `DeckLocation.normalize()` would calculate for the edge.
+	@inline(__always) private func normalizedLocation(of edge: Edge, origin: Vector, length: Real) -> Real
+	{
+		return edge.point.toVector().distance(to: origin) / length
+	}
+
+	/// Adds the squared deviations of a MarkLocation's start and end (from those of the MarkDefinition it is matched with) to
+	/// `squaredDeviations`
+	///
+	/// The MarkLocation is normalized to a DeckLocation that starts at `origin` and is `length` long.
+	@inline(__always) private func accumulateSquaredDeviations(_ squaredDeviations: inout Real, markLocation: MarkLocation, markDefinition: MarkDefinition, origin: Vector, length: Real)
+	{
+		// Error for the markLocation start/end positions
+		let startErr = normalizedLocation(of: markLocation.start, origin: origin, length: length) - markDefinition.normalizedStart
+		squaredDeviations += startErr * startErr
+
+		let endErr = normalizedLocation(of: markLocation.end, origin: origin, length: length) - markDefinition.normalizedEnd
+		squaredDeviations += endErr * endErr
+	}
+
+	/// Calculates the error for a deck using Root Mean Standard Error method (see `referenceBestMatch()`)
 	private func calcRMSD(deckLocation: DeckLocation) -> Real?
 	{
 		if deckLocation.markCount != totalLandmarkCount
@@ -780,11 +967,6 @@ public final class CodeDefinition
 			let endErr = markLocation.end.normalizedLocation - markDefinition.normalizedEnd
 			squaredDeviations += endErr * endErr
 			deviationCount += 1
-
-//			let markNormalizedWidth = markLocation.end.normalizedLocation - markLocation.start.normalizedLocation
-//			let widthErr = markNormalizedWidth - markDefinition.normalizedWidth
-//			squaredDeviations += widthErr * widthErr
-//			deviationCount += 1
 		}
 
 		let variance = squaredDeviations / Real(deviationCount)
@@ -799,6 +981,16 @@ public final class CodeDefinition
 		return error
 	}
 
+	/// Calculates the error for a deck using Root Mean Standard Error method, from the sum of the squared deviations of the start
+	/// and end of each of its landmarks (see `accumulateSquaredDeviations()`)
+	///
+	/// The squared deviations must be summed in landmark order.
+	private func calcError(squaredDeviations: Real) -> Real
+	{
+		let variance = squaredDeviations / Real(totalLandmarkCount * 2)
+		return Real(sqrt(Double(variance))) * kErrorScale
+	}
+
 	// -----------------------------------------------------------------------------------------------------------------------------
 	// Debug
 	// -----------------------------------------------------------------------------------------------------------------------------
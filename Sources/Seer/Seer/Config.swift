@@ -211,6 +211,51 @@ public struct Config
 			"description": "Log file masks (see `Logger` for details)"
 		],
 
+		// The number of recent frames kept in memory by the black box recorder (0 to disable)
+		"diagnostic.BlackBoxFrames":
+		[
+			"value": Int(30),
+			"public": false,
+			"type": ValueType.Integer.rawValue,
+			"description": "The number of recent frames kept in memory by the black box recorder (0 to disable.)\n\nRecording only copies each frame into a preallocated slot. When a trigger occurs (see `diagnostic.BlackBoxTriggers`), the recent frames are written to a luma archive in `diagnostic.LumaFilePath`."
+		],
+
+		// The black box recorder writes the frames from this many milliseconds leading up to a trigger
+		"diagnostic.BlackBoxWindowMS":
+		[
+			"value": Double(2000.0),
+			"public": false,
+			"type": ValueType.Time.rawValue,
+			"description": "The black box recorder writes the frames from this many milliseconds leading up to a trigger (limited to `diagnostic.BlackBoxFrames` frames.)"
+		],
+
+		// Crop the frames kept by the black box recorder to the area around a tracked deck
+		"diagnostic.BlackBoxCropToDeck":
+		[
+			"value": Bool(true),
+			"public": false,
+			"type": ValueType.Boolean.rawValue,
+			"description": "Crop the frames kept by the black box recorder to the area around a tracked deck, keeping full frames while no deck is tracked.\n\nCropping reduces the time spent copying frames and the size of the archives written."
+		],
+
+		// The events that cause the black box recorder to write its frames
+		"diagnostic.BlackBoxTriggers":
+		[
+			"value": "Incorrect",
+			"public": false,
+			"type": ValueType.String.rawValue,
+			"description": "The events that cause the black box recorder to write its frames, separated by spaces.\n\n`Incorrect` triggers when a result is validated as incorrect (see `debug.ValidateResults`.) Any analysis result (as reported to peers, e.g. `Inconslusive` or `NotEnoughHistory`) may also be listed."
+		],
+
+		// Losslessly compress the frames written to luma archives
+		"diagnostic.LumaArchiveCompression":
+		[
+			"value": Bool(true),
+			"public": false,
+			"type": ValueType.Boolean.rawValue,
+			"description": "Losslessly compress the frames written to luma archives (such as those written by the black box recorder.)\n\nFrames are compressed in the background as they are written, typically to less than half their size. Frames that would not get any smaller are stored uncompressed. Individual `.luma` files are never compressed."
+		],
+
 		// When writing diagnostic LUMA files, where to store them
 		"diagnostic.LumaFilePath":
 		[
@@ -472,6 +517,15 @@ public struct Config
 			"description": "Amount a trace mark is allowed to stray from center, allowing for imperfectly squared decks.\n\nThis value represents a ratio of the width of a mark. A value of 0.5 allows a stray of half the width of the mark. A value of 1.0 would allow the mark to stray its full width.\n\nNote that this value is dependent upon the width of the traced mark."
 		],
 
+		// The number of threads used to evaluate search lines in parallel
+		"search.ParallelThreads":
+		[
+			"value": Int(0),
+			"public": true,
+			"type": ValueType.Integer.rawValue,
+			"description": "The number of threads used to evaluate search lines in parallel. Use 0 for one thread per core, or 1 to search sequentially.\n\nSearch lines are evaluated in batches and considered in the same priority order as a sequential search, so the results are the same either way. Searches that draw to a debug buffer are always sequential."
+		],
+
 		// Temporal coherence tracks the deck in the frame. If our temporal state is older than this, it is
 		// considered to be expired.
 		"search.TemporalExpirationMS":
@@ -582,6 +636,16 @@ public struct Config
 			"description": "Denotes the relative intensity of a printed mark in order to be detected. Based on the min/max range of a column of printed marks, a value of 0.5 will use the center of the min/max range as the threshold. Smaller values (toward 0.0) will require more intense marks (Black under normal and IR light, bright under UV). Larger values (toward 1.0) will allow for less intense marks.\n\nA good starting point is 0.5."
 		],
 
+		// Where to store the error correction tables for each deck format, so they only need to be built once and can be shared
+		// by every process that decodes with them. If empty (or not writable), the tables are built in memory on each run.
+		"decode.ErrorCorrectionTablePath":
+		[
+			"value": "~/.cache/nettle-magic",
+			"public": false,
+			"type": ValueType.String.rawValue,
+			"description": "Where to store the error correction tables for each deck format, so they only need to be built once and can be shared by every process that decodes with them. If empty (or not writable), the tables are built in memory on each run."
+		],
+
 		// The Genocide challenge compares two non-overlapping instances of a card to decide if one card's
 		// instance should simply go away. This is effectively throwing away a card's instance, assuming it is simply wrong.
 		// This should be a high-confidence challenge. To that end, we don't simply compare the raw counts.
@@ -729,6 +793,105 @@ public struct Config
 			"description": "The camera's capture rate in frames per second"
 		],
 
+		// Crop captured frames to the area around a tracked deck
+		"capture.RoiEnable":
+		[
+			"value": Bool(false),
+			"public": true,
+			"type": ValueType.Boolean.rawValue,
+			"description": "Crop captured frames to the area around a tracked deck\n\nWhile a deck is being tracked, frames are cropped to a region around it before they are scanned, reducing memory traffic and search time. Capture widens back to the full frame when the deck's temporal state expires (see `search.TemporalExpirationMS`.)"
+		],
+
+		// Margin around a tracked deck when cropping captured frames
+		"capture.RoiMarginPercent":
+		[
+			"value": Int(50),
+			"public": true,
+			"type": ValueType.Integer.rawValue,
+			"description": "Margin around a tracked deck when cropping captured frames (see `capture.RoiEnable`), as a percentage of the deck's larger dimension.\n\nLarger margins allow the deck to move further between frames without being lost."
+		],
+
+		// Binning applied to cropped frames
+		"capture.RoiBinning":
+		[
+			"value": Int(1),
+			"public": true,
+			"type": ValueType.Integer.rawValue,
+			"description": "Binning applied to cropped frames (see `capture.RoiEnable`): 1, 2 or 4.\n\nEach scanned sample is the average of a block of this many samples in each dimension. This reduces the resolution available for scanning, so it is only useful when the deck is comfortably larger than the minimum scannable size."
+		],
+
+		// The source of captured frames
+		"capture.Backend":
+		[
+			"value": "",
+			"public": true,
+			"type": ValueType.String.rawValue,
+			"description": "The source of captured frames: `mmal` (the Raspberry Pi camera), `v4l2` (a Video4Linux2 device) or `replay` (frames replayed from `capture.Source` at the capture frame rate.)\n\nIf empty, the camera is used on the Raspberry Pi and the default V4L2 device is used elsewhere."
+		],
+
+		// The device or file path for the capture backend
+		"capture.Source":
+		[
+			"value": "",
+			"public": true,
+			"type": ValueType.String.rawValue,
+			"description": "The device or file path for the capture backend (see `capture.Backend`.)\n\nFor `v4l2`, this is the device path (default: /dev/video0.) For `replay`, this is a `.luma` file, a raw luma file, or a directory of them; if empty, synthetic frames are generated."
+		],
+
+		// Scan frames lent directly from the capture's buffers, rather than frames delivered to a receiver
+		"capture.LendBuffers":
+		[
+			"value": Bool(false),
+			"public": true,
+			"type": ValueType.Boolean.rawValue,
+			"description": "Scan frames lent directly from the capture's buffers, rather than frames delivered to a receiver.\n\nThe scanner takes the latest frame from the capture whenever it is ready for one, and returns the buffer once the next frame has been scanned. Frames are scanned in full, so `capture.RoiEnable` has no effect."
+		],
+
+		// How captured frames are queued for the scanner
+		"capture.DispatchPolicy":
+		[
+			"value": "latest",
+			"public": true,
+			"type": ValueType.String.rawValue,
+			"description": "How captured frames are queued for the scanner: `latest` or `fifo`.\n\nFrames are queued on their way to the scanner so that the camera never waits for a frame to be scanned. With `latest`, a new frame replaces one still waiting to be scanned. With `fifo`, up to `capture.DispatchQueueFrames` frames wait to be scanned in order and new frames are dropped while the queue is full.\n\nThis has no effect when `capture.LendBuffers` is set."
+		],
+
+		// The number of captured frames that may wait for the scanner with the `fifo` policy
+		"capture.DispatchQueueFrames":
+		[
+			"value": Int(2),
+			"public": true,
+			"type": ValueType.Integer.rawValue,
+			"description": "The number of captured frames that may wait to be scanned when `capture.DispatchPolicy` is `fifo` (minimum: 1.)\n\nEach waiting frame holds one of the camera's buffers."
+		],
+
+		// The number of threads used to decode video files (0 for one per CPU)
+		"capture.VideoDecodeThreads":
+		[
+			"value": Int(0),
+			"public": true,
+			"type": ValueType.Integer.rawValue,
+			"description": "The number of threads used to decode video files (0 for one per CPU.)\n\nFrames are decoded in parallel (frame threading), which adds a frame of latency per thread. See also `capture.VideoDecodeSliceThreads`."
+		],
+
+		// Allow video decoding to also split each frame across threads (slice threading)
+		"capture.VideoDecodeSliceThreads":
+		[
+			"value": Bool(true),
+			"public": true,
+			"type": ValueType.Boolean.rawValue,
+			"description": "Allow video decoding to also split each frame across threads (slice threading), for codecs and streams that support it.\n\nSee `capture.VideoDecodeThreads`."
+		],
+
+		// The number of video frames decoded ahead of the scanner
+		"capture.VideoDecodeReadAheadFrames":
+		[
+			"value": Int(3),
+			"public": true,
+			"type": ValueType.Integer.rawValue,
+			"description": "The number of video frames decoded ahead of the scanner (minimum: 1.)\n\nDecoding runs on its own thread, filling a pool of reusable frames while the previous frame is scanned."
+		],
+
 		// If this value is greater than zero, a video thumbnail will be sent to wifi clients every `ViewportFrequencyFrames`
 		// frames.
 		"capture.ViewportFrequencyFrames":
@@ -1221,6 +1384,11 @@ public struct Config
 	public static var logFileLocations: [PathString] { get { return _logFileLocations } set(x) { setPathArray("log.FileLocations", withValue: x); _logFileLocations = x } }
 	public static var logResetOnStart: Bool { get { return _logResetOnStart } set(x) { setBool("log.ResetOnStart", withValue: x); _logResetOnStart = x } }
 	public static var logMasks: [String: String] { get { return _logMasks } set(x) { setStringMap("log.Masks", withValue: x); _logMasks = x } }
+	public static var diagnosticBlackBoxFrames: Int { get { return _diagnosticBlackBoxFrames } set(x) { setInt("diagnostic.BlackBoxFrames", withValue: x); _diagnosticBlackBoxFrames = x } }
+	public static var diagnosticBlackBoxWindowMS: Time { get { return _diagnosticBlackBoxWindowMS } set(x) { setTime("diagnostic.BlackBoxWindowMS", withValue: x); _diagnosticBlackBoxWindowMS = x } }
+	public static var diagnosticBlackBoxCropToDeck: Bool { get { return _diagnosticBlackBoxCropToDeck } set(x) { setBool("diagnostic.BlackBoxCropToDeck", withValue: x); _diagnosticBlackBoxCropToDeck = x } }
+	public static var diagnosticBlackBoxTriggers: String { get { return _diagnosticBlackBoxTriggers } set(x) { setString("diagnostic.BlackBoxTriggers", withValue: x); _diagnosticBlackBoxTriggers = x } }
+	public static var diagnosticLumaArchiveCompression: Bool { get { return _diagnosticLumaArchiveCompression } set(x) { setBool("diagnostic.LumaArchiveCompression", withValue: x); _diagnosticLumaArchiveCompression = x } }
 	public static var diagnosticLumaFilePath: PathString { get { return _diagnosticLumaFilePath } set(x) { setPath("diagnostic.LumaFilePath", withValue: x); _diagnosticLumaFilePath = x } }
 	public static var systemReservedDiskSpaceMB: Int { get { return _systemReservedDiskSpaceMB } set(x) { setInt("system.ReservedDiskSpaceMB", withValue: x); _systemReservedDiskSpaceMB = x } }
 	public static var edgeMinimumThreshold: RollValue { get { return _edgeMinimumThreshold } set(x) { setRollValue("edge.MinimumThreshold", withValue: x); _edgeMinimumThreshold = x } }
@@ -1241,6 +1409,7 @@ public struct Config
 	public static var searchEdgeDetectionDeckEdgeSensitivity: FixedPoint { get { return _searchEdgeDetectionDeckEdgeSensitivity } set(x) { setFixed("search.EdgeDetectionDeckEdgeSensitivity", withValue: x); _searchEdgeDetectionDeckEdgeSensitivity = x } }
 	public static var searchTraceMarksEdgeSensitivity: FixedPoint { get { return _searchTraceMarksEdgeSensitivity } set(x) { setFixed("search.TraceMarksEdgeSensitivity", withValue: x); _searchTraceMarksEdgeSensitivity = x } }
 	public static var searchTraceMarksMaxStray: FixedPoint { get { return _searchTraceMarksMaxStray } set(x) { setFixed("search.TraceMarksMaxStray", withValue: x); _searchTraceMarksMaxStray = x } }
+	public static var searchParallelThreads: Int { get { return _searchParallelThreads } set(x) { setInt("search.ParallelThreads", withValue: x); _searchParallelThreads = x } }
 	public static var searchTemporalExpirationMS: Time { get { return _searchTemporalExpirationMS } set(x) { setTime("search.TemporalExpirationMS", withValue: x); _searchTemporalExpirationMS = x } }
 	public static var searchBaseMaxEdgeTraceMisses: Int { get { return _searchBaseMaxEdgeTraceMisses } set(x) { setInt("search.BaseMaxEdgeTraceMisses", withValue: x); _searchBaseMaxEdgeTraceMisses = x } }
 	public static var searchTraceMarkBackupDistance: Int { get { return _searchTraceMarkBackupDistance } set(x) { setInt("search.TraceMarkBackupDistance", withValue: x); _searchTraceMarkBackupDistance = x } }
@@ -1250,6 +1419,7 @@ public struct Config
 	public static var decodeMinimumSharpnessUnitScalarThreshold: FixedPoint { get { return _decodeMinimumSharpnessUnitScalarThreshold } set(x) { setFixed("decode.MinimumSharpnessUnitScalarThreshold", withValue: x); _decodeMinimumSharpnessUnitScalarThreshold = x } }
 	public static var decodeResampleBitColumnLengthMultiplier: FixedPoint { get { return _decodeResampleBitColumnLengthMultiplier } set(x) { setFixed("decode.ResampleBitColumnLengthMultiplier", withValue: x); _decodeResampleBitColumnLengthMultiplier = x } }
 	public static var decodeMarkLineAverageOffsetMultiplier: FixedPoint { get { return _decodeMarkLineAverageOffsetMultiplier } set(x) { setFixed("decode.MarkLineAverageOffsetMultiplier", withValue: x); _decodeMarkLineAverageOffsetMultiplier = x } }
+	public static var decodeErrorCorrectionTablePath: PathString { get { return _decodeErrorCorrectionTablePath } set(x) { setPath("decode.ErrorCorrectionTablePath", withValue: x); _decodeErrorCorrectionTablePath = x } }
 	public static var resolveGenocideScaleFactor: FixedPoint { get { return _resolveGenocideScaleFactor } set(x) { setFixed("resolve.GenocideScaleFactor", withValue: x); _resolveGenocideScaleFactor = x } }
 	public static var deckMinSamplesPerCard: Real { get { return _deckMinSamplesPerCard } set(x) { setReal("deck.MinSamplesPerCard", withValue: x); _deckMinSamplesPerCard = x } }
 	public static var analysisMissingCardPopularity: FixedPoint { get { return _analysisMissingCardPopularity } set(x) { setFixed("analysis.MissingCardPopularity", withValue: x); _analysisMissingCardPopularity = x } }
@@ -1261,6 +1431,17 @@ public struct Config
 	public static var captureFrameWidth: Int { get { return _captureFrameWidth } set(x) { setInt("capture.FrameWidth", withValue: x); _captureFrameWidth = x } }
 	public static var captureFrameHeight: Int { get { return _captureFrameHeight } set(x) { setInt("capture.FrameHeight", withValue: x); _captureFrameHeight = x } }
 	public static var captureFrameRateHz: Int { get { return _captureFrameRateHz } set(x) { setInt("capture.FrameRateHz", withValue: x); _captureFrameRateHz = x } }
+	public static var captureRoiEnable: Bool { get { return _captureRoiEnable } set(x) { setBool("capture.RoiEnable", withValue: x); _captureRoiEnable = x } }
+	public static var captureRoiMarginPercent: Int { get { return _captureRoiMarginPercent } set(x) { setInt("capture.RoiMarginPercent", withValue: x); _captureRoiMarginPercent = x } }
+	public static var captureRoiBinning: Int { get { return _captureRoiBinning } set(x) { setInt("capture.RoiBinning", withValue: x); _captureRoiBinning = x } }
+	public static var captureBackend: String { get { return _captureBackend } set(x) { setString("capture.Backend", withValue: x); _captureBackend = x } }
+	public static var captureSource: String { get { return _captureSource } set(x) { setString("capture.Source", withValue: x); _captureSource = x } }
+	public static var captureLendBuffers: Bool { get { return _captureLendBuffers } set(x) { setBool("capture.LendBuffers", withValue: x); _captureLendBuffers = x } }
+	public static var captureDispatchPolicy: String { get { return _captureDispatchPolicy } set(x) { setString("capture.DispatchPolicy", withValue: x); _captureDispatchPolicy = x } }
+	public static var captureDispatchQueueFrames: Int { get { return _captureDispatchQueueFrames } set(x) { setInt("capture.DispatchQueueFrames", withValue: x); _captureDispatchQueueFrames = x } }
+	public static var captureVideoDecodeThreads: Int { get { return _captureVideoDecodeThreads } set(x) { setInt("capture.VideoDecodeThreads", withValue: x); _captureVideoDecodeThreads = x } }
+	public static var captureVideoDecodeSliceThreads: Bool { get { return _captureVideoDecodeSliceThreads } set(x) { setBool("capture.VideoDecodeSliceThreads", withValue: x); _captureVideoDecodeSliceThreads = x } }
+	public static var captureVideoDecodeReadAheadFrames: Int { get { return _captureVideoDecodeReadAheadFrames } set(x) { setInt("capture.VideoDecodeReadAheadFrames", withValue: x); _captureVideoDecodeReadAheadFrames = x } }
 	public static var captureViewportFrequencyFrames: Int { get { return _captureViewportFrequencyFrames } set(x) { setInt("capture.ViewportFrequencyFrames", withValue: x); _captureViewportFrequencyFrames = x } }
 	public static var captureViewportType: ViewportMessage.ViewportType { get { return _captureViewportType } set(x) { setInt("capture.ViewportType", withValue: Int(x.rawValue)); _captureViewportType = x } }
 	public static var testbedDrawViewport: Bool { get { return _testbedDrawViewport } set(x) { setBool("testbed.DrawViewport", withValue: x); _testbedDrawViewport = x } }
@@ -1297,6 +1478,11 @@ public struct Config
 	private static var _logFileLocations: [PathString] = [PathString]()
 	private static var _logResetOnStart: Bool = false
 	private static var _logMasks: [String: String] = [:]
+	private static var _diagnosticBlackBoxFrames: Int = 0
+	private static var _diagnosticBlackBoxWindowMS: Time = 0
+	private static var _diagnosticBlackBoxCropToDeck: Bool = false
+	private static var _diagnosticBlackBoxTriggers: String = ""
+	private static var _diagnosticLumaArchiveCompression: Bool = false
 	private static var _diagnosticLumaFilePath: PathString = PathString()
 	private static var _systemReservedDiskSpaceMB: Int = 0
 	private static var _edgeMinimumThreshold: RollValue = 0
@@ -1317,6 +1503,7 @@ public struct Config
 	private static var _searchEdgeDetectionDeckEdgeSensitivity: FixedPoint = FixedPoint(0)
 	private static var _searchTraceMarksEdgeSensitivity: FixedPoint = FixedPoint(0)
 	private static var _searchTraceMarksMaxStray: FixedPoint = FixedPoint(0)
+	private static var _searchParallelThreads: Int = 0
 	private static var _searchTemporalExpirationMS: Time = 0
 	private static var _searchBaseMaxEdgeTraceMisses: Int = 0
 	private static var _searchTraceMarkBackupDistance: Int = 0
@@ -1326,6 +1513,7 @@ public struct Config
 	private static var _decodeMinimumSharpnessUnitScalarThreshold: FixedPoint = FixedPoint(0)
 	private static var _decodeResampleBitColumnLengthMultiplier: FixedPoint = FixedPoint(0)
 	private static var _decodeMarkLineAverageOffsetMultiplier: FixedPoint = FixedPoint(0)
+	private static var _decodeErrorCorrectionTablePath: PathString = PathString()
 	private static var _resolveGenocideScaleFactor: FixedPoint = FixedPoint(0)
 	private static var _deckMinSamplesPerCard: Real = 0
 	private static var _analysisMissingCardPopularity: FixedPoint = FixedPoint(0)
@@ -1337,6 +1525,17 @@ public struct Config
 	private static var _captureFrameWidth: Int = 0
 	private static var _captureFrameHeight: Int = 0
 	private static var _captureFrameRateHz: Int = 0
+	private static var _captureRoiEnable: Bool = false
+	private static var _captureRoiMarginPercent: Int = 0
+	private static var _captureRoiBinning: Int = 0
+	private static var _captureBackend: String = ""
+	private static var _captureSource: String = ""
+	private static var _captureLendBuffers: Bool = false
+	private static var _captureDispatchPolicy: String = ""
+	private static var _captureDispatchQueueFrames: Int = 0
+	private static var _captureVideoDecodeThreads: Int = 0
+	private static var _captureVideoDecodeSliceThreads: Bool = false
+	private static var _captureVideoDecodeReadAheadFrames: Int = 0
 	private static var _captureViewportFrequencyFrames: Int = 0
 	private static var _captureViewportType: ViewportMessage.ViewportType = .LumaResampledToViewportSize
 	private static var _testbedDrawViewport: Bool = false
@@ -1375,6 +1574,11 @@ public struct Config
 		_logFileLocations = getPathArray("log.FileLocations")
 		_logResetOnStart = getBool("log.ResetOnStart")
 		_logMasks = getStringMap("log.Masks")
+		_diagnosticBlackBoxFrames = getInt("diagnostic.BlackBoxFrames")
+		_diagnosticBlackBoxWindowMS = getTime("diagnostic.BlackBoxWindowMS")
+		_diagnosticBlackBoxCropToDeck = getBool("diagnostic.BlackBoxCropToDeck")
+		_diagnosticBlackBoxTriggers = getString("diagnostic.BlackBoxTriggers")
+		_diagnosticLumaArchiveCompression = getBool("diagnostic.LumaArchiveCompression")
 		_diagnosticLumaFilePath = getPath("diagnostic.LumaFilePath")
 		_systemReservedDiskSpaceMB = getInt("system.ReservedDiskSpaceMB")
 		_edgeMinimumThreshold = getRollValue("edge.MinimumThreshold")
@@ -1395,6 +1599,7 @@ public struct Config
 		_searchEdgeDetectionDeckEdgeSensitivity = getFixed("search.EdgeDetectionDeckEdgeSensitivity")
 		_searchTraceMarksEdgeSensitivity = getFixed("search.TraceMarksEdgeSensitivity")
 		_searchTraceMarksMaxStray = getFixed("search.TraceMarksMaxStray")
+		_searchParallelThreads = getInt("search.ParallelThreads")
 		_searchTemporalExpirationMS = getTime("search.TemporalExpirationMS")
 		_searchBaseMaxEdgeTraceMisses = getInt("search.BaseMaxEdgeTraceMisses")
 		_searchTraceMarkBackupDistance = getInt("search.TraceMarkBackupDistance")
@@ -1404,6 +1609,7 @@ public struct Config
 		_decodeMinimumSharpnessUnitScalarThreshold = getFixed("decode.MinimumSharpnessUnitScalarThreshold")
 		_decodeResampleBitColumnLengthMultiplier = getFixed("decode.ResampleBitColumnLengthMultiplier")
 		_decodeMarkLineAverageOffsetMultiplier = getFixed("decode.MarkLineAverageOffsetMultiplier")
+		_decodeErrorCorrectionTablePath = getPath("decode.ErrorCorrectionTablePath")
 		_resolveGenocideScaleFactor = getFixed("resolve.GenocideScaleFactor")
 		_deckMinSamplesPerCard = getReal("deck.MinSamplesPerCard")
 		_analysisMissingCardPopularity = getFixed("analysis.MissingCardPopularity")
@@ -1415,6 +1621,17 @@ public struct Config
 		_captureFrameWidth = getInt("capture.FrameWidth")
 		_captureFrameHeight = getInt("capture.FrameHeight")
 		_captureFrameRateHz = getInt("capture.FrameRateHz")
+		_captureRoiEnable = getBool("capture.RoiEnable")
+		_captureRoiMarginPercent = getInt("capture.RoiMarginPercent")
+		_captureRoiBinning = getInt("capture.RoiBinning")
+		_captureBackend = getString("capture.Backend")
+		_captureSource = getString("capture.Source")
+		_captureLendBuffers = getBool("capture.LendBuffers")
+		_captureDispatchPolicy = getString("capture.DispatchPolicy")
+		_captureDispatchQueueFrames = getInt("capture.DispatchQueueFrames")
+		_captureVideoDecodeThreads = getInt("capture.VideoDecodeThreads")
+		_captureVideoDecodeSliceThreads = getBool("capture.VideoDecodeSliceThreads")
+		_captureVideoDecodeReadAheadFrames = getInt("capture.VideoDecodeReadAheadFrames")
 		_captureViewportFrequencyFrames = getInt("capture.ViewportFrequencyFrames")
 		_captureViewportType = ViewportMessage.ViewportType.fromUInt8(UInt8(getInt("capture.ViewportType")))
 		_testbedDrawViewport = getBool("testbed.DrawViewport")
@@ -88,6 +88,20 @@ public final class Deck
 		self.resolvedRobustness = deck.resolvedRobustness
 	}
 
+	/// Replaces the results in this deck with those of another Deck (of the same format), reusing this deck's storage
+	///
+	/// This is the reusable form of `init(deckForResults:)`. The contents are copied, rather than shared with the source deck, so
+	/// that neither deck needs new storage the next time it is updated.
+	func assign(resultsFrom deck: Deck)
+	{
+		assert(format.name == deck.format.name)
+
+		resolvedIndices.removeAll(keepingCapacity: true)
+		resolvedIndices.append(contentsOf: deck.resolvedIndices)
+		resolvedRobustness.removeAll(keepingCapacity: true)
+		resolvedRobustness.append(contentsOf: deck.resolvedRobustness)
+	}
+
 	// -----------------------------------------------------------------------------------------------------------------------------
 	// Deck resolution
 	// -----------------------------------------------------------------------------------------------------------------------------
@@ -291,8 +305,11 @@ public final class Deck
 		}
 
 		// Update our resolved indices
+		//
+		// These are copied into our own storage (rather than sharing the history's) so that it can be reused (see `Decoder`)
 		assert(indices.max()! <= UInt8(format.maxCardCountWithReversed))
-		resolvedIndices = indices
+		resolvedIndices.removeAll(keepingCapacity: true)
+		resolvedIndices.append(contentsOf: indices)
 
 		if History.instance.calcTotalHistorySize() < Config.analysisMinHistoryEntries
 		{
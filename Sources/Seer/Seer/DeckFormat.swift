@@ -13,8 +13,10 @@
 import Foundation
 #if os(iOS)
 import MinionIOS
+import NativeTasksIOS
 #else
 import Minion
+import NativeTasks
 #endif
 
 /// Defines a protocol for classes to manage the specifics that link a given deck to the underlying CodeDefinition for the deck
@@ -179,13 +181,14 @@ public class DeckFormat
 	/// Stores the mapping of a Face Code (key) to Card Index (value)
 	private(set) public var mapFaceCodeToIndex: [String: Int]
 
-	/// Stores the mapping of (potentially invalid) Raw Card Codes to error-corrected Card Codes using a maximum Hamming Distance
-	/// calculated by `HammingDistance.calcErrorCorrectedMaps`.
-	private(set) public var mapCodeToErrorCorrectedCode = [Int]()
-
 	/// Stores the mapping of (potentially invalid) Raw Card Codes to Card Indices using error correction on the input Raw Card
-	/// Code using a maximum Hamming Distance calculated by `HammingDistance.calcErrorCorrectedMaps`.
-	private(set) public var mapCodeToErrorCorrectedIndex = [Int]()
+	/// Code, by minimum Hamming Distance. Codes without a single nearest card are `HammingDistance.CardState.Unassigned`.
+	///
+	/// The error-corrected Card Code for a Raw Card Code is simply `mapIndexToCode` of its Card Index.
+	///
+	/// The table is mapped read-only from the error correction tables stored in `Config.decodeErrorCorrectionTablePath` (built
+	/// there on first use) and shared by every process using this format. See `prepareForDecode()`.
+	private(set) public var mapCodeToErrorCorrectedIndex = UnsafeBufferPointer<Int16>(start: nil, count: 0)
 
 	/// Our mark definitions, as read in via JSON
 	private var jsonMarkDefinitions = [MarkDefinitionJson]()
@@ -366,23 +369,42 @@ public class DeckFormat
 		if !fastLoad && !prepareForDecode() { return nil }
 	}
 
+	/// Cleanup the error correction table
+	deinit
+	{
+		nativeErrorCorrectionTableClose(mapCodeToErrorCorrectedIndex.baseAddress)
+	}
+
 	// -----------------------------------------------------------------------------------------------------------------------------
 	// General implementation
 	// -----------------------------------------------------------------------------------------------------------------------------
 
 	/// Prepares a DeckFormat for decoding.
 	///
-	/// This calculates the error correction maps and caches them in memory. It is safe to call this before each attempt to decode a deck using this DeckFormat.
+	/// This maps the error correction table (building it on first use) and caches it in memory. It is safe to call this before each attempt to decode a deck using this DeckFormat.
 	public func prepareForDecode() -> Bool
 	{
-		// If we've already calculated our error correction maps, don't do it again
-		if mapCodeToErrorCorrectedCode.count != 0 && mapCodeToErrorCorrectedIndex.count != 0
+		// If we've already mapped our error correction table, don't do it again
+		if mapCodeToErrorCorrectedIndex.count != 0
 		{
 			return true
 		}
 
-		// Calculate our error correction maps
-		(mapCodeToErrorCorrectedCode, mapCodeToErrorCorrectedIndex) = HammingDistance.calcErrorCorrectedMaps(formatName: name, bitCount: cardCodeBitCount, mapIndexToCode: mapIndexToCode)
+		// Map our error correction table
+		let tablePath = Config.decodeErrorCorrectionTablePath.isEmpty ? "" : Config.decodeErrorCorrectionTablePath.toAbsolutePath().toString()
+		let codes = mapIndexToCode.map { Int64($0) }
+		guard let table = nativeErrorCorrectionTableOpen(tablePath, codes, UInt32(codes.count), UInt32(cardCodeBitCount)) else
+		{
+			gLogger.error("\(name): Unable to build the error correction table for \(codes.count) codes of \(cardCodeBitCount) bits")
+			return false
+		}
+		mapCodeToErrorCorrectedIndex = UnsafeBufferPointer<Int16>(start: table, count: 1 << cardCodeBitCount)
+
+		// Ensure we have all actual codes in the map
+		for i in 0..<mapIndexToCode.count
+		{
+			assert(Int(mapCodeToErrorCorrectedIndex[mapIndexToCode[i]]) == i)
+		}
 
 		// Verify reversible/palindrome codes have marks that are also palindromes
 		let palendromeLayout = isPalendromeLayout(markDefinitions: jsonMarkDefinitions)
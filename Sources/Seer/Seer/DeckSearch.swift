@@ -38,6 +38,9 @@ public final class DeckSearch
 		/// Angle of the search line where the previous deck was found
 		public let angleDegrees: Real
 
+		/// Size of the bounding box of the previous deck (zero if unknown)
+		public let extents: IVector
+
 		/// Compiler bug: Inserting this entry into the struct avoids a compiler crash in the 3.0.2 compiler (Apple)
 		public let __COMPILER_FIX__: String = ""
 
@@ -49,17 +52,39 @@ public final class DeckSearch
 		{
 			self.offset = IVector()
 			self.angleDegrees = 0
+			self.extents = IVector()
 			self.validTimeMS = 0
 		}
 
 		/// Initialize a temporal state from the essentials
-		public init(offset: IVector, angleDegrees: Real)
+		public init(offset: IVector, angleDegrees: Real, extents: IVector = IVector())
 		{
 			self.offset = offset
 			self.angleDegrees = angleDegrees
+			self.extents = extents
 			self.validTimeMS = PausableTime.getTimeMS()
 		}
 
+		/// Initialize a temporal state that was valid at `validTimeMS`
+		private init(offset: IVector, angleDegrees: Real, extents: IVector, validTimeMS: Time)
+		{
+			self.offset = offset
+			self.angleDegrees = angleDegrees
+			self.extents = extents
+			self.validTimeMS = validTimeMS
+		}
+
+		/// Returns this temporal state moved from the coordinates of one scanned image to those of another
+		///
+		/// `fromOrigin` and `toOrigin` are the centers of the two images, which cover the regions `from` and `to` of the full
+		/// frame. The time at which the state was valid is unchanged.
+		fileprivate func translated(from: FrameRegion, fromOrigin: IVector, to: FrameRegion, toOrigin: IVector) -> TemporalState
+		{
+			let center = to.fromFullFrame(from.toFullFrame(fromOrigin + offset))
+			let extents = self.extents * from.binning / to.binning
+			return TemporalState(offset: center - toOrigin, angleDegrees: angleDegrees, extents: extents, validTimeMS: validTimeMS)
+		}
+
 		/// Temporal states are only good for a period of time (hence the use of the term temporal)
 		public func hasExpired() -> Bool
 		{
@@ -67,6 +92,61 @@ public final class DeckSearch
 		}
 	}
 
+	/// The region of the full camera frame covered by a scanned image
+	///
+	/// Capture may crop frames to the area around a tracked deck (see `trackedDeckBounds`), and may bin them to a lower
+	/// resolution. A point in the scanned image maps to `origin + point * binning` in the full frame.
+	public struct FrameRegion: Equatable
+	{
+		/// Position of the scanned image's top-left corner within the full frame
+		public let origin: IVector
+
+		/// The number of full-frame samples (in each dimension) averaged into each sample of the scanned image
+		public let binning: Int
+
+		/// Initialize a region covering the full frame
+		public init()
+		{
+			self.origin = IVector()
+			self.binning = 1
+		}
+
+		/// Initialize a region from the essentials
+		public init(origin: IVector, binning: Int)
+		{
+			self.origin = origin
+			self.binning = max(binning, 1)
+		}
+
+		/// Returns the full-frame position of `point` in the scanned image
+		public func toFullFrame(_ point: IVector) -> IVector
+		{
+			return origin + point * binning
+		}
+
+		/// Returns the position in the scanned image of full-frame position `point`
+		public func fromFullFrame(_ point: IVector) -> IVector
+		{
+			return (point - origin) / binning
+		}
+
+		/// Regions are equal if they map points to the full frame identically
+		public static func == (left: FrameRegion, right: FrameRegion) -> Bool
+		{
+			return left.origin == right.origin && left.binning == right.binning
+		}
+	}
+
+	/// A single trace of a LandMark from `center` toward the top or bottom of the deck (see `traceMarks`)
+	private struct MarkTrace
+	{
+		let scanVector: IVector
+		let markWidth: Int
+		let markWidthExtension: Int
+		let center: IVector
+		let towardTop: Bool
+	}
+
 	// -----------------------------------------------------------------------------------------------------------------------------
 	// Constants
 	// -----------------------------------------------------------------------------------------------------------------------------
@@ -75,6 +155,12 @@ public final class DeckSearch
 	/// displayed in sequence
 	private let kSequentialGridLinesRateMS: Int = 20
 
+	/// When searching in parallel, the number of search lines evaluated by each worker per batch
+	///
+	/// Lines are evaluated a batch at a time, so lines beyond the first successful one are evaluated needlessly. Smaller batches
+	/// waste less work; larger batches spend less time waiting on the slowest worker.
+	private let kParallelSearchLinesPerWorker: Int = 2
+
 	// -----------------------------------------------------------------------------------------------------------------------------
 	// Properties
 	// -----------------------------------------------------------------------------------------------------------------------------
@@ -82,6 +168,23 @@ public final class DeckSearch
 	/// Our current temporal state, useful for tracking the deck through the video
 	private var temporalState = TemporalState()
 
+	/// The region of the full frame covered by the image in which the temporal state was found, and that image's center
+	private var temporalRegion = FrameRegion()
+	private var temporalOrigin = IVector()
+
+	/// The bounds of the tracked deck within the full frame, or nil if no deck is being tracked
+	///
+	/// This reflects the most recent scan and becomes nil once the temporal state expires. Capture uses this to crop frames to
+	/// the area around the deck, widening back to the full frame when tracking is lost.
+	public var trackedDeckBounds: Rect<Int>?
+	{
+		if temporalState.hasExpired() || temporalState.extents == 0 { return nil }
+
+		let center = temporalRegion.toFullFrame(temporalOrigin + temporalState.offset)
+		let size = temporalState.extents * temporalRegion.binning
+		return Rect<Int>(x: center.x - size.x / 2, y: center.y - size.y / 2, width: size.x, height: size.y)
+	}
+
 	/// The pre-calculated search lines used to scan the image. These search lines will be relative the center
 	/// of the screen, plus any TemporalState values
 	private var markLines: MarkLines
@@ -90,12 +193,26 @@ public final class DeckSearch
 	/// of the screen, plus any TemporalState values
 	private var searchLines: SearchLines
 
-	/// We'll re-use this sample line while tracing marks
-	private var traceMarksSampleLine = SampleLine()
+	/// We'll re-use these sample lines while tracing marks (one for each of the traces in `traceMarks`)
+	private var traceMarksSampleLines = [SampleLine(), SampleLine(), SampleLine(), SampleLine()]
+
+	/// When tracing marks in parallel, each trace stores its marks here before they are merged into the center marks
+	///
+	/// Note that each of these has its own storage, so they can't be created with `Array(repeating:count:)`
+	private var traceOutputs = (0..<4).map { _ in UnsafeBidirectionalArray<IVector>(withCapacity: Deck.kMaxSampleHeight) }
 
 	/// We use a static EdgeDetection to avoid having to allocate a new one for each search line
 	private let edgeDetector = EdgeDetection(predictedSize: 2048)
 
+	/// When searching in parallel, each worker uses its own EdgeDetection (see `evaluateSearchLines`)
+	///
+	/// These are not sequenced, as the workers run concurrently (see `EdgeDetection.sequenced`)
+	private var workerEdgeDetectors = [EdgeDetection]()
+
+	/// When searching in parallel, the results of the current batch of search lines (indexed from `batchStart`)
+	private var batchMatches = [DeckMatchResult?]()
+	private var batchStart = 0
+
 	/// Left side center marks
 	///
 	/// Note that values toward the top of the deck are pushed FRONT and values toward the bottom of the deck are pushed BACK
@@ -128,6 +245,11 @@ public final class DeckSearch
 	{
 		lCenterMarks.free()
 		rCenterMarks.free()
+
+		for i in 0..<traceOutputs.count
+		{
+			traceOutputs[i].free()
+		}
 	}
 
 	// -----------------------------------------------------------------------------------------------------------------------------
@@ -138,7 +260,8 @@ public final class DeckSearch
 	///
 	/// - Parameter lumaBuffer: Buffer of luminance sample values to scan
 	/// - Parameter debugBuffer: Buffer used to draw debug information
-	public func scanImage(debugBuffer inDebugBuffer: DebugBuffer?, lumaBuffer inLumaBuffer: LumaBuffer, codeDefinition: CodeDefinition) -> SearchResult
+	/// - Parameter frameRegion: The region of the full frame covered by `lumaBuffer`
+	public func scanImage(debugBuffer inDebugBuffer: DebugBuffer?, lumaBuffer inLumaBuffer: LumaBuffer, codeDefinition: CodeDefinition, frameRegion: FrameRegion = FrameRegion()) -> SearchResult
 	{
 		// Do we need to update the search lines?
 		if searchLines.isOutdated(size: IVector(x: inLumaBuffer.width, y: inLumaBuffer.height), reversible: codeDefinition.format.reversible)
@@ -155,6 +278,8 @@ public final class DeckSearch
 			debugDrawSequentialSearchLineOrder(image: debugBuffer)
 		}
 
+		let origin = lumaBuffer.rect.center.chopToPoint()
+
 		// If we are replaying a temporal state, override the temporal state with the replay state
 		if Config.isReplayingFrame
 		{
@@ -168,7 +293,14 @@ public final class DeckSearch
 			{
 				resetTemporalState()
 			}
+			// If this image covers a different region of the frame, move the temporal state into this image's coordinates
+			else if frameRegion != temporalRegion || origin != temporalOrigin
+			{
+				temporalState = temporalState.translated(from: temporalRegion, fromOrigin: temporalOrigin, to: frameRegion, toOrigin: origin)
+			}
 
+			temporalRegion = frameRegion
+			temporalOrigin = origin
 			Config.replayTemporalState = temporalState
 		}
 
@@ -176,8 +308,6 @@ public final class DeckSearch
 		let temporalOffset = temporalState.offset
 		let temporalAngle = temporalState.angleDegrees
 
-		let origin = lumaBuffer.rect.center.chopToPoint()
-
 		if Config.debugDrawFullSearchGrid
 		{
 			debugDrawFullSearchGrid(image: debugBuffer, origin: origin, offsetLocation: temporalOffset, offsetAngleDegrees: temporalAngle)
@@ -186,24 +316,42 @@ public final class DeckSearch
 		let edgeDetectionWindowSize = Int(codeDefinition.narrowestLandmarkNormalizedWidth() * codeDefinition.calcMinSampleWidth())
 		let edgeDetectionminMaxWindowSize = Int(Config.searchEdgeDetectionDeckRollingMinMaxWindowMultiplier * Real(edgeDetectionWindowSize))
 
+		// Debug drawing isn't thread-safe, so we only search in parallel without a debug buffer
+		let workerCount = debugBuffer == nil ? searchWorkerCount() : 1
+		batchMatches.removeAll(keepingCapacity: true)
+		batchStart = 0
+
 		for i in 0..<searchLines.count
 		{
 			//
 			// Scan for the deck
 			//
 
-			// Get a search line
-			guard let searchLine = searchLines[i].getLine(origin: origin, offsetLocation: temporalOffset, offsetAngleDegrees: temporalAngle, bufferRect: lumaBuffer.rect) else
+			var lineMatch: DeckMatchResult?
+			if workerCount > 1
 			{
-				continue
-			}
+				// Evaluate the next batch of search lines when we reach it
+				if i >= batchStart + batchMatches.count
+				{
+					evaluateSearchLines(start: i, count: min(workerCount * kParallelSearchLinesPerWorker, searchLines.count - i), workerCount: workerCount, codeDefinition: codeDefinition, origin: origin, temporalOffset: temporalOffset, temporalAngle: temporalAngle, windowSize: edgeDetectionWindowSize, minMaxWindowSize: edgeDetectionminMaxWindowSize)
+				}
 
-			// Scan the search line for a deck's landmarks
-			guard let match = matchSearchLine(codeDefinition: codeDefinition, sampleLine: searchLine, imageHeight: lumaBuffer.height, windowSize: edgeDetectionWindowSize, minMaxWindowSize: edgeDetectionminMaxWindowSize) else
+				lineMatch = batchMatches[i - batchStart]
+			}
+			else
 			{
-				continue
+				// Get a search line
+				guard let searchLine = searchLines[i].getLine(origin: origin, offsetLocation: temporalOffset, offsetAngleDegrees: temporalAngle, bufferRect: lumaBuffer.rect) else
+				{
+					continue
+				}
+
+				// Scan the search line for a deck's landmarks
+				lineMatch = matchSearchLine(codeDefinition: codeDefinition, sampleLine: searchLine, imageHeight: lumaBuffer.height, windowSize: edgeDetectionWindowSize, minMaxWindowSize: edgeDetectionminMaxWindowSize, edgeDetector: edgeDetector)
 			}
 
+			guard let match = lineMatch else { continue }
+
 			// Log some match info
 			if Config.debugDrawDeckMatchResults
 			{
@@ -225,7 +373,10 @@ public final class DeckSearch
 			if !Config.isReplayingFrame
 			{
 				let angleDegrees = matchLineNormal.angleDegrees(to: Vector(x: 1, y: 0))
-				temporalState = TemporalState(offset: matchLine.center - origin, angleDegrees: angleDegrees)
+
+				// We only know the deck's width, so assume it may be as tall as it is wide
+				let width = matchLineVector.length.floor()
+				temporalState = TemporalState(offset: matchLine.center - origin, angleDegrees: angleDegrees, extents: IVector(x: width, y: width))
 			}
 
 			//
@@ -279,7 +430,9 @@ public final class DeckSearch
 			{
 				let deckCenter = (deckCenterLeft + deckCenterRight) / 2
 				let angleDegrees = centerVector.angleDegrees(to: Vector(x: 1, y: 0))
-				temporalState = TemporalState(offset: deckCenter - origin, angleDegrees: angleDegrees)
+				let bounds = Rect<Int>(minX: min(lTop.x, lBot.x, rTop.x, rBot.x), minY: min(lTop.y, lBot.y, rTop.y, rBot.y),
+				                       maxX: max(lTop.x, lBot.x, rTop.x, rBot.x), maxY: max(lTop.y, lBot.y, rTop.y, rBot.y))
+				temporalState = TemporalState(offset: deckCenter - origin, angleDegrees: angleDegrees, extents: IVector(x: bounds.width, y: bounds.height))
 			}
 
 			//
@@ -322,7 +475,7 @@ public final class DeckSearch
 	/// Scan the samples along a given line and return a DeckMatchResult if a valid deck was found.
 	///
 	/// Note that the `windowSize` parameter is used for edge detection rolling averages
-	private func matchSearchLine(codeDefinition: CodeDefinition, sampleLine: SampleLine, imageHeight: Int, windowSize: Int, minMaxWindowSize: Int) -> DeckMatchResult?
+	private func matchSearchLine(codeDefinition: CodeDefinition, sampleLine: SampleLine, imageHeight: Int, windowSize: Int, minMaxWindowSize: Int, edgeDetector: EdgeDetection) -> DeckMatchResult?
 	{
 		// Draw the search line so we can track where we've been
 		if Config.debugDrawSearchedLines
@@ -347,16 +500,72 @@ public final class DeckSearch
 
 		if Config.debugDrawAllMarks
 		{
-			for markLocation in markLocations
+			for i in 0..<markLocations.count
 			{
-				markLocation.debugDrawOverlay(image: debugBuffer, color: kDebugUnusedMarkLocationLineColor)
+				markLocations[i].debugDrawOverlay(image: debugBuffer, color: kDebugUnusedMarkLocationLineColor)
 			}
 		}
 
+		// Keep the marks for replaying the match outside of the scan, if we're recording them
+		MarkSetRecorder.active?.record(markLocations)
+
 		// Try to match in each direction
 		return codeDefinition.bestMatch(markLocations: markLocations)
 	}
 
+	/// Evaluates `count` search lines starting at `start` across `workerCount` workers, storing the results in `batchMatches`
+	///
+	/// Each worker evaluates every `workerCount`th line of the batch with its own EdgeDetection. The results are stored in search
+	/// line order, so the caller can consider them in the same priority order as a sequential search.
+	///
+	/// Each worker's busy time is tracked in the PerfTimer as "Search Worker N", and the time for the batch as "Search Lines".
+	/// Together, these provide the utilization of each core (see `PerfTimer.generatePerfStatsText`.)
+	private func evaluateSearchLines(start: Int, count: Int, workerCount: Int, codeDefinition: CodeDefinition, origin: IVector, temporalOffset: IVector, temporalAngle: Real, windowSize: Int, minMaxWindowSize: Int)
+	{
+		let batchStartTime = PerfTimer.trackBegin()
+
+		while workerEdgeDetectors.count < workerCount
+		{
+			workerEdgeDetectors.append(EdgeDetection(predictedSize: 2048, sequenced: false))
+		}
+
+		batchStart = start
+		batchMatches.removeAll(keepingCapacity: true)
+		batchMatches.append(contentsOf: repeatElement(nil, count: count))
+
+		let lumaBuffer = self.lumaBuffer
+		let edgeDetectors = workerEdgeDetectors
+		batchMatches.withUnsafeMutableBufferPointer
+		{ buffer in
+			let results = buffer
+			DispatchQueue.concurrentPerform(iterations: workerCount)
+			{ worker in
+				let workerStartTime = PerfTimer.trackBegin()
+
+				for index in stride(from: worker, to: count, by: workerCount)
+				{
+					guard let searchLine = searchLines[start + index].getLine(origin: origin, offsetLocation: temporalOffset, offsetAngleDegrees: temporalAngle, bufferRect: lumaBuffer.rect) else
+					{
+						continue
+					}
+
+					results[index] = matchSearchLine(codeDefinition: codeDefinition, sampleLine: searchLine, imageHeight: lumaBuffer.height, windowSize: windowSize, minMaxWindowSize: minMaxWindowSize, edgeDetector: edgeDetectors[worker])
+				}
+
+				PerfTimer.trackEnd(name: "Search Worker \(worker)", start: workerStartTime)
+			}
+		}
+
+		PerfTimer.trackEnd(name: "Search Lines", start: batchStartTime)
+	}
+
+	/// Returns the number of workers used to evaluate search lines (see `Config.searchParallelThreads`)
+	private func searchWorkerCount() -> Int
+	{
+		let threads = Config.searchParallelThreads
+		return threads > 0 ? threads : ProcessInfo.processInfo.activeProcessorCount
+	}
+
 	/// Scan a range of samples in the given sampleLine and return an optional set of MarkLocations if any are found.
 	///
 	/// Implementation details:
@@ -373,17 +582,20 @@ public final class DeckSearch
 	/// with:
 	///
 	///     max(rolling_average_window_size, rolling_min_max_len) / 2
-	private func findMarks(edges: [Edge]) -> [MarkLocation]?
+	///
+	/// The MarkLocations are allocated from the FrameArena, so they are only valid until the end of the frame.
+	private func findMarks(edges: UnsafeMutableArray<Edge>) -> UnsafeMutableArray<MarkLocation>?
 	{
 		// No edges found, stop here
 		if edges.isEmpty { return nil }
 
-		// Scan the sample edges to build a set of MarkLocations
-		var markLocations = [MarkLocation]()
-		markLocations.reserveCapacity(edges.count)
+		// Scan the sample edges to build a set of MarkLocations (each takes two edges)
+		var markLocations = FrameArena.instance.allocate(MarkLocation.self, capacity: edges.count / 2)
 		var startEdge: Edge?
-		for edge in edges
+		for i in 0..<edges.count
 		{
+			let edge = edges[i]
+
 			// Start a mark if the slope dropped below our threshold (it is dark; the start of a mark)
 			if edge.slope < 0
 			{
@@ -393,7 +605,7 @@ public final class DeckSearch
 			else if startEdge != nil && edge.slope > 0
 			{
 				// Store the new mark location
-				markLocations.append(MarkLocation(start: startEdge!, end: edge, scanIndex: markLocations.count))
+				markLocations.add(MarkLocation(start: startEdge!, end: edge, scanIndex: markLocations.count))
 
 				// Reset the current start
 				startEdge = nil
@@ -455,12 +667,6 @@ public final class DeckSearch
 		// Coarse trace (every other sample)
 		var step = 2
 
-		//
-		// Initial (coarse) trace of the left-side marks
-		//
-		lCenterMarks.removeAll()
-		lCenterMarks.pushFront(lMarkLoc.center)
-
 		// When tracing edges to find the deck extents, we'll allow a few misses to ensure that we are able to capture the
 		// full deck extent.
 		//
@@ -469,30 +675,29 @@ public final class DeckSearch
 
 		let invertSampleLuma = codeDefinition.format.invertLuma
 
-		traceMark(scanVector: scanVector, invertSampleLuma: invertSampleLuma, markWidth: lMarkLoc.sampleCount, markWidthExtension: lMarkExtension, center: lMarkLoc.center, step: step, towardTop: true, centerMarks: &lCenterMarks, maxEdgeTraceMisses: maxEdgeTraceMisses)
-		traceMark(scanVector: scanVector, invertSampleLuma: invertSampleLuma, markWidth: lMarkLoc.sampleCount, markWidthExtension: lMarkExtension, center: lMarkLoc.center, step: step, towardTop: false, centerMarks: &lCenterMarks, maxEdgeTraceMisses: maxEdgeTraceMisses)
-
-		// Grab the first pass extents
-		guard let lTopAlignCenter = lCenterMarks.front else { return false }
-		guard let lBotAlignCenter = lCenterMarks.back else { return false }
-
-		// Back up a bit
-		guard let lTopNewCenter = lCenterMarks.popFront(count: Config.searchTraceMarkBackupDistance) else { return false }
-		guard let lBotNewCenter = lCenterMarks.popBack(count: Config.searchTraceMarkBackupDistance) else { return false }
-
 		//
-		// Initial (coarse) trace of the right-side marks
+		// Initial (coarse) trace of the left-side and right-side marks
 		//
+		lCenterMarks.removeAll()
+		lCenterMarks.pushFront(lMarkLoc.center)
 		rCenterMarks.removeAll()
 		rCenterMarks.pushFront(rMarkLoc.center)
-		traceMark(scanVector: scanVector, invertSampleLuma: invertSampleLuma, markWidth: rMarkLoc.sampleCount, markWidthExtension: rMarkExtension, center: rMarkLoc.center, step: step, towardTop: true, centerMarks: &rCenterMarks, maxEdgeTraceMisses: maxEdgeTraceMisses)
-		traceMark(scanVector: scanVector, invertSampleLuma: invertSampleLuma, markWidth: rMarkLoc.sampleCount, markWidthExtension: rMarkExtension, center: rMarkLoc.center, step: step, towardTop: false, centerMarks: &rCenterMarks, maxEdgeTraceMisses: maxEdgeTraceMisses)
+
+		traceMarks([MarkTrace(scanVector: scanVector, markWidth: lMarkLoc.sampleCount, markWidthExtension: lMarkExtension, center: lMarkLoc.center, towardTop: true),
+		            MarkTrace(scanVector: scanVector, markWidth: lMarkLoc.sampleCount, markWidthExtension: lMarkExtension, center: lMarkLoc.center, towardTop: false),
+		            MarkTrace(scanVector: scanVector, markWidth: rMarkLoc.sampleCount, markWidthExtension: rMarkExtension, center: rMarkLoc.center, towardTop: true),
+		            MarkTrace(scanVector: scanVector, markWidth: rMarkLoc.sampleCount, markWidthExtension: rMarkExtension, center: rMarkLoc.center, towardTop: false)],
+		           step: step, invertSampleLuma: invertSampleLuma, maxEdgeTraceMisses: maxEdgeTraceMisses)
 
 		// Grab the first pass extents
+		guard let lTopAlignCenter = lCenterMarks.front else { return false }
+		guard let lBotAlignCenter = lCenterMarks.back else { return false }
 		guard let rTopAlignCenter = rCenterMarks.front else { return false }
 		guard let rBotAlignCenter = rCenterMarks.back else { return false }
 
 		// Back up a bit
+		guard let lTopNewCenter = lCenterMarks.popFront(count: Config.searchTraceMarkBackupDistance) else { return false }
+		guard let lBotNewCenter = lCenterMarks.popBack(count: Config.searchTraceMarkBackupDistance) else { return false }
 		guard let rTopNewCenter = rCenterMarks.popFront(count: Config.searchTraceMarkBackupDistance) else { return false }
 		guard let rBotNewCenter = rCenterMarks.popBack(count: Config.searchTraceMarkBackupDistance) else { return false }
 
@@ -506,16 +711,13 @@ public final class DeckSearch
 		step = 1
 
 		//
-		// Final (fine, aligned) trace of the left-side marks
+		// Final (fine, aligned) trace of the left-side and right-side marks
 		//
-		traceMark(scanVector: topScanVector, invertSampleLuma: invertSampleLuma, markWidth: lMarkLoc.sampleCount, markWidthExtension: lMarkExtension, center: lTopNewCenter, step: step, towardTop: true, centerMarks: &lCenterMarks, maxEdgeTraceMisses: maxEdgeTraceMisses)
-		traceMark(scanVector: botScanVector, invertSampleLuma: invertSampleLuma, markWidth: lMarkLoc.sampleCount, markWidthExtension: lMarkExtension, center: lBotNewCenter, step: step, towardTop: false, centerMarks: &lCenterMarks, maxEdgeTraceMisses: maxEdgeTraceMisses)
-
-		//
-		// Final (fine, aligned) trace of the right-side marks
-		//
-		traceMark(scanVector: topScanVector, invertSampleLuma: invertSampleLuma, markWidth: rMarkLoc.sampleCount, markWidthExtension: rMarkExtension, center: rTopNewCenter, step: step, towardTop: true, centerMarks: &rCenterMarks, maxEdgeTraceMisses: maxEdgeTraceMisses)
-		traceMark(scanVector: botScanVector, invertSampleLuma: invertSampleLuma, markWidth: rMarkLoc.sampleCount, markWidthExtension: rMarkExtension, center: rBotNewCenter, step: step, towardTop: false, centerMarks: &rCenterMarks, maxEdgeTraceMisses: maxEdgeTraceMisses)
+		traceMarks([MarkTrace(scanVector: topScanVector, markWidth: lMarkLoc.sampleCount, markWidthExtension: lMarkExtension, center: lTopNewCenter, towardTop: true),
+		            MarkTrace(scanVector: botScanVector, markWidth: lMarkLoc.sampleCount, markWidthExtension: lMarkExtension, center: lBotNewCenter, towardTop: false),
+		            MarkTrace(scanVector: topScanVector, markWidth: rMarkLoc.sampleCount, markWidthExtension: rMarkExtension, center: rTopNewCenter, towardTop: true),
+		            MarkTrace(scanVector: botScanVector, markWidth: rMarkLoc.sampleCount, markWidthExtension: rMarkExtension, center: rBotNewCenter, towardTop: false)],
+		           step: step, invertSampleLuma: invertSampleLuma, maxEdgeTraceMisses: maxEdgeTraceMisses)
 
 		if Config.debugDrawDeckExtents
 		{
@@ -540,6 +742,80 @@ public final class DeckSearch
 		return true
 	}
 
+	/// Performs the four traces of a pass, storing the results in `lCenterMarks` and `rCenterMarks`
+	///
+	/// The `traces` are ordered: left side toward the top, left side toward the bottom, right side toward the top and right side
+	/// toward the bottom. The center marks should already be seeded with the centers that the traces begin from.
+	///
+	/// The traces are independent of each other, so they are run concurrently (unless we're drawing to a debug buffer or
+	/// `Config.searchParallelThreads` is 1.) Each trace collects its marks in its own entry of `traceOutputs`, which are then
+	/// merged into the center marks in the same order a sequential trace would have added them.
+	private func traceMarks(_ traces: [MarkTrace], step: Int, invertSampleLuma: Bool, maxEdgeTraceMisses: Int)
+	{
+		assert(traces.count == traceOutputs.count)
+
+		if debugBuffer != nil || searchWorkerCount() < 2
+		{
+			for i in 0..<traces.count
+			{
+				let trace = traces[i]
+				if i < 2
+				{
+					traceMark(scanVector: trace.scanVector, invertSampleLuma: invertSampleLuma, markWidth: trace.markWidth, markWidthExtension: trace.markWidthExtension, center: trace.center, step: step, towardTop: trace.towardTop, sampleLine: traceMarksSampleLines[i], centerMarks: &lCenterMarks, maxEdgeTraceMisses: maxEdgeTraceMisses)
+				}
+				else
+				{
+					traceMark(scanVector: trace.scanVector, invertSampleLuma: invertSampleLuma, markWidth: trace.markWidth, markWidthExtension: trace.markWidthExtension, center: trace.center, step: step, towardTop: trace.towardTop, sampleLine: traceMarksSampleLines[i], centerMarks: &rCenterMarks, maxEdgeTraceMisses: maxEdgeTraceMisses)
+				}
+			}
+			return
+		}
+
+		let sampleLines = traceMarksSampleLines
+		traceOutputs.withUnsafeMutableBufferPointer
+		{ buffer in
+			let outputs = buffer
+			DispatchQueue.concurrentPerform(iterations: traces.count)
+			{ i in
+				let trace = traces[i]
+				outputs[i].removeAll()
+				traceMark(scanVector: trace.scanVector, invertSampleLuma: invertSampleLuma, markWidth: trace.markWidth, markWidthExtension: trace.markWidthExtension, center: trace.center, step: step, towardTop: trace.towardTop, sampleLine: sampleLines[i], centerMarks: &outputs[i], maxEdgeTraceMisses: maxEdgeTraceMisses)
+			}
+		}
+
+		for i in 0..<traces.count
+		{
+			if i < 2 { DeckSearch.mergeTrace(traceOutputs[i], towardTop: traces[i].towardTop, into: &lCenterMarks) }
+			else     { DeckSearch.mergeTrace(traceOutputs[i], towardTop: traces[i].towardTop, into: &rCenterMarks) }
+		}
+	}
+
+	/// Adds the marks from a single trace's `output` to `centerMarks`, outward from the center as `traceMark` would have
+	///
+	/// Marks that no longer fit in `centerMarks` are discarded.
+	private static func mergeTrace(_ output: UnsafeBidirectionalArray<IVector>, towardTop: Bool, into centerMarks: inout UnsafeBidirectionalArray<IVector>)
+	{
+		if towardTop
+		{
+			// The trace pushed its marks to the front, so the mark nearest the center is at the back
+			var i = output.count - 1
+			while i >= 0 && centerMarks.frontIndex > 0
+			{
+				centerMarks.pushFront(output[i])
+				i -= 1
+			}
+		}
+		else
+		{
+			var i = 0
+			while i < output.count && centerMarks.frontIndex + centerMarks.count < centerMarks.capacity
+			{
+				centerMarks.pushBack(output[i])
+				i += 1
+			}
+		}
+	}
+
 	/// Traces a LandMark in a given direction in an effort to locate one of the vertical extents of a deck
 	///
 	/// HIGH LEVEL DESCRIPTION
@@ -610,7 +886,12 @@ public final class DeckSearch
 	/// careful with this! A step value of 2 will perform half the work, but will be capable of detecting smaller shift amounts
 	/// within the LandMark. This author does not recommend going above 2. In addition, be aware that with a step value > 1, the
 	/// exact extent of the deck may not be returned (the actual termination point could land between steps.)
-	private func traceMark(scanVector: IVector, invertSampleLuma: Bool, markWidth: Int, markWidthExtension: Int, center: IVector, step: Int, towardTop: Bool, centerMarks: inout UnsafeBidirectionalArray<IVector>, maxEdgeTraceMisses: Int)
+	///
+	/// A NOTE ABOUT CONCURRENCY
+	///
+	/// This method only writes to `sampleLine` and `centerMarks`, so traces with their own of each may run concurrently (see
+	/// `traceMarks`.)
+	private func traceMark(scanVector: IVector, invertSampleLuma: Bool, markWidth: Int, markWidthExtension: Int, center: IVector, step: Int, towardTop: Bool, sampleLine traceMarksSampleLine: SampleLine, centerMarks: inout UnsafeBidirectionalArray<IVector>, maxEdgeTraceMisses: Int)
 	{
 		// A half-vector that defines the vector for a cross-section of our landmark, perpendicular to its maximal extent.
 		//
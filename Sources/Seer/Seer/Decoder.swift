@@ -33,6 +33,12 @@ public final class Decoder
 	// This is our working deck - we have just one in order to reduce reallocation overhead
 	private static var workDeck: Deck?
 
+	/// The most result decks we keep for reuse (see `resultDeck(from:)`)
+	private static let kMaxResultDecks = 8
+
+	/// Decks previously returned in results, reused once nothing else holds them
+	private static var resultDecks = [Deck]()
+
 	// -----------------------------------------------------------------------------------------------------------------------------
 	// Implementation
 	// -----------------------------------------------------------------------------------------------------------------------------
@@ -95,6 +101,7 @@ public final class Decoder
 		if workDeck != nil && deckFormat.name != workDeck!.format.name
 		{
 			workDeck = nil
+			resultDecks.removeAll()
 		}
 
 		// Allocate a new work deck?
@@ -119,7 +126,7 @@ public final class Decoder
 			for wordIndex in 0..<words.count
 			{
 				let cardCode = words[wordIndex]
-				let cardIndex = codeToIndexMap[Int(cardCode)]
+				let cardIndex = Int(codeToIndexMap[Int(cardCode)])
 
 				// Add the new scanned card
 				if cardIndex == HammingDistance.CardState.Unassigned.rawValue { continue }
@@ -159,12 +166,38 @@ public final class Decoder
 
 			if deck.count < deck.format.minCardCount
 			{
-				return .TooFewCards(deck: Deck(deckForResults: deck))
+				return .TooFewCards(deck: resultDeck(from: deck))
 			}
 
-			return .Decoded(deck: Deck(deckForResults: deck))
+			return .Decoded(deck: resultDeck(from: deck))
 		}
 
 		return .GeneralFailure(reason: "There is no workDeck object")
 	}
+
+	/// Returns a deck for use with results, holding the results of `deck`
+	///
+	/// Result decks are reused once the results they were returned in have been released, so that a steady stream of decodes
+	/// doesn't allocate a new deck (and its storage) for every frame. Each is counted as a pooled allocation in the FrameArena.
+	private class func resultDeck(from deck: Deck) -> Deck
+	{
+		for i in 0..<resultDecks.count
+		{
+			// Only we hold it, so its previous results have been released
+			if !isKnownUniquelyReferenced(&resultDecks[i]) { continue }
+
+			resultDecks[i].assign(resultsFrom: deck)
+			FrameArena.instance.countPoolAllocation(fromHeap: false)
+			return resultDecks[i]
+		}
+
+		let newDeck = Deck(deckForResults: deck)
+		if resultDecks.count < kMaxResultDecks
+		{
+			resultDecks.append(newDeck)
+		}
+
+		FrameArena.instance.countPoolAllocation(fromHeap: true)
+		return newDeck
+	}
 }
@@ -11,6 +11,11 @@
 // in the LICENSE file in the root of the source tree.
 
 import Foundation
+#if os(iOS)
+import NativeTasksIOS
+#else
+import NativeTasks
+#endif
 
 /// The EdgeDetection is intended to operate on linear data for common edge-detection values, such as rolling averages, rolling
 /// sums, rolling slopes, etc.
@@ -42,14 +47,16 @@ final class EdgeDetection
 	/// or another EdgeDetection object. It may also contain something completely different, if being used for debugging purposes.
 	private var data: UnsafeMutableArray<RollValue>
 
-	/// The detected edges
-	private var edgesDetected = [Edge]()
-
 	/// Internal storage of peaks as they are detected, but prior to being converted to Edges
-	private static var rolledPeaks = UnsafeMutableArray<Peak>()
+	///
+	/// This (like `rolledMinMax`) belongs to the instance so that separate instances can detect edges on separate threads
+	private var rolledPeaks = UnsafeMutableArray<Peak>()
 
 	/// Internal storage of rolling min/max values used during edge detection
-	private static var rolledMinMax = UnsafeMutableArray<MinMax<Sample>>()
+	private var rolledMinMax = UnsafeMutableArray<MinMax<Sample>>()
+
+	/// Internal storage of the edges found by `nativeDetectEdges()`, prior to being converted to Edges
+	private var nativePeaks = UnsafeMutableArray<NativeEdgePeak>()
 
 	#if DEBUG
 	/// Used to track the sequence of debuggable edges in order to determine which edge detection is drawn when Config.debugDrawEdges
@@ -57,28 +64,40 @@ final class EdgeDetection
 	private static var debuggableEdgeDetectionSequenceId = 0
 	#endif
 
+	/// True if this instance's edge detections are numbered in the debuggable edge sequence (and can have their detail drawn)
+	///
+	/// Instances used from multiple threads at once (such as the parallel search workers) must not be sequenced: the sequence is
+	/// shared, and is only meaningful in the order of a sequential search.
+	private let sequenced: Bool
+
 	// -----------------------------------------------------------------------------------------------------------------------------
 	// Initialization
 	// -----------------------------------------------------------------------------------------------------------------------------
 
 	/// Initializes a EdgeDetection object with a prediction of the number of samples that will be used as input
 	///
-	/// The data will be pre-initialized to the given `predictedSize` and will grow as needed.
-	init(predictedSize: Int)
+	/// The data will be pre-initialized to the given `predictedSize` and will grow as needed. See `sequenced` for details on
+	/// `sequenced`.
+	init(predictedSize: Int, sequenced: Bool = true)
 	{
 		self.data = UnsafeMutableArray<RollValue>(withCapacity: predictedSize)
+		self.sequenced = sequenced
 	}
 
 	/// Copies a EdgeDetection object, duplicating the internal data
 	init(_ rhs: EdgeDetection)
 	{
 		self.data = UnsafeMutableArray<RollValue>(rhs.data)
+		self.sequenced = rhs.sequenced
 	}
 
 	/// Cleanup any allocated memory used by this object
 	deinit
 	{
 		data.free()
+		rolledPeaks.free()
+		rolledMinMax.free()
+		nativePeaks.free()
 	}
 
 	// -----------------------------------------------------------------------------------------------------------------------------
@@ -87,13 +106,15 @@ final class EdgeDetection
 
 	/// Performs edge detection on a SampleLine, returning an array of Edge objects for those edges found, or nil on error.
 	///
+	/// The edges are allocated from the FrameArena, so they are only valid until the end of the frame (see `FrameArena`.)
+	///
 	/// This is the public-facing interface routine for edge detection. For further details on the edge detection process, see the
 	/// `findPeaks` and `thresholdPeaks` methods.
 	///
 	/// It is assumed that the caller has already sampled the line (or populated the SampleLine with appropriate data in some way.)
 	///
-	/// At the end of this call, `data` will contain rolling sums. After calling this method, `peakValues` and `peakIndices`
-	/// will contain the peak data.
+	/// When the multi-pass version is used (see the implementation notes below), `data` will contain rolling sums at the end of
+	/// this call, and `rolledPeaks` will contain the peak data.
 	///
 	/// The `windowSize` parameter is used for the rolling sums (see `UnsafeMutableArray.rollSums` for more information.)
 	///
@@ -128,15 +149,22 @@ final class EdgeDetection
 	///   * If there is not enough data to find peaks
 	///
 	/// If no error occurs but no edges can be found, this method will return an empty array of Edges.
-	func detectEdges(debugBuffer: DebugBuffer?, sampleLine: SampleLine, windowSize inWindowSize: Int, minMaxWindowSize inMinMaxWindowSize: Int, overlap: Int, sensitivity: FixedPoint, imageHeight: Int) -> [Edge]?
+	///
+	/// Implementation notes:
+	///
+	/// The steps above are performed in a single pass over the samples by `nativeDetectEdges()`, which produces identical edges
+	/// without storing the intermediate sums, slopes or min/max values. The multi-pass version (`rollSums`, `findPeaks`,
+	/// `rollMinMax` and `thresholdPeaks`) is only used when the intermediate values are drawn for debugging.
+	func detectEdges(debugBuffer: DebugBuffer?, sampleLine: SampleLine, windowSize inWindowSize: Int, minMaxWindowSize inMinMaxWindowSize: Int, overlap: Int, sensitivity: FixedPoint, imageHeight: Int) -> UnsafeMutableArray<Edge>?
 	{
-		// Reset the set of detected edges
-		edgesDetected.removeAll(keepingCapacity: true)
-
-		// Track our sequence ID
+		// Track our sequence ID (only on the sequential path, see `sequenced`)
 		#if DEBUG
-		let debugSequenceId = EdgeDetection.debuggableEdgeDetectionSequenceId
-		EdgeDetection.debuggableEdgeDetectionSequenceId += 1
+		var debugSequenceId = -1
+		if sequenced
+		{
+			debugSequenceId = EdgeDetection.debuggableEdgeDetectionSequenceId
+			EdgeDetection.debuggableEdgeDetectionSequenceId += 1
+		}
 		#endif
 
 		// Scale our window sizes to suit the resolution of the image
@@ -146,43 +174,71 @@ final class EdgeDetection
 		let windowSize = inWindowSize * imageHeight / 720
 		let minMaxWindowSize = inMinMaxWindowSize * imageHeight / 720
 
-		// Roll the sums
-		if !data.rollSums(samples: sampleLine.samples, windowSize: windowSize) { return nil }
-
-		// Find the peaks
 		let peakOffset = windowSize - 1 - overlap/2
 		let rollingSlopeOffset = windowSize-overlap
-		if !findPeaks(rollingSlopeOffset: rollingSlopeOffset) { return nil }
 
-		// Threshold the peaks to produce a final set of peaks which represent actual edges
-		//
-		// Note that we can do this either with rolling the min/max or with a single min/max
-		if minMaxWindowSize > 0
+		// Only the debug graphs need the intermediate values of the multi-pass version
+		#if DEBUG
+		let debugEdgeDetail = sequenced &&
+		                      ((Config.debugDrawSequencedEdgeDetection && debugSequenceId == Config.debugEdgeDetectionSequenceId) ||
+		                       (Config.debugDrawMouseEdgeDetection && sampleLine.toLine().distance(to: Config.mousePosition) < 0.5))
+		#else
+		let debugEdgeDetail = false
+		#endif
+
+		// The detected edges
+		var edges: UnsafeMutableArray<Edge>
+
+		if !debugEdgeDetail
 		{
-			if !EdgeDetection.rolledMinMax.rollMinMax(samples: sampleLine.samples, count: data.count, windowSize: minMaxWindowSize) { return nil }
-			thresholdPeaks(minMaxWindowSize: minMaxWindowSize, peakOffset: peakOffset, sensitivity: sensitivity, dataScale: RollValue(windowSize))
+			// Find the edges in a single pass
+			let samples = sampleLine.samples
+			nativePeaks.ensureReservation(capacity: samples.count)
+			let edgeCount = nativeDetectEdges(samples._rawPointer, UInt32(samples.count), Int32(windowSize), Int32(minMaxWindowSize), Int32(overlap), sensitivity.value, Config.edgeMinimumThreshold, nativePeaks._rawPointer)
+			if edgeCount < 0 { return nil }
+
+			// Generate the edges
+			edges = FrameArena.instance.allocate(Edge.self, capacity: Int(edgeCount))
+			for i in 0..<Int(edgeCount)
+			{
+				let peak = nativePeaks._rawPointer[i]
+				edges.add(Edge(slope: peak.slope, sampleOffset: Int(peak.sampleOffset), threshold: peak.threshold, sampleLine: sampleLine))
+			}
 		}
 		else
 		{
-			thresholdPeaks(minMax: sampleLine.samples.getMinMax(), peakOffset: peakOffset, sensitivity: sensitivity, dataScale: RollValue(windowSize))
-		}
+			// Roll the sums
+			if !data.rollSums(samples: sampleLine.samples, windowSize: windowSize) { return nil }
 
-		// Generate the edges
-		for i in 0..<EdgeDetection.rolledPeaks.count
-		{
-			let peak = EdgeDetection.rolledPeaks[i]
-			edgesDetected.append(Edge(slope: peak.scaledPeakSlope, sampleOffset: peak.sampleOffset, threshold: peak.threshold, sampleLine: sampleLine))
-		}
+			// Find the peaks
+			if !findPeaks(rollingSlopeOffset: rollingSlopeOffset) { return nil }
 
-		#if DEBUG
-		if Config.debugDrawSequencedEdgeDetection && debugSequenceId == Config.debugEdgeDetectionSequenceId
-		{
-			debugDrawEdgeDetail(debugBuffer: debugBuffer, sampleLine: sampleLine, windowSize: windowSize, minMaxWindowSize: minMaxWindowSize, overlap: overlap)
+			// Threshold the peaks to produce a final set of peaks which represent actual edges
+			//
+			// Note that we can do this either with rolling the min/max or with a single min/max
+			if minMaxWindowSize > 0
+			{
+				if !rolledMinMax.rollMinMax(samples: sampleLine.samples, count: data.count, windowSize: minMaxWindowSize) { return nil }
+				thresholdPeaks(minMaxWindowSize: minMaxWindowSize, peakOffset: peakOffset, sensitivity: sensitivity, dataScale: RollValue(windowSize))
+			}
+			else
+			{
+				thresholdPeaks(minMax: sampleLine.samples.getMinMax(), peakOffset: peakOffset, sensitivity: sensitivity, dataScale: RollValue(windowSize))
+			}
+
+			// Generate the edges
+			edges = FrameArena.instance.allocate(Edge.self, capacity: rolledPeaks.count)
+			for i in 0..<rolledPeaks.count
+			{
+				let peak = rolledPeaks[i]
+				edges.add(Edge(slope: peak.scaledPeakSlope, sampleOffset: peak.sampleOffset, threshold: peak.threshold, sampleLine: sampleLine))
+			}
 		}
 
-		if Config.debugDrawMouseEdgeDetection && sampleLine.toLine().distance(to: Config.mousePosition) < 0.5
+		#if DEBUG
+		if debugEdgeDetail
 		{
-			debugDrawEdgeDetail(debugBuffer: debugBuffer, sampleLine: sampleLine, windowSize: windowSize, minMaxWindowSize: minMaxWindowSize, overlap: overlap)
+			debugDrawEdgeDetail(debugBuffer: debugBuffer, sampleLine: sampleLine, edges: edges, windowSize: windowSize, minMaxWindowSize: minMaxWindowSize, overlap: overlap)
 		}
 
 		if Config.debugDrawEdges
@@ -190,18 +246,18 @@ final class EdgeDetection
 			var edgePos = sampleLine.interpolationPoint(sampleOffset: rollingSlopeOffset)
 			edgePos.draw(to: debugBuffer, color: 0xa0ffff00)
 
-			edgePos = sampleLine.interpolationPoint(sampleOffset: data.count - 1 - overlap / 2)
+			edgePos = sampleLine.interpolationPoint(sampleOffset: sampleLine.samples.count - windowSize - overlap / 2)
 			edgePos.draw(to: debugBuffer, color: 0xa0ffff00)
 
-			for edge in edgesDetected
+			for i in 0..<edges.count
 			{
-				edgePos = sampleLine.interpolationPoint(sampleOffset: edge.sampleOffset)
+				edgePos = sampleLine.interpolationPoint(sampleOffset: edges[i].sampleOffset)
 				edgePos.draw(to: debugBuffer, color: 0xa0ff0000)
 			}
 		}
 		#endif
 
-		return edgesDetected
+		return edges
 	}
 
 	/// Scans through the rolling sums looking for peaks that represent edges in the data
@@ -228,7 +284,7 @@ final class EdgeDetection
 		let maxSlopeCount = data.count - rollingSlopeOffset - 1
 
 		// Reset our peak counts
-		EdgeDetection.rolledPeaks.ensureReservation(capacity: maxSlopeCount)
+		rolledPeaks.ensureReservation(capacity: maxSlopeCount)
 
 		if maxSlopeCount <= 0 { return false }
 
@@ -281,7 +337,7 @@ final class EdgeDetection
 			// We access the raw pointer here since we're not incrementing the count yet - these are temporary values
 			//
 			// Instead, we'll ensure that we don't exceed the capacity
-			EdgeDetection.rolledPeaks.add(Peak(scaledPeakSlope: maxSlope, sampleOffset: maxSlopeIndex))
+			rolledPeaks.add(Peak(scaledPeakSlope: maxSlope, sampleOffset: maxSlopeIndex))
 
 			let absSlope = abs(maxSlope)
 			if absSlope < slopeMin { slopeMin = absSlope }
@@ -309,13 +365,13 @@ final class EdgeDetection
 		let minMaxOffset = peakOffset - minMaxWindowSize / 2
 
 		// As this is an in-place operation, we'll save off the current count, then reset the count so we can add the new elements
-		let peakCount = EdgeDetection.rolledPeaks.count
-		EdgeDetection.rolledPeaks.removeAll()
+		let peakCount = rolledPeaks.count
+		rolledPeaks.removeAll()
 
 		for i in 0..<peakCount
 		{
 			// Get the min/max of the neighboring samples around the peak
-			var peak = EdgeDetection.rolledPeaks._rawPointer[i]
+			var peak = rolledPeaks._rawPointer[i]
 			let absScaledPeakSlope = abs(peak.scaledPeakSlope)
 
 			// We perform an early-out for most unusable peaks here
@@ -323,9 +379,9 @@ final class EdgeDetection
 
 			// Grab our min/max, properly offset into the min/max array (taking the peak's sample offset into account)
 			//
-			// Note that this can produce negative indices, so clamp them to 0 upon lookup
-			let idx = peak.sampleOffset + minMaxOffset
-			peak.minMax = EdgeDetection.rolledMinMax[idx < 0 ? 0 : idx]
+			// Note that this can produce indices outside the min/max array, so clamp them upon lookup
+			let idx = min(peak.sampleOffset + minMaxOffset, rolledMinMax.count - 1)
+			peak.minMax = rolledMinMax[idx < 0 ? 0 : idx]
 
 			// Calculate the threshold for this single sample
 			let threshold = EdgeDetection.calcThreshold(blackPoint: peak.minMax.min,
@@ -338,7 +394,7 @@ final class EdgeDetection
 			{
 				peak.sampleOffset += peakOffset
 				peak.threshold = threshold
-				EdgeDetection.rolledPeaks.add(peak)
+				rolledPeaks.add(peak)
 			}
 		}
 	}
@@ -359,13 +415,13 @@ final class EdgeDetection
 		                                            sensitivity: sensitivity) * dataScale
 
 		// As this is an in-place operation, we'll save off the current count, then reset the count so we can add the new elements
-		let peakCount = EdgeDetection.rolledPeaks.count
-		EdgeDetection.rolledPeaks.removeAll()
+		let peakCount = rolledPeaks.count
+		rolledPeaks.removeAll()
 
 		for i in 0..<peakCount
 		{
 			// Get the current peak
-			var peak = EdgeDetection.rolledPeaks._rawPointer[i]
+			var peak = rolledPeaks._rawPointer[i]
 
 			// Store this peak if it meets the threshold
 			if abs(peak.scaledPeakSlope) >= threshold
@@ -373,7 +429,7 @@ final class EdgeDetection
 				peak.minMax = minMax
 				peak.sampleOffset += peakOffset
 				peak.threshold = threshold
-				EdgeDetection.rolledPeaks.add(peak)
+				rolledPeaks.add(peak)
 			}
 		}
 	}
@@ -442,7 +498,7 @@ final class EdgeDetection
 		return true
 	}
 
-	private func debugDrawEdgeDetail(debugBuffer: DebugBuffer?, sampleLine: SampleLine, windowSize: Int, minMaxWindowSize: Int, overlap: Int)
+	private func debugDrawEdgeDetail(debugBuffer: DebugBuffer?, sampleLine: SampleLine, edges: UnsafeMutableArray<Edge>, windowSize: Int, minMaxWindowSize: Int, overlap: Int)
 	{
 		// Our data is out of scale by the window size
 		let dataScale = Real(1.0) / Real(windowSize)
@@ -457,9 +513,9 @@ final class EdgeDetection
 		{
 			debugDrawMinMaxValue(debugBuffer: debugBuffer, sampleLine: sampleLine, dataScale: 1, offset: minMaxWindowSize/2, fillColor: 0x10ff88ff, lineColor: 0x40ff80ff, amplitude: true)
 		}
-		else if EdgeDetection.rolledMinMax.count > 1
+		else if rolledMinMax.count > 1
 		{
-			debugDrawMinMaxGraph(debugBuffer: debugBuffer, sampleLine: sampleLine, data: EdgeDetection.rolledMinMax, dataScale: 1, offset: minMaxWindowSize/2, fillColor: 0x10ff88ff, lineColor: 0x40ff80ff, amplitude: true)
+			debugDrawMinMaxGraph(debugBuffer: debugBuffer, sampleLine: sampleLine, data: rolledMinMax, dataScale: 1, offset: minMaxWindowSize/2, fillColor: 0x10ff88ff, lineColor: 0x40ff80ff, amplitude: true)
 		}
 
 		// Sums graph
@@ -485,7 +541,7 @@ final class EdgeDetection
 		// Peaks graph
 		//
 		// Peaks represent the slope values that have been filtered to remove any slope value that is co-linear with its neighbors.
-		debugDrawPeaksGraph(debugBuffer: debugBuffer, sampleLine: sampleLine, edges: edgesDetected, dataScale: dataScale, color: 0xffffff00)
+		debugDrawPeaksGraph(debugBuffer: debugBuffer, sampleLine: sampleLine, edges: edges, dataScale: dataScale, color: 0xffffff00)
 	}
 
 	private func debugDrawPointGraph(debugBuffer: DebugBuffer?, sampleLine: SampleLine, data: UnsafeMutableArray<RollValue>, dataScale: Real, offset: Int, color: Color, amplitude: Bool = false)
@@ -636,15 +692,16 @@ final class EdgeDetection
 		}
 	}
 
-	private func debugDrawPeaksGraph(debugBuffer: DebugBuffer?, sampleLine: SampleLine, edges: [Edge], dataScale: Real, color: Color)
+	private func debugDrawPeaksGraph(debugBuffer: DebugBuffer?, sampleLine: SampleLine, edges: UnsafeMutableArray<Edge>, dataScale: Real, color: Color)
 	{
 		if debugBuffer == nil { return }
 		if edges.count == 0 { return }
 
 		let perpNormal = sampleLine.toLine().perpendicularNormal
 
-		for edge in edges
+		for i in 0..<edges.count
 		{
+			let edge = edges[i]
 			let d = Real(edge.slope) * dataScale
 			let p0 = sampleLine.interpolationPoint(sampleOffset: edge.sampleOffset)
 			let p1 = p0.toVector() + perpNormal * d
@@ -655,8 +712,9 @@ final class EdgeDetection
 		{
 			let signedPerpNormal = perpNormal * Real(sign)
 			var t0 = sampleLine.interpolationPoint(sampleOffset: edges[0].sampleOffset).toVector() + signedPerpNormal * Real(edges[0].threshold) * dataScale
-			for edge in edges
+			for i in 0..<edges.count
 			{
+				let edge = edges[i]
 				let t1 = sampleLine.interpolationPoint(sampleOffset: edge.sampleOffset).toVector() + signedPerpNormal * Real(edge.threshold) * dataScale
 				SampleLine(p0: t0.chopToPoint(), p1: t1.chopToPoint()).draw(to: debugBuffer, color: 0xff00ff00)
 				t0 = t1
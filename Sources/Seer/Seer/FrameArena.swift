@@ -0,0 +1,129 @@
+//
+//  FrameArena.swift
+//  Seer
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+import Foundation
+#if os(iOS)
+import NativeTasksIOS
+#else
+import NativeTasks
+#endif
+
+/// Serves the temporary storage used while scanning a single frame
+///
+/// Much of the scan works with short-lived arrays: the edges along a search line, the marks found between them, the indices of a
+/// candidate match. Allocating each of these from the heap, for every search line of every frame, adds up. Instead, they are
+/// carved from a native bump allocator (see `nativeFrameArenaCreate()`) and released all at once when the frame ends (see
+/// `nextFrame()`.) It is safe to allocate from multiple threads at once.
+///
+/// ***
+/// *** IMPORTANT ***
+/// ***
+///
+///		Arrays from the arena wrap the arena's memory. Do not `free()` them, and do not keep them (or anything that points into
+///		them) beyond the end of the frame. Like any `UnsafeMutableArray`, they must not store class objects.
+///
+/// The arena also counts the frame's allocations, along with how many of them needed the heap. Temporaries that can't live in
+/// the arena (objects, mostly) are pooled instead, and their pools report here as well (see `countPoolAllocation()`.) In a
+/// steady state, a frame makes no heap allocations for any of these.
+public final class FrameArena
+{
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Local constants
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// The initial size of the arena, in bytes (it grows to fit the largest frame)
+	private static let kInitialCapacity = 1024 * 1024
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Singleton
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// The arena used by the scan
+	public static let instance = FrameArena(capacity: kInitialCapacity)
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Properties
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// The native arena
+	private let arena: UnsafeMutableRawPointer
+
+	/// Allocations served by pools during the current frame, and how many of those needed the heap
+	private var poolAllocations = 0
+	private var poolHeapAllocations = 0
+
+	/// The number of allocations served during the most recent frame (from the arena and from pools; see `nextFrame()`)
+	public private(set) var lastFrameAllocations = 0
+
+	/// The number of the most recent frame's allocations that needed the heap (zero in a steady state)
+	public private(set) var lastFrameHeapAllocations = 0
+
+	/// The number of bytes allocated from the arena during the most recent frame
+	public private(set) var lastFrameBytes = 0
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Initialization
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Initializes an arena with an initial size of `capacity` bytes
+	init(capacity: Int)
+	{
+		arena = nativeFrameArenaCreate(UInt64(capacity))
+	}
+
+	deinit
+	{
+		nativeFrameArenaDestroy(arena)
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Allocation
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Returns an empty array with room for `capacity` elements, valid until the end of the frame
+	///
+	/// The array must not be freed (see the class notes.)
+	@inline(__always) public func allocate<Element>(_ type: Element.Type = Element.self, capacity: Int) -> UnsafeMutableArray<Element>
+	{
+		let byteCount = max(capacity, 1) * MemoryLayout<Element>.stride
+		guard let memory = nativeFrameArenaAllocate(arena, UInt64(byteCount), UInt32(MemoryLayout<Element>.alignment)) else
+		{
+			fatalError("FrameArena: Unable to allocate \(byteCount) bytes")
+		}
+
+		return UnsafeMutableArray<Element>(withPointer: memory.bindMemory(to: Element.self, capacity: capacity), capacity: capacity)
+	}
+
+	/// Counts an allocation served by a pool during the current frame, noting whether the pool needed the heap to serve it
+	///
+	/// This must be called from the thread processing frames.
+	@inline(__always) public func countPoolAllocation(fromHeap: Bool)
+	{
+		poolAllocations += 1
+		if fromHeap { poolHeapAllocations += 1 }
+	}
+
+	/// Releases everything allocated during the frame, recording its statistics (see `lastFrameAllocations`)
+	///
+	/// This must be called from the thread processing frames, once the frame's results are no longer using any storage from the
+	/// arena.
+	public func nextFrame()
+	{
+		let stats = nativeFrameArenaReset(arena)
+		lastFrameAllocations = Int(stats.allocations) + poolAllocations
+		lastFrameHeapAllocations = Int(stats.heapAllocations) + poolHeapAllocations
+		lastFrameBytes = Int(stats.bytesUsed)
+
+		poolAllocations = 0
+		poolHeapAllocations = 0
+	}
+}
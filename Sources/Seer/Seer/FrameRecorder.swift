@@ -0,0 +1,345 @@
+//
+//  FrameRecorder.swift
+//  Seer
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+import Foundation
+import Dispatch
+#if os(iOS)
+import MinionIOS
+#else
+import Minion
+#endif
+
+/// A "black box" that keeps the most recent frames in memory, writing them out when something goes wrong
+///
+/// Archiving a frame by hand (see `MediaProvider.archiveFrame()`) captures the frame with the problem, but not the frames that
+/// led up to it, and temporal tracking means those frames often matter. Instead, every frame is recorded into a fixed ring of
+/// `Config.diagnosticBlackBoxFrames` slots, optionally cropped to the area around the tracked deck. When a trigger occurs (see
+/// `Config.diagnosticBlackBoxTriggers`), the frames from the last `Config.diagnosticBlackBoxWindowMS` are written to a luma archive
+/// (see `LumaArchiveWriter`) in the background, named for the trigger (e.g., `12-blackbox-Incorrect.lumas`.)
+///
+/// Recording copies the frame's samples into a slot, and nothing more; slots are allocated once and grow only to fit a larger
+/// frame. This keeps the recorder cheap enough to leave enabled. A slot being written out is not recorded over; frames arriving
+/// while the writes catch up are left out of the ring (see `droppedFrameCount`.)
+///
+/// Each archived frame's header data starts with its temporal state (translated to the recorded samples) so that it replays as a
+/// `.luma` file would. The scan's view of the frame follows:
+///
+///		Int32		Offset x of the temporal state
+///		Int32		Offset y of the temporal state
+///		Real		Angle of the temporal state (degrees)
+///		UInt32		Frame number (counting from the first frame recorded)
+///		Double		Time the frame was recorded (see `PausableTime`), in milliseconds
+///		Int32 x 2	Position of the recorded samples within the full frame
+///		Int32		Binning of the recorded samples (see `DeckSearch.FrameRegion`)
+///		Real		Confidence factor of the analysis result (0 if none)
+///		UInt8		Validation: 0 (not validated), 1 (correct), 2 (incorrect)
+///		UTF-8		The analysis result (see `AnalysisResult.parsableDescription`), filling the rest of the header data
+///
+/// Frames must be recorded from the thread processing them.
+public final class FrameRecorder
+{
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Local constants
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// When cropping to a tracked deck, the space kept on each side of the deck as a fraction of the deck's larger dimension
+	private static let kCropMargin: Real = 0.5
+
+	/// The trigger for results validated as incorrect (see `Config.diagnosticBlackBoxTriggers`)
+	public static let kIncorrectTrigger = "Incorrect"
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Local types
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// A recorded frame, and what the scan made of it
+	private final class Slot
+	{
+		/// The frame's packed samples, with room for `capacity` samples
+		var samples: UnsafeMutablePointer<Luma>?
+		var capacity = 0
+
+		/// Dimensions of the recorded samples
+		var width = 0
+		var height = 0
+
+		/// The frame's number (0 for a slot that has never been recorded) and when it was recorded
+		var frameNumber = 0
+		var timeMS: Time = 0
+
+		/// The region of the full frame covered by the recorded samples
+		var region = DeckSearch.FrameRegion()
+
+		/// The temporal state the frame was scanned with, in the coordinates of the recorded samples
+		var temporalOffset = IVector()
+		var temporalAngle: Real = 0
+
+		/// The frame's analysis result (see `AnalysisResult.parsableDescription`), its confidence factor and its validation
+		var result = ""
+		var confidence: Real = 0
+		var validation: UInt8 = 0
+
+		/// Set while the slot is waiting to be written out (guarded by `FrameRecorder.mutex`)
+		var flushing = false
+
+		deinit
+		{
+			samples?.deallocate()
+		}
+
+		/// Ensures room for `count` samples
+		func reserve(_ count: Int)
+		{
+			if count <= capacity { return }
+
+			samples?.deallocate()
+			samples = UnsafeMutablePointer<Luma>.allocate(capacity: count)
+			capacity = count
+		}
+
+		/// Returns the frame's header data, as described in the `FrameRecorder` notes
+		func headerData() -> Data
+		{
+			var header = Data(capacity: 48 + result.utf8.count)
+			header += Int32(temporalOffset.x)
+			header += Int32(temporalOffset.y)
+			header += temporalAngle
+			header += UInt32(truncatingIfNeeded: frameNumber)
+			header += timeMS
+			header += Int32(region.origin.x)
+			header += Int32(region.origin.y)
+			header += Int32(region.binning)
+			header += confidence
+			header += validation
+			header += result
+			return header
+		}
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Properties
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// The ring of recorded frames, and the index of the slot that will be recorded next (the oldest)
+	private var slots = [Slot]()
+	private var nextSlot = 0
+
+	/// The slot recorded for the current frame (until `finishFrame()`), and the center of the image it was recorded from, in the
+	/// coordinates of the recorded samples
+	private var currentSlot: Slot?
+	private var currentImageCenter = IVector()
+
+	/// The number of frames recorded, and the number of the most recent frame written out
+	private var frameCount = 0
+	private var lastFlushedFrameNumber = 0
+
+	/// The triggers in effect, parsed from `triggersString`
+	private var triggersString = ""
+	private var triggers = Set<String>()
+
+	/// Guards the `flushing` flag of each slot
+	private let mutex = PThreadMutex()
+
+	/// Writes archives, one at a time, in the order they were triggered
+	private let flushQueue = DispatchQueue(label: "FrameRecorder.flush", qos: .utility)
+
+	/// The number of frames left out of the ring because their slot was still being written out
+	public private(set) var droppedFrameCount = 0
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Initialization
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	public init()
+	{
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Recording
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Records `lumaBuffer`, which covers `frameRegion` of the full frame
+	///
+	/// This must be called before the frame is preprocessed, so that it replays as it was captured. If
+	/// `Config.diagnosticBlackBoxCropToDeck` is set, only the area around `trackedDeckBounds` (the deck tracked through the previous
+	/// frame, in full-frame coordinates) is kept.
+	///
+	/// The scan's results are added by `finishFrame()`.
+	public func record(lumaBuffer: LumaBuffer, frameRegion: DeckSearch.FrameRegion, trackedDeckBounds: Rect<Int>?)
+	{
+		currentSlot = nil
+
+		// Replayed frames were recorded the first time around
+		if Config.isReplayingFrame || !prepareSlots() { return }
+
+		let slot = slots[nextSlot]
+		if mutex.fastsync(execute: { slot.flushing })
+		{
+			droppedFrameCount += 1
+			return
+		}
+		nextSlot = (nextSlot + 1) % slots.count
+
+		// Copy the frame (or just the area around the deck)
+		let crop = cropRect(imageRect: lumaBuffer.rect, frameRegion: frameRegion, trackedDeckBounds: trackedDeckBounds)
+		slot.width = crop.width
+		slot.height = crop.height
+		slot.reserve(crop.width * crop.height)
+
+		let samples = slot.samples!
+		if crop.width == lumaBuffer.width
+		{
+			samples.assign(from: lumaBuffer.buffer + crop.minY * lumaBuffer.width, count: crop.width * crop.height)
+		}
+		else
+		{
+			for y in 0..<crop.height
+			{
+				(samples + y * crop.width).assign(from: lumaBuffer.buffer + (crop.minY + y) * lumaBuffer.width + crop.minX, count: crop.width)
+			}
+		}
+
+		frameCount += 1
+		slot.frameNumber = frameCount
+		slot.timeMS = PausableTime.getTimeMS()
+		slot.region = DeckSearch.FrameRegion(origin: frameRegion.toFullFrame(IVector(x: crop.minX, y: crop.minY)), binning: frameRegion.binning)
+
+		// The temporal state is relative to the center of the image it was scanned in
+		let cropCenter = IVector(x: crop.minX, y: crop.minY) + Rect<Int>(x: 0, y: 0, width: crop.width, height: crop.height).center.chopToPoint()
+		currentImageCenter = lumaBuffer.rect.center.chopToPoint() - cropCenter
+		currentSlot = slot
+	}
+
+	/// Adds the scan's results to the frame recorded by `record()`, writing out the recent frames if they meet a trigger (see
+	/// `Config.diagnosticBlackBoxTriggers`)
+	///
+	/// `validationResult` is the frame's validation, if it was validated (see `ResultValidator.lastValidationResult`.)
+	public func finishFrame(analysisResult: AnalysisResult, validationResult: ValidationResult?)
+	{
+		guard let slot = currentSlot else { return }
+		currentSlot = nil
+
+		// This is the temporal state the scan started with (see `DeckSearch.scanImage()`)
+		let temporalState = Config.replayTemporalState
+		slot.temporalOffset = temporalState.offset + currentImageCenter
+		slot.temporalAngle = temporalState.angleDegrees
+
+		slot.result = analysisResult.parsableDescription
+		slot.confidence = analysisResult.confidenceFactor ?? 0
+		slot.validation = validationResult == nil ? 0 : (validationResult!.isCorrect ? 1 : 2)
+
+		if triggersString != Config.diagnosticBlackBoxTriggers
+		{
+			triggersString = Config.diagnosticBlackBoxTriggers
+			triggers = Set(triggersString.split(separator: " ").map { String($0) })
+		}
+
+		if validationResult?.isIncorrect ?? false && triggers.contains(FrameRecorder.kIncorrectTrigger)
+		{
+			flush(trigger: FrameRecorder.kIncorrectTrigger)
+		}
+		else if triggers.contains(slot.result)
+		{
+			flush(trigger: slot.result)
+		}
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Implementation
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Sizes the ring to `Config.diagnosticBlackBoxFrames` slots, if it has changed and nothing is being written out
+	///
+	/// Returns false if recording is disabled
+	private func prepareSlots() -> Bool
+	{
+		let slotCount = max(Config.diagnosticBlackBoxFrames, 0)
+		if slots.count == slotCount { return slotCount > 0 }
+
+		let flushing = mutex.fastsync { slots.contains { $0.flushing } }
+		if flushing { return !slots.isEmpty }
+
+		slots = (0..<slotCount).map { _ in Slot() }
+		nextSlot = 0
+		return slotCount > 0
+	}
+
+	/// Returns the area of an image (`imageRect`, covering `frameRegion` of the full frame) to record
+	///
+	/// This is the full image, unless cropping to a tracked deck (see `record()`.)
+	private func cropRect(imageRect: Rect<Int>, frameRegion: DeckSearch.FrameRegion, trackedDeckBounds: Rect<Int>?) -> Rect<Int>
+	{
+		guard Config.diagnosticBlackBoxCropToDeck, let bounds = trackedDeckBounds else { return imageRect }
+
+		let margin = Int(Real(max(bounds.width, bounds.height)) * FrameRecorder.kCropMargin)
+		let p0 = frameRegion.fromFullFrame(IVector(x: bounds.minX - margin, y: bounds.minY - margin))
+		let p1 = frameRegion.fromFullFrame(IVector(x: bounds.maxX + margin, y: bounds.maxY + margin))
+		return Rect<Int>(minX: p0.x, minY: p0.y, maxX: p1.x, maxY: p1.y).intersected(with: imageRect) ?? imageRect
+	}
+
+	/// Writes the frames recorded within `Config.diagnosticBlackBoxWindowMS` (that haven't already been written) to a new luma
+	/// archive named for `trigger`
+	///
+	/// The frames are gathered here; the archive is written in the background.
+	private func flush(trigger: String)
+	{
+		let newest = slots[(nextSlot + slots.count - 1) % slots.count]
+		let windowStartMS = newest.timeMS - Config.diagnosticBlackBoxWindowMS
+
+		// Oldest first
+		var frames = [Slot]()
+		mutex.fastsync
+		{
+			for i in 0..<slots.count
+			{
+				let slot = slots[(nextSlot + i) % slots.count]
+				if slot.frameNumber > lastFlushedFrameNumber && slot.timeMS >= windowStartMS && !slot.flushing
+				{
+					slot.flushing = true
+					frames.append(slot)
+				}
+			}
+		}
+
+		if frames.isEmpty { return }
+		lastFlushedFrameNumber = newest.frameNumber
+
+		gLogger.info("Black box: \(trigger) on frame \(newest.frameNumber), writing \(frames.count) recent frames")
+
+		let mutex = self.mutex
+		flushQueue.async
+		{
+			var writer: LumaArchiveWriter?
+			do
+			{
+				writer = try LumaArchiveWriter(to: "blackbox-\(trigger)")
+			}
+			catch
+			{
+				gLogger.error("Black box: Unable to write recent frames: \(error.localizedDescription)")
+			}
+
+			// Each slot is free to record over as soon as the writer has its copy
+			for slot in frames
+			{
+				if let writer = writer, let samples = slot.samples
+				{
+					writer.append(LumaBuffer(width: slot.width, height: slot.height, buffer: samples), withHeaderData: slot.headerData())
+				}
+
+				mutex.fastsync { slot.flushing = false }
+			}
+
+			writer?.close()
+		}
+	}
+}
@@ -13,8 +13,10 @@
 import Foundation
 #if os(iOS)
 import MinionIOS
+import NativeTasksIOS
 #else
 import Minion
+import NativeTasks
 #endif
 
 public final class HammingDistance
@@ -51,6 +53,10 @@ public final class HammingDistance
 		return hammingDistance
 	}
 
+	/// Returns the minimum Hamming Distance between any two of `codes` (at most `codeBits`), or 0 if it falls below
+	/// `bestMinimumDistance`
+	///
+	/// The pairwise comparison is native (see `nativeMinimumDistance()`), using hardware popcount where available.
 	@inline(__always) public class func calcMinimumDistance(for codes: UnsafeMutableArray<Int>, codeBits: Int, reversible: Bool = false, bestMinimumDistance: Int = 0) -> Int
 	{
 		// If the codes are reversible, calculate the dinimum distance of an array with the original set and revesible set
@@ -68,19 +74,9 @@ public final class HammingDistance
 			return calcMinimumDistance(for: reversibleCodes, codeBits: codeBits, reversible: false, bestMinimumDistance: bestMinimumDistance)
 		}
 
-		var mds = codeBits
-		for i in 0..<codes.count
-		{
-			let iCode = codes[i]
-			for j in i+1..<codes.count
-			{
-				mds = min(mds, calcHammingDistance(from: iCode, to: codes[j]))
-			}
-
-			if mds < bestMinimumDistance { return 0 }
-		}
-
-		return mds
+		// The native codes are always 64-bit (Int is only 32 bits on some targets)
+		let nativeCodes = (0..<codes.count).map { Int64(codes[$0]) }
+		return Int(nativeMinimumDistance(nativeCodes, UInt32(nativeCodes.count), UInt32(codeBits), Int32(bestMinimumDistance)))
 	}
 
 	/// Produces a 2D distance map of Hamming Distances between each pair of codes from `codes'. In addition, each line in the string
@@ -125,127 +121,6 @@ public final class HammingDistance
 		return matrixHeader + String.kNewLine + matrixData
 	}
 
-	// -----------------------------------------------------------------------------------------------------------------------------
-	// Error correction
-	// -----------------------------------------------------------------------------------------------------------------------------
-
-	/// Calculates the mapping of raw codes to the nearest real code (via MDS)
-	///
-	/// As expected, any direct hits will contain the same code at the code's position in the array
-	public class func calcErrorCorrectedMaps(formatName: String, bitCount: Int, mapIndexToCode: [Int]) -> (mapCodeToErrorCorrectedCode: [Int], mapCodeToErrorCorrectedIndex: [Int])
-	{
-		let kFullRange = Int(1) << bitCount
-		let kCollision = -2
-
-		// Initialize the maps
-		//
-		// Note that during processing, the `mapCodeToErrorCorrectedCode` does double-duty. Card Codes are stored with the
-		// minimum distance for all Card Codes in the upper bits.
-		var mapCodeToErrorCorrectedCode = [Int](repeating: CardState.Unassigned.rawValue, count: kFullRange)
-		var mapDistToErrorCorrectedCode = [Int8](repeating: Int8(bitCount), count: kFullRange)
-		var mapCodeToErrorCorrectedIndex = [Int](repeating: CardState.Unassigned.rawValue, count: kFullRange)
-
-		for cardIndex in 0..<mapIndexToCode.count
-		{
-			let cardCode = mapIndexToCode[cardIndex]
-
-			for possibleValue in 0..<kFullRange
-			{
-				let possibleValueIndex = possibleValue
-
-				// Calculate the distance
-				let distance = HammingDistance.calcHammingDistance(from: possibleValue, to: cardCode)
-
-				let minValue = mapCodeToErrorCorrectedCode[possibleValueIndex]
-				let minDistance = mapDistToErrorCorrectedCode[possibleValueIndex]
-
-				// If it's a better distance just assign it
-				if distance < minDistance
-				{
-					mapCodeToErrorCorrectedCode[possibleValueIndex] = cardCode
-					mapDistToErrorCorrectedCode[possibleValueIndex] = Int8(distance)
-					mapCodeToErrorCorrectedIndex[possibleValueIndex] = cardIndex
-					continue
-				}
-
-				// If we have a distance collision, mark it as a collision and the distance at which we collided
-				if distance == minDistance
-				{
-					// Don't bother marking it if it's already marked
-					if minValue != kCollision
-					{
-						mapCodeToErrorCorrectedCode[possibleValueIndex] = kCollision
-						mapDistToErrorCorrectedCode[possibleValueIndex] = Int8(distance)
-					}
-					continue
-				}
-			}
-		}
-
-		// Remove the minDistances from the upper bits of the map codes and replace collisions with `Unassigned`
-		for i in 0..<kFullRange
-		{
-			// Extract the distance and value from the map data
-			let value = mapCodeToErrorCorrectedCode[i]
-
-			// At this point, we should no longer have an unassigned value
-			assert(value != CardState.Unassigned.rawValue)
-
-			// Collisions get remapped to `Unassigned`
-			if value == kCollision
-			{
-				mapCodeToErrorCorrectedCode[i] = CardState.Unassigned.rawValue
-				mapCodeToErrorCorrectedIndex[i] = CardState.Unassigned.rawValue
-			}
-			// Not a collision, so just store the value
-			else
-			{
-				mapCodeToErrorCorrectedCode[i] = value
-			}
-		}
-
-		// Ensure we have all actual codes in both maps
-		for i in 0..<mapIndexToCode.count
-		{
-			let code = mapIndexToCode[i]
-
-			assert(mapCodeToErrorCorrectedCode[code] == code)
-			assert(mapCodeToErrorCorrectedIndex[code] == i)
-		}
-
-		// Calc error correction distance
-		var distances = [Int](repeating: 0, count: bitCount)
-		for i in 0..<mapCodeToErrorCorrectedCode.count
-		{
-			let x = mapCodeToErrorCorrectedCode[i]
-			if x == CardState.Unassigned.rawValue { continue }
-			let d = calcHammingDistance(from: i, to: x)
-			distances[d] += 1
-		}
-
-		var distancesStr = ""
-		for i in 0..<distances.count
-		{
-			let c = distances[i]
-			if c == 0 { continue }
-			distancesStr += "\(i)[\(c)] "
-		}
-
-		var used = 0
-		for value in mapCodeToErrorCorrectedCode
-		{
-			if value != CardState.Unassigned.rawValue
-			{
-				used += 1
-			}
-		}
-		let ecRate = Double(used) * 100 / Double(mapCodeToErrorCorrectedCode.count)
-
-		gLogger.always(" > \(formatName): Bits: \(bitCount), Values: \(mapIndexToCode.count), EC Rate: \(String(format: "%.2f", ecRate))%, EC distances: \(distancesStr)")
-
-		return (mapCodeToErrorCorrectedCode, mapCodeToErrorCorrectedIndex)
-	}
-
 	// -----------------------------------------------------------------------------------------------------------------------------
 	// Histograms
 	// -----------------------------------------------------------------------------------------------------------------------------
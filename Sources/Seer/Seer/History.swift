@@ -32,47 +32,40 @@ public final class History
 
 	/// A unique result (in the form of the set of indices) in the history
 	///
-	/// A single `Entry` may be present in the history multiple times. Rather than duplicating multiple entries in the history, an
-	/// array of timestamps is included that allow us to calculate the age of each history entry (and prune older entries by simply
-	/// removing the timestamp from the array.)
+	/// A single `Entry` may be present in the history multiple times. Rather than duplicating multiple entries in the history, the
+	/// entry counts the number of times it is present. The time of each appearance is kept in a shared ring of buckets (see
+	/// `buckets`), so that older appearances can be pruned by simply decrementing the count.
 	private struct Entry
 	{
 		/// The set of indices that this history entry represents
-		var indices: [UInt8]
+		let indices: [UInt8]
 
-		/// The timestamps for each time this entry was added to the history
-		var timestamps: [Time]
-
-		/// Initialize the entry from its base constituents
-		init(indices: [UInt8], timestamps: [Time] = [Time]())
-		{
-			self.indices = indices
-			self.timestamps = timestamps
-		}
+		/// The order in which this entry was added to the history
+		///
+		/// Entries are stored in the order they were added, so this increases through `History.entries` (see `History.linkKeys`)
+		let serial: Int
 
 		/// The number of times this entry appears in the history
-		///
-		/// This is simply calculated by the number of timestamps in this entry
-		var count: Int
-		{
-			return timestamps.count
-		}
+		var count = 0
 
-		/// Adds a timestamp to this entry (thus increasing `count` by 1)
-		mutating func addTimestamp(_ timestamp: Time)
+		/// Initialize the entry from its base constituents
+		init(indices: [UInt8], serial: Int)
 		{
-			timestamps.append(timestamp)
+			self.indices = indices
+			self.serial = serial
 		}
+	}
 
-		/// Removes timestamps that are older than `maxHistoryAgeMS` (thus decreasing `count` by the number of entries that were
-		/// removed)
-		mutating func removeOldEntries(maxHistoryAgeMS: Int)
-		{
-			let oldestAllowedTimeMS = PausableTime.getTimeMS() - Time(Config.analysisMaxHistoryAgeMS)
+	/// A single appearance of an entry in the history
+	///
+	/// One bucket is added per frame (see `addEntry(indices:deckFormat:)`), so the buckets are in time order.
+	private struct Bucket
+	{
+		/// The time that the entry appeared
+		let time: Time
 
-			// Keep all elements not older than `oldestAllowedTimeMS`
-			timestamps = timestamps.filter {$0 > oldestAllowedTimeMS}
-		}
+		/// The serial of the entry (see `Entry.serial`)
+		let serial: Int
 	}
 
 	/// A unique link from one card to another
@@ -137,6 +130,27 @@ public final class History
 	/// This is our history
 	private var entries = [Entry]()
 
+	/// The serial of the entry for each set of indices in the history (see `findHistoryIndex(of:)`)
+	private var entrySerials = [[UInt8]: Int]()
+
+	/// A ring of every appearance of an entry in the history, oldest first
+	///
+	/// The ring starts at `bucketFront` and holds `bucketCount` buckets, wrapping around the end of the array. It is initialized
+	/// to an arbitrary capacity and grows only when necessary (see `addBucket(_:)`.)
+	private var buckets = UnsafeMutableArray<Bucket>(withCapacity: 256)
+
+	/// The index of the oldest bucket in `buckets`
+	private var bucketFront = 0
+
+	/// The number of buckets in `buckets`
+	private var bucketCount = 0
+
+	/// The sum of the count of all entries (see `calcTotalHistorySize()`)
+	private var totalHistorySize = 0
+
+	/// The sum of the link counts in `consolidatedLinks` (see `calcConfidence()`)
+	private var consolidatedLinkSum = 0
+
 	/// The deck format for the entries in the history
 	///
 	/// This is important because histories store indices, which are `DeckFormat`-dependent.
@@ -164,15 +178,37 @@ public final class History
 
 	/// A link from card-to-card, which allows us to track which cards follow which
 	///
-	/// This is initially declared as a 1x1 array and is reallocated as needed
+	/// This is initially declared as a 1x1 array and is reallocated as needed (see `resetLinks()`.) It is maintained as entries
+	/// are added to (and pruned from) the history, such that it is always identical to a matrix built from the full history (see
+	/// `linkKeys`.)
 	private var linkMatrix = LinkMatrix(rowCapacity: 1, colCapacity: 1)
 
+	/// The number of slots for each source in `linkColumns` and `linkKeys`: one for every target, including the head and tail
+	private var linkStride = 0
+
+	/// The column of each link (at `source * linkStride + target`) within its row of `linkMatrix`, or -1 if there is no such link
+	private var linkColumns = UnsafeMutableArray<Int>()
+
+	/// The first appearance of each link (at `source * linkStride + target`) in the history (see `linkKey(serial:position:)`)
+	///
+	/// A matrix built by visiting every entry in turn would order the links in each row by where they first appear, so the links
+	/// in each row of `linkMatrix` are kept sorted by these keys. This order matters, as it decides some ties in the analysis.
+	///
+	/// Keys are 64-bit on every platform, as they hold a serial and a position side by side.
+	private var linkKeys = UnsafeMutableArray<Int64>()
+
+	/// The serial for the next new entry (see `Entry.serial`)
+	private var nextEntrySerial = 0
+
 	/// A linear set of links, typically consolidated from a `LinkMatrix`
 	private var consolidatedLinks = ConsolidatedLinks()
 
 	/// An internal-use array used to quickly find the full set of missing indices
 	private var missingIndices = UnsafeMutableArray<Bool>()
 
+	/// The indices returned by `analyze()`, kept so their storage is reused from one analysis to the next
+	private var analyzedIndices = [UInt8]()
+
 	// -----------------------------------------------------------------------------------------------------------------------------
 	// Implementation
 	// -----------------------------------------------------------------------------------------------------------------------------
@@ -207,11 +243,20 @@ public final class History
 		var historyIndex = findHistoryIndex(of: indices)
 		if historyIndex == nil
 		{
-			entries.append(Entry(indices: indices))
+			entries.append(Entry(indices: indices, serial: nextEntrySerial))
+			entrySerials[indices] = nextEntrySerial
+			nextEntrySerial += 1
 			historyIndex = entries.count - 1
 		}
 
-		entries[historyIndex!].addTimestamp(PausableTime.getTimeMS())
+		// Buckets must stay in time order, so should the clock ever step backwards, we hold it where it was
+		var time = PausableTime.getTimeMS()
+		if bucketCount > 0 { time = max(time, buckets._rawPointer[(bucketFront + bucketCount - 1) % buckets.capacity].time) }
+		addBucket(Bucket(time: time, serial: entries[historyIndex!].serial))
+
+		entries[historyIndex!].count += 1
+		totalHistorySize += 1
+		adjustLinks(of: entries[historyIndex!], by: 1)
 	}
 
 	/// Determine the probability of a scanned set of card indices is likely to be valid and return a confidence factor.
@@ -268,33 +313,41 @@ public final class History
 		if mergedLinks[0].source != cardIndexHead || mergedLinks[mergedLinks.count-1].source == cardIndexTail { return nil }
 
 		// Build an array of indices for the deck
-		var indices = [UInt8]()
-		indices.reserveCapacity(mergedLinks.count)
+		//
+		// The caller copies these (see `Deck.analyze()`), so our storage is ours alone again by the next analysis
+		analyzedIndices.removeAll(keepingCapacity: true)
+		analyzedIndices.reserveCapacity(mergedLinks.count)
 
 		// Note we skip the first entry in order to skip the head
 		for i in 1..<mergedLinks.count
 		{
-			indices.append(mergedLinks[i].source)
+			analyzedIndices.append(mergedLinks[i].source)
 		}
 
-		return indices
+		return analyzedIndices
 	}
 
 	/// Returns the index within the history that matches the given set of indices, or `nil` if not found
 	private func findHistoryIndex(of indices: [UInt8]) -> Int?
 	{
-		return findHistoryIndex(of: indices, from: entries)
+		guard let serial = entrySerials[indices] else { return nil }
+		return findHistoryIndex(ofSerial: serial)
 	}
 
-	/// Returns the index within a merged history that matches the given set of indices, or `nil` if not found
-	private func findHistoryIndex(of indices: [UInt8], from entries: [Entry]) -> Int?
+	/// Returns the index within the history of the entry with the given serial, or `nil` if not found
+	///
+	/// Entries are stored in the order they were added, so this is a binary search of their serials.
+	private func findHistoryIndex(ofSerial serial: Int) -> Int?
 	{
-		for i in 0..<entries.count
+		var lo = 0
+		var hi = entries.count
+		while lo < hi
 		{
-			if entries[i].indices == indices { return i }
+			let mid = (lo + hi) / 2
+			if entries[mid].serial < serial { lo = mid + 1 } else { hi = mid }
 		}
 
-		return nil
+		return lo < entries.count && entries[lo].serial == serial ? lo : nil
 	}
 
 	// -----------------------------------------------------------------------------------------------------------------------------
@@ -309,8 +362,8 @@ public final class History
 
 	/// Merge all history entries into a single set of links that defines the final order of indices
 	///
-	/// This is a rather involved process that starts by building a link matrix of every link (i.e., a pair of cards seen next to
-	/// each other in the history.)
+	/// This is a rather involved process that starts with the link matrix of every link (i.e., a pair of cards seen next to each
+	/// other in the history.) The link matrix is kept up to date as the history changes (see `adjustLinks(of:by:)`.)
 	///
 	/// Once this full matrix of links is created, all of the links are analyzed and consolidated into a single list of links that
 	/// defines the (nearly) final set of indices.
@@ -328,8 +381,7 @@ public final class History
 		// Ensure we have some history
 		if entries.count == 0 { return nil }
 
-		// Build our link matrix
-		let linkMatrix = buildLinkMatrix(deckFormat: deckFormat, entries: entries)
+		dumpLinkMatrix(heading: "History link matrix:", deckFormat: deckFormat, linkMatrix: linkMatrix)
 
 		guard let consolidated = consolidateLinks(deckFormat: deckFormat, linkMatrix: linkMatrix) else
 		{
@@ -354,13 +406,19 @@ public final class History
 		return finalConsolidated
 	}
 
-	/// Build a matrix of [source x link_to_target] from the full set of history entries
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Link matrix
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Empty the matrix of [source x link_to_target] links, sizing it for the current `deckFormat`
 	///
 	/// The rows in the matrix are indexed by the card's index. Note that we include two additional indices here, a head and tail
 	/// index, which allows us to link to the first card and from the last card. These special indices are defined as the indices
 	/// immediately following the actual card indices for the given `deckFormat`.
-	private func buildLinkMatrix(deckFormat: DeckFormat, entries: [Entry]) -> LinkMatrix
+	private func resetLinks()
 	{
+		guard let deckFormat = deckFormat else { return }
+
 		// The maximum number of indices allowed for the type
 		let maxIndexCount = 1 << (MemoryLayout<UInt8>.size * 8)
 
@@ -374,50 +432,143 @@ public final class History
 		// It is expensive to determine the number of links, so we go with the maximum possible
 		linkMatrix.ensureReservation(rowCapacity: maxIndexCount, colCapacity: Int(cardIndexTail))
 
-		// We visit every entry in the history
-		for entry in entries
-		{
-			// Sanity check that this entry isn't empty
-			assert(entry.count != 0)
-			if entry.count == 0 { continue }
+		// No links
+		linkStride = Int(cardIndexTail) + 1
+		linkColumns.ensureReservation(capacity: linkStride * linkStride)
+		linkColumns.initialize(to: -1, count: linkStride * linkStride)
+		linkKeys.ensureReservation(capacity: linkStride * linkStride)
+		linkKeys.initialize(to: 0, count: linkStride * linkStride)
+	}
 
-			// We always start with a head element
-			var sourceIndex = Int(cardIndexHead)
+	/// Returns the key for a link that first appears at `position` (the index of its target) in the entry with `serial`
+	///
+	/// Keys sort in the order that the links would be found by visiting every entry in turn (see `linkKeys`.)
+	@inline(__always) private static func linkKey(serial: Int, position: Int) -> Int64
+	{
+		return Int64(serial) << 32 | Int64(position)
+	}
 
-			// Visit each index in this history entry, looking for targets that the current source points to
-			//
-			// Note how we loop one past the last index, which we'll use as the tail
-			for i in 0...entry.indices.count
+	/// Adds `delta` to the count of every link in `entry`, adding new links to (or removing unused links from) the link matrix
+	///
+	/// An entry's links run from the head, through each of its indices, to the tail. Each is counted every time it appears in the
+	/// entry, for every time the entry appears in the history.
+	private func adjustLinks(of entry: Entry, by delta: Int)
+	{
+		var sourceIndex = Int(cardIndexHead)
+
+		// Note how we loop one past the last index, which we'll use as the tail
+		for i in 0...entry.indices.count
+		{
+			// Our target index, which becomes `cardIndexTail` when we reach the very end
+			let targetIndex = i == entry.indices.count ? cardIndexTail : entry.indices[i]
+			let slot = sourceIndex * linkStride + Int(targetIndex)
+			let column = linkColumns[slot]
+
+			if column < 0
+			{
+				// A link that isn't in the history can only come from the newest entry, so it appears after every other link from
+				// this source
+				assert(delta > 0)
+				linkColumns[slot] = linkMatrix.colCount(row: sourceIndex)
+				linkKeys[slot] = History.linkKey(serial: entry.serial, position: i)
+				linkMatrix.add(toRow: sourceIndex, value: Link(source: UInt8(sourceIndex), target: targetIndex, count: delta))
+			}
+			else
 			{
-				// Our target index, which becomes `cardIndexTail` when we reach the very end
-				let targetIndex = i == entry.indices.count ? cardIndexTail : entry.indices[i]
+				linkMatrix[sourceIndex, column].count += delta
 
-				// See if the current source has a link to this target
-				var found = false
-				for j in 0..<linkMatrix.colCount(row: sourceIndex)
+				// Remove links that are no longer in the history
+				if linkMatrix[sourceIndex, column].count == 0
 				{
-					if linkMatrix[sourceIndex, j].target == targetIndex
-					{
-						// This source has a link to this target, so update the count by adding the current histgory entry's count
-						linkMatrix[sourceIndex, j].count += entry.count
-						found = true
-						break
-					}
+					linkColumns[slot] = -1
+					linkMatrix.remove(row: sourceIndex, col: column)
+					updateLinkColumns(row: sourceIndex, from: column)
 				}
+			}
 
-				// This source doesn't yet have a link to this target, so add one (making sure to use the history entry's count)
-				if !found
+			// Roll through `source` -> `target`
+			sourceIndex = Int(targetIndex)
+		}
+	}
+
+	/// Re-keys the links that first appeared in `entry`, which has been removed from the history
+	///
+	/// Links that remain in the history now first appear in a later entry, so they are moved to their new place in their row.
+	private func rekeyLinks(of entry: Entry)
+	{
+		var sourceIndex = Int(cardIndexHead)
+		for i in 0...entry.indices.count
+		{
+			let targetIndex = i == entry.indices.count ? cardIndexTail : entry.indices[i]
+			let slot = sourceIndex * linkStride + Int(targetIndex)
+
+			if linkColumns[slot] >= 0 && linkKeys[slot] == History.linkKey(serial: entry.serial, position: i)
+			{
+				linkKeys[slot] = findLinkKey(source: sourceIndex, target: Int(targetIndex))
+				sortLinks(row: sourceIndex)
+			}
+
+			sourceIndex = Int(targetIndex)
+		}
+	}
+
+	/// Returns the key of the first appearance in the history of the link from `source` to `target` (which must exist)
+	private func findLinkKey(source: Int, target: Int) -> Int64
+	{
+		for entry in entries
+		{
+			var sourceIndex = Int(cardIndexHead)
+			for i in 0...entry.indices.count
+			{
+				let targetIndex = i == entry.indices.count ? Int(cardIndexTail) : Int(entry.indices[i])
+				if sourceIndex == source && targetIndex == target
 				{
-					linkMatrix.add(toRow: sourceIndex, value: Link(source: UInt8(sourceIndex), target: targetIndex, count: entry.count))
+					return History.linkKey(serial: entry.serial, position: i)
 				}
 
-				// Roll through `source` -> `target`
-				sourceIndex = Int(targetIndex)
+				sourceIndex = targetIndex
 			}
 		}
 
-		dumpLinkMatrix(heading: "History link matrix:", deckFormat: deckFormat, linkMatrix: linkMatrix)
-		return linkMatrix
+		// If you hit this assert, the link matrix has a link that isn't in the history
+		assert(false)
+		return Int64.max
+	}
+
+	/// Sorts the links in `row` of the link matrix by their keys (see `linkKeys`)
+	///
+	/// The links are almost always in order already, so this is a simple insertion sort.
+	private func sortLinks(row: Int)
+	{
+		let links = linkMatrix[row]
+		let count = linkMatrix.colCount(row: row)
+		let rowSlot = row * linkStride
+		if count < 2 { return }
+
+		for i in 1..<count
+		{
+			let link = links[i]
+			let key = linkKeys[rowSlot + Int(link.target)]
+			var j = i
+			while j > 0 && linkKeys[rowSlot + Int(links[j - 1].target)] > key
+			{
+				links[j] = links[j - 1]
+				j -= 1
+			}
+			links[j] = link
+		}
+
+		updateLinkColumns(row: row, from: 0)
+	}
+
+	/// Updates `linkColumns` for the links in `row` of the link matrix, starting at column `from`
+	@inline(__always) private func updateLinkColumns(row: Int, from column: Int)
+	{
+		let rowSlot = row * linkStride
+		for i in column..<linkMatrix.colCount(row: row)
+		{
+			linkColumns[rowSlot + Int(linkMatrix[row, i].target)] = i
+		}
 	}
 
 	/// Consolidate the link matrix into an ordered array of single links
@@ -428,6 +579,7 @@ public final class History
 		// Ensure we have enough space in our consolidated links to account for a full deck plus our head & tail
 		consolidatedLinks.ensureReservation(capacity: deckFormat.maxCardCountWithReversed + 2)
 		consolidatedLinks.removeAll()
+		consolidatedLinkSum = 0
 
 		// All cards are missing until they are found
 		missingIndices.ensureReservation(capacity: deckFormat.maxCardCountWithReversed + 2)
@@ -466,6 +618,7 @@ public final class History
 			// Mark it as found and add it
 			missingIndices[Int(maxLink.source)] = false
 			consolidatedLinks.add(maxLink)
+			consolidatedLinkSum += maxLink.count
 
 			curIndex = Int(maxLink.target)
 		}
@@ -648,6 +801,19 @@ public final class History
 			}
 
 			// Replace the found link with the one that links to the missing card
+			//
+			// Note that `newFoundCards` shares its storage with `consolidatedLinks`, whose count doesn't change, so we keep the sum
+			// of its links (see `calcConfidence()`) in step with the links that are replaced, inserted or pushed past its end.
+			let consolidatedCount = consolidatedLinks.count
+			if bestFoundCardIndex < consolidatedCount
+			{
+				consolidatedLinkSum += bestTestLink.count - newFoundCards[bestFoundCardIndex].count
+			}
+			if bestFoundCardIndex + 1 < consolidatedCount
+			{
+				consolidatedLinkSum += bestMissingCardLink.count - newFoundCards[consolidatedCount - 1].count
+			}
+
 			newFoundCards[bestFoundCardIndex] = bestTestLink
 			newFoundCards.insert(before: bestFoundCardIndex+1, value: bestMissingCardLink)
 		}
@@ -661,15 +827,54 @@ public final class History
 	// -----------------------------------------------------------------------------------------------------------------------------
 
 	// Cleanup history - remove all entries older than the max age defined by `Config.analysisMaxHistoryAgeMS`
+	//
+	// The buckets are in time order, so only those that have expired are visited
 	private func prune()
 	{
-		for i in 0..<entries.count
+		let oldestAllowedTimeMS = PausableTime.getTimeMS() - Time(Config.analysisMaxHistoryAgeMS)
+
+		while bucketCount > 0 && buckets._rawPointer[bucketFront].time <= oldestAllowedTimeMS
+		{
+			let serial = buckets._rawPointer[bucketFront].serial
+			bucketFront = (bucketFront + 1) % buckets.capacity
+			bucketCount -= 1
+
+			// If you hit this assert, a bucket has outlived its entry
+			guard let historyIndex = findHistoryIndex(ofSerial: serial) else { assert(false); continue }
+
+			entries[historyIndex].count -= 1
+			totalHistorySize -= 1
+			adjustLinks(of: entries[historyIndex], by: -1)
+
+			// Wipe out empty history entries, along with any links that first appeared in them
+			if entries[historyIndex].count == 0
+			{
+				let entry = entries.remove(at: historyIndex)
+				entrySerials[entry.indices] = nil
+				rekeyLinks(of: entry)
+			}
+		}
+	}
+
+	/// Adds a bucket to the end of the ring of buckets, growing it if needed
+	private func addBucket(_ bucket: Bucket)
+	{
+		if bucketCount == buckets.capacity
 		{
-			entries[i].removeOldEntries(maxHistoryAgeMS: Config.analysisMaxHistoryAgeMS)
+			// Unroll the ring into a larger one
+			var grown = UnsafeMutableArray<Bucket>(withCapacity: buckets.capacity * 2)
+			for i in 0..<bucketCount
+			{
+				grown.add(buckets._rawPointer[(bucketFront + i) % buckets.capacity])
+			}
+
+			buckets.free()
+			buckets = grown
+			bucketFront = 0
 		}
 
-		// Wipe out empty history entries
-		entries = entries.filter {$0.count > 0}
+		buckets._rawPointer[(bucketFront + bucketCount) % buckets.capacity] = bucket
+		bucketCount += 1
 	}
 
 	/// Reset the analyzer completely
@@ -680,6 +885,11 @@ public final class History
 	public func reset()
 	{
 		entries.removeAll()
+		entrySerials.removeAll()
+		bucketFront = 0
+		bucketCount = 0
+		totalHistorySize = 0
+		resetLinks()
 	}
 
 	/// Confidence example:
@@ -693,29 +903,14 @@ public final class History
 	///         33 / 35 = 0.9428571429
 	public func calcConfidence() -> Real
 	{
-		var linkCount = 0
-		var linkSum = 0
-
-		for i in 0..<consolidatedLinks.count
-		{
-			linkSum += consolidatedLinks[i].count
-			linkCount += 1
-		}
-
-		let linkAverage = Real(linkSum) / Real(linkCount)
+		let linkAverage = Real(consolidatedLinkSum) / Real(consolidatedLinks.count)
 		return linkAverage / Real(calcTotalHistorySize()) * 100
 	}
 
 	/// Returns the total size of the history, returning the sum of the count of all entries
 	public func calcTotalHistorySize() -> Int
 	{
-		var historyTotalSize = 0
-		for i in 0..<entries.count
-		{
-			historyTotalSize += entries[i].count
-		}
-
-		return historyTotalSize
+		return totalHistorySize
 	}
 
 	// -----------------------------------------------------------------------------------------------------------------------------
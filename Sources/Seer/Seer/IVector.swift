@@ -364,7 +364,7 @@ public struct IVector: Arithmeticable
 
 	@inline(__always) public static func == (left: IVector, right: IVector) -> Bool
 	{
-		return left.x == right.x && left.y == left.y
+		return left.x == right.x && left.y == right.y
 	}
 
 	@inline(__always) public static func == (left: IVector, right: Int) -> Bool
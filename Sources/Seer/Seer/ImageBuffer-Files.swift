@@ -50,6 +50,12 @@ extension ImageBuffer
 	///
 	/// An Optional URL object for the given image file
 	internal func locateFilenameURL(for filename: PathString, createPath: Bool = false) -> URL?
+	{
+		return ImageBuffer.locateFilenameURL(for: filename, createPath: createPath)
+	}
+
+	/// See `locateFilenameURL(for:createPath:)`; this form is for files that are not written from an image (see `LumaArchiveWriter`)
+	internal static func locateFilenameURL(for filename: PathString, createPath: Bool = false) -> URL?
 	{
 		#if os(Linux)
 			let initialPath = filename.withoutLastComponent() ?? PathString.currentDirectory()
@@ -559,25 +565,44 @@ extension ImageBuffer where Sample == Luma
 	/// All other errors are logged (as errors) but the caller is not notified as these errors occur on a DispatchQueue
 	public func writeLuma(to fileBase: String, reservedMB: Int = Config.systemReservedDiskSpaceMB, withHeaderData innerHeader: Data? = nil, async: Bool = true) throws
 	{
-		// Copy the image data with headers
-		let innerHeaderSize = (innerHeader?.count ?? 12)
-		var lumaHeader = Data(capacity: 8 + innerHeaderSize)
+		// Copy the image data with headers (if the user didn't provide an inner header, use the temporal state information)
+		let innerHeader = innerHeader ?? ImageBuffer.temporalStateHeaderData()
+		var lumaHeader = Data(capacity: 8 + innerHeader.count)
 		lumaHeader += Int16(width)
 		lumaHeader += Int16(height)
-		lumaHeader += Int32(innerHeaderSize)
+		lumaHeader += Int32(innerHeader.count)
+		lumaHeader += innerHeader
 
-		// If the user provided an inner header, use that, otherwise we'll use the temporal state information from `Config`
-		if let innerHeader = innerHeader
-		{
-			lumaHeader += innerHeader
-		}
-		else
-		{
-			lumaHeader += Int32(Config.replayTemporalState.offset.x)
-			lumaHeader += Int32(Config.replayTemporalState.offset.y)
-			lumaHeader += Config.replayTemporalState.angleDegrees
-		}
+		// Note that once we build our data into `varData` we must assign it to the constant `data`. We do this due to a bug
+		// in the Swift compiler (v3.0.1) related to capture promotion (https://bugs.swift.org/browse/SR-293).
+		let data = lumaHeader
+
+		let imagePath = try ImageBuffer.locateNumberedLumaPath(for: fileBase, fileExtension: "luma", reservedMB: reservedMB,
+		                                                       dataBytes: UInt64(width * height + data.count))
+
+		try writeRaw(to: imagePath, binaryHeader: data, async: async)
+	}
 
+	/// Returns the header data that `writeLuma()` stores with an image by default: the current temporal state information found
+	/// in the `Config` class (offset x, offset y and angle)
+	public static func temporalStateHeaderData() -> Data
+	{
+		var header = Data(capacity: 12)
+		header += Int32(Config.replayTemporalState.offset.x)
+		header += Int32(Config.replayTemporalState.offset.y)
+		header += Config.replayTemporalState.angleDegrees
+		return header
+	}
+
+	/// Returns the path for a new diagnostic file with a base name of `fileBase` and the extension `fileExtension`
+	///
+	/// The file is placed in `Config.diagnosticLumaFilePath` (see `locateFilenameURL()`) and numbered after the largest numbered
+	/// file in that directory with the same extension, so that files sort in the order they were written.
+	///
+	/// Throws ImageError.WriteFailure if the path cannot be located, or if writing `dataBytes` would leave less than `reservedMB`
+	/// free on its volume
+	internal static func locateNumberedLumaPath(for fileBase: String, fileExtension: String, reservedMB: Int, dataBytes: UInt64) throws -> PathString
+	{
 		// On macOS -> Desktop or $HOME or getcwd()
 		// Other -> $HOME or getcwd()
 		let tmpPath = Config.diagnosticLumaFilePath.isEmpty ? PathString(fileBase) : (Config.diagnosticLumaFilePath + fileBase)
@@ -592,15 +617,8 @@ extension ImageBuffer where Sample == Luma
 			throw ImageError.WriteFailure("writeLuma: Aborting - unable to extract path from url: \(tmpImageUrl)")
 		}
 
-		// Scan the directory for *.luma files so we can add to the end of the list
-		let largestFileNumber = (path.getLargestFileNumberFromDirectory(pattern: "[.]luma$") ?? 0) + 1
-
-		// Generate a filename
-		let imageUrl = (path + "\(largestFileNumber)-\(fileBase).luma").toUrl()
-
-		// Note that once we build our data into `varData` we must assign it to the constant `data`. We do this due to a bug
-		// in the Swift compiler (v3.0.1) related to capture promotion (https://bugs.swift.org/browse/SR-293).
-		let data = lumaHeader
+		// Scan the directory for files with our extension so we can add to the end of the list
+		let largestFileNumber = (path.getLargestFileNumberFromDirectory(pattern: "[.]\(fileExtension)$") ?? 0) + 1
 
 		// Do we have enough space?
 		guard let freeBytes = path.availableSpaceForPath() else
@@ -608,7 +626,6 @@ extension ImageBuffer where Sample == Luma
 			throw ImageError.WriteFailure("writeLuma: Aborting - unable to determine available space to write Luma image: \(path)")
 		}
 
-		let dataBytes = UInt64(width * height + data.count)
 		let finalFreeMB = freeBytes - dataBytes
 		let limitBytes = UInt64(reservedMB) * 1024 * 1024
 
@@ -617,6 +634,7 @@ extension ImageBuffer where Sample == Luma
 			throw ImageError.WriteFailure("writeLuma: Aborting - not enough disk space to write Luma image (\(path)): free(\(freeBytes)) - data(\(dataBytes)) < \(limitBytes)")
 		}
 
-		try writeRaw(to: PathString(imageUrl.path), binaryHeader: data, async: async)
+		// Generate a filename
+		return path + "\(largestFileNumber)-\(fileBase).\(fileExtension)"
 	}
 }
@@ -0,0 +1,170 @@
+//
+//  LumaArchive.swift
+//  Seer
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+import Foundation
+#if os(iOS)
+import NativeTasksIOS
+import MinionIOS
+#else
+import NativeTasks
+import Minion
+#endif
+
+/// Writes a sequence of frames to a single luma archive (`.lumas`)
+///
+/// Writing a `.luma` file per frame means a directory scan, a file creation and a filesystem extension for every frame. An
+/// archive is located and numbered once (as `writeLuma()` would locate a `.luma` file), after which appending a frame only copies
+/// it; the native writer (see `nativeLumaArchiveWriterCreate()`) does the writing in the background, into preallocated space,
+/// losslessly compressing each frame along the way (see `Config.diagnosticLumaArchiveCompression`.)
+///
+/// Each frame is stored with the same header data as a `.luma` file (by default, the current temporal state.) Archives are read
+/// with `LumaArchiveReader`, and can be replayed wherever `.luma` files can.
+public final class LumaArchiveWriter
+{
+	/// The file extension for luma archives
+	public static let fileExtension = "lumas"
+
+	/// The path of the archive
+	public let path: PathString
+
+	/// The number of frames appended
+	public private(set) var count = 0
+
+	/// The native writer, or nil once closed
+	private var writer: UnsafeMutableRawPointer?
+
+	/// Creates a new archive with a base name of `fileBase`, located and numbered as `writeLuma()` locates `.luma` files
+	///
+	/// Space is preallocated `preallocateMB` at a time (0 for the native default), and at least that much must be available
+	/// beyond `reservedMB`. Frames are compressed if `compress` is set.
+	///
+	/// Throws ImageError.WriteFailure if the archive cannot be created
+	public init(to fileBase: String, reservedMB: Int = Config.systemReservedDiskSpaceMB, preallocateMB: Int = 0,
+	            compress: Bool = Config.diagnosticLumaArchiveCompression) throws
+	{
+		let preallocationBytes = UInt64(preallocateMB) * 1024 * 1024
+		path = try LumaBuffer.locateNumberedLumaPath(for: fileBase, fileExtension: LumaArchiveWriter.fileExtension,
+		                                             reservedMB: reservedMB, dataBytes: preallocationBytes)
+
+		guard let writer = nativeLumaArchiveWriterCreate(path.toString(), preallocationBytes, compress) else
+		{
+			throw ImageError.WriteFailure("Unable to create luma archive: \(path)")
+		}
+
+		self.writer = writer
+		gLogger.info("Writing luma archive: \(path)")
+	}
+
+	deinit
+	{
+		close()
+	}
+
+	/// Appends `image` to the archive
+	///
+	/// `withHeaderData` is stored with the frame as it would be with a `.luma` file; if `nil`, the current temporal state
+	/// information is used (see `writeLuma()`.)
+	///
+	/// Returns false if the archive is closed or the frame could not be written
+	@discardableResult
+	public func append(_ image: LumaBuffer, withHeaderData headerData: Data? = nil) -> Bool
+	{
+		guard let writer = writer else { return false }
+
+		let header = headerData ?? LumaBuffer.temporalStateHeaderData()
+		let appended = header.withUnsafeBytes
+		{
+			nativeLumaArchiveWriterAppend(writer, image.buffer, UInt32(image.width), UInt32(image.height), $0.baseAddress, UInt32(header.count))
+		}
+
+		if appended { count += 1 }
+		return appended
+	}
+
+	/// Finishes writing the archive and closes it (does nothing if already closed)
+	///
+	/// Returns false if any part of the archive failed to write
+	@discardableResult
+	public func close() -> Bool
+	{
+		guard let writer = writer else { return true }
+		self.writer = nil
+
+		if !nativeLumaArchiveWriterClose(writer)
+		{
+			gLogger.error("Failed to write luma archive: \(path)")
+			return false
+		}
+
+		gLogger.info("Wrote luma archive (\(count) frames): \(path)")
+		return true
+	}
+}
+
+/// Reads the frames of a luma archive (see `LumaArchiveWriter`)
+///
+/// The archive is mapped into memory, and any frame can be read directly. An archive that was never closed (for example, the
+/// process ended while writing it) is still readable, up to its last complete frame.
+public final class LumaArchiveReader
+{
+	/// The path of the archive
+	public let path: PathString
+
+	/// The number of frames in the archive
+	public let count: Int
+
+	/// The native reader
+	private let reader: UnsafeMutableRawPointer
+
+	/// Opens the archive at `path`
+	///
+	/// Throws ImageError.Conversion if the file cannot be read as a luma archive
+	public init(path: PathString) throws
+	{
+		guard let reader = nativeLumaArchiveReaderOpen(path.toString()) else
+		{
+			gLogger.error("Unable to open luma archive: \(path)")
+			throw ImageError.Conversion
+		}
+
+		self.path = path
+		self.reader = reader
+		count = Int(nativeLumaArchiveReaderFrameCount(reader))
+	}
+
+	deinit
+	{
+		nativeLumaArchiveReaderClose(reader)
+	}
+
+	/// Returns the frame at `index` and its header data (as the user data of a `.luma` file), or nil if out of range or invalid
+	///
+	/// The image wraps the archive's mapped memory, so no samples are copied; it remains valid for as long as this reader exists.
+	/// A compressed frame is decoded into memory owned by the reader instead, and so is only valid until the next frame is read.
+	/// Either way, the image may be modified without changing the file.
+	public func frame(at index: Int) -> (image: LumaBuffer, userData: Data)?
+	{
+		if index < 0 || index >= count { return nil }
+
+		var frame = NativeLumaArchiveFrame()
+		if !nativeLumaArchiveReaderFrame(reader, UInt32(index), &frame) { return nil }
+		guard let luma = frame.luma else { return nil }
+
+		var userData = Data()
+		if let header = frame.header, frame.headerSize > 0
+		{
+			userData = Data(bytes: header, count: Int(frame.headerSize))
+		}
+
+		return (LumaBuffer(width: Int(frame.width), height: Int(frame.height), buffer: luma), userData)
+	}
+}
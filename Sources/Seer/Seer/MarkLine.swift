@@ -98,48 +98,43 @@ final class MarkLine
 	// Utilitarian
 	// -----------------------------------------------------------------------------------------------------------------------------
 
-	/// Returns a new bitColumn which has been resampled to a new length
+	/// Resamples our bitColumn to `resampleCount` bits, packing them into `packed` eight bits to a byte
 	///
-	/// The caller is responsible for freeing the memory from the returned array when they are done with it.
-	///
-	/// If the original bit column is already at the length requested, then a new bitColumn is allocated and the contents of this
-	/// MarkLine's bitColumn is simply copied over.
+	/// Resampled bit `i` is stored in bit `i % 8` of `packed[(i / 8) * stride]`, so that the bit columns of a set of MarkLines
+	/// can be interleaved (see `MarkLines.generateBitWords()`.) Every byte is written in full, so `packed` must have room for
+	/// `(resampleCount + 7) / 8` bytes, `stride` bytes apart.
 	///
 	/// As the original array is an array of boolean values, the resample must choose nearest neighbor. It does this via a proper
-	/// rounding method (optimized).
-	func resampledBitColumn(to resampleCount: Int) -> UnsafeMutableArray<Bool>
+	/// rounding method (optimized). If the original bit column is already at the length requested, this steps through it one bit
+	/// at a time.
+	func packResampledBitColumn(to resampleCount: Int, into packed: UnsafeMutablePointer<UInt8>, stride: Int)
 	{
 		// We must have a bit column
 		assert(bitColumn != nil)
+		let bits = bitColumn!._rawPointer
 
-		// Allocate a new bitColumns array
-		var newBits = UnsafeMutableArray<Bool>(withCapacity: resampleCount)
-
-		// If our column is already the correct length, just return it
-		if bitColumn!.count == resampleCount
-		{
-			newBits.assign(from: bitColumn!._rawPointer, count: bitColumn!.count)
-		}
-		else
-		{
-			// Delta through the bits
-			let delta = bitColumn!.count.toFixed() / resampleCount.toFixed()
+		// Delta through the bits
+		let delta = bitColumn!.count.toFixed() / resampleCount.toFixed()
 
-			// Similar to the approach used by Bresenham line drawing, we add half the delta in order to center our error inside
-			// the full range.
-			var index = delta >> 1
+		// Similar to the approach used by Bresenham line drawing, we add half the delta in order to center our error inside
+		// the full range.
+		var index = delta >> 1
 
-			for _ in 0..<resampleCount
+		var bit = 0
+		var byteOffset = 0
+		while bit < resampleCount
+		{
+			var byte: UInt8 = 0
+			for shift in 0..<UInt8(min(8, resampleCount - bit))
 			{
-				newBits.add(bitColumn![index.floor()])
+				byte |= (bits[index.floor()] ? 1 : 0) << shift
 				index += delta
 			}
-		}
 
-		// Sanity check
-		assert(newBits.count == resampleCount)
-
-		return newBits
+			packed[byteOffset] = byte
+			byteOffset += stride
+			bit += 8
+		}
 	}
 }
 
@@ -11,6 +11,11 @@
 // in the LICENSE file in the root of the source tree.
 
 import Foundation
+#if os(iOS)
+import NativeTasksIOS
+#else
+import NativeTasks
+#endif
 
 // ---------------------------------------------------------------------------------------------------------------------------------
 // Local constants
@@ -36,6 +41,9 @@ public final class MarkLines
 	/// The growth scalar for all allocations used by the MarkLines
 	private static let kAllocationGrowthScalar: FixedPoint = 2
 
+	/// The number of rows in each group of packed bit columns: one for each bit of a BitWord (see `resampleBitColumns(to:)`)
+	private static let kPackedBitRows = MemoryLayout<BitWord>.size * 8
+
 	// -----------------------------------------------------------------------------------------------------------------------------
 	// Properties
 	// -----------------------------------------------------------------------------------------------------------------------------
@@ -46,11 +54,12 @@ public final class MarkLines
 	/// will grow only when necessary.
 	private var bitWords = UnsafeMutableArray<BitWord>(withCapacity: 1024)
 
-	/// Our resampled bit columns, stored in a static to avoid re-allocation when not necessary
+	/// Our resampled bit columns, packed eight to a byte and interleaved for transposing (see `generateBitWords()`), stored in a
+	/// static to avoid re-allocation when not necessary
 	///
 	/// It is initialized to an arbitrary capacity, which will get resized on the first run to a more representative capacity and
 	/// will grow only when necessary.
-	private var resampledBitColumns = StaticMatrix<Bool>(rowCapacity: 1024, colCapacity: 25)
+	private var packedBitColumns = UnsafeMutableArray<UInt8>(withCapacity: 4096)
 
 	/// Storage for the bit marks when generating contoured mark lines
 	private var bitMarkMatrix = StaticMatrix<Sample>(rowCapacity: 25, colCapacity: 1024)
@@ -226,48 +235,18 @@ public final class MarkLines
 		// Do we need to grow our matrix?
 		bitMarkMatrix.ensureReservation(rowCapacity: bitCount, colCapacity: scanlineCount, colGrowthScalar: MarkLines.kAllocationGrowthScalar)
 
-		if invertSampleLuma
-		{
-			for scanlineIndex in 0..<scanlineCount
-			{
-				let lPoint = lCenters[(lCentersDeltaIndex * scanlineIndex).floor()].toVector()
-				let rPoint = rCenters[(rCentersDeltaIndex * scanlineIndex).floor()].toVector()
-				let normal = (rPoint - lPoint).normal()
-
-				// Collect the samples for each column of bits
-				for bit in 0..<bitCount
-				{
-					let bitMarkCenter = normalizedBitMarkCenters[bit]
-					let bitLoc = lPoint + (rPoint - lPoint) * bitMarkCenter
-					let b = Sample(Luma(255)-lumaBuffer.sample(from: (bitLoc         ).chopToPoint())!)
-					let a = Sample(Luma(255)-lumaBuffer.sample(from: (bitLoc - normal).chopToPoint())!)
-					let c = Sample(Luma(255)-lumaBuffer.sample(from: (bitLoc + normal).chopToPoint())!)
-					let sample = (a + b * 6 + c) / 8
-					bitMarkMatrix.add(toRow: bit, value: sample)
-				}
+		// Collect the samples for each column of bits, scanline by scanline, weighting each with its neighbors along the scanline
+		let sampledCount = lCenters._rawPointer.withMemoryRebound(to: NativePoint.self, capacity: lCenters.count)
+		{ lNativeCenters in
+			rCenters._rawPointer.withMemoryRebound(to: NativePoint.self, capacity: rCenters.count)
+			{ rNativeCenters in
+				nativeSampleBitColumns(lumaBuffer.buffer, UInt32(lumaBuffer.width), UInt32(lumaBuffer.height), lNativeCenters, UInt32(lCenters.count), rNativeCenters, UInt32(rCenters.count), normalizedBitMarkCenters, UInt32(bitCount), invertSampleLuma, bitMarkMatrix.elements, UInt32(bitMarkMatrix.colCapacity))
 			}
 		}
-		else
-		{
-			for scanlineIndex in 0..<scanlineCount
-			{
-				let lPoint = lCenters[(lCentersDeltaIndex * scanlineIndex).floor()].toVector()
-				let rPoint = rCenters[(rCentersDeltaIndex * scanlineIndex).floor()].toVector()
-				let normal = (rPoint - lPoint).normal()
 
-				// Collect the samples for each column of bits
-				for bit in 0..<bitCount
-				{
-					let bitMarkCenter = normalizedBitMarkCenters[bit]
-					let bitLoc = lPoint + (rPoint - lPoint) * bitMarkCenter
-					let b = Sample(lumaBuffer.sample(from: (bitLoc         ).chopToPoint())!)
-					let a = Sample(lumaBuffer.sample(from: (bitLoc - normal).chopToPoint())!)
-					let c = Sample(lumaBuffer.sample(from: (bitLoc + normal).chopToPoint())!)
-					let sample = (a + b * 6 + c) / 8
-					bitMarkMatrix.add(toRow: bit, value: sample)
-				}
-			}
-		}
+		// A sample outside the image means the landmark centers have wandered off of it
+		if sampledCount == 0 { return false }
+		bitMarkMatrix.setColCounts(Int(sampledCount), rowCount: bitCount)
 
 		let lTop = lCenters[0].toVector()
 		let rTop = rCenters[0].toVector()
@@ -319,32 +298,23 @@ public final class MarkLines
 	/// This function will return nil if an error occurs.
 	func generateBitWords(maxCardCount: Int) -> UnsafeMutableArray<BitWord>?
 	{
+		// If you hit this assert, you have too many bit columns to fit within the value return type
+		assert(markLines.count <= MarkLines.kPackedBitRows)
+		if markLines.count > MarkLines.kPackedBitRows { return nil }
+
 		// Get a resampled set of bit columns
 		let columnCount = (Config.decodeResampleBitColumnLengthMultiplier * maxCardCount).floor()
-		guard let bitColumns = resampleBitColumns(to: columnCount) else { return nil }
-		let colCount = bitColumns.colCount(row: 0)
-
-		// If you hit this assert, you have too many bit columns to fit within the value return type
-		assert(bitColumns.rowCapacity <= MemoryLayout<BitWord>.size * 8)
-		if bitColumns.rowCapacity > MemoryLayout<BitWord>.size * 8 { return nil }
+		if !resampleBitColumns(to: columnCount) { return nil }
 
 		// Setup our value array
-		bitWords.ensureReservation(capacity: colCount, growthScalar: MarkLines.kAllocationGrowthScalar)
+		bitWords.ensureReservation(capacity: columnCount, growthScalar: MarkLines.kAllocationGrowthScalar)
 
-		// Scan the each row of bits in the mark lines, combining bits into a single word for each bit in the column
-		for i in 0..<colCount
+		// Combine the bits from each mark line into a single word for each bit in the column, by transposing the packed bits
+		bitWords._rawPointer.withMemoryRebound(to: UInt32.self, capacity: columnCount)
 		{
-			var value: BitWord = 0
-			for j in 0..<count
-			{
-				if bitColumns[j, i]
-				{
-					value += 1 << BitWord(j)
-				}
-			}
-
-			bitWords.add(value)
+			nativeTransposeBitColumns(packedBitColumns._rawPointer, UInt32(columnCount), $0)
 		}
+		bitWords.count = columnCount
 
 		return bitWords
 	}
@@ -387,33 +357,30 @@ public final class MarkLines
 	// Utilitarian
 	// -----------------------------------------------------------------------------------------------------------------------------
 
-	/// Returns an array of identical-length bit columns
+	/// Resamples the bit columns of every MarkLine to `resampleCount` bits, packing them into `packedBitColumns`
 	///
-	/// The length of each array returned will be equal to the length of the longest bit column from the original set of MarkLines.
-	/// In order to do this, the bits are resampled (see MarkLine.resampledBits() for details on how this is done.)
+	/// The bits are packed in groups of eight columns, with one byte for each of `kPackedBitRows` rows in each group; bit `j` of
+	/// byte `i` of group `g` is bit `g * 8 + j` of MarkLine `i`'s resampled bit column. Rows without a MarkLine are zero. The
+	/// bits are resampled with MarkLine.packResampledBitColumn() (see that method for details on how this is done.)
 	///
-	/// This routine will return nil if there are no bit columns to resample (it will not return an empty array.)
-	private func resampleBitColumns(to resampleCount: Int) -> StaticMatrix<Bool>?
+	/// This routine will return false if there are no bit columns to resample.
+	private func resampleBitColumns(to resampleCount: Int) -> Bool
 	{
 		// Sanity check
-		if resampleCount == 0 || markLines.count == 0 { return nil }
+		if resampleCount == 0 || markLines.count == 0 { return false }
 
-		// Do we need to grow our matrix?
-		resampledBitColumns.ensureReservation(rowCapacity: markLines.count, colCapacity: resampleCount, colGrowthScalar: MarkLines.kAllocationGrowthScalar)
+		// Do we need to grow our packed bits?
+		let packedCount = (resampleCount + 7) / 8 * MarkLines.kPackedBitRows
+		packedBitColumns.ensureReservation(capacity: packedCount, growthScalar: MarkLines.kAllocationGrowthScalar)
+		packedBitColumns.initialize(to: 0, count: packedCount)
 
-		// Resample each MarkLine. Note that the resample process will return its own array if no resample is needed
+		// Resample each MarkLine straight into its row of the packed bits
 		for markLineIndex in 0..<markLines.count
 		{
-			var bitColumn = markLines[markLineIndex].resampledBitColumn(to: resampleCount)
-			for bitColumnIndex in 0..<bitColumn.count
-			{
-				resampledBitColumns.add(toRow: markLineIndex, value: bitColumn[bitColumnIndex])
-			}
-			bitColumn.free()
+			markLines[markLineIndex].packResampledBitColumn(to: resampleCount, into: packedBitColumns._rawPointer + markLineIndex, stride: MarkLines.kPackedBitRows)
 		}
 
-		// Return the newly resampled bit columns, or nil if there aren't any
-		return resampledBitColumns
+		return true
 	}
 
 	// -----------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,300 @@
+//
+//  MarkSets.swift
+//  Seer
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+import Foundation
+#if os(iOS)
+import MinionIOS
+#else
+import Minion
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Mark set files
+//
+// A mark set is the set of MarkLocations found along a single search line, just as the deck search hands them to
+// `CodeDefinition.bestMatch()`. A mark set file holds every set from a scan, so that the matcher can be verified and timed on
+// the marks of real frames without scanning them again. All values are big-endian (see `Encodable`):
+//
+//		UInt32		Magic (`kMagic`)
+//		UInt16		Version (`kVersion`)
+//		String		The name of the CodeDefinition that was scanned for
+//
+// Followed by each mark set:
+//
+//		UInt16		The number of marks in the set
+//
+// Followed by each mark in the set:
+//
+//		Int32		The mark's scan index
+//		Int32 x 5	The mark's start Edge: sample offset, slope, threshold, point x, point y
+//		Int32 x 5	The mark's end Edge (as above)
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// The identifying magic of a mark set file ("MKST")
+private let kMagic: UInt32 = 0x4D4B5354
+
+/// The version of the mark set file format
+private let kVersion: UInt16 = 1
+
+/// The number of bytes that each mark is encoded with
+private let kEncodedMarkBytes = 44
+
+/// Records the mark sets that the deck search matches, for writing to a mark set file (see the notes above)
+///
+/// Recording is enabled by setting `active` before scanning starts, and disabled by clearing it once scanning is done. Search
+/// lines may be evaluated on multiple threads, so sets are recorded in the order they happen to be matched.
+public final class MarkSetRecorder
+{
+	/// The recorder that the deck search records to, or nil to record nothing
+	///
+	/// This must not be changed while scanning.
+	public static var active: MarkSetRecorder?
+
+	/// The path of the file to write
+	public let path: PathString
+
+	/// The number of mark sets recorded
+	public private(set) var count = 0
+
+	/// The file contents, as they are recorded
+	private var data = Data()
+
+	/// Guards `data` and `count`
+	private let mutex = PThreadMutex()
+
+	/// Prepares to record the mark sets matched against `codeDefinition`, to be written to `path` (see `write()`)
+	public init(path: PathString, codeDefinition: CodeDefinition)
+	{
+		self.path = path
+
+		_ = kMagic.encode(into: &data)
+		_ = kVersion.encode(into: &data)
+		_ = codeDefinition.encode(into: &data)
+	}
+
+	/// Records a set of MarkLocations
+	func record(_ markLocations: UnsafeMutableArray<MarkLocation>)
+	{
+		// Each set is encoded on its own, keeping it well within the limits of `Encodable`
+		var set = Data(capacity: 2 + markLocations.count * kEncodedMarkBytes)
+		var encoded = UInt16(exactly: markLocations.count)?.encode(into: &set) ?? false
+		for i in 0..<markLocations.count where encoded
+		{
+			let markLocation = markLocations[i]
+			encoded = Int32(markLocation.scanIndex).encode(into: &set) &&
+			          MarkSetRecorder.encode(markLocation.start, into: &set) &&
+			          MarkSetRecorder.encode(markLocation.end, into: &set)
+		}
+
+		if !encoded
+		{
+			gLogger.warn("MarkSetRecorder: Unable to record a set of \(markLocations.count) marks")
+			return
+		}
+
+		mutex.fastsync
+		{
+			data.append(set)
+			count += 1
+		}
+	}
+
+	/// Writes the mark sets recorded so far to `path`
+	///
+	/// Returns false if the file could not be written
+	public func write() -> Bool
+	{
+		let (contents, setCount) = mutex.fastsync { (data, count) }
+
+		do
+		{
+			try contents.write(to: path.toUrl())
+		}
+		catch
+		{
+			gLogger.error("Unable to write mark sets (\(error.localizedDescription)): \(path)")
+			return false
+		}
+
+		gLogger.info("Wrote \(setCount) mark sets: \(path)")
+		return true
+	}
+
+	/// Encodes the components of `edge` that the matcher relies on
+	private static func encode(_ edge: Edge, into data: inout Data) -> Bool
+	{
+		return Int32(edge.sampleOffset).encode(into: &data) &&
+		       edge.slope.encode(into: &data) &&
+		       edge.threshold.encode(into: &data) &&
+		       Int32(edge.point.x).encode(into: &data) &&
+		       Int32(edge.point.y).encode(into: &data)
+	}
+}
+
+/// Replays the mark sets from a mark set file (see the notes above) through the CodeDefinition they were recorded with
+///
+/// Every set is matched by `CodeDefinition.bestMatch()`, or by the original matcher it must agree with (see
+/// `CodeDefinition.referenceBestMatch()`.) Each set is matched as it would be in a scan, from its own frame's temporaries (see
+/// `FrameArena`.)
+public final class MarkSetPlayback
+{
+	/// The CodeDefinition that the sets were recorded with
+	public let codeDefinition: CodeDefinition
+
+	/// The number of mark sets
+	public var count: Int { return markSets.count }
+
+	/// The total number of marks, over all sets
+	public private(set) var markCount = 0
+
+	/// The mark sets
+	private var markSets = [UnsafeMutableArray<MarkLocation>]()
+
+	/// Loads the mark sets from `path`
+	///
+	/// Returns nil if the file cannot be read, or if its CodeDefinition is unknown
+	public init?(path: PathString)
+	{
+		guard let data = try? Data(contentsOf: path.toUrl()) else
+		{
+			gLogger.error("Unable to read mark sets: \(path)")
+			return nil
+		}
+
+		var consumed = 0
+		guard data.count >= 6,
+		      UInt32.decode(from: data, consumed: &consumed) == kMagic,
+		      UInt16.decode(from: data, consumed: &consumed) == kVersion else
+		{
+			gLogger.error("Not a mark set file: \(path)")
+			return nil
+		}
+
+		guard let codeDefinition = CodeDefinition.decode(from: data, consumed: &consumed) else
+		{
+			gLogger.error("Mark sets were recorded with an unknown code definition: \(path)")
+			return nil
+		}
+
+		self.codeDefinition = codeDefinition
+
+		while consumed + 2 <= data.count
+		{
+			guard let setMarkCount = UInt16.decode(from: data, consumed: &consumed) else { break }
+			if consumed + Int(setMarkCount) * kEncodedMarkBytes > data.count
+			{
+				gLogger.warn("Ignoring a truncated mark set at the end of: \(path)")
+				break
+			}
+
+			var markSet = UnsafeMutableArray<MarkLocation>(withCapacity: Int(setMarkCount))
+			for _ in 0..<Int(setMarkCount)
+			{
+				let scanIndex = Int(Int32.decode(from: data, consumed: &consumed)!)
+				let start = MarkSetPlayback.decodeEdge(from: data, consumed: &consumed)
+				let end = MarkSetPlayback.decodeEdge(from: data, consumed: &consumed)
+				markSet.add(MarkLocation(start: start, end: end, scanIndex: scanIndex))
+			}
+
+			markSets.append(markSet)
+			markCount += markSet.count
+		}
+	}
+
+	deinit
+	{
+		for i in 0..<markSets.count
+		{
+			markSets[i].free()
+		}
+	}
+
+	/// Matches every set, returning the number of sets that matched
+	///
+	/// The sets are matched with `CodeDefinition.referenceBestMatch()` if `reference` is set, otherwise with
+	/// `CodeDefinition.bestMatch()`.
+	public func matchAll(reference: Bool = false) -> Int
+	{
+		var matchCount = 0
+		for markSet in markSets
+		{
+			let result = reference ? codeDefinition.referenceBestMatch(markLocations: markSet) : codeDefinition.bestMatch(markLocations: markSet)
+			if result != nil { matchCount += 1 }
+			FrameArena.instance.nextFrame()
+		}
+
+		return matchCount
+	}
+
+	/// Matches every set with both `CodeDefinition.bestMatch()` and `CodeDefinition.referenceBestMatch()`, returning the number
+	/// of sets for which they disagree
+	///
+	/// The two must choose the same marks, matched to the same MarkDefinitions, with exactly the same error. Each disagreement is
+	/// logged.
+	public func verify() -> Int
+	{
+		var mismatchCount = 0
+		for (setIndex, markSet) in markSets.enumerated()
+		{
+			let result = codeDefinition.bestMatch(markLocations: markSet)
+			let reference = codeDefinition.referenceBestMatch(markLocations: markSet)
+			if !MarkSetPlayback.isSameMatch(result, reference)
+			{
+				gLogger.error("MarkSetPlayback: Set \(setIndex) (\(markSet.count) marks) matched \(MarkSetPlayback.describe(result)), expected \(MarkSetPlayback.describe(reference))")
+				mismatchCount += 1
+			}
+
+			FrameArena.instance.nextFrame()
+		}
+
+		return mismatchCount
+	}
+
+	/// Returns true if `a` and `b` are the same match
+	private static func isSameMatch(_ a: DeckMatchResult?, _ b: DeckMatchResult?) -> Bool
+	{
+		guard let a = a, let b = b else { return a == nil && b == nil }
+		if a.error.bitPattern != b.error.bitPattern { return false }
+
+		let aMarks = a.deckLocation.markLocations
+		let bMarks = b.deckLocation.markLocations
+		if aMarks.count != bMarks.count { return false }
+		for i in 0..<aMarks.count
+		{
+			if aMarks[i].scanIndex != bMarks[i].scanIndex { return false }
+			if aMarks[i].matchedDefinitionIndex != bMarks[i].matchedDefinitionIndex { return false }
+		}
+
+		return true
+	}
+
+	/// Returns a description of a match (its marks by scan index, and its error) for logging
+	private static func describe(_ result: DeckMatchResult?) -> String
+	{
+		guard let result = result else { return "nothing" }
+		let marks = result.deckLocation.markLocations.map { "\($0.scanIndex)" }.joined(separator: ",")
+		return "marks[\(marks)] error[\(result.error)]"
+	}
+
+	/// Decodes an Edge encoded by `MarkSetRecorder.encode()`
+	///
+	/// The caller must ensure that the data holds the full Edge.
+	private static func decodeEdge(from data: Data, consumed: inout Int) -> Edge
+	{
+		let sampleOffset = Int(Int32.decode(from: data, consumed: &consumed)!)
+		let slope = RollValue.decode(from: data, consumed: &consumed)!
+		let threshold = RollValue.decode(from: data, consumed: &consumed)!
+		let x = Int(Int32.decode(from: data, consumed: &consumed)!)
+		let y = Int(Int32.decode(from: data, consumed: &consumed)!)
+		return Edge(slope: slope, sampleOffset: sampleOffset, threshold: threshold, point: IVector(x: x, y: y))
+	}
+}
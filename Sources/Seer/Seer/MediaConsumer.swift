@@ -27,6 +27,9 @@ public class MediaConsumer
 	/// The object responsible for validating the scanned deck against the known test deck order
 	public var resultValidator = ResultValidator()
 
+	/// Keeps the most recent frames, writing them out when a scan goes wrong (see `Config.diagnosticBlackBoxTriggers`)
+	public let frameRecorder = FrameRecorder()
+
 	/// The message used to send scan reports over UDP
 	private var udpScanReport = ScanReportMessage()
 
@@ -92,6 +95,9 @@ public class MediaConsumer
 	/// The number of frames scanned thus far
 	private var scanFrameCount = 0
 
+	/// The image sent as the Luma viewport, reused from one viewport to the next while its size stays the same
+	private var viewportImage: LumaBuffer?
+
 	/// Our mutex for processing
 	///
 	/// Generally, this is used to allow other threads to know when it is safe to modify stuff (such as the CodeDefinition) so they
@@ -225,14 +231,19 @@ public class MediaConsumer
 	///
 	/// This is the full processor, responsible for performing the actual scanning as well as any pre/postprocessing, sending
 	/// results to peers, updating stats and the viewport, etc.
-	public func processFrame(lumaBuffer: LumaBuffer, codeDefinition: CodeDefinition)
+	///
+	/// `frameRegion` is the region of the full camera frame covered by `lumaBuffer` (see `DeckSearch.FrameRegion`)
+	public func processFrame(lumaBuffer: LumaBuffer, codeDefinition: CodeDefinition, frameRegion: DeckSearch.FrameRegion = DeckSearch.FrameRegion())
 	{
 		scanFrameCount += 1
 
+		// Record the frame as it was captured (preprocessing modifies it)
+		frameRecorder.record(lumaBuffer: lumaBuffer, frameRegion: frameRegion, trackedDeckBounds: scanManager.trackedDeckBounds)
+
 		let debugBuffer = debugPreprocess(lumaBuffer: lumaBuffer)
 
 		// Scan this image and attempt to read the deck
-		let analysisResult = scanManager.scan(debugBuffer: debugBuffer, lumaBuffer: lumaBuffer, codeDefinition: codeDefinition)
+		let analysisResult = scanManager.scan(debugBuffer: debugBuffer, lumaBuffer: lumaBuffer, codeDefinition: codeDefinition, frameRegion: frameRegion)
 
 		// Update our last scan time
 		lastScanTimeMS = PausableTime.getTimeMS()
@@ -267,13 +278,18 @@ public class MediaConsumer
 			_ = resultValidator.validateResults(debugBuffer: debugBuffer, codeDefinition: codeDefinition, stats: &scanManager.resultStats, analysisResult: analysisResult)
 		}
 
+		frameRecorder.finishFrame(analysisResult: analysisResult, validationResult: Config.debugValidateResults ? resultValidator.lastValidationResult : nil)
+
 		// Update our diagnostic stats
 		mediaViewport?.updateStats(analysisResult: analysisResult, stats: scanManager.resultStats)
 
 		PerfTimer.trackEnd(name: "Debug", start: debugStart)
 
 		// Next frame
+		//
+		// Nothing from this frame's scan (including its results) uses the FrameArena beyond this point
 		PerfTimer.nextFrame()
+		FrameArena.instance.nextFrame()
 
 		debugPostprocess(debugBuffer: debugBuffer)
 	}
@@ -362,7 +378,16 @@ public class MediaConsumer
 			height = Int(Float(width) / ratio)
 		}
 
-		let newImage = LumaBuffer(width: width, height: height)
+		if viewportImage == nil || viewportImage!.width != width || viewportImage!.height != height
+		{
+			viewportImage = LumaBuffer(width: width, height: height)
+			FrameArena.instance.countPoolAllocation(fromHeap: true)
+		}
+		else
+		{
+			FrameArena.instance.countPoolAllocation(fromHeap: false)
+		}
+		let newImage = viewportImage!
 
 		let viewportType = ViewportMessage.ViewportType.fromUInt8(UInt8(Config.captureViewportType.rawValue))
 		switch viewportType
@@ -11,6 +11,11 @@
 // in the LICENSE file in the root of the source tree.
 
 import Foundation
+#if os(iOS)
+import NativeTasksIOS
+#else
+import NativeTasks
+#endif
 
 // -----------------------------------------------------------------------------------------------------------------------------
 // Local constants
@@ -201,82 +206,27 @@ extension UnsafeMutableArray where Element == MinMax<Sample>
 	///
 	/// If the `windowSize` is larger than `count`, then there isn't enough data to provide a single MinMax of the requested
 	/// `windowSize`. In that case, this function will return false. Otherwise, it will return true.
+	///
+	/// Implementation notes:
+	///
+	/// The rolling is performed by `nativeRollMinMax()`, which produces identical results to rolling a single min/max along the
+	/// samples (and re-scanning the window whenever its min or max rolls out.) That re-scan made the cost proportional to the
+	/// window size on the periodic patterns of a deck's marks, where the min/max rolls out on nearly every sample. The native
+	/// version costs the same per sample for any window size or pattern. See `nativebench minmax` for the comparison.
 	public mutating func rollMinMax(samples: UnsafeMutableArray<Sample>, count inCount: Int, windowSize inWindowSize: Int) -> Bool
 	{
 		// Ensure we have sane input
-		if samples.count <= 0 { return false }
-
-		// Clamp the windowSize to count
-		let windowSize = min(inWindowSize, samples.count)
+		if samples.count <= 0 || inWindowSize <= 0 { return false }
 
 		// Clear out the data and ensure we have enough room
 		ensureReservation(capacity: samples.count, growthScalar: kCapacityGrowthScalar)
 
-		// Prime our rolling min/max with the first full window
-		var minMax = MinMax(with: samples[0])
-		for i in 0..<windowSize
-		{
-			minMax.update(with: samples[i])
-		}
-
-		// Roll the min/max
-		//
-		// We loop through of the center samples of our rolling min/max, except the last one. We do this because the code
-		// in this loop ends with a rolling forward of the min/max. This min/max is then used in the following loop to
-		// write the last full rolling min/max value, and then continues to fill out the last halfWindowSize values.
-		let end = inCount - windowSize
-		var i = 0
-		while i < end
-		{
-			// Store the current min/max
-			add(minMax)
-
-			// Roll forward
-			let rollOutValue = samples[i]
-			let rollInValue = samples[i + windowSize]
-
-			// If we roll in a new min, we can skip the rolling process
-			if rollInValue <= minMax.min
-			{
-				minMax.min = rollInValue
-			}
-			// If our min must rolled out, re-calc
-			else if rollOutValue == minMax.min
-			{
-				minMax.min = rollInValue
-				let end = i + windowSize
-				for j in i+1..<end
-				{
-					let sample = samples[j]
-					if sample < minMax.min { minMax.min = sample }
-				}
-			}
-
-			// If we roll in a new max, we can skip the rolling process
-			if rollInValue >= minMax.max
-			{
-				minMax.max = rollInValue
-			}
-			// If our max must rolled out, re-calc
-			else if rollOutValue == minMax.max
-			{
-				minMax.max = rollInValue
-				let end = i + windowSize
-				for j in i+1..<end
-				{
-					let sample = samples[j]
-					if minMax.max < sample { minMax.max = sample }
-				}
-			}
-
-			i += 1
-		}
-
-		// Populate the last full averaged sample, and then our lead-out samples
-		for _ in end..<inCount
+		// MinMax<Sample> shares its layout with NativeMinMax
+		let minMaxCount = _rawPointer.withMemoryRebound(to: NativeMinMax.self, capacity: capacity)
 		{
-			add(minMax)
+			return nativeRollMinMax(samples._rawPointer, UInt32(samples.count), UInt32(Swift.max(inCount, 0)), UInt32(inWindowSize), $0)
 		}
+		count = Int(minMaxCount)
 
 		return true
 	}
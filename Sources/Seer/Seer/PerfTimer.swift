@@ -274,6 +274,27 @@ public final class PerfTimer
 			timing += String(format: " res:%5.2f", arguments: [resolveMS])
 			timing += ")"
 
+			// Parallel search: the share of each batch of search lines that the workers spent busy
+			if let linesMS = getStat(name: "Search Lines", useAverage: useAverage), linesMS > 0
+			{
+				var workerCount = 0
+				var busyMS: Real = 0
+				while let workerMS = getStat(name: "Search Worker \(workerCount)", useAverage: useAverage)
+				{
+					busyMS += workerMS
+					workerCount += 1
+				}
+
+				if workerCount > 0
+				{
+					timing += String(format: " par:%3.0f%%", arguments: [Float(busyMS * 100 / (linesMS * Real(workerCount)))])
+				}
+			}
+
+			// Frame temporaries: allocations served during the last frame, and how many needed the heap (see `FrameArena`)
+			let frameArena = FrameArena.instance
+			timing += String(format: " alc:%d/%d", arguments: [frameArena.lastFrameAllocations, frameArena.lastFrameHeapAllocations])
+
 			if let reportMS = getStat(name: "Report", useAverage: useAverage)
 			{
 				timing += String(format: " rprt:%4.1f", arguments: [Float(reportMS)])
@@ -20,138 +20,138 @@ public struct ResultStats
 	//
 
 	/// Number of decks found
-	var searchDecodableCount = 0
+	public internal(set) var searchDecodableCount = 0
 
 	/// The total number of frames that were ignored from the search (ex: too small)
-	var searchTooSmallCount = 0
+	public internal(set) var searchTooSmallCount = 0
 
 	/// The total number of frames that we were unable to find a deck to scan
-	var searchNotFoundCount = 0
+	public internal(set) var searchNotFoundCount = 0
 
 	/// Total number of decks found (includes decodable and too small)
-	var searchFoundCount: Int { return searchDecodableCount + searchTooSmallCount }
+	public var searchFoundCount: Int { return searchDecodableCount + searchTooSmallCount }
 
 	/// The total number of searches
-	var searchTotalCount: Int { return searchFoundCount + searchNotFoundCount }
+	public var searchTotalCount: Int { return searchFoundCount + searchNotFoundCount }
 
 	/// Percentage of decks found from all searches
-	var searchFoundPercent: Real { return searchTotalCount == 0 ? 0 : Real(searchFoundCount) / Real(searchTotalCount) }
+	public var searchFoundPercent: Real { return searchTotalCount == 0 ? 0 : Real(searchFoundCount) / Real(searchTotalCount) }
 
 	//
 	// Deck decoding
 	//
 
 	/// The number of decoded frames (correct or not)
-	var decodeDecodedCount = 0
+	public internal(set) var decodeDecodedCount = 0
 
 	/// The total number of frames that were ignored during decoding (ex: not sharp enough)
-	var decodeBlurryCount = 0
+	public internal(set) var decodeBlurryCount = 0
 
 	/// The total number of frames that contained too few cards
-	var decodeTooFewCardsCount = 0
+	public internal(set) var decodeTooFewCardsCount = 0
 
 	/// The total number of frames that encountered a general decode failure
-	var decodeGeneralFailureCount = 0
+	public internal(set) var decodeGeneralFailureCount = 0
 
 	/// The total number of decodes
-	var decodeTotalCount: Int { return decodeDecodedCount + decodeBlurryCount + decodeTooFewCardsCount + decodeGeneralFailureCount }
+	public var decodeTotalCount: Int { return decodeDecodedCount + decodeBlurryCount + decodeTooFewCardsCount + decodeGeneralFailureCount }
 
 	/// The percentage of total frames that were decoded
-	var decodeDecodedPercent: Real { return decodeTotalCount == 0 ? 0 : Real(decodeDecodedCount) / Real(decodeTotalCount) }
+	public var decodeDecodedPercent: Real { return decodeTotalCount == 0 ? 0 : Real(decodeDecodedCount) / Real(decodeTotalCount) }
 
 	//
 	// Analyzer stats
 	//
 
 	/// Total Fail history results
-	var analyzedFailureCount = 0
+	public internal(set) var analyzedFailureCount = 0
 
 	/// Total inconclusive results
-	var analyzedInconclusiveCount = 0
+	public internal(set) var analyzedInconclusiveCount = 0
 
 	/// Total insufficient history results
-	var analyzedInsufficientHistoryCount = 0
+	public internal(set) var analyzedInsufficientHistoryCount = 0
 
 	/// Total insufficient confidence results
-	var analyzedInsufficientConfidenceCount = 0
+	public internal(set) var analyzedInsufficientConfidenceCount = 0
 
 	/// Total low-confidence results (these are reported)
-	var analyzedReportLowConfidenceCount = 0
+	public internal(set) var analyzedReportLowConfidenceCount = 0
 
 	/// Total high-confidence results (these are reported)
-	var analyzedReportHighConfidenceCount = 0
+	public internal(set) var analyzedReportHighConfidenceCount = 0
 
 	/// Total unsufficient results: no confidence, very low low confidence, or determined to be probably incorrect
-	var analyzedInsufficientTotal: Int { return analyzedInsufficientHistoryCount + analyzedInsufficientConfidenceCount }
+	public var analyzedInsufficientTotal: Int { return analyzedInsufficientHistoryCount + analyzedInsufficientConfidenceCount }
 
 	/// Total reports: Suggested to report to the user, with either low or high confidence
-	var analyzedReportsTotal: Int { return analyzedReportLowConfidenceCount + analyzedReportHighConfidenceCount }
+	public var analyzedReportsTotal: Int { return analyzedReportLowConfidenceCount + analyzedReportHighConfidenceCount }
 
 	/// Total number of results analyzed
-	var analyzedTotal: Int { return analyzedInconclusiveCount + analyzedInsufficientTotal + analyzedReportsTotal + analyzedFailureCount }
+	public var analyzedTotal: Int { return analyzedInconclusiveCount + analyzedInsufficientTotal + analyzedReportsTotal + analyzedFailureCount }
 
 	/// Percentage of reports from total number of analyzed results
-	var analyzedReportPercent: Real { return analyzedTotal == 0 ? 0 : Real(analyzedReportsTotal) / Real(analyzedTotal) }
+	public var analyzedReportPercent: Real { return analyzedTotal == 0 ? 0 : Real(analyzedReportsTotal) / Real(analyzedTotal) }
 
 	//
 	// Validation (decoding)
 	//
 
 	/// The number of missed cards
-	var validatedDecodeMissedCardCount = 0
+	public internal(set) var validatedDecodeMissedCardCount = 0
 
 	/// The number of out of order cards
-	var validatedDecodeOutOfOrderCardCount = 0
+	public internal(set) var validatedDecodeOutOfOrderCardCount = 0
 
 	/// The number of correct results
-	var validatedDecodeCorrectCount = 0
+	public internal(set) var validatedDecodeCorrectCount = 0
 
 	/// The number of incorrect results
-	var validatedDecodeIncorrectCount = 0
+	public internal(set) var validatedDecodeIncorrectCount = 0
 
 	/// The total number of correct + incorrect decodes
-	var validatedDecodeTotalCount: Int { return validatedDecodeCorrectCount + validatedDecodeIncorrectCount }
+	public var validatedDecodeTotalCount: Int { return validatedDecodeCorrectCount + validatedDecodeIncorrectCount }
 
 	/// The percentage of correct decodes
-	var validatedDecodeCorrectPercent: Real { return validatedDecodeTotalCount == 0 ? 0 : Real(validatedDecodeCorrectCount) / Real(validatedDecodeTotalCount) }
+	public var validatedDecodeCorrectPercent: Real { return validatedDecodeTotalCount == 0 ? 0 : Real(validatedDecodeCorrectCount) / Real(validatedDecodeTotalCount) }
 
 	//
 	// Validation (reporting)
 	//
 
 	/// The total number of incorrect reports
-	var validatedReportIncorrectCount = 0
+	public internal(set) var validatedReportIncorrectCount = 0
 
 	/// The total number of correct low-confidence reports
-	var validatedReportCorrectLowConfidenceCount = 0
+	public internal(set) var validatedReportCorrectLowConfidenceCount = 0
 
 	/// The total number of correct high-confidence reports
-	var validatedReportCorrectHighConfidenceCount = 0
+	public internal(set) var validatedReportCorrectHighConfidenceCount = 0
 
 	/// The total number of correct reports (high + low confidence)
-	var validatedReportCorrectCount: Int { return validatedReportCorrectLowConfidenceCount + validatedReportCorrectHighConfidenceCount }
+	public var validatedReportCorrectCount: Int { return validatedReportCorrectLowConfidenceCount + validatedReportCorrectHighConfidenceCount }
 
 	/// The total number of reports (correct + incorrect)
-	var validatedReportTotalCount: Int { return validatedReportCorrectCount + validatedReportIncorrectCount }
+	public var validatedReportTotalCount: Int { return validatedReportCorrectCount + validatedReportIncorrectCount }
 
 	/// The percentage of correct reports
-	var validatedReportCorrectPercent: Real { return validatedReportTotalCount == 0 ? 0 : Real(validatedReportCorrectCount) / Real(validatedReportTotalCount) }
+	public var validatedReportCorrectPercent: Real { return validatedReportTotalCount == 0 ? 0 : Real(validatedReportCorrectCount) / Real(validatedReportTotalCount) }
 
 	//
 	// Validation (overall scanning process)
 	//
 
 	/// Total number of scans considered valid
-	var validatedScanCorrectCount: Int { return validatedDecodeCorrectCount + decodeBlurryCount + decodeTooFewCardsCount + searchTooSmallCount }
+	public var validatedScanCorrectCount: Int { return validatedDecodeCorrectCount + decodeBlurryCount + decodeTooFewCardsCount + searchTooSmallCount }
 
 	/// Total number of scans considered invalid
-	var validatedScanIncorrectCount: Int { return validatedDecodeIncorrectCount + decodeTooFewCardsCount + decodeGeneralFailureCount }
+	public var validatedScanIncorrectCount: Int { return validatedDecodeIncorrectCount + decodeTooFewCardsCount + decodeGeneralFailureCount }
 
 	/// Total number of scans performed
-	var validatedScanTotalCount: Int { return validatedScanCorrectCount + validatedScanIncorrectCount }
+	public var validatedScanTotalCount: Int { return validatedScanCorrectCount + validatedScanIncorrectCount }
 
 	/// Percentage of valid scans from found decks
-	var validatedScanCorrectPercent: Real { return validatedScanTotalCount == 0 ? 0 : Real(validatedScanCorrectCount) / Real(validatedScanTotalCount) }
+	public var validatedScanCorrectPercent: Real { return validatedScanTotalCount == 0 ? 0 : Real(validatedScanCorrectCount) / Real(validatedScanTotalCount) }
 
 	//
 	// Total number of frames processed
@@ -20,6 +20,9 @@ import Minion
 /// Performs validation on decoded deck results, using the known deck order from the test harness
 public final class ResultValidator
 {
+	/// The result of the most recent validation, or nil if the most recent result could not be validated (e.g., it was a failure)
+	public private(set) var lastValidationResult: ValidationResult?
+
 	// We need a public initializer in order to use this externally
 	public init()
 	{
@@ -37,6 +40,7 @@ public final class ResultValidator
 	/// Returns true if the results were determined to be correct
 	public func validateResults(debugBuffer: DebugBuffer?, codeDefinition: CodeDefinition, stats: inout ResultStats, analysisResult: AnalysisResult) -> Bool
 	{
+		lastValidationResult = nil
 		let result = internalValidateResults(debugBuffer: debugBuffer, codeDefinition: codeDefinition, stats: &stats, analysisResult: analysisResult)
 
 		if Config.debugDrawScanResults
@@ -75,6 +79,7 @@ public final class ResultValidator
 		let prefix = "  "
 		if validatedCorrect
 		{
+			lastValidationResult = .Correct
 			stats.validatedDecodeCorrectCount += 1
 
 			if gLogger.isSet(LogLevel.Correct)
@@ -84,6 +89,7 @@ public final class ResultValidator
 		}
 		else
 		{
+			lastValidationResult = .Incorrect(missingCards: missingCards, unorderedCards: unorderedCards, scannedComparison: scannedComparison, knownComparison: knownComparison)
 			stats.validatedDecodeIncorrectCount += 1
 			stats.validatedDecodeMissedCardCount += missingCards.count
 			stats.validatedDecodeOutOfOrderCardCount += unorderedCards.count
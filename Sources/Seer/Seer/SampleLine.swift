@@ -11,6 +11,11 @@
 // in the LICENSE file in the root of the source tree.
 
 import Foundation
+#if os(iOS)
+import NativeTasksIOS
+#else
+import NativeTasks
+#endif
 
 // ---------------------------------------------------------------------------------------------------------------------------------
 // Global types
@@ -365,7 +370,8 @@ public final class SampleLine
 	///
 	/// Implementation notes:
 	///
-	/// See `draw(to:color:)` for more information
+	/// The samples are collected by `nativeSampleLine()`, which walks the line as `draw(to:color:)` does. See `draw(to:color:)`
+	/// for more information.
 	func sample(from image: LumaBuffer, invertSampleLuma: Bool, p0 inP0: IVector? = nil, p1 inP1: IVector? = nil) -> Bool
 	{
 		// Are we given a new set of points?
@@ -381,84 +387,11 @@ public final class SampleLine
 		// Get ready...
 		prepareSampler(suggestedCapacity: interpolatedLength)
 
-		// Deltas
-		let dx = p1.x - p0.x
-		let dy = p1.y - p0.y
-		let absDX = abs(dx)
-		let absDY = abs(dy)
-		let width = image.width
-
-		// Primarily horizontal
-		let src = image.buffer
-		if absDX >= absDY
-		{
-			var x = p0.x
-			var y = p0.y.toFixed() + FixedPoint.kHalf
-			let endX = p1.x
-			let endY = p1.y.toFixed() + FixedPoint.kHalf
-			let xStep = dx >= 0 ? 1 : -1
-			let yStep = absDX == 0 ? 0 : dy.toFixed() / absDX
-
-			// Calculate our error epsilon and add it to the starting point
-			y += endY - (y + yStep * absDX)
-
-			if invertSampleLuma
-			{
-				samples.add(Sample(255-src[y.floor() * width + x]))
-				while x != endX
-				{
-					y += yStep
-					x += xStep
-					samples.add(255-Sample(src[y.floor() * width + x]))
-				}
-			}
-			else
-			{
-				samples.add(Sample(src[y.floor() * width + x]))
-				while x != endX
-				{
-					y += yStep
-					x += xStep
-					samples.add(Sample(src[y.floor() * width + x]))
-				}
-			}
-		}
-		// Primarily vertical
-		else // dy.abs() > dx.abs()
-		{
-			var x = p0.x.toFixed() + FixedPoint.kHalf
-			var y = p0.y * width
-			let endX = p1.x.toFixed() + FixedPoint.kHalf
-			let endY = p1.y * width
-			let xStep = absDY == 0 ? 0 : dx.toFixed() / absDY
-			let yStep = dy >= 0 ? width : -width
-
-			// Calculate our error epsilon and add it to the starting point
-			x += endX - (x + xStep * absDY)
-
-			if invertSampleLuma
-			{
-				samples.add(255-Sample(src[y + x.floor()]))
-				while y != endY
-				{
-					x += xStep
-					y += yStep
-					samples.add(255-Sample(src[y + x.floor()]))
-				}
-			}
-			else
-			{
-				samples.add(Sample(src[y + x.floor()]))
-				while y != endY
-				{
-					x += xStep
-					y += yStep
-					samples.add(Sample(src[y + x.floor()]))
-				}
-			}
-		}
+		// The native sampler walks the line exactly as `draw(to:color:)` does, a row at a time where it can
+		let count = nativeSampleLine(image.buffer, UInt32(image.width), UInt32(image.height), Int32(p0.x), Int32(p0.y), Int32(p1.x), Int32(p1.y), invertSampleLuma, samples._rawPointer)
+		samples.count = Int(count)
 
-		return true
+		return count != 0
 	}
 
 	/// Collects samples along the line from the given ImageBuffer, using a weighted average of the sample line with its neighbors
@@ -479,7 +412,8 @@ public final class SampleLine
 	///
 	/// Implementation notes:
 	///
-	/// See `draw(to:color:)` for more information
+	/// The samples are collected by `nativeSampleLineWide()`, which walks the line as `draw(to:color:)` does. See
+	/// `draw(to:color:)` for more information.
 	func sampleWide(from image: LumaBuffer, p0 inP0: IVector? = nil, p1 inP1: IVector? = nil) -> Bool
 	{
 		let kWideAmount = 2
@@ -498,67 +432,11 @@ public final class SampleLine
 		// Get ready...
 		prepareSampler(suggestedCapacity: interpolatedLength)
 
-		// Deltas
-		let dx = p1.x - p0.x
-		let dy = p1.y - p0.y
-		let absDX = abs(dx)
-		let absDY = abs(dy)
-		let width = image.width
-
-		// Primarily horizontal
-		let src = image.buffer
-		if absDX >= absDY
-		{
-			var x = p0.x
-			var y = p0.y.toFixed() + FixedPoint.kHalf
-			let endX = p1.x
-			let endY = p1.y.toFixed() + FixedPoint.kHalf
-			let xStep = dx >= 0 ? 1 : -1
-			let yStep = absDX == 0 ? 0 : dy.toFixed() / absDX
-
-			// Calculate our error epsilon and add it to the starting point
-			y += endY - (y + yStep * absDX)
+		// The native sampler walks the line exactly as `draw(to:color:)` does, a row at a time where it can
+		let count = nativeSampleLineWide(image.buffer, UInt32(image.width), UInt32(image.height), Int32(p0.x), Int32(p0.y), Int32(p1.x), Int32(p1.y), samples._rawPointer)
+		samples.count = Int(count)
 
-			samples.add(Sample(src[y.floor() * width + x]))
-			let wideWidth = width * kWideAmount
-			while x != endX
-			{
-				y += yStep
-				x += xStep
-				let idx = y.floor() * width + x
-				let a = Int(src[idx - wideWidth])
-				let b = Int(src[idx]) * 2
-				let c = Int(src[idx + wideWidth])
-				samples.add(Sample((a + b + c) / 4))
-			}
-		}
-		// Primarily vertical
-		else // dy.abs() > dx.abs()
-		{
-			var x = p0.x.toFixed() + FixedPoint.kHalf
-			var y = p0.y * width
-			let endX = p1.x.toFixed() + FixedPoint.kHalf
-			let endY = p1.y * width
-			let xStep = absDY == 0 ? 0 : dx.toFixed() / absDY
-			let yStep = dy >= 0 ? width : -width
-
-			// Calculate our error epsilon and add it to the starting point
-			x += endX - (x + xStep * absDY)
-
-			samples.add(Sample(src[y + x.floor()]))
-			while y != endY
-			{
-				y += yStep
-				x += xStep
-				let idx = y + x.floor()
-				let a = Int(src[idx - kWideAmount])
-				let b = Int(src[idx]) * 2
-				let c = Int(src[idx + kWideAmount])
-				samples.add(Sample((a + b + c) / 4))
-			}
-		}
-
-		return true
+		return count != 0
 	}
 
 	/// Find the center of a mark within the set of samples
@@ -37,6 +37,9 @@ public final class ScanManager
 	/// We'll use this to locate the deck in the image
 	var deckSearch: DeckSearch
 
+	/// The bounds of the tracked deck within the full frame, or nil if no deck is being tracked (see `DeckSearch.trackedDeckBounds`)
+	public var trackedDeckBounds: Rect<Int>? { return deckSearch.trackedDeckBounds }
+
 	// -----------------------------------------------------------------------------------------------------------------------------
 	// Initialization
 	// -----------------------------------------------------------------------------------------------------------------------------
@@ -60,11 +63,13 @@ public final class ScanManager
 	///    3. Validate the results (see validateDecodedCards())
 	///
 	/// An AnalysisResult is returned
-	public func scan(debugBuffer: DebugBuffer?, lumaBuffer: LumaBuffer, codeDefinition: CodeDefinition) -> AnalysisResult
+	///
+	/// `frameRegion` is the region of the full camera frame covered by `lumaBuffer` (see `DeckSearch.FrameRegion`)
+	public func scan(debugBuffer: DebugBuffer?, lumaBuffer: LumaBuffer, codeDefinition: CodeDefinition, frameRegion: DeckSearch.FrameRegion = DeckSearch.FrameRegion()) -> AnalysisResult
 	{
 		// Perform the scan
 		let scanStart = PerfTimer.trackBegin()
-		let result = internalScan(debugBuffer: debugBuffer, lumaBuffer: lumaBuffer, codeDefinition: codeDefinition)
+		let result = internalScan(debugBuffer: debugBuffer, lumaBuffer: lumaBuffer, codeDefinition: codeDefinition, frameRegion: frameRegion)
 		PerfTimer.trackEnd(name: "Scan", start: scanStart)
 
 		// Draw the mouse
@@ -130,7 +135,7 @@ public final class ScanManager
 	}
 
 	/// Internal scanning routine. See `scan()` for details
-	private func internalScan(debugBuffer: DebugBuffer?, lumaBuffer: LumaBuffer, codeDefinition: CodeDefinition) -> AnalysisResult
+	private func internalScan(debugBuffer: DebugBuffer?, lumaBuffer: LumaBuffer, codeDefinition: CodeDefinition, frameRegion: DeckSearch.FrameRegion) -> AnalysisResult
 	{
 		resultStats.frameCount += 1
 
@@ -151,7 +156,7 @@ public final class ScanManager
 		var markLines: MarkLines?
 
 		let searchStart = PerfTimer.trackBegin()
-		let deckSearchResult = deckSearch.scanImage(debugBuffer: debugBuffer, lumaBuffer: lumaBuffer, codeDefinition: codeDefinition)
+		let deckSearchResult = deckSearch.scanImage(debugBuffer: debugBuffer, lumaBuffer: lumaBuffer, codeDefinition: codeDefinition, frameRegion: frameRegion)
 
 		switch deckSearchResult
 		{
@@ -166,11 +171,13 @@ public final class ScanManager
 				resultStats.searchDecodableCount += 1
 		}
 
+		// Searches that find nothing are tracked as well, as they are usually the most expensive
+		PerfTimer.trackEnd(name: "Deck Search", start: searchStart)
+
 		if markLines == nil
 		{
 			return .Fail(deckSearchResult: deckSearchResult, decodeResult: nil)
 		}
-		PerfTimer.trackEnd(name: "Deck Search", start: searchStart)
 
 		// =-=-=-=-=-=-==-=-=-=-=-=-=-=-=-=-=-==-=-=-=-=-=-=-=-=-=-=-==-=-=-=-=-=-=-=-=-=-=-==-=-=-=-=-=-=-=-=-=-=-==-=-=-=-=-=-=-=-
 		// Decode and process the deck
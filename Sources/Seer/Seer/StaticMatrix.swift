@@ -245,6 +245,23 @@ public final class StaticMatrix<T>
 		count += 1
 	}
 
+	/// Sets the column count for each of the first `rowCount` rows to `colCount`
+	///
+	/// This is for rows whose elements were stored directly (for example, through `elements` by native code) rather than through
+	/// `add(toRow:value:)`. You are required to make sure that the counts are within the matrix's capacities. Range checking is
+	/// asserted in debug mode but that protection will go away in optimized (release) builds.
+	@inline(__always) public func setColCounts(_ colCount: Int, rowCount: Int)
+	{
+		assert(rowCount >= 0 && rowCount <= rowCapacity)
+		assert(colCount >= 0 && colCount <= colCapacity)
+
+		for row in 0..<rowCount
+		{
+			count += colCount - colCounts[row]
+			colCounts[row] = colCount
+		}
+	}
+
 	/// Fills a matrix with a given value
 	///
 	/// Every element in the matrix is replaced with the given value. Any data currently stored in the matrix will be overwritten.
@@ -266,7 +283,7 @@ public final class StaticMatrix<T>
 	{
 		assert(row >= 0 && row < rowCapacity)
 		assert(col >= 0 && col < colCapacity)
-		assert(colCounts[row] > 0 && colCounts[row] < colCapacity)
+		assert(colCounts[row] > 0 && colCounts[row] <= colCapacity)
 
 		let colCount = colCounts[row] - 1
 		count -= 1
@@ -85,6 +85,13 @@ final class SteveMediaProvider: MediaProvider
 	private var workImage: LumaBuffer?
 	private var lumaBuffer: LumaBuffer?
 
+	//
+	// Luma archives (stepped through a frame at a time)
+	//
+
+	private var lumaArchive: LumaArchiveReader?
+	private var lumaArchiveFrameIndex = 0
+
 	/// Media consumer (where our decoded frames are sent for processing)
 	private var mediaConsumer: MediaConsumer?
 
@@ -125,6 +132,11 @@ final class SteveMediaProvider: MediaProvider
 		return filename.lowercased().hasSuffix(".luma")
 	}
 
+	private func isLumaArchiveFile(filename: PathString) -> Bool
+	{
+		return filename.lowercased().hasSuffix(".\(LumaArchiveWriter.fileExtension)")
+	}
+
 	private func isVideoFile(filename: PathString) -> Bool
 	{
 		let lowerName = filename.lowercased()
@@ -225,6 +237,43 @@ final class SteveMediaProvider: MediaProvider
 			return
 		}
 
+		restoreFrame(image: image, userData: data, path: path)
+	}
+
+	private func loadLumaArchive(path: PathString) -> Bool
+	{
+		guard let archive = try? LumaArchiveReader(path: path), archive.count > 0 else
+		{
+			gLogger.error("Unable to restore frames, luma archive would not open (or is empty): \(path)")
+			return false
+		}
+
+		gLogger.info("Loaded luma archive with \(archive.count) frames: \(path.toString().split(on: "/").last ?? "- Unknown -")")
+
+		lumaArchive = archive
+		return loadLumaArchiveFrame(index: 0)
+	}
+
+	/// Restores frame `index` of the current luma archive (see `step(by:)`)
+	private func loadLumaArchiveFrame(index: Int) -> Bool
+	{
+		guard let archive = lumaArchive, let frame = archive.frame(at: index) else { return false }
+
+		// The archive's frames wrap its mapped file, so we keep a copy that outlives the archive
+		let image = LumaBuffer(width: frame.image.width, height: frame.image.height)
+		image.buffer.assign(from: frame.image.buffer, count: image.width * image.height)
+
+		gLogger.info("Restoring archived frame \(index + 1) of \(archive.count)")
+
+		lumaArchiveFrameIndex = index
+		restoreFrame(image: image, userData: frame.userData, path: archive.path)
+		return true
+	}
+
+	/// Replaces the work image with an archived frame, restoring the temporal state stored with it (`userData`, as stored in a
+	/// `.luma` file) and playing it
+	private func restoreFrame(image: LumaBuffer, userData data: Data, path: PathString)
+	{
 		// Extract the elements from the data
 		var offset = data.startIndex
 		let end = data.endIndex
@@ -704,7 +753,7 @@ final class SteveMediaProvider: MediaProvider
 	static var videoFileExtensions: [String] { return ["mov", "mp4", "m4v"] }
 
 	/// Array of supported media file extensions for image formats
-	static var imageFileExtensions: [String] { return ["png", "jpg", "jpeg", "luma"] }
+	static var imageFileExtensions: [String] { return ["png", "jpg", "jpeg", "luma", LumaArchiveWriter.fileExtension] }
 
 	/// Pre-frame callback
 	///
@@ -914,9 +963,19 @@ final class SteveMediaProvider: MediaProvider
 	///
 	/// If `count` is a positive value, the step will be forward. Conversely, if `count` is a negative value, the step will be in
 	/// reverse. Calling with a `count` of `0` will do nothing.
+	///
+	/// For a luma archive, this steps through the archived frames (stopping at either end.)
 	func step(by count: Int)
 	{
-		if let playerItem = playerItem.value
+		if let archive = lumaArchive
+		{
+			let index = max(0, min(archive.count - 1, lumaArchiveFrameIndex + count))
+			if index != lumaArchiveFrameIndex
+			{
+				_ = executeWhenNotProcessing { self.loadLumaArchiveFrame(index: index) }
+			}
+		}
+		else if let playerItem = playerItem.value
 		{
 			if count > 0 && playerItem.canStepForward
 			{
@@ -959,8 +1018,15 @@ final class SteveMediaProvider: MediaProvider
 			gLogger.warn("Code definition not found in filename '\(path.lastComponent() ?? "unknown")', maintaining current definition")
 		}
 
+		// Only a luma archive keeps its file open
+		lumaArchive = nil
+
 		var result = false
-		if isLumaFile(filename: path)
+		if isLumaArchiveFile(filename: path)
+		{
+			result = loadLumaArchive(path: path)
+		}
+		else if isLumaFile(filename: path)
 		{
 			loadLuma(path: path)
 			result = true
@@ -12,6 +12,7 @@
 
 import Foundation
 import Seer
+import NativeTasks
 
 // ---------------------------------------------------------------------------------------------------------------------------------
 //   ____                           _                __  __       _        _
@@ -25,54 +26,66 @@ import Seer
 internal func generateMDSCodesMatrix(codeBits: Int, dataBits: Int, binaryOptimization: Bool, shuffle: Bool, verbose: Bool)
 {
 	let parityBits = codeBits - dataBits
-	var bestMinimumDistance = 0
-	var bestPoly = 0
-	var bestCodes = UnsafeMutableArray<Int>()
-	var bestMatrix = UnsafeMutableArray<Int>()
+	let maxPoly = 1 << (parityBits-1)
 
-	var lastUpdateTimeMS = Date.timeIntervalSinceReferenceDate * 1000.0
+	// Measure every polynomial, spread across all cores
+	//
+	// Each worker rejects candidates that can't beat the best it has found so far (they measure as 0.) A worker's best never
+	// exceeds the best overall, so the best polynomials are always measured in full.
+	let workerCount = min(ProcessInfo.processInfo.activeProcessorCount, maxPoly)
+	let progress = ProgressReporter(total: maxPoly)
+	var minimumDistances = [Int](repeating: 0, count: maxPoly)
+	minimumDistances.withUnsafeMutableBufferPointer
+	{ buffer in
+		let results = buffer
+		DispatchQueue.concurrentPerform(iterations: workerCount)
+		{ worker in
+			var bestMinimumDistance = 0
+			for polyBase in stride(from: worker, to: maxPoly, by: workerCount)
+			{
+				let poly = generatePoly(parityBits: parityBits, polyBase: polyBase)
+				var matrix = generateMdsMatrix(codeBits: codeBits, dataBits: dataBits, poly: poly)
+				defer { matrix.free() }
 
-	let maxPoly = 1 << (parityBits-1)
-	for polyBase in 0..<maxPoly
-	{
-		// Generate a polynomial value with an additional high and low bit surrounding the original polyBase bits
-		let poly = (1 << parityBits+1) | (polyBase << 1) | 1
-		var matrix = generateMdsMatrix(codeBits: codeBits, dataBits: dataBits, poly: poly)
-		defer { matrix.free() }
+				var codes = generateCodes(fromMatrix: matrix, dataBits: dataBits, poly: poly)
+				defer { codes.free() }
 
-		var codes = generateCodes(fromMatrix: matrix, dataBits: dataBits, poly: poly)
-		defer { codes.free() }
+				let minimumDistance = HammingDistance.calcMinimumDistance(for: codes, codeBits: codeBits, bestMinimumDistance: bestMinimumDistance)
+				results[polyBase] = minimumDistance
+				bestMinimumDistance = max(bestMinimumDistance, minimumDistance)
 
-		let minimumDistance = HammingDistance.calcMinimumDistance(for: codes, codeBits: codeBits, bestMinimumDistance: bestMinimumDistance)
-		if minimumDistance > bestMinimumDistance
-		{
-			bestMinimumDistance = minimumDistance
-			bestPoly = poly
-			bestMatrix = UnsafeMutableArray<Int>(matrix)
-			bestCodes = UnsafeMutableArray<Int>(codes)
+				// The workers advance together, so the first speaks for all of them
+				if worker == 0 { progress.update(completed: min(polyBase + workerCount, maxPoly)) }
+			}
 		}
+	}
 
-		let curUpdateTimeMS = Date.timeIntervalSinceReferenceDate * 1000.0
-		if curUpdateTimeMS - lastUpdateTimeMS > 250
+	progress.finish()
+
+	// The first polynomial with the best minimum distance wins
+	var bestMinimumDistance = 0
+	var bestPolyBase = -1
+	for polyBase in 0..<maxPoly
+	{
+		if minimumDistances[polyBase] > bestMinimumDistance
 		{
-			lastUpdateTimeMS = curUpdateTimeMS
-			let pct = Int(Double(polyBase+1) / Double(maxPoly) * 100)
-			print("\(polyBase+1) of \(maxPoly) (\(pct)%)\r", terminator: "")
+			bestMinimumDistance = minimumDistances[polyBase]
+			bestPolyBase = polyBase
 		}
 	}
 
-	print("                                                    \r", terminator: "")
-
-	if bestMatrix.isEmpty
+	if bestPolyBase < 0
 	{
 		print("No valid matrix found")
 		return
 	}
-	if bestCodes.isEmpty
-	{
-		print("No valid codes found")
-		return
-	}
+
+	let bestPoly = generatePoly(parityBits: parityBits, polyBase: bestPolyBase)
+	var bestMatrix = generateMdsMatrix(codeBits: codeBits, dataBits: dataBits, poly: bestPoly)
+	defer { bestMatrix.free() }
+
+	var bestCodes = generateCodes(fromMatrix: bestMatrix, dataBits: dataBits, poly: bestPoly)
+	defer { bestCodes.free() }
 
 	if binaryOptimization
 	{
@@ -90,6 +103,12 @@ internal func generateMDSCodesMatrix(codeBits: Int, dataBits: Int, binaryOptimiz
 	dumpMdsData(codes: bestCodes, codeBits: codeBits, type: "Matrix", poly: bestPoly, matrix: bestMatrix, verbose: verbose)
 }
 
+// Generate a polynomial value with an additional high and low bit surrounding the original polyBase bits
+func generatePoly(parityBits: Int, polyBase: Int) -> Int
+{
+	return (1 << parityBits+1) | (polyBase << 1) | 1
+}
+
 // Much of this information comes from:
 //
 //     http://www.ee.unb.ca/cgi-bin/tervo/polygen2.pl
@@ -362,45 +381,124 @@ private func shuffleArray(_ array: inout UnsafeMutableArray<Int>)
 ///
 /// Favorable codes are those with the bit distributions that land in the center of the histogram. In other words, those codes
 /// closest to the same number of bits set as unset, across the entire set of codes.
+///
+/// The masks are spread across all cores, each worker keeping the best of the masks it tries.
 private func optimizeBinaryDistribution(codes: UnsafeMutableArray<Int>, codeBits: Int) -> UnsafeMutableArray<Int>
 {
-	let codeCount = Int(1) << codeBits
+	let maskCount = (Int(1) << codeBits) - 1
 
 	print("Optimizing...")
 
-	var bestHistString = ""
-	var optimizedBestSet = UnsafeMutableArray<Int>(codes)
-	var optimizedMaskedSet = UnsafeMutableArray<Int>()
-	defer { optimizedMaskedSet.free() }
-
-	/// Try each value as a mask to determine which mask provides the best bit distribution
-	for mask in 0..<codeCount-1
-	{
-		optimizedMaskedSet.assign(from: codes)
-		for i in 0..<optimizedMaskedSet.count { optimizedMaskedSet[i] ^= mask }
-
-		var histogram = HammingDistance.generateBinaryHistogram(for: optimizedMaskedSet, ofBits: codeBits)
-		defer { histogram.free() }
-
-		// Fold the histogram over upon itself, so first half contains both, the start to the center and the end to the center. We
-		// then store this in string format so it can be sorted.
-		var histString = ""
-		for i in 0..<histogram.count / 2
-		{
-			histString += (histogram[i] + histogram[histogram.count - i - 1]).toString(5, zero: true)
+	let workerCount = min(ProcessInfo.processInfo.activeProcessorCount, maskCount)
+	let progress = ProgressReporter(total: maskCount)
+	var workerBestMasks = [Int](repeating: -1, count: workerCount)
+	var workerBestFolds = [[Int32]](repeating: [Int32](), count: workerCount)
+
+	// The native codes are always 64-bit (Int is only 32 bits on some targets)
+	let nativeCodes = (0..<codes.count).map { Int64(codes[$0]) }
+
+	nativeCodes.withUnsafeBufferPointer
+	{ codePointer in
+		workerBestMasks.withUnsafeMutableBufferPointer
+		{ bestMasks in
+			workerBestFolds.withUnsafeMutableBufferPointer
+			{ bestFolds in
+				let (masks, folds) = (bestMasks, bestFolds)
+				DispatchQueue.concurrentPerform(iterations: workerCount)
+				{ worker in
+					var histogram = [Int32](repeating: 0, count: codeBits + 1)
+					var fold = [Int32](repeating: 0, count: histogram.count / 2)
+					var bestFold = [Int32]()
+					var bestMask = -1
+
+					/// Try each value as a mask to determine which mask provides the best bit distribution
+					for mask in stride(from: worker, to: maskCount, by: workerCount)
+					{
+						nativeBinaryHistogram(codePointer.baseAddress, UInt32(codePointer.count), Int64(mask), UInt32(codeBits), &histogram)
+
+						// Fold the histogram over upon itself, so first half contains both, the start to the center and the end
+						// to the center.
+						for i in 0..<fold.count
+						{
+							fold[i] = histogram[i] + histogram[histogram.count - i - 1]
+						}
+
+						// Lower counts toward the extremes are better for balance (compared in order, as the fixed-width
+						// strings of these counts once were)
+						if bestFold.isEmpty || fold.lexicographicallyPrecedes(bestFold)
+						{
+							bestFold = fold
+							bestMask = mask
+						}
+
+						// The workers advance together, so the first speaks for all of them
+						if worker == 0 { progress.update(completed: min(mask + workerCount, maskCount)) }
+					}
+
+					masks[worker] = bestMask
+					folds[worker] = bestFold
+				}
+			}
 		}
+	}
+
+	progress.finish()
 
-		// Higher numbers are better for balance
-		if bestHistString.isEmpty || histString < bestHistString
+	// The first mask with the best fold wins
+	var bestWorker = 0
+	for worker in 1..<workerCount
+	{
+		let fold = workerBestFolds[worker]
+		let bestFold = workerBestFolds[bestWorker]
+		if fold.lexicographicallyPrecedes(bestFold) || (fold == bestFold && workerBestMasks[worker] < workerBestMasks[bestWorker])
 		{
-			bestHistString = histString
-			optimizedBestSet.assign(from: optimizedMaskedSet)
+			bestWorker = worker
 		}
 	}
 
+	var optimizedBestSet = UnsafeMutableArray<Int>(codes)
+	for i in 0..<optimizedBestSet.count { optimizedBestSet[i] ^= workerBestMasks[bestWorker] }
 	return optimizedBestSet
 }
 
+/// Reports the progress of a long search on a single line, along with an estimate of the time remaining
+///
+/// Progress must only be reported from one thread at a time.
+private final class ProgressReporter
+{
+	/// The number of steps in the search
+	private let total: Int
+
+	/// When the search started
+	private let startTimeMS = Date.timeIntervalSinceReferenceDate * 1000.0
+
+	/// When progress was last reported
+	private var lastUpdateTimeMS = Date.timeIntervalSinceReferenceDate * 1000.0
+
+	init(total: Int)
+	{
+		self.total = total
+	}
+
+	/// Reports that `completed` steps of the search are complete (at most four times per second)
+	func update(completed: Int)
+	{
+		let curUpdateTimeMS = Date.timeIntervalSinceReferenceDate * 1000.0
+		if curUpdateTimeMS - lastUpdateTimeMS <= 250 { return }
+		lastUpdateTimeMS = curUpdateTimeMS
+
+		let fraction = Double(completed) / Double(total)
+		let remainingSeconds = Int((curUpdateTimeMS - startTimeMS) / 1000.0 * (1 - fraction) / fraction)
+		print("\(completed) of \(total) (\(Int(fraction * 100))%), ETA \(remainingSeconds / 60)m \(remainingSeconds % 60)s    \r", terminator: "")
+	}
+
+	/// Clears the progress line
+	func finish()
+	{
+		print("                                                    \r", terminator: "")
+	}
+}
+
 // ---------------------------------------------------------------------------------------------------------------------------------
 // User output
 // ---------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,171 @@
+//
+//  Bench.cpp
+//  nativebench
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+#if defined(__linux__)
+	#include <unistd.h>
+	#include <sys/ioctl.h>
+	#include <sys/syscall.h>
+	#include <linux/perf_event.h>
+#endif // defined(__linux__)
+
+#include "Bench.h"
+#include "NativeTasks.h"
+
+using namespace std;
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Cycle counting
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Counts user-space CPU cycles via the kernel's perf events (Linux only)
+///
+/// Virtual machines and locked-down kernels (see /proc/sys/kernel/perf_event_paranoid) may not allow this, in which case
+/// `isValid()` returns false and cycles are simply not reported.
+class CycleCounter
+{
+	public: CycleCounter()
+	{
+#if defined(__linux__)
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = PERF_COUNT_HW_CPU_CYCLES;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		mFd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+		if (mFd >= 0)
+		{
+			ioctl(mFd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif // defined(__linux__)
+	}
+
+	public: ~CycleCounter()
+	{
+#if defined(__linux__)
+		if (mFd >= 0) close(mFd);
+#endif // defined(__linux__)
+	}
+
+	public: bool isValid() const { return mFd >= 0; }
+
+	public: uint64_t read() const
+	{
+		uint64_t count = 0;
+#if defined(__linux__)
+		if (mFd < 0 || ::read(mFd, &count, sizeof(count)) != sizeof(count)) return 0;
+#endif // defined(__linux__)
+		return count;
+	}
+
+	private: int mFd = -1;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+bool benchFilter(const BenchOptions &options, const string &name)
+{
+	return options.filter.empty() || name.find(options.filter) != string::npos;
+}
+
+vector<string> benchImageIsas(const BenchOptions &options)
+{
+	static const char *kAllIsas[] = { "scalar", "sse2", "avx2", "neon" };
+
+	// Restore whatever was active when we're done
+	string active = nativeImageKernelsName();
+
+	vector<string> result;
+	for (const char *isa : kAllIsas)
+	{
+		if (!options.isa.empty() && options.isa != isa) continue;
+		if (nullptr == nativeImageKernelsSelect(isa)) result.push_back(isa);
+	}
+
+	nativeImageKernelsSelect(active.c_str());
+	return result;
+}
+
+BenchMeasurement benchMeasure(const BenchOptions &options, const function<void()> &fn)
+{
+	static CycleCounter cycleCounter;
+
+	// Warm up (caches, page faults, lazily allocated scratch memory)
+	fn();
+
+	vector<double> seconds;
+	vector<double> cycles;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	double elapsed = 0;
+	while (static_cast<int>(seconds.size()) < options.minIterations || elapsed < options.minSeconds)
+	{
+		uint64_t c0 = cycleCounter.read();
+		chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+		fn();
+		chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+		uint64_t c1 = cycleCounter.read();
+
+		seconds.push_back(chrono::duration<double>(t1 - t0).count());
+		cycles.push_back(static_cast<double>(c1 - c0));
+		elapsed = chrono::duration<double>(t1 - start).count();
+	}
+
+	BenchMeasurement result;
+	result.iterations = static_cast<int>(seconds.size());
+
+	sort(seconds.begin(), seconds.end());
+	result.seconds = seconds[seconds.size() / 2];
+
+	if (cycleCounter.isValid())
+	{
+		sort(cycles.begin(), cycles.end());
+		result.cycles = cycles[cycles.size() / 2];
+	}
+
+	return result;
+}
+
+void benchReportHeader(const char *title)
+{
+	printf("\n%s\n\n", title);
+	printf("  %-30s %-7s %-21s %10s %9s %9s %8s  %s\n", "kernel", "variant", "size", "ns/unit", "GB/s", "cyc/unit", "iters", "result");
+	printf("  %-30s %-7s %-21s %10s %9s %9s %8s  %s\n", "------", "-------", "----", "-------", "----", "--------", "-----", "------");
+}
+
+void benchReport(const string &kernel, const string &variant, const string &size, uint64_t units, uint64_t bytes, const BenchMeasurement *measurement, bool passed)
+{
+	const char *status = passed ? "ok" : "MISMATCH";
+	if (!measurement)
+	{
+		printf("  %-30s %-7s %-21s %10s %9s %9s %8s  %s\n", kernel.c_str(), variant.c_str(), size.c_str(), "-", "-", "-", "-", status);
+		return;
+	}
+
+	double nsPerUnit = measurement->seconds * 1e9 / static_cast<double>(units);
+	double gbPerSecond = static_cast<double>(bytes) / measurement->seconds / 1e9;
+	char cyclesPerUnit[32] = "-";
+	if (measurement->cycles >= 0)
+	{
+		snprintf(cyclesPerUnit, sizeof(cyclesPerUnit), "%.3f", measurement->cycles / static_cast<double>(units));
+	}
+
+	printf("  %-30s %-7s %-21s %10.3f %9.2f %9s %8d  %s\n", kernel.c_str(), variant.c_str(), size.c_str(), nsPerUnit, gbPerSecond, cyclesPerUnit, measurement->iterations, status);
+}
@@ -0,0 +1,92 @@
+//
+//  Bench.h
+//  nativebench
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+/// Options shared by all benchmark suites (see `printUsage()` in main.cpp)
+struct BenchOptions
+{
+	/// Only run kernels whose name contains this string (empty for all)
+	std::string filter;
+
+	/// Only run this instruction set (empty for all available)
+	std::string isa;
+
+	/// Verify results without timing them
+	bool verifyOnly = false;
+
+	/// Minimum time to spend measuring each kernel, in seconds
+	double minSeconds = 0.25;
+
+	/// Minimum number of timed calls for each kernel
+	int minIterations = 5;
+
+	/// A directory of recorded frames (`.luma` files and luma archives) for suites that can measure them (empty for none)
+	std::string mediaPath;
+};
+
+/// The result of timing a kernel
+struct BenchMeasurement
+{
+	/// Median wall time of a single call, in seconds
+	double seconds = 0;
+
+	/// Median CPU cycles of a single call, or a negative value if cycle counting is unavailable
+	double cycles = -1;
+
+	/// Number of timed calls
+	int iterations = 0;
+};
+
+/// Returns true if `name` passes the `--filter` option
+bool benchFilter(const BenchOptions &options, const std::string &name);
+
+/// Returns the instruction sets that are available on this machine (and pass the `--isa` option)
+std::vector<std::string> benchImageIsas(const BenchOptions &options);
+
+/// Calls `fn` repeatedly (after a warm-up call) and returns the median cost of a single call
+BenchMeasurement benchMeasure(const BenchOptions &options, const std::function<void()> &fn);
+
+/// Prints the header for a table of results
+void benchReportHeader(const char *title);
+
+/// Prints a result line
+///
+/// `units` is the number of work units (pixels, samples, etc.) processed per call, and `bytes` is the total number of bytes
+/// read and written per call. If `measurement` is null, only the verification status is printed.
+void benchReport(const std::string &kernel, const std::string &variant, const std::string &size, uint64_t units, uint64_t bytes, const BenchMeasurement *measurement, bool passed);
+
+/// Deterministic pseudo-random numbers (xorshift32) so that failures are reproducible
+class BenchRandom
+{
+	public: explicit BenchRandom(uint32_t seed = 0x2545f491) : mState(seed ? seed : 1) { }
+	public: uint32_t next() { mState ^= mState << 13; mState ^= mState >> 17; mState ^= mState << 5; return mState; }
+	public: void fill(uint8_t *data, size_t count) { for (size_t i = 0; i < count; ++i) data[i] = static_cast<uint8_t>(next() >> 24); }
+	public: void fill(uint32_t *data, size_t count) { for (size_t i = 0; i < count; ++i) data[i] = next(); }
+	private: uint32_t mState;
+};
+
+/// Benchmark suites
+///
+/// Each returns the number of verification failures
+int benchFastImage(const BenchOptions &options);
+int benchRollMinMax(const BenchOptions &options);
+int benchEdgeDetection(const BenchOptions &options);
+int benchErrorCorrection(const BenchOptions &options);
+int benchFrameArena(const BenchOptions &options);
+int benchLumaArchive(const BenchOptions &options);
+int benchLumaCodec(const BenchOptions &options);
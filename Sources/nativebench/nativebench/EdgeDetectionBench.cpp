@@ -0,0 +1,464 @@
+//
+//  EdgeDetectionBench.cpp
+//  nativebench
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+//
+// Conformance and performance of the kernels used by Seer's edge detection (`nativeRollMinMax()` and `nativeDetectEdges()`.)
+//
+// The references here are literal ports of Seer's Swift code: the original `rollMinMax(samples:count:windowSize:)`, which rescans
+// the window each time its min or max rolls out, and the multi-pass `EdgeDetection.detectEdges()`. Each is timed alongside the
+// native implementation.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "Bench.h"
+#include "NativeTasks.h"
+
+using namespace std;
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Reference implementation
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Rolling min/max, written as a literal port of Seer's original `rollMinMax(samples:count:windowSize:)`, replacing `dst`
+static void referenceRollMinMax(const vector<int32_t> &samples, int inCount, int inWindowSize, vector<NativeMinMax> &dst)
+{
+	dst.clear();
+	if (samples.empty()) return;
+
+	int windowSize = min(inWindowSize, static_cast<int>(samples.size()));
+
+	NativeMinMax minMax = { samples[0], samples[0] };
+	for (int i = 0; i < windowSize; ++i)
+	{
+		if (samples[i] < minMax.min) minMax.min = samples[i];
+		else if (minMax.max < samples[i]) minMax.max = samples[i];
+	}
+
+	int end = inCount - windowSize;
+	for (int i = 0; i < end; ++i)
+	{
+		dst.push_back(minMax);
+
+		int32_t rollOutValue = samples[i];
+		int32_t rollInValue = samples[i + windowSize];
+
+		if (rollInValue <= minMax.min)
+		{
+			minMax.min = rollInValue;
+		}
+		else if (rollOutValue == minMax.min)
+		{
+			minMax.min = rollInValue;
+			for (int j = i + 1; j < i + windowSize; ++j)
+			{
+				if (samples[j] < minMax.min) minMax.min = samples[j];
+			}
+		}
+
+		if (rollInValue >= minMax.max)
+		{
+			minMax.max = rollInValue;
+		}
+		else if (rollOutValue == minMax.max)
+		{
+			minMax.max = rollInValue;
+			for (int j = i + 1; j < i + windowSize; ++j)
+			{
+				if (minMax.max < samples[j]) minMax.max = samples[j];
+			}
+		}
+	}
+
+	for (int i = end; i < inCount; ++i)
+	{
+		dst.push_back(minMax);
+	}
+}
+
+static bool operator==(const NativeMinMax &a, const NativeMinMax &b)
+{
+	return a.min == b.min && a.max == b.max;
+}
+
+static bool operator==(const NativeEdgePeak &a, const NativeEdgePeak &b)
+{
+	return a.slope == b.slope && a.sampleOffset == b.sampleOffset && a.threshold == b.threshold;
+}
+
+/// Calculates a threshold, written as a literal port of Seer's `EdgeDetection.calcThreshold()` (with its FixedPoint math)
+static int32_t referenceCalcThreshold(int32_t blackPoint, int32_t whitePoint, int32_t minThreshold, int32_t sensitivity)
+{
+	int32_t sampleRange = (whitePoint - blackPoint) * 65536;
+	int32_t product = static_cast<int32_t>((static_cast<int64_t>(sensitivity) * sampleRange) >> 16);
+	int32_t threshold = product >> 16;
+	return threshold < minThreshold ? minThreshold : threshold;
+}
+
+/// Edge detection, written as a literal port of Seer's multi-pass `EdgeDetection.detectEdges()`, replacing `dst`
+///
+/// The passes are `rollSums`, `findPeaks`, `rollMinMax` (using `nativeRollMinMax()`, as Seer does) and `thresholdPeaks`. Returns
+/// false if any pass fails.
+static bool referenceDetectEdges(const vector<int32_t> &samples, int windowSize, int minMaxWindowSize, int overlap, int32_t sensitivity, int32_t minThreshold, vector<int32_t> &sums, vector<NativeEdgePeak> &peaks, vector<NativeMinMax> &rolledMinMax, vector<NativeEdgePeak> &dst)
+{
+	dst.clear();
+
+	// rollSums
+	int last = static_cast<int>(samples.size()) - windowSize;
+	if (last < 0) return false;
+
+	sums.resize(last + 1);
+	int32_t sum = 0;
+	for (int i = 0; i < windowSize; ++i) sum += samples[i];
+	for (int i = 0; i < last; ++i)
+	{
+		sums[i] = sum;
+		sum -= samples[i];
+		sum += samples[i + windowSize];
+	}
+	sums[last] = sum;
+
+	// findPeaks
+	int rollingSlopeOffset = windowSize - overlap;
+	int maxSlopeCount = static_cast<int>(sums.size()) - rollingSlopeOffset - 1;
+	peaks.clear();
+	if (maxSlopeCount <= 0) return false;
+
+	int dataIndex = 0;
+	while (dataIndex < maxSlopeCount)
+	{
+		int32_t maxSlope = sums[dataIndex + rollingSlopeOffset] - sums[dataIndex];
+		int maxSlopeIndex = dataIndex;
+		dataIndex += 1;
+
+		if (maxSlope >= 0)
+		{
+			while (dataIndex < maxSlopeCount)
+			{
+				int32_t slope = sums[dataIndex + rollingSlopeOffset] - sums[dataIndex];
+				if (slope <= 0) break;
+				if (slope > maxSlope) { maxSlope = slope; maxSlopeIndex = dataIndex; }
+				dataIndex += 1;
+			}
+		}
+		else if (maxSlope <= 0)
+		{
+			while (dataIndex < maxSlopeCount)
+			{
+				int32_t slope = sums[dataIndex + rollingSlopeOffset] - sums[dataIndex];
+				if (slope >= 0) break;
+				dataIndex += 1;
+				if (slope <= maxSlope) { maxSlope = slope; maxSlopeIndex = dataIndex; }
+			}
+		}
+
+		NativeEdgePeak peak = { maxSlope, maxSlopeIndex, 0 };
+		peaks.push_back(peak);
+	}
+
+	// thresholdPeaks
+	int peakOffset = windowSize - 1 - overlap / 2;
+	if (minMaxWindowSize > 0)
+	{
+		rolledMinMax.resize(samples.size());
+		uint32_t rolledCount = nativeRollMinMax(samples.data(), static_cast<uint32_t>(samples.size()), static_cast<uint32_t>(sums.size()), static_cast<uint32_t>(minMaxWindowSize), rolledMinMax.data());
+		if (rolledCount == 0) return false;
+
+		int32_t scaledMinThreshold = minThreshold * windowSize;
+		int minMaxOffset = peakOffset - minMaxWindowSize / 2;
+		for (NativeEdgePeak peak : peaks)
+		{
+			int32_t absScaledPeakSlope = abs(peak.slope);
+			if (absScaledPeakSlope < scaledMinThreshold) continue;
+
+			int idx = min(peak.sampleOffset + minMaxOffset, static_cast<int>(rolledCount) - 1);
+			const NativeMinMax &minMax = rolledMinMax[idx < 0 ? 0 : idx];
+			int32_t threshold = referenceCalcThreshold(minMax.min, minMax.max, minThreshold, sensitivity) * windowSize;
+			if (absScaledPeakSlope >= threshold)
+			{
+				peak.sampleOffset += peakOffset;
+				peak.threshold = threshold;
+				dst.push_back(peak);
+			}
+		}
+	}
+	else
+	{
+		NativeMinMax minMax = { samples[0], samples[0] };
+		for (int32_t sample : samples)
+		{
+			if (sample < minMax.min) minMax.min = sample;
+			else if (minMax.max < sample) minMax.max = sample;
+		}
+
+		int32_t threshold = referenceCalcThreshold(minMax.min, minMax.max, minThreshold, sensitivity) * windowSize;
+		for (NativeEdgePeak peak : peaks)
+		{
+			if (abs(peak.slope) >= threshold)
+			{
+				peak.sampleOffset += peakOffset;
+				peak.threshold = threshold;
+				dst.push_back(peak);
+			}
+		}
+	}
+
+	return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Sample generation
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Generates the samples of a search line across a deck: a noisy background, then the deck's periodic bars (`barWidth` samples
+/// wide, with soft edges) under an uneven light, then background again
+///
+/// Flat, repeating bars are the worst case for the rescan: the window's min or max rolls out on almost every step.
+static void generateSearchLine(BenchRandom &random, uint32_t count, uint32_t barWidth, vector<int32_t> &samples)
+{
+	samples.resize(count);
+	uint32_t deckStart = count / 8, deckEnd = count - count / 8;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		int32_t value = 40;
+		if (i >= deckStart && i < deckEnd)
+		{
+			uint32_t phase = (i - deckStart) % (barWidth * 2);
+			int32_t light = 150 + static_cast<int32_t>((i - deckStart) * 60 / (deckEnd - deckStart));
+			if (phase < barWidth) value = light;
+			else if (phase == barWidth || phase == barWidth * 2 - 1) value = light / 2;
+			else value = 60;
+		}
+
+		// A little sensor noise, so not every bar is perfectly flat
+		if ((random.next() >> 28) == 0) value += static_cast<int32_t>(random.next() % 5) - 2;
+		samples[i] = value;
+	}
+}
+
+/// Search lines as DeckSearch samples them: about the width of the image, with the rolling average window (the narrowest
+/// landmark) and min/max window (6.77x that) scaled with the image height
+struct SearchLine
+{
+	const char *name;
+	uint32_t count;
+	uint32_t averageWindow;
+	uint32_t minMaxWindow;
+};
+
+static const SearchLine kSearchLines[] =
+{
+	{ "720p", 1280, 13, 88 },
+	{ "1080p", 1920, 19, 132 },
+};
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Suites
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+int benchRollMinMax(const BenchOptions &options)
+{
+	benchReportHeader("Rolling min/max (units are samples)");
+
+	int failures = 0;
+	BenchRandom random;
+
+	// Conformance over the edge cases: tiny lines, windows larger than the line, single-sample windows and short counts
+	if (benchFilter(options, "rollMinMax"))
+	{
+		int edgeFailures = 0;
+		vector<int32_t> samples;
+		vector<NativeMinMax> golden, output;
+		for (int i = 0; i < 2000; ++i)
+		{
+			uint32_t sampleCount = 1 + random.next() % 300;
+			uint32_t windowSize = 1 + random.next() % (sampleCount + 20);
+			uint32_t count = random.next() % (sampleCount + 1);
+			samples.resize(sampleCount);
+			for (int32_t &sample : samples) sample = static_cast<int32_t>(random.next() % ((i % 3) == 0 ? 4 : 256));
+
+			referenceRollMinMax(samples, static_cast<int>(count), static_cast<int>(windowSize), golden);
+			output.assign(sampleCount, NativeMinMax { -1, -1 });
+			uint32_t stored = nativeRollMinMax(samples.data(), sampleCount, count, windowSize, output.data());
+			output.resize(stored);
+
+			if (output != golden)
+			{
+				if (edgeFailures == 0)
+				{
+					fprintf(stderr, "  rollMinMax: mismatch with %u samples, count %u, window %u\n", sampleCount, count, windowSize);
+				}
+				edgeFailures += 1;
+			}
+		}
+
+		benchReport("rollMinMax", "native", "edge cases", 0, 0, nullptr, edgeFailures == 0);
+		failures += edgeFailures != 0 ? 1 : 0;
+	}
+
+	for (const SearchLine &line : kSearchLines)
+	{
+		// The bars in a line are about one rolling average window wide; noise is the general case
+		for (int noise = 0; noise < 2; ++noise)
+		{
+			string kernel = noise ? "rollMinMax (noise)" : "rollMinMax (marks)";
+			if (!benchFilter(options, kernel)) continue;
+
+			char size[32];
+			snprintf(size, sizeof(size), "%s/%u", line.name, line.minMaxWindow);
+
+			vector<int32_t> samples;
+			if (noise)
+			{
+				samples.resize(line.count);
+				for (int32_t &sample : samples) sample = static_cast<int32_t>(random.next() >> 24);
+			}
+			else
+			{
+				generateSearchLine(random, line.count, line.averageWindow, samples);
+			}
+
+			// EdgeDetection rolls the min/max over as many samples as there are rolling sums
+			uint32_t count = line.count - line.averageWindow + 1;
+
+			vector<NativeMinMax> golden, output(line.count);
+			referenceRollMinMax(samples, static_cast<int>(count), static_cast<int>(line.minMaxWindow), golden);
+			output.resize(nativeRollMinMax(samples.data(), line.count, count, line.minMaxWindow, output.data()));
+
+			bool passed = output == golden;
+			if (!passed)
+			{
+				failures += 1;
+				size_t first = mismatch(output.begin(), output.end(), golden.begin()).first - output.begin();
+				fprintf(stderr, "  %s/%s: first mismatch at element %zu\n", kernel.c_str(), size, first);
+			}
+
+			uint64_t bytes = count * (sizeof(int32_t) + sizeof(NativeMinMax));
+			if (options.verifyOnly)
+			{
+				benchReport(kernel, "native", size, count, bytes, nullptr, passed);
+				continue;
+			}
+
+			vector<NativeMinMax> rescan;
+			BenchMeasurement measurement = benchMeasure(options, [&]() { referenceRollMinMax(samples, static_cast<int>(count), static_cast<int>(line.minMaxWindow), rescan); });
+			benchReport(kernel, "rescan", size, count, bytes, &measurement, true);
+
+			measurement = benchMeasure(options, [&]() { nativeRollMinMax(samples.data(), line.count, count, line.minMaxWindow, output.data()); });
+			benchReport(kernel, "native", size, count, bytes, &measurement, passed);
+		}
+	}
+
+	return failures;
+}
+
+int benchEdgeDetection(const BenchOptions &options)
+{
+	// DeckSearch's defaults: a sensitivity of 0.2, a minimum threshold of 10 and no overlap
+	const int32_t kSensitivity = 13107;
+	const int32_t kMinThreshold = 10;
+
+	benchReportHeader("Edge detection (units are samples)");
+
+	int failures = 0;
+	BenchRandom random;
+	vector<int32_t> sums;
+	vector<NativeEdgePeak> peaks;
+	vector<NativeMinMax> rolledMinMax;
+
+	// Conformance over the edge cases: tiny lines, large overlaps, windows larger than the line and single-sample windows, with
+	// and without a rolling min/max
+	if (benchFilter(options, "detectEdges"))
+	{
+		int edgeFailures = 0;
+		vector<int32_t> samples;
+		vector<NativeEdgePeak> golden, output;
+		for (int i = 0; i < 4000; ++i)
+		{
+			uint32_t sampleCount = 1 + random.next() % 400;
+			int windowSize = static_cast<int>(random.next() % 24);
+			int overlap = static_cast<int>(random.next() % (windowSize + 1));
+			int minMaxWindowSize = (i % 4) == 0 ? 0 : 1 + static_cast<int>(random.next() % (sampleCount + 40));
+			int32_t sensitivity = static_cast<int32_t>(random.next() % 65536);
+			int32_t minThreshold = static_cast<int32_t>(random.next() % 16);
+
+			samples.resize(sampleCount);
+			if ((i % 3) == 0) generateSearchLine(random, sampleCount, 1 + random.next() % 20, samples);
+			else for (int32_t &sample : samples) sample = static_cast<int32_t>(random.next() >> 24);
+
+			bool valid = referenceDetectEdges(samples, windowSize, minMaxWindowSize, overlap, sensitivity, minThreshold, sums, peaks, rolledMinMax, golden);
+			output.assign(sampleCount, NativeEdgePeak { -1, -1, -1 });
+			int32_t stored = nativeDetectEdges(samples.data(), sampleCount, windowSize, minMaxWindowSize, overlap, sensitivity, minThreshold, output.data());
+			output.resize(stored < 0 ? 0 : stored);
+
+			if ((stored >= 0) != valid || output != golden)
+			{
+				if (edgeFailures == 0)
+				{
+					fprintf(stderr, "  detectEdges: mismatch with %u samples, window %d, overlap %d, min/max window %d\n", sampleCount, windowSize, overlap, minMaxWindowSize);
+				}
+				edgeFailures += 1;
+			}
+		}
+
+		benchReport("detectEdges", "fused", "edge cases", 0, 0, nullptr, edgeFailures == 0);
+		failures += edgeFailures != 0 ? 1 : 0;
+	}
+
+	for (const SearchLine &line : kSearchLines)
+	{
+		// With the rolling min/max (as DeckSearch uses it) and against the whole line
+		for (int rolling = 1; rolling >= 0; --rolling)
+		{
+			string kernel = rolling ? "detectEdges (rolling)" : "detectEdges (line)";
+			if (!benchFilter(options, kernel)) continue;
+
+			char size[32];
+			snprintf(size, sizeof(size), "%s/%u", line.name, line.averageWindow);
+
+			vector<int32_t> samples;
+			generateSearchLine(random, line.count, line.averageWindow, samples);
+			int minMaxWindowSize = rolling ? static_cast<int>(line.minMaxWindow) : 0;
+			int windowSize = static_cast<int>(line.averageWindow);
+
+			vector<NativeEdgePeak> golden, output(line.count);
+			referenceDetectEdges(samples, windowSize, minMaxWindowSize, 0, kSensitivity, kMinThreshold, sums, peaks, rolledMinMax, golden);
+			int32_t stored = nativeDetectEdges(samples.data(), line.count, windowSize, minMaxWindowSize, 0, kSensitivity, kMinThreshold, output.data());
+			output.resize(stored < 0 ? 0 : stored);
+
+			bool passed = !golden.empty() && output == golden;
+			if (!passed)
+			{
+				failures += 1;
+				fprintf(stderr, "  %s/%s: %zu edges, expected %zu\n", kernel.c_str(), size, output.size(), golden.size());
+			}
+
+			uint64_t bytes = line.count * sizeof(int32_t);
+			if (options.verifyOnly)
+			{
+				benchReport(kernel, "fused", size, line.count, bytes, nullptr, passed);
+				continue;
+			}
+
+			vector<NativeEdgePeak> passes;
+			BenchMeasurement measurement = benchMeasure(options, [&]() { referenceDetectEdges(samples, windowSize, minMaxWindowSize, 0, kSensitivity, kMinThreshold, sums, peaks, rolledMinMax, passes); });
+			benchReport(kernel, "passes", size, line.count, bytes, &measurement, true);
+
+			output.resize(line.count);
+			measurement = benchMeasure(options, [&]() { nativeDetectEdges(samples.data(), line.count, windowSize, minMaxWindowSize, 0, kSensitivity, kMinThreshold, output.data()); });
+			benchReport(kernel, "fused", size, line.count, bytes, &measurement, passed);
+		}
+	}
+
+	return failures;
+}
@@ -0,0 +1,377 @@
+//
+//  ErrorCorrectionBench.cpp
+//  nativebench
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+//
+// Conformance and performance of the error correction tables (`nativeErrorCorrectionTableOpen()`) and the code analysis used by
+// mdscodes (`nativeMinimumDistance()` and `nativeBinaryHistogram()`.)
+//
+// The references are literal ports of Seer's original `HammingDistance` functions. Tables are checked both when built into
+// private memory and when stored to (and mapped back from) a directory.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "Bench.h"
+#include "NativeTasks.h"
+
+using namespace std;
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Reference implementation
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Seer's `HammingDistance.calcHammingDistance()`
+static int referenceHammingDistance(int64_t a, int64_t b)
+{
+	int64_t diffBits = a ^ b;
+	int hammingDistance = 0;
+
+	while (diffBits != 0)
+	{
+		hammingDistance += 1;
+		diffBits &= diffBits - 1;
+	}
+
+	return hammingDistance;
+}
+
+/// The index map of Seer's original `HammingDistance.calcErrorCorrectedMaps()`
+static void referenceErrorCorrectedIndices(const vector<int64_t> &codes, uint32_t bitCount, vector<int64_t> &mapCodeToErrorCorrectedIndex)
+{
+	const int64_t kUnassigned = -1;
+	const int64_t kCollision = -2;
+	int64_t fullRange = int64_t(1) << bitCount;
+
+	vector<int64_t> mapCodeToErrorCorrectedCode(fullRange, kUnassigned);
+	vector<int8_t> mapDistToErrorCorrectedCode(fullRange, static_cast<int8_t>(bitCount));
+	mapCodeToErrorCorrectedIndex.assign(fullRange, kUnassigned);
+
+	for (size_t cardIndex = 0; cardIndex < codes.size(); ++cardIndex)
+	{
+		int64_t cardCode = codes[cardIndex];
+		for (int64_t possibleValue = 0; possibleValue < fullRange; ++possibleValue)
+		{
+			int distance = referenceHammingDistance(possibleValue, cardCode);
+			int64_t minValue = mapCodeToErrorCorrectedCode[possibleValue];
+			int minDistance = mapDistToErrorCorrectedCode[possibleValue];
+
+			if (distance < minDistance)
+			{
+				mapCodeToErrorCorrectedCode[possibleValue] = cardCode;
+				mapDistToErrorCorrectedCode[possibleValue] = static_cast<int8_t>(distance);
+				mapCodeToErrorCorrectedIndex[possibleValue] = static_cast<int64_t>(cardIndex);
+				continue;
+			}
+
+			if (distance == minDistance)
+			{
+				if (minValue != kCollision)
+				{
+					mapCodeToErrorCorrectedCode[possibleValue] = kCollision;
+					mapDistToErrorCorrectedCode[possibleValue] = static_cast<int8_t>(distance);
+				}
+				continue;
+			}
+		}
+	}
+
+	for (int64_t i = 0; i < fullRange; ++i)
+	{
+		if (mapCodeToErrorCorrectedCode[i] == kCollision)
+		{
+			mapCodeToErrorCorrectedIndex[i] = kUnassigned;
+		}
+	}
+}
+
+/// Seer's original `HammingDistance.calcMinimumDistance()` (not reversible)
+static int referenceMinimumDistance(const vector<int64_t> &codes, int codeBits, int bestMinimumDistance)
+{
+	int mds = codeBits;
+	for (size_t i = 0; i < codes.size(); ++i)
+	{
+		int64_t iCode = codes[i];
+		for (size_t j = i + 1; j < codes.size(); ++j)
+		{
+			mds = min(mds, referenceHammingDistance(iCode, codes[j]));
+		}
+
+		if (mds < bestMinimumDistance) return 0;
+	}
+
+	return mds;
+}
+
+/// Seer's `HammingDistance.generateBinaryHistogram()` of the codes XORed with `mask` (as mdscodes' `optimizeBinaryDistribution()`)
+static void referenceBinaryHistogram(const vector<int64_t> &codes, int64_t mask, int bitCount, vector<int32_t> &histogram)
+{
+	histogram.assign(bitCount + 1, 0);
+	for (int64_t code : codes)
+	{
+		int bitsUsed = 0;
+		for (int i = 0; i < bitCount; ++i)
+		{
+			if (((code ^ mask) >> i) & 1) bitsUsed += 1;
+		}
+		histogram[bitsUsed] += 1;
+	}
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Local helpers
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Seer's `Int.reversedBits(bitCount:)`
+static int64_t reversedBits(int64_t code, uint32_t bitCount)
+{
+	int64_t reversed = 0;
+	for (uint32_t i = 0; i < bitCount; ++i)
+	{
+		reversed |= ((code >> i) & 1) << (bitCount - 1 - i);
+	}
+	return reversed;
+}
+
+/// Generates `cardCount` distinct random codes of `bitCount` bits, as `DeckFormat` lays out its `mapIndexToCode` (the reversed
+/// codes follow the forward codes, for reversible formats)
+static void generateCodes(BenchRandom &random, uint32_t cardCount, uint32_t bitCount, bool reversible, vector<int64_t> &codes)
+{
+	int64_t mask = (int64_t(1) << bitCount) - 1;
+	codes.clear();
+	while (codes.size() < cardCount)
+	{
+		int64_t code = static_cast<int64_t>(random.next()) & mask;
+		if (find(codes.begin(), codes.end(), code) != codes.end()) continue;
+		if (reversible && (code == reversedBits(code, bitCount) || find(codes.begin(), codes.end(), reversedBits(code, bitCount)) != codes.end())) continue;
+		codes.push_back(code);
+	}
+
+	if (reversible)
+	{
+		for (uint32_t i = 0; i < cardCount; ++i)
+		{
+			codes.push_back(reversedBits(codes[i], bitCount));
+		}
+	}
+}
+
+/// Returns true if `table` matches `expected`
+static bool tableMatches(const int16_t *table, const vector<int64_t> &expected)
+{
+	if (nullptr == table) return false;
+
+	for (size_t i = 0; i < expected.size(); ++i)
+	{
+		if (table[i] != expected[i]) return false;
+	}
+
+	return true;
+}
+
+/// Removes the stored tables from `directory`, along with the directory
+static void removeDirectory(const string &directory)
+{
+	string command = "rm -rf '" + directory + "'";
+	if (system(command.c_str()) != 0)
+	{
+		fprintf(stderr, "Unable to remove %s\n", directory.c_str());
+	}
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Benchmarks
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+int benchErrorCorrection(const BenchOptions &options)
+{
+	struct Format { uint32_t cardCount; uint32_t bitCount; bool reversible; };
+	static const Format kFormats[] =
+	{
+		{ 1, 1, false },
+		{ 52, 8, false },
+		{ 52, 12, true },
+		{ 54, 16, false },
+		{ 104, 20, true },
+	};
+
+	benchReportHeader("Error correction tables (units are values)");
+
+	char directoryTemplate[] = "/tmp/nativebench-ec-XXXXXX";
+	string directory = mkdtemp(directoryTemplate) ? directoryTemplate : "";
+
+	int failures = 0;
+	BenchRandom random;
+	vector<int64_t> codes;
+	vector<int64_t> expected;
+
+	for (const Format &format : kFormats)
+	{
+		string size = "2^" + to_string(format.bitCount) + " x " + to_string(format.cardCount) + (format.reversible ? " rev" : "");
+		uint64_t valueCount = uint64_t(1) << format.bitCount;
+		uint64_t bytes = valueCount * sizeof(int16_t);
+
+		generateCodes(random, format.cardCount, format.bitCount, format.reversible, codes);
+		uint32_t codeCount = static_cast<uint32_t>(codes.size());
+
+		if (benchFilter(options, "private"))
+		{
+			referenceErrorCorrectedIndices(codes, format.bitCount, expected);
+
+			const int16_t *table = nativeErrorCorrectionTableOpen(nullptr, codes.data(), codeCount, format.bitCount);
+			bool passed = tableMatches(table, expected);
+			nativeErrorCorrectionTableClose(table);
+			failures += passed ? 0 : 1;
+
+			if (options.verifyOnly)
+			{
+				benchReport("private", "native", size, valueCount, bytes, nullptr, passed);
+			}
+			else
+			{
+				BenchMeasurement measurement = benchMeasure(options, [&]()
+				{
+					referenceErrorCorrectedIndices(codes, format.bitCount, expected);
+				});
+				benchReport("private", "swift", size, valueCount, bytes, &measurement, true);
+
+				measurement = benchMeasure(options, [&]()
+				{
+					nativeErrorCorrectionTableClose(nativeErrorCorrectionTableOpen(nullptr, codes.data(), codeCount, format.bitCount));
+				});
+				benchReport("private", "native", size, valueCount, bytes, &measurement, passed);
+			}
+		}
+
+		if (benchFilter(options, "stored") && !directory.empty())
+		{
+			referenceErrorCorrectedIndices(codes, format.bitCount, expected);
+
+			// The first open stores the table, the second maps the stored table
+			const int16_t *built = nativeErrorCorrectionTableOpen(directory.c_str(), codes.data(), codeCount, format.bitCount);
+			const int16_t *mapped = nativeErrorCorrectionTableOpen(directory.c_str(), codes.data(), codeCount, format.bitCount);
+			bool passed = tableMatches(built, expected) && tableMatches(mapped, expected);
+			nativeErrorCorrectionTableClose(built);
+			nativeErrorCorrectionTableClose(mapped);
+
+			// A damaged table must be rebuilt rather than mapped
+			char filename[64];
+			snprintf(filename, sizeof(filename), "/ec-%u-", format.bitCount);
+			string command = "for f in '" + directory + "'" + filename + "*.table; do printf 'XXXX' | dd of=\"$f\" conv=notrunc 2>/dev/null; done";
+			passed = passed && system(command.c_str()) == 0;
+			const int16_t *rebuilt = nativeErrorCorrectionTableOpen(directory.c_str(), codes.data(), codeCount, format.bitCount);
+			passed = passed && tableMatches(rebuilt, expected);
+			nativeErrorCorrectionTableClose(rebuilt);
+			failures += passed ? 0 : 1;
+
+			if (options.verifyOnly)
+			{
+				benchReport("stored", "mapped", size, valueCount, bytes, nullptr, passed);
+			}
+			else
+			{
+				// Mapping doesn't touch the pages, so touch them all as a decode would, over time
+				BenchMeasurement measurement = benchMeasure(options, [&]()
+				{
+					const int16_t *table = nativeErrorCorrectionTableOpen(directory.c_str(), codes.data(), codeCount, format.bitCount);
+					int64_t sum = 0;
+					for (uint64_t i = 0; i < valueCount; i += 2048) sum += table[i];
+					if (sum == INT64_MAX) printf("\n");
+					nativeErrorCorrectionTableClose(table);
+				});
+				benchReport("stored", "mapped", size, valueCount, bytes, &measurement, passed);
+			}
+		}
+	}
+
+	if (!directory.empty()) removeDirectory(directory);
+
+	// Code analysis, over sets of codes the size of those mdscodes searches
+	struct CodeSet { uint32_t codeCount; uint32_t codeBits; };
+	static const CodeSet kCodeSets[] =
+	{
+		{ 0, 8 },
+		{ 1, 8 },
+		{ 300, 12 },
+		{ 1024, 18 },
+		{ 4096, 24 },
+	};
+
+	for (const CodeSet &codeSet : kCodeSets)
+	{
+		string size = to_string(codeSet.codeCount) + " x " + to_string(codeSet.codeBits);
+		uint64_t pairCount = uint64_t(codeSet.codeCount) * (codeSet.codeCount > 0 ? codeSet.codeCount - 1 : 0) / 2;
+		generateCodes(random, codeSet.codeCount, codeSet.codeBits, false, codes);
+		uint32_t codeCount = static_cast<uint32_t>(codes.size());
+		const int64_t *codeData = codes.empty() ? nullptr : codes.data();
+
+		if (benchFilter(options, "minimumDistance"))
+		{
+			// Check floors below, at and above the distance (which rejects the set)
+			int distance = referenceMinimumDistance(codes, codeSet.codeBits, 0);
+			bool passed = true;
+			for (int floor : { 0, distance - 1, distance, distance + 1, static_cast<int>(codeSet.codeBits) + 1 })
+			{
+				passed = passed && nativeMinimumDistance(codeData, codeCount, codeSet.codeBits, floor) == referenceMinimumDistance(codes, codeSet.codeBits, floor);
+			}
+			failures += passed ? 0 : 1;
+
+			if (options.verifyOnly || pairCount == 0)
+			{
+				benchReport("minimumDistance", "native", size, pairCount, 0, nullptr, passed);
+			}
+			else
+			{
+				// The result is kept, so that the (pure) reference isn't optimized away
+				volatile int result = 0;
+				BenchMeasurement measurement = benchMeasure(options, [&]() { result = referenceMinimumDistance(codes, codeSet.codeBits, 0); });
+				benchReport("minimumDistance", "swift", size, pairCount, 0, &measurement, true);
+
+				measurement = benchMeasure(options, [&]() { result = nativeMinimumDistance(codeData, codeCount, codeSet.codeBits, 0); });
+				benchReport("minimumDistance", "native", size, pairCount, 0, &measurement, passed);
+			}
+		}
+
+		if (benchFilter(options, "binaryHistogram"))
+		{
+			vector<int32_t> expectedHistogram;
+			vector<int32_t> histogram(codeSet.codeBits + 1);
+			bool passed = true;
+			for (int i = 0; i < 16; ++i)
+			{
+				int64_t mask = static_cast<int64_t>(random.next()) & ((int64_t(1) << codeSet.codeBits) - 1);
+				referenceBinaryHistogram(codes, mask, codeSet.codeBits, expectedHistogram);
+				nativeBinaryHistogram(codeData, codeCount, mask, codeSet.codeBits, histogram.data());
+				passed = passed && histogram == expectedHistogram;
+			}
+			failures += passed ? 0 : 1;
+
+			if (options.verifyOnly || codeCount == 0)
+			{
+				benchReport("binaryHistogram", "native", size, codeCount, 0, nullptr, passed);
+			}
+			else
+			{
+				BenchMeasurement measurement = benchMeasure(options, [&]() { referenceBinaryHistogram(codes, 0x5555, codeSet.codeBits, expectedHistogram); });
+				benchReport("binaryHistogram", "swift", size, codeCount, 0, &measurement, true);
+
+				measurement = benchMeasure(options, [&]() { nativeBinaryHistogram(codeData, codeCount, 0x5555, codeSet.codeBits, histogram.data()); });
+				benchReport("binaryHistogram", "native", size, codeCount, 0, &measurement, passed);
+			}
+		}
+	}
+
+	return failures;
+}
@@ -0,0 +1,479 @@
+//
+//  FastImageBench.cpp
+//  nativebench
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+//
+// Conformance and performance of the image conversion kernels (FastImage) for every instruction set available on this machine.
+//
+// The reference implementations here are intentionally written per-pixel from the definition of each operation, rather than being
+// copies of the NativeTasks scalar kernels, so that the scalar kernels are verified too.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#include "Bench.h"
+#include "NativeTasks.h"
+
+using namespace std;
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Reference implementations
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+static void reference2vuyToLuma(const vector<uint8_t> &src, vector<uint8_t> &dst)
+{
+	for (size_t i = 0; i < dst.size(); ++i) dst[i] = src[i * 2 + 1];
+}
+
+static void referenceLumaToColor(const vector<uint8_t> &src, vector<uint32_t> &dst)
+{
+	for (size_t i = 0; i < dst.size(); ++i) dst[i] = uint32_t(src[i]) * 0x010101;
+}
+
+static void referenceColorToLuma(const vector<uint32_t> &src, vector<uint8_t> &dst)
+{
+	for (size_t i = 0; i < dst.size(); ++i)
+	{
+		uint8_t b = src[i] & 0xff, g = (src[i] >> 8) & 0xff, r = (src[i] >> 16) & 0xff;
+		dst[i] = max(r, max(g, b));
+	}
+}
+
+template<class T>
+static void referenceNearestNeighbor(const vector<T> &src, uint32_t srcWidth, uint32_t srcHeight, vector<T> &dst, uint32_t dstWidth, uint32_t dstHeight)
+{
+	int dx = (srcWidth << 16) / dstWidth;
+	int dy = (srcHeight << 16) / dstHeight;
+	for (uint32_t y = 0; y < dstHeight; ++y)
+	{
+		for (uint32_t x = 0; x < dstWidth; ++x)
+		{
+			dst[y * dstWidth + x] = src[((y * dy) >> 16) * srcWidth + ((x * dx) >> 16)];
+		}
+	}
+}
+
+/// Box average of the source area covered by each destination pixel (downscale only)
+static void referenceLerpFast(const vector<uint8_t> &src, uint32_t srcWidth, uint32_t srcHeight, vector<uint8_t> &dst, uint32_t dstWidth, uint32_t dstHeight)
+{
+	int dx = (srcWidth << 16) / dstWidth;
+	int dy = (srcHeight << 16) / dstHeight;
+	for (uint32_t y = 0; y < dstHeight; ++y)
+	{
+		uint32_t y0 = (y * dy) >> 16, y1 = ((y + 1) * dy) >> 16;
+		for (uint32_t x = 0; x < dstWidth; ++x)
+		{
+			uint32_t x0 = (x * dx) >> 16, x1 = ((x + 1) * dx) >> 16;
+			uint32_t sum = 0;
+			for (uint32_t sy = y0; sy < y1; ++sy)
+			{
+				for (uint32_t sx = x0; sx < x1; ++sx) sum += src[sy * srcWidth + sx];
+			}
+			dst[y * dstWidth + x] = static_cast<uint8_t>(sum / ((y1 - y0) * (x1 - x0)));
+		}
+	}
+}
+
+/// Rotation by 180 degrees, matching the NativeTasks definition: the center row (odd heights) and center column (odd widths) are
+/// left in place
+static void referenceRotate180(const vector<uint8_t> &src, vector<uint8_t> &dst, uint32_t width, uint32_t height)
+{
+	dst = src;
+	for (uint32_t y = 0; y < height / 2; ++y)
+	{
+		uint32_t top = y * width;
+		uint32_t bot = (height - 1 - y) * width;
+		for (uint32_t x = 0; x < width / 2; ++x)
+		{
+			uint32_t mx = width - 1 - x;
+			dst[top + x] = src[bot + mx];
+			dst[top + mx] = src[bot + x];
+			dst[bot + x] = src[top + mx];
+			dst[bot + mx] = src[top + x];
+		}
+	}
+}
+
+/// Line sampling, written as a literal port of Seer's `SampleLine.sample()` and `SampleLine.sampleWide()`, appending to `dst`
+static void referenceSampleLine(const vector<uint8_t> &src, uint32_t width, int x0, int y0, int x1, int y1, bool wide, bool invert, vector<int32_t> &dst)
+{
+	const int kOne = 1 << 16;
+	const int kHalf = kOne / 2;
+	const int kWideAmount = 2;
+	int w = static_cast<int>(width);
+	int dx = x1 - x0, dy = y1 - y0;
+	int absDX = abs(dx), absDY = abs(dy);
+
+	auto sample = [&](int idx, int wideOffset, bool first)
+	{
+		if (!wide) dst.push_back(invert ? 255 - src[idx] : src[idx]);
+		else if (first) dst.push_back(src[idx]);
+		else dst.push_back((src[idx - wideOffset] + src[idx] * 2 + src[idx + wideOffset]) / 4);
+	};
+
+	if (absDX >= absDY)
+	{
+		int x = x0, y = y0 * kOne + kHalf;
+		int endX = x1, endY = y1 * kOne + kHalf;
+		int xStep = dx >= 0 ? 1 : -1;
+		int yStep = absDX == 0 ? 0 : dy * kOne / absDX;
+		y += endY - (y + yStep * absDX);
+
+		sample((y >> 16) * w + x, w * kWideAmount, true);
+		while (x != endX)
+		{
+			y += yStep;
+			x += xStep;
+			sample((y >> 16) * w + x, w * kWideAmount, false);
+		}
+	}
+	else
+	{
+		int x = x0 * kOne + kHalf, y = y0 * w;
+		int endX = x1 * kOne + kHalf, endY = y1 * w;
+		int xStep = absDY == 0 ? 0 : dx * kOne / absDY;
+		int yStep = dy >= 0 ? w : -w;
+		x += endX - (x + xStep * absDY);
+
+		sample(y + (x >> 16), kWideAmount, true);
+		while (y != endY)
+		{
+			x += xStep;
+			y += yStep;
+			sample(y + (x >> 16), kWideAmount, false);
+		}
+	}
+}
+
+/// Bit column sampling, written as a literal port of the sampling loop of Seer's `MarkLines.generateContouredMarkLines()`,
+/// appending each bit's row of samples to `dst` (or nothing, if a sample lies outside the image)
+static void referenceSampleBitColumns(const vector<uint8_t> &src, uint32_t width, uint32_t height, const vector<NativePoint> &lCenters, const vector<NativePoint> &rCenters, const vector<float> &bitCenters, bool invert, vector<int32_t> &dst)
+{
+	const int kOne = 1 << 16;
+	int scanlineCount = int(max(lCenters.size(), rCenters.size()));
+	int lCentersDeltaIndex = int(lCenters.size()) * kOne / scanlineCount;
+	int rCentersDeltaIndex = int(rCenters.size()) * kOne / scanlineCount;
+	size_t bitCount = bitCenters.size();
+
+	auto sample = [&](float x, float y, int32_t &luma)
+	{
+		int px = int(x), py = int(y);
+		if (px < 0 || py < 0 || px >= int(width) || py >= int(height)) return false;
+		luma = invert ? 255 - src[py * int(width) + px] : src[py * int(width) + px];
+		return true;
+	};
+
+	vector<int32_t> rows(bitCount * scanlineCount);
+	for (int scanlineIndex = 0; scanlineIndex < scanlineCount; ++scanlineIndex)
+	{
+		const NativePoint &l = lCenters[(lCentersDeltaIndex * scanlineIndex) >> 16];
+		const NativePoint &r = rCenters[(rCentersDeltaIndex * scanlineIndex) >> 16];
+		float lx = float(l.x), ly = float(l.y);
+		float dx = float(r.x) - lx, dy = float(r.y) - ly;
+		float dx2 = dx * dx, dy2 = dy * dy;
+		float len = float(sqrt(double(dx2 + dy2)));
+		float q = len == 0 ? 0 : 1.0f / len;
+		float nx = dx * q, ny = dy * q;
+
+		for (size_t bit = 0; bit < bitCount; ++bit)
+		{
+			float ox = dx * bitCenters[bit], oy = dy * bitCenters[bit];
+			float bx = lx + ox, by = ly + oy;
+			int32_t a, b, c;
+			if (!sample(bx, by, b) || !sample(bx - nx, by - ny, a) || !sample(bx + nx, by + ny, c)) return;
+			rows[bit * scanlineCount + scanlineIndex] = (a + b * 6 + c) / 8;
+		}
+	}
+
+	dst.insert(dst.end(), rows.begin(), rows.end());
+}
+
+/// Bit column transposition, written as a literal port of the bit combining loop of Seer's `MarkLines.generateBitWords()`
+/// (reading the bits from the packed layout of `nativeTransposeBitColumns()`)
+static void referenceTransposeBitColumns(const vector<uint8_t> &packed, uint32_t rowCount, uint32_t columnCount, vector<uint32_t> &dst)
+{
+	for (uint32_t i = 0; i < columnCount; ++i)
+	{
+		int32_t value = 0;
+		for (uint32_t j = 0; j < rowCount; ++j)
+		{
+			if ((packed[(i / 8) * 32 + j] >> (i % 8)) & 1)
+			{
+				value += int32_t(1u << j);
+			}
+		}
+
+		dst[i] = uint32_t(value);
+	}
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Case runner
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Returns a string describing the dimensions of an image (or an image resample)
+static string sizeString(uint32_t width, uint32_t height)
+{
+	char buf[32];
+	snprintf(buf, sizeof(buf), "%ux%u", width, height);
+	return buf;
+}
+
+/// Verifies (and optionally times) one kernel against its reference output, for every available instruction set
+///
+/// `reset` prepares `output` before each verification run (for in-place kernels, it restores the input.) Returns the number of
+/// instruction sets that failed verification.
+template<class T>
+static int runCase(const BenchOptions &options, const vector<string> &isas, const string &kernel, const string &size, uint64_t units, uint64_t bytes, const vector<T> &golden, vector<T> &output, const function<void()> &reset, const function<void()> &run)
+{
+	if (!benchFilter(options, kernel)) return 0;
+
+	int failures = 0;
+	for (const string &isa : isas)
+	{
+		nativeImageKernelsSelect(isa.c_str());
+
+		reset();
+		run();
+
+		bool passed = output == golden;
+		if (!passed)
+		{
+			failures += 1;
+			size_t first = mismatch(output.begin(), output.end(), golden.begin()).first - output.begin();
+			fprintf(stderr, "  %s/%s/%s: first mismatch at element %zu\n", kernel.c_str(), isa.c_str(), size.c_str(), first);
+		}
+
+		if (options.verifyOnly)
+		{
+			benchReport(kernel, isa, size, units, bytes, nullptr, passed);
+		}
+		else
+		{
+			BenchMeasurement measurement = benchMeasure(options, run);
+			benchReport(kernel, isa, size, units, bytes, &measurement, passed);
+		}
+	}
+
+	return failures;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Suite
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+int benchFastImage(const BenchOptions &options)
+{
+	// Common capture sizes, plus odd widths/heights and sizes that aren't multiples of any vector width
+	static const uint32_t kSizes[][2] =
+	{
+		{ 1920, 1080 },
+		{ 1280, 720 },
+		{ 1921, 1081 },
+		{ 1000, 563 },
+		{ 641, 479 },
+		{ 17, 9 },
+		{ 1, 1 },
+	};
+
+	vector<string> isas = benchImageIsas(options);
+	string active = nativeImageKernelsName();
+
+	benchReportHeader("FastImage kernels (units are destination pixels)");
+
+	int failures = 0;
+	BenchRandom random;
+	for (const auto &dims : kSizes)
+	{
+		uint32_t w = dims[0], h = dims[1];
+		uint32_t n = w * h;
+		string size = sizeString(w, h);
+
+		vector<uint8_t> yuv(n * 2), luma(n);
+		vector<uint32_t> color(n);
+		random.fill(yuv.data(), yuv.size());
+		random.fill(luma.data(), luma.size());
+		random.fill(color.data(), color.size());
+
+		vector<uint8_t> goldenLuma(n), outLuma(n);
+		vector<uint32_t> goldenColor(n), outColor(n);
+		auto clearLuma = [&]() { fill(outLuma.begin(), outLuma.end(), 0xcd); };
+		auto clearColor = [&]() { fill(outColor.begin(), outColor.end(), 0xcdcdcdcd); };
+
+		reference2vuyToLuma(yuv, goldenLuma);
+		failures += runCase(options, isas, "copy2vuyToLuma", size, n, n * 3, goldenLuma, outLuma, clearLuma,
+			[&]() { nativeCopy2vuyToLuma(yuv.data(), outLuma.data(), w, h); });
+
+		referenceLumaToColor(luma, goldenColor);
+		failures += runCase(options, isas, "copyLumaToColor", size, n, n * 5, goldenColor, outColor, clearColor,
+			[&]() { nativeCopyLumaToColor(luma.data(), outColor.data(), w, h); });
+
+		referenceColorToLuma(color, goldenLuma);
+		failures += runCase(options, isas, "copyColorToLuma", size, n, n * 5, goldenLuma, outLuma, clearLuma,
+			[&]() { nativeCopyColorToLuma(color.data(), outLuma.data(), w, h); });
+
+		referenceRotate180(luma, goldenLuma, w, h);
+		failures += runCase(options, isas, "rotate180", size, n, n * 2, goldenLuma, outLuma, [&]() { outLuma = luma; },
+			[&]() { nativeRotate180(outLuma.data(), w, h); });
+
+		// Line sampling: random lines in every direction (long and short), plus the image's edges and single points
+		for (int wide = 0; wide < 2; ++wide)
+		{
+			int margin = wide ? 2 : 0;
+			if (w <= uint32_t(margin * 2) || h <= uint32_t(margin * 2)) continue;
+
+			int maxX = int(w) - 1 - margin, maxY = int(h) - 1 - margin;
+			vector<int> lines = { margin, margin, maxX, margin, maxX, maxY, margin, maxY, margin, maxY, margin, margin, maxX, margin, maxX, margin };
+			for (int i = 0; i < 256; ++i)
+			{
+				for (int p = 0; p < 2; ++p)
+				{
+					lines.push_back(margin + int(random.next() % uint32_t(maxX - margin + 1)));
+					lines.push_back(margin + int(random.next() % uint32_t(maxY - margin + 1)));
+				}
+			}
+
+			vector<int32_t> goldenSamples, outSamples;
+			for (size_t i = 0; i < lines.size(); i += 4)
+			{
+				referenceSampleLine(luma, w, lines[i], lines[i + 1], lines[i + 2], lines[i + 3], wide != 0, (i / 4) % 2 == 1, goldenSamples);
+			}
+			outSamples.resize(goldenSamples.size());
+			uint64_t sampleCount = goldenSamples.size();
+
+			failures += runCase(options, isas, wide ? "sampleLineWide" : "sampleLine", size, sampleCount, sampleCount * (wide ? 7 : 5), goldenSamples, outSamples,
+				[&]() { fill(outSamples.begin(), outSamples.end(), -1); },
+				[&]()
+				{
+					int32_t *out = outSamples.data();
+					for (size_t i = 0; i < lines.size(); i += 4)
+					{
+						if (wide) out += nativeSampleLineWide(luma.data(), w, h, lines[i], lines[i + 1], lines[i + 2], lines[i + 3], out);
+						else out += nativeSampleLine(luma.data(), w, h, lines[i], lines[i + 1], lines[i + 2], lines[i + 3], (i / 4) % 2 == 1, out);
+					}
+				});
+		}
+
+		// Bit column sampling: wandering left and right landmark columns of different lengths, with the bit centers of a typical
+		// deck (plus one set that strays off of the image, which samples nothing)
+		if (w >= 64 && h >= 64)
+		{
+			vector<float> bitCenters;
+			for (int bit = 0; bit < 24; ++bit) bitCenters.push_back(0.04f + float(bit) * 0.04f + float(random.next() % 100) / 10000.0f);
+
+			vector<vector<NativePoint>> centerSets;
+			for (int set = 0; set < 3; ++set)
+			{
+				uint32_t count = h / 2 + random.next() % (h / 3);
+				vector<NativePoint> centers(count);
+				int64_t x = int64_t(set == 1 ? w * 7 / 8 : w / 8), top = int64_t(h / 8);
+				for (uint32_t i = 0; i < count; ++i)
+				{
+					x += int64_t(random.next() % 3) - 1;
+					centers[i].x = x;
+					centers[i].y = top + int64_t(i * (h * 3 / 4) / count);
+				}
+				centerSets.push_back(centers);
+			}
+
+			// The third set runs off of the bottom of the image
+			for (NativePoint &center : centerSets[2]) center.y += h / 2;
+
+			vector<int32_t> goldenSamples, outSamples;
+			vector<uint32_t> rowCounts;
+			for (int i = 0; i < 4; ++i)
+			{
+				const vector<NativePoint> &l = centerSets[0];
+				const vector<NativePoint> &r = centerSets[i < 2 ? 1 : 2];
+				size_t before = goldenSamples.size();
+				referenceSampleBitColumns(luma, w, h, l, r, bitCenters, i % 2 == 1, goldenSamples);
+				rowCounts.push_back(uint32_t((goldenSamples.size() - before) / bitCenters.size()));
+			}
+			outSamples.resize(goldenSamples.size());
+			uint64_t sampleCount = goldenSamples.size();
+
+			failures += runCase(options, isas, "sampleBitColumns", size, sampleCount, sampleCount * 7, goldenSamples, outSamples,
+				[&]() { fill(outSamples.begin(), outSamples.end(), -1); },
+				[&]()
+				{
+					int32_t *out = outSamples.data();
+					for (int i = 0; i < 4; ++i)
+					{
+						const vector<NativePoint> &l = centerSets[0];
+						const vector<NativePoint> &r = centerSets[i < 2 ? 1 : 2];
+						uint32_t count = nativeSampleBitColumns(luma.data(), w, h, l.data(), uint32_t(l.size()), r.data(), uint32_t(r.size()), bitCenters.data(), uint32_t(bitCenters.size()), i % 2 == 1, out, rowCounts[i]);
+						out += count * bitCenters.size();
+					}
+				});
+		}
+
+		// Resamples: typical viewport reductions, an odd reduction and (nearest-neighbor only) an enlargement
+		const uint32_t resampleSizes[][2] =
+		{
+			{ max(w / 2, 1u), max(h / 2, 1u) },
+			{ max(w * 2 / 7, 1u), max(h * 3 / 11, 1u) },
+			{ w * 3 / 2 + 1, h * 3 / 2 + 1 },
+		};
+
+		for (const auto &dstDims : resampleSizes)
+		{
+			uint32_t dw = dstDims[0], dh = dstDims[1];
+			uint32_t dn = dw * dh;
+			string resampleSize = size + ">" + sizeString(dw, dh);
+
+			vector<uint8_t> goldenDstLuma(dn), outDstLuma(dn);
+			vector<uint32_t> goldenDstColor(dn), outDstColor(dn);
+			auto clearDstLuma = [&]() { fill(outDstLuma.begin(), outDstLuma.end(), 0xcd); };
+			auto clearDstColor = [&]() { fill(outDstColor.begin(), outDstColor.end(), 0xcdcdcdcd); };
+
+			referenceNearestNeighbor(luma, w, h, goldenDstLuma, dw, dh);
+			failures += runCase(options, isas, "resampleNearestNeighborLuma", resampleSize, dn, dn * 2, goldenDstLuma, outDstLuma, clearDstLuma,
+				[&]() { nativeResampleNearestNeighborLuma(luma.data(), w, h, outDstLuma.data(), dw, dh); });
+
+			referenceNearestNeighbor(color, w, h, goldenDstColor, dw, dh);
+			failures += runCase(options, isas, "resampleNearestNeighborColor", resampleSize, dn, dn * 8, goldenDstColor, outDstColor, clearDstColor,
+				[&]() { nativeResampleNearestNeighborColor(color.data(), w, h, outDstColor.data(), dw, dh); });
+
+			// The box filter is only defined for reductions
+			if (dw <= w && dh <= h)
+			{
+				referenceLerpFast(luma, w, h, goldenDstLuma, dw, dh);
+				failures += runCase(options, isas, "resampleLerpFastLuma", resampleSize, dn, n + dn, goldenDstLuma, outDstLuma, clearDstLuma,
+					[&]() { nativeResampleLerpFastLuma(luma.data(), w, h, outDstLuma.data(), dw, dh); });
+			}
+		}
+	}
+
+	// Bit column transposition: typical deck widths (including one that fills a BitWord) and column counts (including partial
+	// groups)
+	const uint32_t transposeSizes[][2] = { { 24, 1024 }, { 32, 1003 }, { 7, 333 }, { 1, 1 } };
+	for (const auto &dims : transposeSizes)
+	{
+		uint32_t rowCount = dims[0], columnCount = dims[1];
+		vector<uint8_t> packed((columnCount + 7) / 8 * 32);
+		random.fill(packed.data(), packed.size());
+		for (size_t i = 0; i < packed.size(); ++i)
+		{
+			if (i % 32 >= rowCount) packed[i] = 0;
+		}
+
+		vector<uint32_t> goldenWords(columnCount), outWords(columnCount);
+		referenceTransposeBitColumns(packed, rowCount, columnCount, goldenWords);
+		failures += runCase(options, isas, "transposeBitColumns", sizeString(rowCount, columnCount), columnCount, packed.size() + columnCount * 4, goldenWords, outWords,
+			[&]() { fill(outWords.begin(), outWords.end(), 0xcdcdcdcd); },
+			[&]() { nativeTransposeBitColumns(packed.data(), columnCount, outWords.data()); });
+	}
+
+	nativeImageKernelsSelect(active.c_str());
+	return failures;
+}
@@ -0,0 +1,162 @@
+//
+//  FrameArenaBench.cpp
+//  nativebench
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+//
+// Conformance and performance of the frame arena (`nativeFrameArenaAllocate()`.)
+//
+// Each frame mimics the temporaries of a scan: every search line allocates its edges, mark locations and match indices, with
+// the lines split across worker threads. Allocations are checked for alignment and overlap, and the arena is checked to settle
+// into serving whole frames without the heap. The comparison is the same allocations made with `malloc()` and `free()`.
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+#include "Bench.h"
+#include "NativeTasks.h"
+
+using namespace std;
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Local types
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// A single allocation made during a frame
+struct FrameAllocation
+{
+	uint32_t size;
+	uint32_t alignment;
+};
+
+/// Returns the allocations for a frame of `lineCount` search lines
+static vector<FrameAllocation> generateFrame(BenchRandom &random, uint32_t lineCount)
+{
+	vector<FrameAllocation> allocations;
+	for (uint32_t i = 0; i < lineCount; ++i)
+	{
+		uint32_t edgeCount = 8 + random.next() % 120;
+		allocations.push_back({ edgeCount * 48, 8 });
+		allocations.push_back({ edgeCount / 2 * 112, 8 });
+		allocations.push_back({ 2 * 8 * 8, 8 });
+		if ((random.next() & 15) == 0) allocations.push_back({ 1 + random.next() % 1000, 64 });
+	}
+	return allocations;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Frames
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Makes the allocations of a frame across `threadCount` threads, storing each allocation's address into `pointers`
+///
+/// If `arena` is null, the allocations are made with `malloc()` (and freed) instead. If `fill` is set, each allocation is
+/// filled with its own index so that overlaps can be found later.
+static void runFrame(void *arena, const vector<FrameAllocation> &allocations, unsigned int threadCount, bool fill, vector<void *> &pointers)
+{
+	pointers.assign(allocations.size(), nullptr);
+
+	auto worker = [&](unsigned int first)
+	{
+		for (size_t i = first; i < allocations.size(); i += threadCount)
+		{
+			const FrameAllocation &allocation = allocations[i];
+			void *pMemory = arena ? nativeFrameArenaAllocate(arena, allocation.size, allocation.alignment) : malloc(allocation.size);
+			if (fill) memset(pMemory, static_cast<int>(i & 0xff), allocation.size);
+			pointers[i] = pMemory;
+			if (!arena) free(pMemory);
+		}
+	};
+
+	vector<thread> threads;
+	for (unsigned int i = 1; i < threadCount; ++i) threads.emplace_back(worker, i);
+	worker(0);
+	for (thread &t : threads) t.join();
+}
+
+/// Returns true if every allocation of a frame is aligned and still holds its own fill
+static bool frameMatches(const vector<FrameAllocation> &allocations, const vector<void *> &pointers)
+{
+	for (size_t i = 0; i < allocations.size(); ++i)
+	{
+		const uint8_t *pMemory = static_cast<const uint8_t *>(pointers[i]);
+		if (!pMemory || reinterpret_cast<uintptr_t>(pMemory) % allocations[i].alignment != 0) return false;
+
+		for (uint32_t j = 0; j < allocations[i].size; ++j)
+		{
+			if (pMemory[j] != static_cast<uint8_t>(i & 0xff)) return false;
+		}
+	}
+
+	return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Suite
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+int benchFrameArena(const BenchOptions &options)
+{
+	static const uint32_t kLineCounts[] = { 1, 64, 512 };
+	unsigned int threadCount = max(thread::hardware_concurrency(), 1u);
+
+	benchReportHeader("Frame arena (units are allocations)");
+
+	int failures = 0;
+	BenchRandom random;
+	vector<void *> pointers;
+
+	for (uint32_t lineCount : kLineCounts)
+	{
+		if (!benchFilter(options, "frame")) continue;
+
+		string size = to_string(lineCount) + " lines x " + to_string(threadCount);
+		vector<FrameAllocation> allocations = generateFrame(random, lineCount);
+		uint64_t bytes = 0;
+		for (const FrameAllocation &allocation : allocations) bytes += allocation.size;
+
+		// The first frame overflows the (tiny) block and the block grows to fit, after which the same frame needs no heap
+		void *arena = nativeFrameArenaCreate(0);
+		runFrame(arena, allocations, threadCount, true, pointers);
+		bool passed = frameMatches(allocations, pointers);
+		NativeFrameArenaStats first = nativeFrameArenaReset(arena);
+		passed = passed && first.allocations == allocations.size() && first.bytesUsed >= bytes && first.capacity >= first.bytesUsed;
+
+		runFrame(arena, allocations, threadCount, true, pointers);
+		passed = passed && frameMatches(allocations, pointers);
+		NativeFrameArenaStats second = nativeFrameArenaReset(arena);
+		passed = passed && second.allocations == allocations.size() && second.heapAllocations == 0 && second.capacity == first.capacity;
+		failures += passed ? 0 : 1;
+
+		if (options.verifyOnly)
+		{
+			benchReport("frame", "arena", size, allocations.size(), bytes, nullptr, passed);
+		}
+		else
+		{
+			BenchMeasurement measurement = benchMeasure(options, [&]() { runFrame(nullptr, allocations, threadCount, false, pointers); });
+			benchReport("frame", "malloc", size, allocations.size(), bytes, &measurement, true);
+
+			measurement = benchMeasure(options, [&]()
+			{
+				runFrame(arena, allocations, threadCount, false, pointers);
+				nativeFrameArenaReset(arena);
+			});
+			benchReport("frame", "arena", size, allocations.size(), bytes, &measurement, passed);
+		}
+
+		nativeFrameArenaDestroy(arena);
+	}
+
+	return failures;
+}
@@ -0,0 +1,314 @@
+//
+//  LumaArchiveBench.cpp
+//  nativebench
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+//
+// Conformance and performance of luma archives (`nativeLumaArchiveWriterCreate()` and `nativeLumaArchiveReaderOpen()`.)
+//
+// Archives are checked to read back every frame (and its header data) exactly, in any order, and to recover the complete frames
+// of an archive that was never closed, both with and without compression (the "codec" variants.) Every other frame is a smooth
+// gradient, so that compressed archives hold both compressed and raw (incompressible) frames. The comparison is Seer's one-file-per-frame `.luma` archiving, which scans the directory
+// for the next file number before writing each frame (here, a directory already holding a thousand frames.)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "Bench.h"
+#include "NativeTasks.h"
+
+using namespace std;
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Local types
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// A frame to archive, with the header data of a `.luma` file (offset x, offset y and angle)
+struct ArchiveFrame
+{
+	vector<uint8_t> luma;
+	uint8_t header[12];
+};
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Local helpers
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Returns `frameCount` frames of `width` x `height` samples, alternating between random and a gradient with a little noise
+static vector<ArchiveFrame> generateFrames(BenchRandom &random, uint32_t width, uint32_t height, uint32_t frameCount)
+{
+	vector<ArchiveFrame> frames(frameCount);
+	for (size_t i = 0; i < frames.size(); ++i)
+	{
+		ArchiveFrame &frame = frames[i];
+		frame.luma.resize(width * height);
+		random.fill(frame.luma.data(), frame.luma.size());
+		random.fill(frame.header, sizeof(frame.header));
+
+		if (i % 2 == 0) continue;
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				uint8_t &sample = frame.luma[y * width + x];
+				sample = static_cast<uint8_t>(64 + (x + y) * 128 / (width + height) + sample % 3);
+			}
+		}
+	}
+	return frames;
+}
+
+/// Writes `frames` to a new archive at `path`, compressed if `compress` is set
+///
+/// Returns false on error
+static bool writeArchive(const string &path, const vector<ArchiveFrame> &frames, uint32_t width, uint32_t height, bool compress)
+{
+	void *writer = nativeLumaArchiveWriterCreate(path.c_str(), 0, compress);
+	if (!writer) return false;
+
+	bool succeeded = true;
+	for (const ArchiveFrame &frame : frames)
+	{
+		succeeded = nativeLumaArchiveWriterAppend(writer, frame.luma.data(), width, height, frame.header, sizeof(frame.header)) && succeeded;
+	}
+
+	return nativeLumaArchiveWriterClose(writer) && succeeded;
+}
+
+/// Returns true if the archive at `path` holds the first `frameCount` of `frames`, reading them in reverse order
+static bool archiveMatches(const string &path, const vector<ArchiveFrame> &frames, size_t frameCount, uint32_t width, uint32_t height)
+{
+	void *reader = nativeLumaArchiveReaderOpen(path.c_str());
+	if (!reader) return false;
+
+	bool passed = nativeLumaArchiveReaderFrameCount(reader) == frameCount;
+	for (size_t i = frameCount; passed && i-- > 0; )
+	{
+		NativeLumaArchiveFrame frame;
+		passed = nativeLumaArchiveReaderFrame(reader, static_cast<uint32_t>(i), &frame) &&
+		         frame.width == width && frame.height == height && frame.headerSize == sizeof(frames[i].header) &&
+		         memcmp(frame.header, frames[i].header, sizeof(frames[i].header)) == 0 &&
+		         memcmp(frame.luma, frames[i].luma.data(), frames[i].luma.size()) == 0;
+	}
+
+	NativeLumaArchiveFrame frame;
+	passed = passed && !nativeLumaArchiveReaderFrame(reader, static_cast<uint32_t>(frameCount), &frame);
+
+	nativeLumaArchiveReaderClose(reader);
+	return passed;
+}
+
+/// Clears the index from the archive at `path` (as if it was never closed), optionally cutting `truncateBytes` from its end
+///
+/// Returns false on error
+static bool damageArchive(const string &path, off_t truncateBytes)
+{
+	int fd = open(path.c_str(), O_RDWR);
+	if (fd < 0) return false;
+
+	// The index offset follows the magic and version
+	uint64_t indexOffset = 0;
+	bool succeeded = pwrite(fd, &indexOffset, sizeof(indexOffset), 8) == sizeof(indexOffset);
+
+	struct stat info;
+	if (succeeded && truncateBytes > 0)
+	{
+		succeeded = fstat(fd, &info) == 0 && ftruncate(fd, info.st_size - truncateBytes) == 0;
+	}
+
+	close(fd);
+	return succeeded;
+}
+
+/// Writes `frames` as Seer does without an archive: each to its own `.luma` file, numbered after the largest in the directory
+///
+/// The files written are removed again, leaving the directory as it was.
+static void writeLumaFiles(const string &directory, const vector<ArchiveFrame> &frames, uint32_t width, uint32_t height)
+{
+	vector<string> paths;
+	for (const ArchiveFrame &frame : frames)
+	{
+		int largest = 0;
+		if (DIR *dir = opendir(directory.c_str()))
+		{
+			while (struct dirent *entry = readdir(dir))
+			{
+				largest = max(largest, atoi(entry->d_name));
+			}
+			closedir(dir);
+		}
+
+		paths.push_back(directory + "/" + to_string(largest + 1) + "-bench.luma");
+		FILE *fp = fopen(paths.back().c_str(), "wb");
+		if (!fp) continue;
+
+		int16_t dimensions[2] = { static_cast<int16_t>(width), static_cast<int16_t>(height) };
+		int32_t headerSize = sizeof(frame.header);
+		fwrite(dimensions, sizeof(dimensions), 1, fp);
+		fwrite(&headerSize, sizeof(headerSize), 1, fp);
+		fwrite(frame.header, sizeof(frame.header), 1, fp);
+		fwrite(frame.luma.data(), 1, frame.luma.size(), fp);
+		fclose(fp);
+	}
+
+	for (const string &path : paths) unlink(path.c_str());
+}
+
+/// Removes `directory` and everything in it
+static void removeDirectory(const string &directory)
+{
+	string command = "rm -rf '" + directory + "'";
+	if (system(command.c_str()) != 0)
+	{
+		fprintf(stderr, "Unable to remove %s\n", directory.c_str());
+	}
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Suite
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+int benchLumaArchive(const BenchOptions &options)
+{
+	struct Format { uint32_t width; uint32_t height; uint32_t frameCount; };
+	static const Format kFormats[] =
+	{
+		{ 1, 1, 1 },
+		{ 640, 480, 64 },
+		{ 1920, 1080, 16 },
+	};
+
+	// The number of frames already archived as files when archiving more
+	static const uint32_t kExistingFileCount = 1000;
+
+	benchReportHeader("Luma archives (units are frames)");
+
+	char directoryTemplate[] = "/tmp/nativebench-lumas-XXXXXX";
+	if (!mkdtemp(directoryTemplate))
+	{
+		fprintf(stderr, "Unable to create a temporary directory; skipping luma archives\n");
+		return 1;
+	}
+
+	string directory = directoryTemplate;
+	string path = directory + "/bench.lumas";
+	string filesDirectory = directory + "/files";
+
+	// Archived frames accumulate, so the directory of files isn't empty
+	mkdir(filesDirectory.c_str(), 0755);
+	for (uint32_t i = 1; i <= kExistingFileCount; ++i)
+	{
+		string existing = filesDirectory + "/" + to_string(i) + "-existing.luma";
+		close(open(existing.c_str(), O_WRONLY | O_CREAT, 0644));
+	}
+
+	int failures = 0;
+	BenchRandom random;
+
+	for (const Format &format : kFormats)
+	{
+		string size = to_string(format.width) + "x" + to_string(format.height) + " x " + to_string(format.frameCount);
+		vector<ArchiveFrame> frames = generateFrames(random, format.width, format.height, format.frameCount);
+		uint64_t bytes = uint64_t(format.width) * format.height * format.frameCount;
+
+		if (benchFilter(options, "write"))
+		{
+			bool passed = writeArchive(path, frames, format.width, format.height, false) &&
+			              archiveMatches(path, frames, frames.size(), format.width, format.height);
+			bool codecPassed = writeArchive(path, frames, format.width, format.height, true) &&
+			                   archiveMatches(path, frames, frames.size(), format.width, format.height);
+			failures += (passed ? 0 : 1) + (codecPassed ? 0 : 1);
+
+			if (options.verifyOnly)
+			{
+				benchReport("write", "archive", size, format.frameCount, bytes, nullptr, passed);
+				benchReport("write", "codec", size, format.frameCount, bytes, nullptr, codecPassed);
+			}
+			else
+			{
+				BenchMeasurement measurement = benchMeasure(options, [&]()
+				{
+					writeLumaFiles(filesDirectory, frames, format.width, format.height);
+				});
+				benchReport("write", "files", size, format.frameCount, bytes, &measurement, true);
+
+				measurement = benchMeasure(options, [&]()
+				{
+					writeArchive(path, frames, format.width, format.height, false);
+					unlink(path.c_str());
+				});
+				benchReport("write", "archive", size, format.frameCount, bytes, &measurement, passed);
+
+				measurement = benchMeasure(options, [&]()
+				{
+					writeArchive(path, frames, format.width, format.height, true);
+					unlink(path.c_str());
+				});
+				benchReport("write", "codec", size, format.frameCount, bytes, &measurement, codecPassed);
+			}
+		}
+
+		if (benchFilter(options, "recover"))
+		{
+			// Without its index, every frame is found by walking the records; a partly written last frame is left out
+			bool passed = writeArchive(path, frames, format.width, format.height, false) && damageArchive(path, 0) &&
+			              archiveMatches(path, frames, frames.size(), format.width, format.height);
+
+			size_t padding = (16 - (24 + sizeof(frames[0].header) + bytes / format.frameCount) % 16) % 16;
+			passed = passed && writeArchive(path, frames, format.width, format.height, false) &&
+			         damageArchive(path, static_cast<off_t>(8 + 8 * frames.size() + padding + 1)) &&
+			         archiveMatches(path, frames, frames.size() - 1, format.width, format.height);
+
+			// Compressed records vary in size, so only the walk over them is checked
+			bool codecPassed = writeArchive(path, frames, format.width, format.height, true) && damageArchive(path, 0) &&
+			                   archiveMatches(path, frames, frames.size(), format.width, format.height);
+			failures += (passed ? 0 : 1) + (codecPassed ? 0 : 1);
+
+			benchReport("recover", "archive", size, format.frameCount, bytes, nullptr, passed);
+			benchReport("recover", "codec", size, format.frameCount, bytes, nullptr, codecPassed);
+		}
+
+		if (benchFilter(options, "read") && !options.verifyOnly)
+		{
+			// Every frame, in reverse order, summing a sample from each row
+			auto readArchive = [&]()
+			{
+				void *reader = nativeLumaArchiveReaderOpen(path.c_str());
+				uint32_t sum = 0;
+				for (uint32_t i = nativeLumaArchiveReaderFrameCount(reader); i-- > 0; )
+				{
+					NativeLumaArchiveFrame frame;
+					if (!nativeLumaArchiveReaderFrame(reader, i, &frame)) continue;
+					for (uint32_t y = 0; y < frame.height; ++y) sum += frame.luma[y * frame.width];
+				}
+				if (sum == UINT32_MAX) printf("\n");
+				nativeLumaArchiveReaderClose(reader);
+			};
+
+			writeArchive(path, frames, format.width, format.height, false);
+			BenchMeasurement measurement = benchMeasure(options, readArchive);
+			benchReport("read", "archive", size, format.frameCount, bytes, &measurement, true);
+
+			writeArchive(path, frames, format.width, format.height, true);
+			measurement = benchMeasure(options, readArchive);
+			benchReport("read", "codec", size, format.frameCount, bytes, &measurement, true);
+		}
+	}
+
+	removeDirectory(directory);
+	return failures;
+}
@@ -0,0 +1,330 @@
+//
+//  LumaCodecBench.cpp
+//  nativebench
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+//
+// Conformance and performance of the lossless luma compression used by luma archives (`nativeLumaEncode()` and
+// `nativeLumaDecode()`.)
+//
+// Every frame must decode to exactly the samples encoded, and decoding must fail (rather than read past the data) when the
+// encoded data is cut short. Frames are flat, a synthetic scene (a lit gradient with a striped deck and a little sensor noise),
+// and pure noise, which can't be compressed at all. With `--media`, the recorded frames in a directory are measured as well, as
+// one batch. The compression ratio is reported with the size of each frame, and the speeds are in terms of the uncompressed
+// samples.
+
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "Bench.h"
+#include "NativeTasks.h"
+
+using namespace std;
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Local types
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// A recorded frame (see `loadRecordedFrames()`)
+struct RecordedFrame
+{
+	vector<uint8_t> luma;
+	uint32_t width;
+	uint32_t height;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Local helpers
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+/// Fills `luma` with a synthetic frame of `width` x `height` samples: a gradient with a striped band across the middle (the
+/// printed edges of a deck) and up to +/-2 of noise
+static void generateScene(BenchRandom &random, vector<uint8_t> &luma, uint32_t width, uint32_t height)
+{
+	luma.resize(size_t(width) * height);
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		bool inDeck = y >= height / 3 && y < height * 2 / 3;
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			int value = 40 + static_cast<int>((x + y) * 64 / (width + height));
+			if (inDeck && x >= width / 8 && x < width * 7 / 8)
+			{
+				value = (y / 3) % 2 ? 200 : 60;
+			}
+
+			value += static_cast<int>(random.next() % 5) - 2;
+			luma[size_t(y) * width + x] = static_cast<uint8_t>(value < 0 ? 0 : value > 255 ? 255 : value);
+		}
+	}
+}
+
+/// Returns true if `luma` survives encoding and decoding unchanged, and a decode of the encoded data cut short fails
+///
+/// The encoded size is returned in `encodedSize`.
+static bool roundTrips(const vector<uint8_t> &luma, uint32_t width, uint32_t height, size_t &encodedSize)
+{
+	vector<uint8_t> encoded(nativeLumaEncodeMaxSize(width, height));
+	encodedSize = nativeLumaEncode(luma.data(), width, height, encoded.data());
+	if (encodedSize > encoded.size() || encodedSize % 4 != 0) return false;
+
+	// Fill the output first, so that samples the decoder skips don't match by accident
+	vector<uint8_t> decoded(luma.size());
+	for (size_t i = 0; i < decoded.size(); ++i) decoded[i] = static_cast<uint8_t>(~luma[i]);
+
+	bool passed = nativeLumaDecode(encoded.data(), encodedSize, width, height, decoded.data()) && decoded == luma;
+
+	// The last word always holds at least one bit of the last code
+	if (encodedSize > 0)
+	{
+		passed = passed && !nativeLumaDecode(encoded.data(), encodedSize - 4, width, height, decoded.data());
+	}
+
+	return passed;
+}
+
+/// Returns true if `str` ends with `suffix`
+static bool hasSuffix(const string &str, const string &suffix)
+{
+	return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/// Appends the frame in the `.luma` file at `path` to `frames` (ignoring the file if it isn't valid)
+static void loadLumaFile(const string &path, vector<RecordedFrame> &frames)
+{
+	FILE *fp = fopen(path.c_str(), "rb");
+	if (!fp) return;
+
+	// Header: width (int16), height (int16), user data size (int32), user data, followed by the samples
+	int16_t dimensions[2];
+	int32_t userDataSize;
+	RecordedFrame frame;
+	if (fread(dimensions, sizeof(dimensions), 1, fp) == 1 && fread(&userDataSize, sizeof(userDataSize), 1, fp) == 1 &&
+	    dimensions[0] > 0 && dimensions[1] > 0 && userDataSize >= 0 && fseek(fp, userDataSize, SEEK_CUR) == 0)
+	{
+		frame.width = static_cast<uint32_t>(dimensions[0]);
+		frame.height = static_cast<uint32_t>(dimensions[1]);
+		frame.luma.resize(size_t(frame.width) * frame.height);
+		if (fread(frame.luma.data(), 1, frame.luma.size(), fp) == frame.luma.size()) frames.push_back(move(frame));
+	}
+
+	fclose(fp);
+}
+
+/// Appends every frame of the luma archive at `path` to `frames`
+static void loadLumaArchive(const string &path, vector<RecordedFrame> &frames)
+{
+	void *reader = nativeLumaArchiveReaderOpen(path.c_str());
+	if (!reader) return;
+
+	for (uint32_t i = 0; i < nativeLumaArchiveReaderFrameCount(reader); ++i)
+	{
+		NativeLumaArchiveFrame archived;
+		if (!nativeLumaArchiveReaderFrame(reader, i, &archived)) continue;
+
+		RecordedFrame frame;
+		frame.width = archived.width;
+		frame.height = archived.height;
+		frame.luma.assign(archived.luma, archived.luma + size_t(frame.width) * frame.height);
+		frames.push_back(move(frame));
+	}
+
+	nativeLumaArchiveReaderClose(reader);
+}
+
+/// Returns the frames of every `.luma` file and luma archive in `directory` (in name order)
+static vector<RecordedFrame> loadRecordedFrames(const string &directory)
+{
+	vector<string> names;
+	if (DIR *dir = opendir(directory.c_str()))
+	{
+		while (struct dirent *entry = readdir(dir))
+		{
+			names.push_back(entry->d_name);
+		}
+		closedir(dir);
+	}
+	sort(names.begin(), names.end());
+
+	vector<RecordedFrame> frames;
+	for (const string &name : names)
+	{
+		if (hasSuffix(name, ".luma")) loadLumaFile(directory + "/" + name, frames);
+		else if (hasSuffix(name, ".lumas")) loadLumaArchive(directory + "/" + name, frames);
+	}
+
+	return frames;
+}
+
+/// Verifies and measures the recorded frames in `options.mediaPath` as a batch, returning the number of failures
+static int benchRecordedFrames(const BenchOptions &options)
+{
+	vector<RecordedFrame> frames = loadRecordedFrames(options.mediaPath);
+	if (frames.empty())
+	{
+		fprintf(stderr, "No recorded frames in %s\n", options.mediaPath.c_str());
+		return 0;
+	}
+
+	uint64_t samples = 0;
+	uint64_t encodedBytes = 0;
+	size_t largest = 0;
+	bool passed = true;
+	for (const RecordedFrame &frame : frames)
+	{
+		size_t encodedSize = 0;
+		passed = roundTrips(frame.luma, frame.width, frame.height, encodedSize) && passed;
+		samples += frame.luma.size();
+		encodedBytes += encodedSize;
+		largest = max(largest, frame.luma.size());
+	}
+
+	char size[32];
+	snprintf(size, sizeof(size), "%zu frames @ %.2f:1", frames.size(), static_cast<double>(samples) / static_cast<double>(encodedBytes));
+
+	if (options.verifyOnly)
+	{
+		if (benchFilter(options, "encode")) benchReport("encode", "media", size, samples, samples, nullptr, passed);
+		if (benchFilter(options, "decode")) benchReport("decode", "media", size, samples, samples, nullptr, passed);
+		return passed ? 0 : 1;
+	}
+
+	// Each frame's encoding is kept, so that decoding is measured on its own
+	vector<vector<uint8_t>> encoded(frames.size());
+	for (size_t i = 0; i < frames.size(); ++i)
+	{
+		encoded[i].resize(nativeLumaEncodeMaxSize(frames[i].width, frames[i].height));
+	}
+
+	vector<uint64_t> encodedSizes(frames.size());
+	vector<uint8_t> decoded(largest);
+	auto encodeAll = [&]()
+	{
+		for (size_t i = 0; i < frames.size(); ++i)
+		{
+			encodedSizes[i] = nativeLumaEncode(frames[i].luma.data(), frames[i].width, frames[i].height, encoded[i].data());
+		}
+	};
+
+	encodeAll();
+	if (benchFilter(options, "encode"))
+	{
+		BenchMeasurement measurement = benchMeasure(options, encodeAll);
+		benchReport("encode", "media", size, samples, samples, &measurement, passed);
+	}
+
+	if (benchFilter(options, "decode"))
+	{
+		BenchMeasurement measurement = benchMeasure(options, [&]()
+		{
+			for (size_t i = 0; i < frames.size(); ++i)
+			{
+				nativeLumaDecode(encoded[i].data(), encodedSizes[i], frames[i].width, frames[i].height, decoded.data());
+			}
+		});
+		benchReport("decode", "media", size, samples, samples, &measurement, passed);
+	}
+
+	return passed ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Suite
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+int benchLumaCodec(const BenchOptions &options)
+{
+	struct Format { uint32_t width; uint32_t height; bool timed; };
+	static const Format kFormats[] =
+	{
+		{ 1, 1, false },
+		{ 1, 7, false },
+		{ 7, 1, false },
+		{ 33, 17, false },
+		{ 640, 480, true },
+		{ 1920, 1080, true },
+	};
+
+	static const char *kContents[] = { "flat", "scene", "noise" };
+
+	benchReportHeader("Luma compression (units are samples; sizes show the compression ratio)");
+
+	int failures = 0;
+	BenchRandom random;
+
+	for (const Format &format : kFormats)
+	{
+		for (const char *content : kContents)
+		{
+			vector<uint8_t> luma;
+			if (strcmp(content, "flat") == 0)
+			{
+				luma.assign(size_t(format.width) * format.height, 128);
+			}
+			else if (strcmp(content, "scene") == 0)
+			{
+				generateScene(random, luma, format.width, format.height);
+			}
+			else
+			{
+				luma.resize(size_t(format.width) * format.height);
+				random.fill(luma.data(), luma.size());
+			}
+
+			size_t encodedSize = 0;
+			bool passed = roundTrips(luma, format.width, format.height, encodedSize);
+			failures += passed ? 0 : 1;
+
+			char size[32];
+			snprintf(size, sizeof(size), "%ux%u @ %.2f:1", format.width, format.height,
+			         static_cast<double>(luma.size()) / static_cast<double>(encodedSize));
+
+			uint64_t samples = luma.size();
+			if (options.verifyOnly || !format.timed)
+			{
+				if (benchFilter(options, "encode")) benchReport("encode", content, size, samples, samples, nullptr, passed);
+				if (benchFilter(options, "decode")) benchReport("decode", content, size, samples, samples, nullptr, passed);
+				continue;
+			}
+
+			vector<uint8_t> encoded(nativeLumaEncodeMaxSize(format.width, format.height));
+			vector<uint8_t> decoded(luma.size());
+
+			if (benchFilter(options, "encode"))
+			{
+				BenchMeasurement measurement = benchMeasure(options, [&]()
+				{
+					nativeLumaEncode(luma.data(), format.width, format.height, encoded.data());
+				});
+				benchReport("encode", content, size, samples, samples, &measurement, passed);
+			}
+
+			if (benchFilter(options, "decode"))
+			{
+				nativeLumaEncode(luma.data(), format.width, format.height, encoded.data());
+				BenchMeasurement measurement = benchMeasure(options, [&]()
+				{
+					nativeLumaDecode(encoded.data(), encodedSize, format.width, format.height, decoded.data());
+				});
+				benchReport("decode", content, size, samples, samples, &measurement, passed);
+			}
+		}
+	}
+
+	if (!options.mediaPath.empty())
+	{
+		failures += benchRecordedFrames(options);
+	}
+
+	return failures;
+}
@@ -0,0 +1,137 @@
+//
+//  main.cpp
+//  nativebench
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+//
+// Bit-exact conformance tests and micro-benchmarks for the NativeTasks kernels.
+//
+// This only depends on NativeTasks (no MMAL, no Swift), so it builds and runs on any Linux or Mac development machine:
+//
+//     ./build nativebench && .out/release/nativebench --verify
+//
+// The exit code is non-zero if any kernel fails verification.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <algorithm>
+
+#include "Bench.h"
+#include "NativeTasks.h"
+
+using namespace std;
+
+/// A named benchmark suite
+struct Suite
+{
+	const char *name;
+	int (*run)(const BenchOptions &options);
+};
+
+static const Suite kSuites[] =
+{
+	{ "image", benchFastImage },
+	{ "minmax", benchRollMinMax },
+	{ "edges", benchEdgeDetection },
+	{ "ecc", benchErrorCorrection },
+	{ "arena", benchFrameArena },
+	{ "lumas", benchLumaArchive },
+	{ "codec", benchLumaCodec },
+};
+
+static void printUsage(const char *programName)
+{
+	printf("Usage: %s [options] [suite [suite]...]\n", programName);
+	printf("\n");
+	printf("  SUITES:\n");
+	for (const Suite &suite : kSuites)
+	{
+		printf("      %s\n", suite.name);
+	}
+	printf("\n");
+	printf("      If no suites are specified, all suites are run.\n");
+	printf("\n");
+	printf("  OPTIONS:\n");
+	printf("      --verify | -v          Verify results bit-for-bit against the reference implementations, without timing.\n");
+	printf("      --filter | -f <text>   Only run kernels whose name contains <text>.\n");
+	printf("      --isa <name>           Only run the given instruction set (scalar, sse2, avx2, neon.)\n");
+	printf("      --time <seconds>       Minimum measurement time per kernel (default: 0.25.)\n");
+	printf("      --media <directory>    Also measure the recorded frames (.luma and .lumas files) in <directory> (codec.)\n");
+	printf("      --help | -h            Yer lookin' at it\n");
+}
+
+int main(int argc, char *argv[])
+{
+	BenchOptions options;
+	vector<string> suiteNames;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--verify" || arg == "-v")
+		{
+			options.verifyOnly = true;
+		}
+		else if ((arg == "--filter" || arg == "-f") && hasValue)
+		{
+			options.filter = argv[++i];
+		}
+		else if (arg == "--isa" && hasValue)
+		{
+			options.isa = argv[++i];
+		}
+		else if (arg == "--time" && hasValue)
+		{
+			options.minSeconds = atof(argv[++i]);
+		}
+		else if (arg == "--media" && hasValue)
+		{
+			options.mediaPath = argv[++i];
+		}
+		else if (arg == "--help" || arg == "-h")
+		{
+			printUsage(argv[0]);
+			return 0;
+		}
+		else if (arg[0] != '-')
+		{
+			suiteNames.push_back(arg);
+		}
+		else
+		{
+			fprintf(stderr, "Unknown or incomplete option: %s\n\n", arg.c_str());
+			printUsage(argv[0]);
+			return 2;
+		}
+	}
+
+	printf("Default image kernels: %s\n", nativeImageKernelsName());
+
+	int failures = 0;
+	int suitesRun = 0;
+	for (const Suite &suite : kSuites)
+	{
+		if (!suiteNames.empty() && find(suiteNames.begin(), suiteNames.end(), suite.name) == suiteNames.end()) continue;
+
+		failures += suite.run(options);
+		suitesRun += 1;
+	}
+
+	if (suitesRun == 0)
+	{
+		fprintf(stderr, "No matching suites\n");
+		return 2;
+	}
+
+	printf("\n%s: %d failure(s)\n", failures == 0 ? "PASSED" : "FAILED", failures);
+	return failures == 0 ? 0 : 1;
+}
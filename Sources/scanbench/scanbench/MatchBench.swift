@@ -0,0 +1,137 @@
+//
+//  MatchBench.swift
+//  scanbench
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+import Foundation
+import Seer
+import Minion
+
+/// Verifies and times the deck matcher (`CodeDefinition.bestMatch()`) on mark sets recorded from real frames
+///
+/// The mark sets are recorded by scanning media with `--record-marks` (see `MarkSetRecorder`.) Every set is first matched by both
+/// `bestMatch()` and the original matcher, which must agree exactly (see `MarkSetPlayback.verify()`.) Each matcher then matches
+/// the full collection of sets, `repeatCount` times over; the fastest pass of each is reported.
+final class MatchBench
+{
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Properties
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	private let playback: MarkSetPlayback
+	private let repeatCount: Int
+
+	/// The number of sets for which the matchers disagreed
+	private(set) var mismatchCount = 0
+
+	/// The number of sets matched (the same for either matcher, unless they disagree)
+	private var matchCount = 0
+
+	/// The time spent matching every set, for each pass of each matcher
+	private var passTimesMS = [Double]()
+	private var referencePassTimesMS = [Double]()
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Initialization
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Prepares to match the sets from `playback`, `repeatCount` times over
+	init(playback: MarkSetPlayback, repeatCount: Int)
+	{
+		self.playback = playback
+		self.repeatCount = repeatCount
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Implementation
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Verifies the matcher, then times both matchers
+	///
+	/// Returns false if there are no sets to match
+	func run() -> Bool
+	{
+		if playback.count == 0 { return false }
+
+		mismatchCount = playback.verify()
+
+		// Alternate the matchers, so that neither gets the benefit of a quieter machine
+		for _ in 0..<repeatCount
+		{
+			var start = PausableTime.getTimeMS()
+			matchCount = playback.matchAll()
+			passTimesMS.append(PausableTime.getTimeMS() - start)
+
+			start = PausableTime.getTimeMS()
+			_ = playback.matchAll(reference: true)
+			referencePassTimesMS.append(PausableTime.getTimeMS() - start)
+		}
+
+		return true
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Reporting
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// The time to match a single set, in microseconds, from the fastest pass of `passTimesMS`
+	private func microsecondsPerSet(_ passTimesMS: [Double]) -> Double
+	{
+		return (passTimesMS.min() ?? 0) * 1000 / Double(playback.count)
+	}
+
+	/// How many times faster `bestMatch()` is than the original matcher
+	private var speedup: Double
+	{
+		let us = microsecondsPerSet(passTimesMS)
+		return us <= 0 ? 0 : microsecondsPerSet(referencePassTimesMS) / us
+	}
+
+	/// Returns the results as a JSON document, for comparing builds and devices
+	func generateJson() -> String
+	{
+		let document: [String: Any] =
+		[
+			"host": ProcessInfo.processInfo.hostName,
+			"seerVersion": SeerVersion,
+			"minionVersion": MinionVersion,
+			"codeDefinition": playback.codeDefinition.format.name,
+			"sets": playback.count,
+			"marks": playback.markCount,
+			"matched": matchCount,
+			"mismatches": mismatchCount,
+			"passes": repeatCount,
+			"bestMatchUSPerSet": (microsecondsPerSet(passTimesMS) * 1000).rounded() / 1000,
+			"referenceUSPerSet": (microsecondsPerSet(referencePassTimesMS) * 1000).rounded() / 1000,
+			"speedup": (speedup * 100).rounded() / 100,
+		]
+
+		guard let data = try? JSONSerialization.data(withJSONObject: document, options: [.prettyPrinted, .sortedKeys]) else
+		{
+			return "{}"
+		}
+
+		return String(data: data, encoding: .utf8) ?? "{}"
+	}
+
+	/// Returns the results as text
+	func generateText() -> String
+	{
+		var text = "\(playback.count) mark sets for '\(playback.codeDefinition.format.name)'"
+		text += String(format: " (%.1f marks per set), %d matched, fastest of %d passes\n", arguments:
+			[Double(playback.markCount) / Double(playback.count), matchCount, repeatCount])
+		text += "\n"
+		text += String(format: "  bestMatch   %9.3f us/set\n", microsecondsPerSet(passTimesMS))
+		text += String(format: "  reference   %9.3f us/set (%.1fx)\n", microsecondsPerSet(referencePassTimesMS), speedup)
+		text += "\n"
+		text += mismatchCount == 0 ? "  Verified: every set matched the reference\n" : "  FAILED: \(mismatchCount) set(s) differ from the reference\n"
+		return text
+	}
+}
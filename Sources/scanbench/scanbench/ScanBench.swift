@@ -0,0 +1,400 @@
+//
+//  ScanBench.swift
+//  scanbench
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+import Foundation
+import Seer
+import Minion
+
+/// Scans recorded media as fast as possible, measuring each stage of the scan
+///
+/// Every frame goes through the same steps as a frame in whisper (see `MediaConsumer.processFrame()`): it is preprocessed,
+/// scanned and (optionally) validated, then the per-frame state is reset. There is no viewport, no debug buffer and no server.
+///
+/// Media is scanned in the order given, as one continuous stream of frames (as whisper plays a list of videos), so that the
+/// temporal state and history carry from one frame to the next as they would live.
+final class ScanBench
+{
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Local types
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// A stage of the scan that we measure
+	///
+	/// Stages are measured by the `PerfTimer` (from the times it tracks inside `ScanManager`) except for preprocessing, which we
+	/// time ourselves. Some of the tracked times include others, which are subtracted out (as `generatePerfStatsText()` does.)
+	private struct Stage
+	{
+		/// The name we report the stage by
+		let name: String
+
+		/// The name the stage is tracked by in the `PerfTimer` (or nil if we time it ourselves)
+		let perfTimerName: String?
+
+		/// The tracked names of stages that run within this one
+		let nested: [String]
+
+		/// The time spent in this stage by each frame that ran it
+		var samplesMS = [Double]()
+
+		init(_ name: String, _ perfTimerName: String?, nested: [String] = [])
+		{
+			self.name = name
+			self.perfTimerName = perfTimerName
+			self.nested = nested
+		}
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Properties
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// The extension of a single-frame luma file
+	private static let kLumaFileExtension = "luma"
+
+	/// The stages we report, in the order they run
+	private var stages =
+	[
+		Stage("preprocess", nil),
+		Stage("search", "Deck Search", nested: ["Trace marks"]),
+		Stage("trace", "Trace marks"),
+		Stage("decode", "Deck Decode", nested: ["Merge History", "Resolve"]),
+		Stage("merge", "Merge History"),
+		Stage("resolve", "Resolve"),
+		Stage("scan", "Scan"),
+	]
+
+	/// The total time spent on each frame (preprocessing and scanning)
+	private var frameTimesMS = [Double]()
+
+	/// The number of times each tracked stage had run as of the previous frame (so we know which stages ran in a frame)
+	private var lastCounts = [String: Int]()
+
+	/// The media scanned (their names, in order)
+	private var mediaNames = [String]()
+
+	/// The time spent scanning, including reading and decoding the media
+	private var elapsedMS: Double = 0
+
+	private let scanManager = ScanManager()
+	private let resultValidator = ResultValidator()
+	private let codeDefinition: CodeDefinition
+	private let validate: Bool
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Initialization
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Prepares to scan with `codeDefinition`, validating each result against the test deck if `validate` is set
+	init(codeDefinition: CodeDefinition, validate: Bool)
+	{
+		self.codeDefinition = codeDefinition
+		self.validate = validate
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Implementation
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Scans every frame of the media in `paths`, `repeatCount` times over
+	///
+	/// A directory is scanned as its `.luma` files, luma archives and videos (in name order.) Returns false if there was nothing
+	/// to scan.
+	func run(paths: [PathString], repeatCount: Int) -> Bool
+	{
+		var mediaPaths = [PathString]()
+		for path in paths
+		{
+			if path.isDirectory()
+			{
+				for name in path.contentsOfDirectory().sorted() where ScanBench.isMedia(name: name)
+				{
+					mediaPaths.append(path + name)
+				}
+			}
+			else if path.isFile()
+			{
+				mediaPaths.append(path)
+			}
+			else
+			{
+				gLogger.error("No such file or directory: \(path)")
+			}
+		}
+
+		if mediaPaths.isEmpty { return false }
+
+		let start = PausableTime.getTimeMS()
+		for _ in 0..<max(repeatCount, 1)
+		{
+			for path in mediaPaths
+			{
+				scanMedia(path: path)
+			}
+		}
+		elapsedMS = PausableTime.getTimeMS() - start
+
+		mediaNames = mediaPaths.map { $0.lastComponent() ?? $0.toString() }
+		return !frameTimesMS.isEmpty
+	}
+
+	/// Returns true if the file `name` has an extension of media we can scan
+	private static func isMedia(name: String) -> Bool
+	{
+		let fileExtension = PathString(name).lowercased().toUrl().pathExtension
+		return fileExtension == kLumaFileExtension || fileExtension == LumaArchiveWriter.fileExtension ||
+		       VideoFrameReader.fileExtensions.contains(fileExtension)
+	}
+
+	/// Scans each frame of the media at `path`
+	private func scanMedia(path: PathString)
+	{
+		let fileExtension = path.lowercased().toUrl().pathExtension
+
+		if fileExtension == ScanBench.kLumaFileExtension
+		{
+			var userData = Data()
+			guard let image = try? LumaBuffer(fromLumaFile: path, userData: &userData) else
+			{
+				gLogger.error("Unable to load luma file: \(path)")
+				return
+			}
+
+			scanFrame(image)
+		}
+		else if fileExtension == LumaArchiveWriter.fileExtension
+		{
+			guard let archive = try? LumaArchiveReader(path: path) else { return }
+
+			for index in 0..<archive.count
+			{
+				// Frames are scanned in place (they may be modified without changing the archive)
+				guard let frame = archive.frame(at: index) else
+				{
+					gLogger.error("Unable to read frame \(index) of luma archive: \(path)")
+					continue
+				}
+
+				scanFrame(frame.image)
+			}
+		}
+		else
+		{
+			guard let video = VideoFrameReader(path: path) else { return }
+
+			while let image = video.nextFrame()
+			{
+				scanFrame(image)
+			}
+		}
+	}
+
+	/// Scans `image` and records the time spent in each stage
+	private func scanFrame(_ image: LumaBuffer)
+	{
+		let frameStart = PerfTimer.trackBegin()
+		image.preprocess()
+		let preprocessMS = PausableTime.getTimeMS() - frameStart
+
+		let analysisResult = scanManager.scan(debugBuffer: nil, lumaBuffer: image, codeDefinition: codeDefinition)
+		frameTimesMS.append(PausableTime.getTimeMS() - frameStart)
+
+		if validate
+		{
+			_ = resultValidator.validateResults(debugBuffer: nil, codeDefinition: codeDefinition, stats: &scanManager.resultStats, analysisResult: analysisResult)
+		}
+
+		for i in 0..<stages.count
+		{
+			guard let name = stages[i].perfTimerName else
+			{
+				stages[i].samplesMS.append(preprocessMS)
+				continue
+			}
+
+			// A stage that did not run in this frame has no time to record (as opposed to a time of zero)
+			guard let sample = PerfTimer.getStat(name: name), sample.count != lastCounts[name] else { continue }
+			lastCounts[name] = sample.count
+
+			var ms = Double(sample.lastMS)
+			for nestedName in stages[i].nested
+			{
+				ms -= Double(PerfTimer.getStat(name: nestedName)?.lastMS ?? 0)
+			}
+			stages[i].samplesMS.append(ms)
+		}
+
+		// Next frame
+		PerfTimer.nextFrame()
+		FrameArena.instance.nextFrame()
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Reporting
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Returns the value at `percentile` (0...1) of the sorted `values` (the nearest rank), or 0 if there are none
+	private static func percentile(_ percentile: Double, of values: [Double]) -> Double
+	{
+		if values.isEmpty { return 0 }
+		let rank = Int((percentile * Double(values.count)).rounded(.up))
+		return values[min(max(rank, 1), values.count) - 1]
+	}
+
+	/// Returns the mean of `values`, or 0 if there are none
+	private static func mean(of values: [Double]) -> Double
+	{
+		return values.isEmpty ? 0 : values.reduce(0, +) / Double(values.count)
+	}
+
+	/// Returns `ms` rounded to the microsecond (anything finer is noise, and only clutters the JSON)
+	private static func toMicroseconds(_ ms: Double) -> Double
+	{
+		return (ms * 1000).rounded() / 1000
+	}
+
+	/// Returns the count, mean and percentiles of `samplesMS`
+	private static func summarize(_ samplesMS: [Double]) -> [String: Any]
+	{
+		let sorted = samplesMS.sorted()
+		return [
+			"count": sorted.count,
+			"meanMS": toMicroseconds(mean(of: sorted)),
+			"p50MS": toMicroseconds(percentile(0.50, of: sorted)),
+			"p90MS": toMicroseconds(percentile(0.90, of: sorted)),
+			"p99MS": toMicroseconds(percentile(0.99, of: sorted)),
+			"maxMS": toMicroseconds(sorted.last ?? 0),
+		]
+	}
+
+	/// The number of frames scanned per second, overall (including reading and decoding the media)
+	private var framesPerSecond: Double { return elapsedMS <= 0 ? 0 : Double(frameTimesMS.count) * 1000 / elapsedMS }
+
+	/// The number of frames scanned per second, by the time spent preprocessing and scanning alone
+	private var scanFramesPerSecond: Double
+	{
+		let scanMS = frameTimesMS.reduce(0, +)
+		return scanMS <= 0 ? 0 : Double(frameTimesMS.count) * 1000 / scanMS
+	}
+
+	/// Returns the results as a JSON document, for comparing builds and devices
+	func generateJson() -> String
+	{
+		let stats = scanManager.resultStats
+
+		var stageSummaries = [String: Any]()
+		for stage in stages
+		{
+			stageSummaries[stage.name] = ScanBench.summarize(stage.samplesMS)
+		}
+		stageSummaries["frame"] = ScanBench.summarize(frameTimesMS)
+
+		var outcomes: [String: Any] =
+		[
+			"search": [
+				"notFound": stats.searchNotFoundCount,
+				"tooSmall": stats.searchTooSmallCount,
+				"decodable": stats.searchDecodableCount,
+			],
+			"decode": [
+				"blurry": stats.decodeBlurryCount,
+				"tooFewCards": stats.decodeTooFewCardsCount,
+				"generalFailure": stats.decodeGeneralFailureCount,
+				"decoded": stats.decodeDecodedCount,
+			],
+			"analysis": [
+				"failure": stats.analyzedFailureCount,
+				"inconclusive": stats.analyzedInconclusiveCount,
+				"insufficientHistory": stats.analyzedInsufficientHistoryCount,
+				"insufficientConfidence": stats.analyzedInsufficientConfidenceCount,
+				"reportLowConfidence": stats.analyzedReportLowConfidenceCount,
+				"reportHighConfidence": stats.analyzedReportHighConfidenceCount,
+			],
+		]
+
+		if validate
+		{
+			outcomes["validation"] =
+			[
+				"decodeCorrect": stats.validatedDecodeCorrectCount,
+				"decodeIncorrect": stats.validatedDecodeIncorrectCount,
+				"decodeMissedCards": stats.validatedDecodeMissedCardCount,
+				"decodeOutOfOrderCards": stats.validatedDecodeOutOfOrderCardCount,
+				"reportIncorrect": stats.validatedReportIncorrectCount,
+				"reportCorrectLowConfidence": stats.validatedReportCorrectLowConfidenceCount,
+				"reportCorrectHighConfidence": stats.validatedReportCorrectHighConfidenceCount,
+				"scanCorrect": stats.validatedScanCorrectCount,
+				"scanIncorrect": stats.validatedScanIncorrectCount,
+			]
+		}
+
+		let document: [String: Any] =
+		[
+			"host": ProcessInfo.processInfo.hostName,
+			"seerVersion": SeerVersion,
+			"minionVersion": MinionVersion,
+			"codeDefinition": codeDefinition.format.name,
+			"media": mediaNames,
+			"frames": frameTimesMS.count,
+			"elapsedMS": ScanBench.toMicroseconds(elapsedMS),
+			"framesPerSecond": (framesPerSecond * 100).rounded() / 100,
+			"scanFramesPerSecond": (scanFramesPerSecond * 100).rounded() / 100,
+			"stages": stageSummaries,
+			"outcomes": outcomes,
+		]
+
+		guard let data = try? JSONSerialization.data(withJSONObject: document, options: [.prettyPrinted, .sortedKeys]) else
+		{
+			return "{}"
+		}
+
+		return String(data: data, encoding: .utf8) ?? "{}"
+	}
+
+	/// Returns the results as text
+	func generateText() -> String
+	{
+		let stats = scanManager.resultStats
+
+		var text = String(format: "%d frames from %d media in %.2fs: %.1f fps (%.1f fps scanning alone)\n", arguments:
+			[frameTimesMS.count, mediaNames.count, elapsedMS / 1000, framesPerSecond, scanFramesPerSecond])
+		text += "\n"
+		text += "  Stage (ms)     count      mean       p50       p90       p99       max\n"
+
+		var rows = stages.map { ($0.name, $0.samplesMS) }
+		rows.append(("frame", frameTimesMS))
+		for (name, samplesMS) in rows
+		{
+			let sorted = samplesMS.sorted()
+			text += "  " + name.padding(toLength: 12, withPad: " ", startingAt: 0)
+			text += String(format: " %7d %9.3f %9.3f %9.3f %9.3f %9.3f\n", arguments:
+				[sorted.count,
+				 ScanBench.mean(of: sorted),
+				 ScanBench.percentile(0.50, of: sorted),
+				 ScanBench.percentile(0.90, of: sorted),
+				 ScanBench.percentile(0.99, of: sorted),
+				 sorted.last ?? 0])
+		}
+
+		text += "\n"
+		text += "  Search:   \(stats.generateSearchStatsText())\n"
+		text += "  Decode:   \(stats.generateDecodeStatsText())\n"
+		text += "  Analyze:  \(stats.generateAnalyzerStatsText())\n"
+		if validate
+		{
+			text += "  Correct:  \(stats.generateValidatedDecodeCorrectStatsText())\n"
+			text += "  Reports:  \(stats.generateValidatedReportsStatsText())\n"
+			text += "  Overall:  \(stats.generateValidatedOverallStatsText())\n"
+		}
+
+		return text
+	}
+}
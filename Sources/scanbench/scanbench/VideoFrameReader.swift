@@ -0,0 +1,143 @@
+//
+//  VideoFrameReader.swift
+//  scanbench
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+import Foundation
+import Seer
+import Minion
+
+/// Reads the luma planes of a video's frames, in order, by way of `ffmpeg`
+///
+/// Whisper's video decoder (`VideoDecode`) is built into whisper itself, along with its libav dependencies. Rather than share
+/// them, this runs `ffmpeg` (and `ffprobe`, for the frame size) from the PATH and reads the raw Y plane of each frame from its
+/// output. That is the same plane whisper scans, untouched by any range conversion. Decoding happens in another process, so it
+/// runs alongside scanning and stays out of the scan times.
+final class VideoFrameReader
+{
+	/// The file extensions we treat as video
+	static let fileExtensions = ["mp4", "m4v", "mov", "mkv", "avi", "h264", "264", "mjpeg"]
+
+	/// The path of the video
+	let path: PathString
+
+	/// The size of each frame
+	let width: Int
+	let height: Int
+
+	/// The decoder process
+	private let process = Process()
+
+	/// The decoder's output
+	private let pipe = Pipe()
+
+	/// The frame most recently read (see `nextFrame()`)
+	private let frame: LumaBuffer
+
+	/// Starts decoding the video at `path`
+	///
+	/// Returns nil if the video's frame size cannot be determined or the decoder cannot be started
+	init?(path: PathString)
+	{
+		self.path = path
+
+		guard let size = VideoFrameReader.probeFrameSize(path: path) else
+		{
+			gLogger.error("Unable to determine the frame size (is ffprobe installed?): \(path)")
+			return nil
+		}
+
+		width = size.x
+		height = size.y
+		frame = LumaBuffer(width: width, height: height)
+
+		process.executableURL = URL(fileURLWithPath: "/usr/bin/env")
+		process.arguments = ["ffmpeg", "-nostdin", "-v", "error", "-i", path.toString(), "-map", "0:v:0",
+		                     "-vf", "extractplanes=y", "-f", "rawvideo", "-pix_fmt", "gray", "-"]
+		process.standardOutput = pipe
+
+		do
+		{
+			try process.run()
+		}
+		catch
+		{
+			gLogger.error("Unable to start ffmpeg (\(error.localizedDescription)): \(path)")
+			return nil
+		}
+	}
+
+	deinit
+	{
+		// Stops the decoder if we stopped reading before the end of the video
+		if process.isRunning
+		{
+			process.terminate()
+			process.waitUntilExit()
+		}
+	}
+
+	/// Returns the next frame, or nil at the end of the video
+	///
+	/// The frame is reused, so it is only valid until the next call.
+	func nextFrame() -> LumaBuffer?
+	{
+		let frameBytes = width * height
+		let handle = pipe.fileHandleForReading
+
+		var data = Data(capacity: frameBytes)
+		while data.count < frameBytes
+		{
+			let chunk = handle.readData(ofLength: frameBytes - data.count)
+			if chunk.isEmpty { return nil }
+			data.append(chunk)
+		}
+
+		data.withUnsafeBytes
+		{
+			frame.buffer.assign(from: $0.bindMemory(to: Luma.self).baseAddress!, count: frameBytes)
+		}
+
+		return frame
+	}
+
+	/// Returns the frame size of the first video stream of the video at `path`, or nil if it cannot be determined
+	private static func probeFrameSize(path: PathString) -> IVector?
+	{
+		let probe = Process()
+		let output = Pipe()
+		probe.executableURL = URL(fileURLWithPath: "/usr/bin/env")
+		probe.arguments = ["ffprobe", "-v", "error", "-select_streams", "v:0", "-show_entries", "stream=width,height",
+		                   "-of", "csv=s=x:p=0", path.toString()]
+		probe.standardOutput = output
+
+		do
+		{
+			try probe.run()
+		}
+		catch
+		{
+			return nil
+		}
+
+		let data = output.fileHandleForReading.readDataToEndOfFile()
+		probe.waitUntilExit()
+
+		// The output is "<width>x<height>"
+		guard let text = String(data: data, encoding: .utf8) else { return nil }
+		let dimensions = text.trimmingCharacters(in: .whitespacesAndNewlines).split(separator: "x")
+		guard dimensions.count == 2, let width = Int(dimensions[0]), let height = Int(dimensions[1]), width > 0, height > 0 else
+		{
+			return nil
+		}
+
+		return IVector(x: width, y: height)
+	}
+}
@@ -0,0 +1,263 @@
+//
+//  main.swift
+//  scanbench
+//
+//  Created by Paul Nettle on 10/16/26.
+//
+// This file is part of The Nettle Magic Project.
+// Copyright © 2022 Paul Nettle. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file in the root of the source tree.
+
+import Foundation
+import Seer
+import Minion
+import NativeTasks
+
+/// The configuration shared with whisper, so that scans are configured the same way
+private let kConfigFileBaseName = "whisper.conf"
+
+private var optJson = false
+private var optValidate = false
+private var optRepeatCount = 1
+private var optCodeDefinitionName: String?
+private var optRecordMarksPath: PathString?
+private var optMatchPath: PathString?
+private var optPaths = [PathString]()
+
+private func printUsage()
+{
+	let programName = PathString(CommandLine.arguments[0]).lastComponent() ?? "scanbench"
+
+	print("Usage: \(programName) [options] media-path [media-path...]")
+	print("       \(programName) [options] --match <file>")
+	print("")
+	print("  Scans every frame of the recorded media as fast as possible (no UI, no server) and reports the frame rate, the")
+	print("  latency of each stage of the scan and the outcome of each frame.")
+	print("")
+	print("  With --match, verifies and times the deck matcher on the mark sets recorded (with --record-marks) in <file>")
+	print("  instead.")
+	print("")
+	print("  OPTIONS:")
+	print("")
+	print("      -c <name>  (--code <name>)       Override the Code Definition in \(kConfigFileBaseName)")
+	print("      -h         (--help)              Yer lookin' at it")
+	print("      -j         (--json)              Report as JSON (and log to the log file only)")
+	print("      -m <file>  (--record-marks <file>)")
+	print("                                       Record the marks found along each search line to <file>")
+	print("                 (--match <file>)      Match the marks recorded in <file> (with the code definition they")
+	print("                                       were recorded with)")
+	print("      -r <count> (--repeat <count>)    Scan the media (or match the marks) <count> times over")
+	print("      -v         (--validate)          Validate each result against the test deck")
+	print("")
+	print("  ARGUMENTS:")
+	print("")
+	print("      media-path                       A .luma file, a luma archive (.lumas), a video, or a directory of them")
+	print("                                       (scanned in name order)")
+	print("")
+	print("  NOTES:")
+	print("")
+	print("  * Videos are decoded with ffmpeg and ffprobe, which must be in the PATH")
+	print("")
+	print("  * All media are scanned as one continuous stream of frames, in the order given")
+	print("")
+}
+
+func error(_ message: String) -> Bool
+{
+	print("ERROR: \(message)")
+	printUsage()
+	return false
+}
+
+/// Processes the command line arguments, setting flags and configuration values as necessary
+///
+/// Returns true if parsing was successful, otherwise false. Callers should call `printUsage` on a false return unless they have
+/// a valid reason for not doing so.
+private func parseArguments() -> Bool
+{
+	var i = 1
+	while i < CommandLine.arguments.count
+	{
+		let arg = CommandLine.arguments[i]
+		i += 1
+
+		if arg.hasPrefix("-")
+		{
+			switch arg
+			{
+				case "-c", "--code":
+					if i >= CommandLine.arguments.count { return error("Option \(arg) requires a code definition name") }
+					optCodeDefinitionName = CommandLine.arguments[i]
+					i += 1
+				case "-h", "--help":
+					printUsage()
+					return false
+				case "-j", "--json":
+					optJson = true
+				case "-m", "--record-marks":
+					if i >= CommandLine.arguments.count { return error("Option \(arg) requires a file") }
+					optRecordMarksPath = PathString(CommandLine.arguments[i])
+					i += 1
+				case "--match":
+					if i >= CommandLine.arguments.count { return error("Option \(arg) requires a file") }
+					optMatchPath = PathString(CommandLine.arguments[i])
+					i += 1
+				case "-r", "--repeat":
+					if i >= CommandLine.arguments.count { return error("Option \(arg) requires a count") }
+					guard let value = Int(CommandLine.arguments[i]), value > 0 else
+					{
+						return error("Invalid count: \(CommandLine.arguments[i])")
+					}
+					optRepeatCount = value
+					i += 1
+				case "-v", "--validate":
+					optValidate = true
+				default:
+					return error("Unknown option: '\(arg)'")
+			}
+		}
+		else
+		{
+			optPaths.append(PathString(arg))
+		}
+	}
+
+	if optMatchPath != nil
+	{
+		if !optPaths.isEmpty || optRecordMarksPath != nil { return error("Option --match does not scan media") }
+		return true
+	}
+
+	if optPaths.isEmpty { return error("No media to scan") }
+	return true
+}
+
+/// Verifies and times the deck matcher on the mark sets recorded in `path` (see `MatchBench`)
+///
+/// Returns false if the marks could not be matched, or if the matcher failed verification
+private func matchMarks(path: PathString) -> Bool
+{
+	guard let playback = MarkSetPlayback(path: path) else { return false }
+
+	let matchBench = MatchBench(playback: playback, repeatCount: optRepeatCount)
+	if !matchBench.run()
+	{
+		gLogger.error("No mark sets to match: \(path)")
+		return false
+	}
+
+	print(optJson ? matchBench.generateJson() : matchBench.generateText())
+	return matchBench.mismatchCount == 0
+}
+
+/// Initialize the logging subsystem
+///
+/// Logs go to the log file, as they do for whisper, and to the console unless the console is reserved for JSON output
+private func initLogging()
+{
+	if !gLogger.registerDevice(device: LogDeviceFile(logFileLocations: Config.logFileLocations, truncate: Config.logResetOnStart), logMasks: Config.logMasks)
+	{
+		gLogger.error("Unable to register file logging device")
+	}
+
+	if !optJson
+	{
+		if !gLogger.registerDevice(device: LogDeviceConsole(), logMasks: Config.logMasks)
+		{
+			gLogger.error("Unable to register console logging device")
+		}
+	}
+
+	// Register the loggers with the native interface
+	typealias LogOutputCapture = @convention(c) (UnsafePointer<CChar>) -> Void
+	nativeLogRegisterDebug(unsafeBitCast( { gLogger.debug(String(cString: $0)) } as LogOutputCapture, to: NativeLogReceiver.self))
+	nativeLogRegisterInfo(unsafeBitCast( { gLogger.info(String(cString: $0)) } as LogOutputCapture, to: NativeLogReceiver.self))
+	nativeLogRegisterWarn(unsafeBitCast( { gLogger.warn(String(cString: $0)) } as LogOutputCapture, to: NativeLogReceiver.self))
+	nativeLogRegisterError(unsafeBitCast( { gLogger.error(String(cString: $0)) } as LogOutputCapture, to: NativeLogReceiver.self))
+	nativeLogRegisterSevere(unsafeBitCast( { gLogger.severe(String(cString: $0)) } as LogOutputCapture, to: NativeLogReceiver.self))
+	nativeLogRegisterFatal(unsafeBitCast( { gLogger.fatal(String(cString: $0)) } as LogOutputCapture, to: NativeLogReceiver.self))
+	nativeLogRegisterTrace(unsafeBitCast( { gLogger.trace(String(cString: $0)) } as LogOutputCapture, to: NativeLogReceiver.self))
+	nativeLogRegisterPerf(unsafeBitCast( { gLogger.perf(String(cString: $0)) } as LogOutputCapture, to: NativeLogReceiver.self))
+	nativeLogRegisterStatus(unsafeBitCast( { gLogger.status(String(cString: $0)) } as LogOutputCapture, to: NativeLogReceiver.self))
+	nativeLogRegisterFrame(unsafeBitCast( { gLogger.frame(String(cString: $0)) } as LogOutputCapture, to: NativeLogReceiver.self))
+	nativeLogRegisterSearch(unsafeBitCast( { gLogger.search(String(cString: $0)) } as LogOutputCapture, to: NativeLogReceiver.self))
+	nativeLogRegisterDecode(unsafeBitCast( { gLogger.decode(String(cString: $0)) } as LogOutputCapture, to: NativeLogReceiver.self))
+	nativeLogRegisterResolve(unsafeBitCast( { gLogger.resolve(String(cString: $0)) } as LogOutputCapture, to: NativeLogReceiver.self))
+	nativeLogRegisterBadResolve(unsafeBitCast( { gLogger.badResolve(String(cString: $0)) } as LogOutputCapture, to: NativeLogReceiver.self))
+	nativeLogRegisterCorrect(unsafeBitCast( { gLogger.correct(String(cString: $0)) } as LogOutputCapture, to: NativeLogReceiver.self))
+	nativeLogRegisterIncorrect(unsafeBitCast( { gLogger.incorrect(String(cString: $0)) } as LogOutputCapture, to: NativeLogReceiver.self))
+	nativeLogRegisterResult(unsafeBitCast( { gLogger.result(String(cString: $0)) } as LogOutputCapture, to: NativeLogReceiver.self))
+	nativeLogRegisterBadReport(unsafeBitCast( { gLogger.badReport(String(cString: $0)) } as LogOutputCapture, to: NativeLogReceiver.self))
+	nativeLogRegisterNetwork(unsafeBitCast( { gLogger.network(String(cString: $0)) } as LogOutputCapture, to: NativeLogReceiver.self))
+	nativeLogRegisterNetworkData(unsafeBitCast( { gLogger.networkData(String(cString: $0)) } as LogOutputCapture, to: NativeLogReceiver.self))
+	nativeLogRegisterVideo(unsafeBitCast( { gLogger.video(String(cString: $0)) } as LogOutputCapture, to: NativeLogReceiver.self))
+	nativeLogRegisterAlways(unsafeBitCast( { gLogger.always(String(cString: $0)) } as LogOutputCapture, to: NativeLogReceiver.self))
+
+	// Start the logger
+	gLogger.start(broadcastMessage: ">>> Session starting")
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------------
+// Run the thing
+// ---------------------------------------------------------------------------------------------------------------------------------
+
+// Disable output buffering
+#if os(macOS)
+setbuf(__stdoutp, nil)
+#else
+setbuf(stdout, nil)
+#endif
+
+if parseArguments()
+{
+	CodeDefinition.loadCodeDefinitions()
+	Config.loadConfiguration(configBaseName: kConfigFileBaseName)
+
+	initLogging()
+
+	if let name = optCodeDefinitionName
+	{
+		Config.searchCodeDefinition = CodeDefinition.findCodeDefinition(byName: name)
+	}
+
+	if let matchPath = optMatchPath
+	{
+		if !matchMarks(path: matchPath) { exit(1) }
+	}
+	else if let codeDefinition = Config.searchCodeDefinition
+	{
+		if let recordMarksPath = optRecordMarksPath
+		{
+			MarkSetRecorder.active = MarkSetRecorder(path: recordMarksPath, codeDefinition: codeDefinition)
+		}
+
+		let scanBench = ScanBench(codeDefinition: codeDefinition, validate: optValidate)
+		let scanned = scanBench.run(paths: optPaths, repeatCount: optRepeatCount)
+
+		// Stop recording, then write what we recorded
+		if let recorder = MarkSetRecorder.active
+		{
+			MarkSetRecorder.active = nil
+			if !recorder.write() { exit(1) }
+		}
+
+		if scanned
+		{
+			print(optJson ? scanBench.generateJson() : scanBench.generateText())
+		}
+		else
+		{
+			gLogger.error("No frames were scanned")
+			exit(1)
+		}
+	}
+	else
+	{
+		gLogger.error("Unknown code definition: \(optCodeDefinitionName ?? "- none configured -")")
+		exit(1)
+	}
+
+	gLogger.stop()
+}
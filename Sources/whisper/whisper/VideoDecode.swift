@@ -12,6 +12,7 @@
 
 #if os(macOS) || os(Linux)
 
+import Foundation
 import C_Libav
 import Seer
 import Minion
@@ -23,8 +24,53 @@ import Minion
 /// Video capture management class
 ///
 /// Performs initialization and capture of live video data
+///
+/// Decoding runs ahead of the caller on its own thread (see `decodeFrames()`), filling a small pool of reusable frames (see
+/// `DecodedFrame`.) The codec itself is threaded as configured by `Config.captureVideoDecodeThreads` and
+/// `Config.captureVideoDecodeSliceThreads`.
 public class VideoDecode
 {
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Local constants
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// FFmpeg's `AVERROR(EAGAIN)` and `AVERROR_EOF` (function-like macros, which aren't imported)
+	private static let kAvErrorAgain = -EAGAIN
+	private static let kAvErrorEof: Int32 = -0x20464f45 // -MKTAG('E', 'O', 'F', ' ')
+
+	/// How long the decoder thread sleeps while every frame in the pool is in use
+	private static let kFreeFramePollIntervalMS = 2
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Local types
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// A reusable frame in the decode pool
+	///
+	/// When the decoded luma plane is packed (its stride matches its width) and the frame is writable (nothing else, such as the
+	/// codec's reference frames, holds its buffers), `lumaBuffer` wraps the decoder's own memory, which is kept alive by the
+	/// reference held in `pFrame`. Otherwise, the plane is copied row by row into a `lumaBuffer` owned by this frame, which is
+	/// reused as long as the frame size doesn't change. Either way, the caller is the only user of the luma it is given.
+	///
+	/// A frame is reused once it is no longer waiting to be returned from `frame()` and the caller has released its
+	/// `lumaBuffer`.
+	private final class DecodedFrame
+	{
+		/// The decoded frame, referencing the decoder's buffers for as long as `lumaBuffer` wraps them
+		var pFrame: UnsafeMutablePointer<AVFrame>? = av_frame_alloc()
+
+		/// The luma plane, as returned from `frame()`
+		var lumaBuffer: LumaBuffer?
+
+		/// True while this frame is waiting to be returned from `frame()`
+		var queued = false
+
+		deinit
+		{
+			av_frame_free(&pFrame)
+		}
+	}
+
 	// -----------------------------------------------------------------------------------------------------------------------------
 	// Properties
 	// -----------------------------------------------------------------------------------------------------------------------------
@@ -44,12 +90,32 @@ public class VideoDecode
     private var mpCodec: UnsafeMutablePointer<AVCodec>?
 #endif
 	private var mpCodecCtx: UnsafeMutablePointer<AVCodecContext>?
-	private var mpFrame: UnsafeMutablePointer<AVFrame>?
 	private var mPacket = AVPacket()
 	private var mVideoStreamIndex = 0
 
+	/// The pool of frames (see `DecodedFrame`)
+	///
+	/// The pool only ever grows, and is kept between videos so that a frame still held by the caller remains valid.
+	private var mFrames = [DecodedFrame]()
+
+	/// Frames waiting to be returned from `frame()`, in decode order
+	private var mReadyFrames = [DecodedFrame]()
+
+	/// Guards `mFrames` and `mReadyFrames` (along with the state of each frame) while the decoder thread is running
+	private let mFramesMutex = PThreadMutex()
+
+	/// Signalled once for each frame added to `mReadyFrames`, and once more when the decoder thread has finished
+	private var mReadySemaphore = DispatchSemaphore(value: 0)
+
+	/// Asks the decoder thread to finish
+	private let mStopRequested = AtomicFlag()
+
+	/// Signalled when the decoder thread has finished (this is nil when the decoder thread isn't running)
+	private var mDecoderStopped: DispatchSemaphore?
+
 	/// Decoding stats
 	private var mDecodedFrameCount = 0
+	private var mCopiedFrameCount = 0
 	private var mNonVideoFrameCount = 0
 
 	/// Tracks our one-time initialization
@@ -193,6 +259,11 @@ public class VideoDecode
 				throw VideoDecodeError.Codec("Failed to transfer parameters")
 			}
 
+			// Frame threading decodes several frames at once, while slice threading splits each frame across threads; the codec
+			// uses whichever of these it (and the stream) supports
+			mpCodecCtx?.pointee.thread_count = Int32(max(Config.captureVideoDecodeThreads, 0))
+			mpCodecCtx?.pointee.thread_type = FF_THREAD_FRAME | (Config.captureVideoDecodeSliceThreads ? FF_THREAD_SLICE : 0)
+
 			gLogger.debug("  >> Opening the codec")
 
 			// Open codec
@@ -201,10 +272,7 @@ public class VideoDecode
 				throw VideoDecodeError.Codec("Could not open codec")
 			}
 
-			// Setup our frame
-			mpFrame = av_frame_alloc()
-
-			gLogger.video("  >> Decoding video...")
+			gLogger.video("  >> Decoding video with \(mpCodecCtx?.pointee.thread_count ?? 1) thread(s)...")
 
 			mVideoInitialized = true
 		}
@@ -217,12 +285,15 @@ public class VideoDecode
 
 		// Reset our frame counts
 		mDecodedFrameCount = 0
+		mCopiedFrameCount = 0
 		mNonVideoFrameCount = 0
 
+		startDecoderThread()
+
 		return mVideoInitialized
 	}
 
-	/// Decode and return the next frame of video data
+	/// Returns the next frame of video data
 	///
 	/// Returns a valid frame of video or `nil` in the following cases:
 	///
@@ -232,78 +303,32 @@ public class VideoDecode
 	///
 	/// In any case, if this method returns `nil`, then the video decoder is automatically stopped. When this happens, it is
 	/// unnecessary (but safe) to call `stop()`.
+	///
+	/// Frames are decoded ahead of time on the decoder thread, so this only waits if the decoder has fallen behind. The returned
+	/// buffer belongs to a pool that is reused once it is released, and holding on to it keeps its frame out of the pool. It is
+	/// never shared with the codec, so it may be modified (as `LumaBuffer.preprocess()` does.) It remains valid for as long as it
+	/// is held (and this `VideoDecode` exists.)
 	public func frame() -> LumaBuffer?
 	{
 		// We must be initialized
 		if !mVideoInitialized { return nil }
 
-		while av_read_frame(mpFormatCtx, &mPacket) >= 0
-		{
-			do
-			{
-				// Is this a packet from the video stream?
-				if Int(mPacket.stream_index) == mVideoStreamIndex
-				{
-					// Decode a single video frame
-
-					let sendRes = avcodec_send_packet(mpCodecCtx, &mPacket)
-					if sendRes != 0
-					{
-						throw VideoDecodeError.Frame("Error sending packet for frame decode (\(sendRes))")
-					}
-
-					let recvRes = avcodec_receive_frame(mpCodecCtx, mpFrame)
-					if recvRes != 0
-					{
-						throw VideoDecodeError.Frame("Error receiving frame for decode (\(recvRes))")
-					}
+		mReadySemaphore.wait()
 
-					mDecodedFrameCount += 1
-
-					guard let codecCtx = mpCodecCtx?.pointee else
-					{
-						throw VideoDecodeError.Frame("Frame decode produced no usable codec context")
-					}
-
-					guard let frame = mpFrame?.pointee else
-					{
-						throw VideoDecodeError.Frame("Frame decode produced no usable frame")
-					}
-
-					// Unref the packet that was allocated by av_read_frame
-					av_packet_unref(&mPacket)
-
-					// Return the actual LUMA frame
-					//
-					// This is actually a YUV 4:4:2 frame, which starts with a full-frame of luminance image data
-
-					// // Note: We create an ImageBuffer in which we own the buffer memory (i.e., faster and no copy)
-					// return LumaBuffer(width: Int(codecCtx.width), height: Int(codecCtx.height), buffer: frame.data.0!)
-
-					let buffer = LumaBuffer(width: Int(codecCtx.width), height: Int(codecCtx.height))
-					buffer.copy(from: frame.data.0!, width: Int(codecCtx.width), height: Int(codecCtx.height))
-					return buffer
-				}
-				else
-				{
-					mNonVideoFrameCount += 1
-				}
-			}
-			catch
-			{
-				// Log the error
-				gLogger.error("Caught VideoException: \(error.localizedDescription)")
-			}
+		let lumaBuffer: LumaBuffer? = mFramesMutex.fastsync
+		{
+			// An empty queue means the decoder thread has finished
+			if mReadyFrames.isEmpty { return nil }
 
-			// Free the packet that was allocated by av_read_frame
-			av_packet_unref(&mPacket)
+			let decodedFrame = mReadyFrames.removeFirst()
+			decodedFrame.queued = false
+			return decodedFrame.lumaBuffer
 		}
 
 		// No more frames (or an error), so uninitialize the video
-		stop()
+		if lumaBuffer == nil { stop() }
 
-		// Nothing to return
-		return nil
+		return lumaBuffer
 	}
 
 	/// Stop and uninitialize video decoding
@@ -314,12 +339,8 @@ public class VideoDecode
 	/// Throws VideoException on error
 	public func stop()
 	{
-		// Free the YUV frame
-		if mpFrame != nil
-		{
-			av_frame_free(&mpFrame)
-			mpFrame = nil
-		}
+		// Stop the decoder thread before tearing down anything it uses
+		stopDecoderThread()
 
 		// Close the codecs
 		if mpCodecCtx != nil
@@ -345,12 +366,226 @@ public class VideoDecode
 			// Final logging
 			gLogger.video("Decoding uninitialized")
 			gLogger.video("  >> Frames decoded  : \(mDecodedFrameCount)")
+			gLogger.video("  >> Frames copied   : \(mCopiedFrameCount)")
 			gLogger.video("  >> Non-video frames: \(mNonVideoFrameCount)")
 		}
 
 		// We're no longer initialized
 		mVideoInitialized = false
 	}
+
+	// -----------------------------------------------------------------------------------------------------------------------------
+	// Decoder thread
+	// -----------------------------------------------------------------------------------------------------------------------------
+
+	/// Starts the thread that decodes frames ahead of the caller (see `decodeFrames()`)
+	private func startDecoderThread()
+	{
+		// The frames decoded ahead, plus the one held by the caller
+		let frameCount = max(Config.captureVideoDecodeReadAheadFrames, 1) + 1
+		while mFrames.count < frameCount
+		{
+			mFrames.append(DecodedFrame())
+		}
+
+		mReadyFrames.reserveCapacity(mFrames.count)
+		mReadySemaphore = DispatchSemaphore(value: 0)
+		mStopRequested.value = false
+
+		let decoderStopped = DispatchSemaphore(value: 0)
+		mDecoderStopped = decoderStopped
+
+		let thread = Thread.init
+		{
+			self.decodeFrames()
+
+			// Wake the caller for the end of the stream
+			self.mReadySemaphore.signal()
+			decoderStopped.signal()
+		}
+		thread.start()
+	}
+
+	/// Stops the decoder thread (if it is running) and returns every frame that the caller isn't holding to the pool
+	private func stopDecoderThread()
+	{
+		guard let decoderStopped = mDecoderStopped else { return }
+
+		mStopRequested.value = true
+		decoderStopped.wait()
+		mDecoderStopped = nil
+
+		// Frames that were decoded but never returned are discarded, and any decoder memory that isn't held by the caller is
+		// released (a held frame keeps its reference until it is reused)
+		mReadyFrames.removeAll(keepingCapacity: true)
+		for decodedFrame in mFrames
+		{
+			decodedFrame.queued = false
+			if isKnownUniquelyReferenced(&decodedFrame.lumaBuffer) && !decodedFrame.lumaBuffer!.bufferOwner
+			{
+				decodedFrame.lumaBuffer = nil
+				av_frame_unref(decodedFrame.pFrame)
+			}
+		}
+	}
+
+	/// Decodes frames into the pool until the end of the stream (or an error), or until asked to stop
+	///
+	/// This runs on the decoder thread.
+	private func decodeFrames()
+	{
+		var draining = false
+
+		while let decodedFrame = nextFreeFrame()
+		{
+			if !receiveFrame(into: decodedFrame.pFrame, draining: &draining) { break }
+
+			mDecodedFrameCount += 1
+			if !storeLuma(of: decodedFrame) { break }
+
+			mFramesMutex.fastsync
+			{
+				decodedFrame.queued = true
+				mReadyFrames.append(decodedFrame)
+			}
+			mReadySemaphore.signal()
+		}
+	}
+
+	/// Returns a frame from the pool that is neither waiting to be returned nor held by the caller, waiting for one if necessary
+	///
+	/// Returns `nil` if the decoder thread is asked to stop while waiting.
+	private func nextFreeFrame() -> DecodedFrame?
+	{
+		while !mStopRequested.value
+		{
+			let freeFrame: DecodedFrame? = mFramesMutex.fastsync
+			{
+				for decodedFrame in mFrames where !decodedFrame.queued
+				{
+					if decodedFrame.lumaBuffer == nil || isKnownUniquelyReferenced(&decodedFrame.lumaBuffer)
+					{
+						return decodedFrame
+					}
+				}
+				return nil
+			}
+
+			if let freeFrame = freeFrame
+			{
+				// Release the decoder memory from this frame's previous use
+				av_frame_unref(freeFrame.pFrame)
+				return freeFrame
+			}
+
+			// The caller releases frames without telling us, so we check back shortly
+			usleep(useconds_t(VideoDecode.kFreeFramePollIntervalMS * 1000))
+		}
+
+		return nil
+	}
+
+	/// Receives the next decoded video frame into `pFrame`, feeding the codec packets from the stream as it needs them
+	///
+	/// With frame threading, the codec takes in several packets before it returns its first frame. Once the stream runs out of
+	/// packets, the codec is drained (`draining`) of the frames it is still holding.
+	///
+	/// Returns false at the end of the stream, on error, or if the decoder thread is asked to stop.
+	private func receiveFrame(into pFrame: UnsafeMutablePointer<AVFrame>?, draining: inout Bool) -> Bool
+	{
+		while !mStopRequested.value
+		{
+			let recvRes = avcodec_receive_frame(mpCodecCtx, pFrame)
+			if recvRes == 0 { return true }
+			if recvRes == VideoDecode.kAvErrorEof { return false }
+
+			if recvRes != VideoDecode.kAvErrorAgain
+			{
+				gLogger.error("Caught VideoException: \(VideoDecodeError.Frame("Error receiving frame for decode (\(recvRes))").localizedDescription)")
+				if draining { return false }
+			}
+
+			// The codec needs more input
+			if draining { continue }
+
+			if av_read_frame(mpFormatCtx, &mPacket) < 0
+			{
+				// No more packets, so flush out whatever the codec is holding
+				draining = true
+				_ = avcodec_send_packet(mpCodecCtx, nil)
+				continue
+			}
+
+			// Is this a packet from the video stream?
+			if Int(mPacket.stream_index) == mVideoStreamIndex
+			{
+				let sendRes = avcodec_send_packet(mpCodecCtx, &mPacket)
+				if sendRes != 0
+				{
+					gLogger.error("Caught VideoException: \(VideoDecodeError.Frame("Error sending packet for frame decode (\(sendRes))").localizedDescription)")
+				}
+			}
+			else
+			{
+				mNonVideoFrameCount += 1
+			}
+
+			// Free the packet that was allocated by av_read_frame
+			av_packet_unref(&mPacket)
+		}
+
+		return false
+	}
+
+	/// Points `decodedFrame.lumaBuffer` at the luma plane of its newly decoded frame
+	///
+	/// This is actually a YUV 4:2:0 frame, which starts with a full-frame of luminance image data. If that plane is packed and
+	/// the frame is writable, the buffer wraps it directly; otherwise it is copied (see `DecodedFrame`.)
+	///
+	/// A decoded frame is often also one of the codec's reference frames (and, with frame threading, may still be read by other
+	/// decoder threads.) The caller modifies the luma it is given, so such a frame must never be wrapped.
+	///
+	/// Returns false if the frame has no usable image data.
+	private func storeLuma(of decodedFrame: DecodedFrame) -> Bool
+	{
+		guard let frame = decodedFrame.pFrame?.pointee, let plane = frame.data.0 else
+		{
+			gLogger.error("Caught VideoException: \(VideoDecodeError.Frame("Frame decode produced no usable frame").localizedDescription)")
+			return false
+		}
+
+		let width = Int(frame.width)
+		let height = Int(frame.height)
+		let stride = Int(frame.linesize.0)
+		let current = decodedFrame.lumaBuffer
+		let sizeMatches = current?.width == width && current?.height == height
+
+		if stride == width && av_frame_is_writable(decodedFrame.pFrame) != 0
+		{
+			// The decoder's buffers are pooled, so the wrapper from this frame's previous use often still fits
+			if !sizeMatches || current!.bufferOwner || current!.buffer != plane
+			{
+				decodedFrame.lumaBuffer = LumaBuffer(width: width, height: height, buffer: plane)
+			}
+			return true
+		}
+
+		if !sizeMatches || !current!.bufferOwner
+		{
+			decodedFrame.lumaBuffer = LumaBuffer(width: width, height: height)
+		}
+
+		let packed = decodedFrame.lumaBuffer!.buffer
+		for y in 0..<height
+		{
+			(packed + y * width).assign(from: plane + y * stride, count: width)
+		}
+
+		// The copy is ours, so the decoder can have its memory back
+		av_frame_unref(decodedFrame.pFrame)
+		mCopiedFrameCount += 1
+		return true
+	}
 }
 
 #endif // os(macOS) || os(Linux)
@@ -172,7 +172,7 @@ internal class Whisper
 		}
 		else
 		{
-			#if USE_MMAL
+			#if os(Linux)
 			mediaProvider = WhisperCaptureMediaProvider.instance
 			#endif
 		}
@@ -10,7 +10,7 @@
 // Use of this source code is governed by a BSD-style license that can be found
 // in the LICENSE file in the root of the source tree.
 
-#if USE_MMAL
+#if os(Linux)
 import Foundation
 import Seer
 import NativeTasks
@@ -53,6 +53,11 @@ internal final class WhisperCaptureMediaProvider: MediaProvider
 
 	private var lumaBuffer: LumaBuffer?
 
+	/// Size of the region captured around a tracked deck (zero when capturing the full frame)
+	///
+	/// This only changes when the deck outgrows it (or becomes much smaller), as each new frame size requires new search lines
+	private var roiSize = IVector()
+
 	//
 	// Signals & semaphores
 	//
@@ -65,12 +70,61 @@ internal final class WhisperCaptureMediaProvider: MediaProvider
 
 	/// Receive and process images as they are captured
 	private func internalCaptureReceiverHandler(_ buffer: UnsafeMutablePointer<LumaSample>?, _ width: UInt32, _ height: UInt32)
+	{
+		// Where this frame lies within the full frame (it may be cropped to the tracked deck)
+		let roi = nativeVideoCaptureFrameRoi()
+		let frameRegion = DeckSearch.FrameRegion(origin: IVector(x: Int(roi.x), y: Int(roi.y)), binning: Int(roi.binning))
+
+		if processCapturedFrame(buffer, width: Int(width), height: Int(height), frameRegion: frameRegion)
+		{
+			updateRoi()
+		}
+	}
+
+	/// Acquire and process the images lent from the capture's buffers, until shutdown is requested
+	///
+	/// Each scanned image is held until the next one has been scanned, as `lumaBuffer` refers to it (see `archiveFrame()`.)
+	/// Images that arrive while a frame is being scanned replace each other, so only the latest is scanned.
+	private func processLentImages()
+	{
+		var heldImage = NativeCaptureImage()
+		var image = NativeCaptureImage()
+
+		while !Whisper.instance.shutdownRequested.value
+		{
+			guard let buffer = nativeVideoCaptureImageAcquire(&image) else
+			{
+				// Rest for a millisecond
+				Thread.sleep(forTimeInterval: 0.001)
+				continue
+			}
+
+			if processCapturedFrame(buffer, width: Int(image.width), height: Int(image.height), frameRegion: DeckSearch.FrameRegion())
+			{
+				nativeVideoCaptureImageRelease(&heldImage)
+				heldImage = image
+			}
+			else
+			{
+				nativeVideoCaptureImageRelease(&image)
+			}
+		}
+
+		// The capture can't stop while it has images out
+		lumaBuffer = nil
+		nativeVideoCaptureImageRelease(&heldImage)
+	}
+
+	/// Process a captured image, which lies at `frameRegion` within the full frame
+	///
+	/// Returns true if the image was scanned (in which case `lumaBuffer` now refers to it)
+	private func processCapturedFrame(_ buffer: UnsafeMutablePointer<LumaSample>?, width w: Int, height h: Int, frameRegion: DeckSearch.FrameRegion) -> Bool
 	{
 		let _track_ = PerfTimer.ScopedTrack(name: "Full frame"); _track_.use()
 
 		if Whisper.instance.shutdownRequested.value
 		{
-			return
+			return false
 		}
 
 		// Deal with user input before we process the frame
@@ -82,7 +136,7 @@ internal final class WhisperCaptureMediaProvider: MediaProvider
 			// We're skipping the media consumer, so we have to `present()` ourselves
 			TextUi.instance.present()
 			TextUi.instance.updateLog()
-			return
+			return false
 		}
 
 		// Make sure we have a valid code definition
@@ -91,14 +145,11 @@ internal final class WhisperCaptureMediaProvider: MediaProvider
 			gLogger.error("No code definition set, unable to process frame")
 			TextUi.instance.present()
 			TextUi.instance.updateLog()
-			return
+			return false
 		}
 
 		let frameStart = PerfTimer.trackBegin()
 
-		let w = Int(width)
-		let h = Int(height)
-
 		if let rawLumaBuffer = buffer
 		{
 			gLogger.frame(String(format: "    >> Received capture frame of %dx%d", w, h))
@@ -117,12 +168,52 @@ internal final class WhisperCaptureMediaProvider: MediaProvider
 
 			// Scan the image
 			processingFrame = true
-			Whisper.instance.mediaConsumer?.processFrame(lumaBuffer: lumaBuffer!, codeDefinition: codeDefinition)
+			Whisper.instance.mediaConsumer?.processFrame(lumaBuffer: lumaBuffer!, codeDefinition: codeDefinition, frameRegion: frameRegion)
 			processingFrame = false
+			return true
 		}
 		else
 		{
 			gLogger.error(String(format: "    >> Received nil buffer frame of %dx%d", w, h))
+			return false
+		}
+	}
+
+	/// Crops capture to the area around the tracked deck, widening back to the full frame when no deck is being tracked
+	///
+	/// Scanning a small region rather than the full frame reduces memory traffic and search time considerably while a deck is
+	/// being tracked. The region takes effect with the next frame delivered.
+	private func updateRoi()
+	{
+		let kRoiSizeAlignment = 64
+
+		var origin = IVector()
+		var binning = 1
+
+		if Config.captureRoiEnable, let bounds = Whisper.instance.mediaConsumer?.scanManager.trackedDeckBounds
+		{
+			let margin = max(bounds.width, bounds.height) * Config.captureRoiMarginPercent / 100
+			let size = IVector(x: bounds.width + margin * 2, y: bounds.height + margin * 2)
+			if size.x > roiSize.x || size.y > roiSize.y || size.x < roiSize.x / 2 || size.y < roiSize.y / 2
+			{
+				roiSize = (size + kRoiSizeAlignment - 1) / kRoiSizeAlignment * kRoiSizeAlignment
+			}
+
+			// Center the region on the deck
+			let center = IVector(x: (bounds.minX + bounds.maxX) / 2, y: (bounds.minY + bounds.maxY) / 2)
+			origin = center - roiSize / 2
+			origin = IVector(x: max(origin.x, 0), y: max(origin.y, 0))
+			binning = Config.captureRoiBinning
+		}
+		else
+		{
+			roiSize = IVector()
+		}
+
+		// The capture clamps the region to the frame
+		if let errMsg = nativeVideoCaptureSetRoi(UInt32(origin.x), UInt32(origin.y), UInt32(roiSize.x), UInt32(roiSize.y), UInt32(binning))
+		{
+			gLogger.error("nativeVideoCaptureSetRoi() returned error: \(String(cString: errMsg))")
 		}
 	}
 
@@ -251,28 +342,82 @@ internal final class WhisperCaptureMediaProvider: MediaProvider
 	{
 		self.mediaConsumer = mediaConsumer
 
+		if !Config.captureBackend.isEmpty
+		{
+			if let errMsg = nativeVideoCaptureSelectBackend(Config.captureBackend, Config.captureSource)
+			{
+				gLogger.error("nativeVideoCaptureSelectBackend() returned error: \(String(cString: errMsg))")
+				return
+			}
+		}
+
 		let width = UInt32(Config.captureFrameWidth)
 		let height = UInt32(Config.captureFrameHeight)
 		let rate = UInt32(Config.captureFrameRateHz)
-		if let errMsg = nativeVideoCaptureStart(width, height, rate, { (buffer, width, height) in WhisperCaptureMediaProvider.captureReceiverHandler(buffer, width, height)})
+		let lendBuffers = Config.captureLendBuffers
+		if lendBuffers
 		{
-			gLogger.error("nativeVideoCaptureStart() returned error: \(errMsg)")
-			return
+			if let errMsg = nativeVideoCaptureStartLending(width, height, rate)
+			{
+				gLogger.error("nativeVideoCaptureStartLending() returned error: \(String(cString: errMsg))")
+				return
+			}
+		}
+		else
+		{
+			// How frames are queued for the receiver (this must be set before capture starts)
+			var policy = NativeFrameDispatchPolicyLatest
+			switch Config.captureDispatchPolicy.lowercased()
+			{
+				case "latest":
+					break
+				case "fifo":
+					policy = NativeFrameDispatchPolicyFifo
+				default:
+					gLogger.warn("Unknown capture.DispatchPolicy '\(Config.captureDispatchPolicy)', using 'latest'")
+			}
+
+			if let errMsg = nativeVideoCaptureDispatchConfigure(policy, UInt32(max(Config.captureDispatchQueueFrames, 1)))
+			{
+				gLogger.error("nativeVideoCaptureDispatchConfigure() returned error: \(String(cString: errMsg))")
+			}
+
+			if let errMsg = nativeVideoCaptureStart(width, height, rate, { (buffer, width, height) in WhisperCaptureMediaProvider.captureReceiverHandler(buffer, width, height)})
+			{
+				gLogger.error("nativeVideoCaptureStart() returned error: \(errMsg)")
+				return
+			}
 		}
 
 		stoppedSemaphore = DispatchSemaphore(value: 0)
 
 		let thread = Thread.init
 		{
-			while !Whisper.instance.shutdownRequested.value
+			if lendBuffers
 			{
-				// Rest for a millisecond
-				Thread.sleep(forTimeInterval: 0.001)
+				// Frames are scanned on this thread
+				self.processLentImages()
+			}
+			else
+			{
+				while !Whisper.instance.shutdownRequested.value
+				{
+					// Rest for a millisecond
+					Thread.sleep(forTimeInterval: 0.001)
+				}
 			}
 
-			// Stop capturing
+			// Stop capturing (this waits for delivery of the current frame to finish)
 			nativeVideoCaptureStop()
 
+			if !lendBuffers
+			{
+				let stats = nativeVideoCaptureDispatchStats(false)
+				gLogger.info("Capture dispatch: \(stats.framesDelivered) of \(stats.framesSubmitted) frames delivered, " +
+				             "\(stats.framesDropped) dropped, max queue depth \(stats.maxDepth), " +
+				             "mean latency \(stats.meanLatencyMicroseconds)us (max \(stats.maxLatencyMicroseconds)us)")
+			}
+
 			// Wait for processing of the last frame to finish before quitting
 			while self.processingFrame
 			{
@@ -386,4 +531,4 @@ internal final class WhisperCaptureMediaProvider: MediaProvider
 		(self as MediaProvider).onMediaChanged(to: path, withSize: size)
 	}
 }
-#endif // USE_MMAL
+#endif // os(Linux)
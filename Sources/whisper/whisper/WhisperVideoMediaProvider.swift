@@ -46,6 +46,10 @@ internal final class WhisperVideoMediaProvider: MediaProvider
 	/// Our primary video decode manager
 	private let videoDecoder = VideoDecode()
 
+	/// The luma archive being played (instead of a video), and the index of its next frame
+	private var lumaArchive: LumaArchiveReader?
+	private var lumaArchiveFrameIndex = 0
+
 	//
 	// Media file & management
 	//
@@ -57,6 +61,7 @@ internal final class WhisperVideoMediaProvider: MediaProvider
 	// Image frames
 	//
 
+	/// The most recent frame (for archiving), which keeps its frame out of the decoder's pool until the next one replaces it
 	private var lumaBuffer: LumaBuffer?
 
 	//
@@ -213,7 +218,7 @@ internal final class WhisperVideoMediaProvider: MediaProvider
 				if firstFrame || Whisper.instance.restartPlayback.value
 				{
 					let videoFileUrl = self.mediaFiles[self.currentMediaFileIndex]
-					if !self.videoDecoder.start(path: videoFileUrl)
+					if !self.startMedia(path: videoFileUrl)
 					{
 						gLogger.error("Unable to start media file: '\(videoFileUrl)'")
 					}
@@ -237,7 +242,7 @@ internal final class WhisperVideoMediaProvider: MediaProvider
 				let frameStart = PerfTimer.trackBegin()
 
 				let videoStart = PerfTimer.trackBegin()
-				self.lumaBuffer = self.videoDecoder.frame()
+				self.lumaBuffer = self.nextFrame()
 
 				if let lumaBuffer = self.lumaBuffer
 				{
@@ -280,13 +285,13 @@ internal final class WhisperVideoMediaProvider: MediaProvider
 					}
 
 					// Go to the next media file
-					self.videoDecoder.stop()
+					self.stopMedia()
 					self.next()
 					firstFrame = true
 				}
 			} while !Whisper.instance.shutdownRequested.value
 
-			self.videoDecoder.stop()
+			self.stopMedia()
 
 			// Signal that we're fully stopped
 			self.stoppedSemaphore?.signal()
@@ -294,6 +299,54 @@ internal final class WhisperVideoMediaProvider: MediaProvider
 		thread.start()
 	}
 
+	/// Starts playback of the video or luma archive (see `LumaArchiveWriter`) at `path`
+	///
+	/// Returns false on error
+	private func startMedia(path: PathString) -> Bool
+	{
+		// If we're already playing, stop now
+		stopMedia()
+
+		if !path.lowercased().hasSuffix(".\(LumaArchiveWriter.fileExtension)")
+		{
+			return videoDecoder.start(path: path)
+		}
+
+		guard let archive = try? LumaArchiveReader(path: path) else { return false }
+
+		gLogger.video("Playing luma archive (\(archive.count) frames): \(path)")
+		lumaArchive = archive
+		lumaArchiveFrameIndex = 0
+		return true
+	}
+
+	/// Returns the next frame of the current media, or `nil` at the end of it (or on error)
+	///
+	/// Frames from a luma archive are read in place from the mapped archive (or, if compressed, decoded into a buffer that the
+	/// next frame reuses, which is fine as only the playback thread reads them); the temporal state stored with each is not
+	/// restored, as the archive is played like any other video.
+	private func nextFrame() -> LumaBuffer?
+	{
+		guard let archive = lumaArchive else { return videoDecoder.frame() }
+
+		let frame = archive.frame(at: lumaArchiveFrameIndex)
+		lumaArchiveFrameIndex += 1
+		return frame?.image
+	}
+
+	/// Stops playback of the current media
+	private func stopMedia()
+	{
+		videoDecoder.stop()
+
+		// Frames from an archive point into its mapping, so the most recent one must go with it
+		if lumaArchive != nil
+		{
+			lumaBuffer = nil
+			lumaArchive = nil
+		}
+	}
+
 	/// Restart the current media file at the beginning
 	func restart()
 	{